@@ -0,0 +1,165 @@
+/** ============================================================================
+ *  @file       attitude.c
+ *
+ *  @brief      Orientation of the device from the MPU samples, and its posture.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <string.h>
+
+#include "attitude.h"
+#include "probe.h"
+
+/* -----------------------------------------------------------------------------
+*  Constants
+* ------------------------------------------------------------------------------
+*/
+// Q14 rad/s of 1 deg/s
+#define ATTITUDE_DEG        285.9569f
+// The accelerometer is trusted from 0.75 to 1.25 g, squared
+#define ATTITUDE_MIN_G2     (ATTITUDE_ONE * 9 / 16)
+#define ATTITUDE_MAX_G2     (ATTITUDE_ONE * 25 / 16)
+// ...when it changed less than 0.25 g from the previous sample, squared
+#define ATTITUDE_STEADY2    (ATTITUDE_ONE / 16)
+// The turn of a sample is followed up to half a radian, the accelerometer does the rest
+#define ATTITUDE_MAX_TURN   (ATTITUDE_ONE / 2)
+#define ATTITUDE_MAX_G      (4 * ATTITUDE_ONE)
+
+// The sign of z of the up direction lying face up: the MPU reads -1 g on z on the desk, see Debug/data.csv
+#define POSTURE_FACE_UP_Z   (-1)
+// Of z towards the face, lying flat (about 37 degrees) and on the edge (about 17 degrees)
+#define POSTURE_FLAT        (ATTITUDE_ONE * 8 / 10)
+#define POSTURE_EDGE        (ATTITUDE_ONE * 3 / 10)
+// A posture holds until this much past its limit
+#define POSTURE_HYSTERESIS  (ATTITUDE_ONE * 2 / 10)
+
+/* -----------------------------------------------------------------------------
+*  Local Functions
+* ------------------------------------------------------------------------------
+*/
+static int32_t toFixed(float value, float scale, int32_t limit)
+{
+    float fixed = value * scale;
+
+    if (fixed > limit) {
+        return limit;
+    }
+    if (fixed < -limit) {
+        return -limit;
+    }
+    return (int32_t)fixed;
+}
+
+static int32_t multiply(int32_t a, int32_t b)
+{
+    return (int32_t)(((int64_t)a * b) >> 14);
+}
+
+// Whether z of the up direction towards the face is in the posture, margin past its limit
+static int holds(Posture posture, int32_t z, int32_t margin)
+{
+    switch (posture) {
+    case POSTURE_FACE_UP:
+        return z > POSTURE_FLAT - margin;
+    case POSTURE_FACE_DOWN:
+        return z < -POSTURE_FLAT + margin;
+    case POSTURE_ON_EDGE:
+        return z < POSTURE_EDGE + margin && z > -POSTURE_EDGE - margin;
+    default:
+        return 0;
+    }
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          attitudeReset
+ *
+ * @brief       Forget the orientation, the next sample starts it over
+ *
+ * @return      -
+ */
+void attitudeReset(Attitude *attitude)
+{
+    memset(attitude, 0, sizeof(*attitude));
+}
+
+/*******************************************************************************
+ * @fn          attitudeSample
+ *
+ * @brief       Follow the orientation by a sample
+ *
+ * @descr       The first sample after a reset takes the up direction from
+ *              the accelerometer alone.
+ *
+ * @return      The posture
+ */
+Posture attitudeSample(Attitude *attitude, const float motion[6], uint32_t periodMs)
+{
+    int32_t accel[3], turn[3], cross[3];
+    int32_t *up = attitude->up;
+    int32_t length, change, gain, face;
+    Posture posture;
+    int i;
+    PROBE_START(PROBE_ATTITUDE);
+
+    for (i = 0; i < 3; i++) {
+        accel[i] = toFixed(motion[i], ATTITUDE_ONE, ATTITUDE_MAX_G);
+        turn[i] = toFixed(motion[i + 3], ATTITUDE_DEG, ATTITUDE_MAX_TURN * 1000 / periodMs) * (int32_t)periodMs / 1000;
+    }
+    length = multiply(accel[0], accel[0]) + multiply(accel[1], accel[1]) + multiply(accel[2], accel[2]);
+    change = 0;
+    for (i = 0; i < 3; i++) {
+        change += multiply(accel[i] - attitude->accel[i], accel[i] - attitude->accel[i]);
+        attitude->accel[i] = accel[i];
+    }
+
+    if (attitude->posture == POSTURE_UNKNOWN) {
+        memcpy(up, accel, sizeof(accel));
+    } else {
+        // The device turns, up turns the other way: up += up x turn
+        cross[0] = multiply(up[1], turn[2]) - multiply(up[2], turn[1]);
+        cross[1] = multiply(up[2], turn[0]) - multiply(up[0], turn[2]);
+        cross[2] = multiply(up[0], turn[1]) - multiply(up[1], turn[0]);
+        for (i = 0; i < 3; i++) {
+            up[i] += cross[i];
+        }
+        // Back to unit length, a Newton step of 1 / sqrt
+        gain = (3 * ATTITUDE_ONE - (multiply(up[0], up[0]) + multiply(up[1], up[1]) + multiply(up[2], up[2]))) / 2;
+        for (i = 0; i < 3; i++) {
+            up[i] = multiply(up[i], gain);
+        }
+
+        // Towards the accelerometer while it reads about gravity alone
+        if (length >= ATTITUDE_MIN_G2 && length <= ATTITUDE_MAX_G2 && change < ATTITUDE_STEADY2) {
+            gain = (int32_t)((periodMs << 14) / (ATTITUDE_TAU_MS + periodMs));
+            for (i = 0; i < 3; i++) {
+                up[i] += multiply(accel[i] - up[i], gain);
+            }
+        }
+    }
+
+    // The posture, with hysteresis
+    face = POSTURE_FACE_UP_Z * up[2];
+    if (!holds(attitude->posture, face, POSTURE_HYSTERESIS)) {
+        for (posture = POSTURE_FACE_UP; posture <= POSTURE_ON_EDGE; posture++) {
+            if (holds(posture, face, 0)) {
+                attitude->posture = posture;
+            }
+        }
+    }
+    // Not face up, down or on the edge yet, e.g. at the first sample while shaking
+    if (attitude->posture == POSTURE_UNKNOWN) {
+        attitude->posture = face > 0 ? POSTURE_FACE_UP : POSTURE_FACE_DOWN;
+    }
+
+    PROBE_STOP(PROBE_ATTITUDE);
+    return attitude->posture;
+}
@@ -0,0 +1,61 @@
+/** ============================================================================
+ *  @file       attitude.h
+ *
+ *  @brief      Orientation of the device from the MPU samples, and its posture.
+ *
+ *  A complementary filter in fixed point, for the CPU without an FPU. The
+ *  estimate is the up direction in the device frame, the unit vector the
+ *  accelerometer reads at rest (-z lying face up). Each sample turns it by
+ *  the gyro rates, then pulls it towards the accelerometer with the time
+ *  constant ATTITUDE_TAU_MS, while it reads about gravity alone: about 1 g
+ *  and steady since the previous sample, not shaken. A turn is followed by
+ *  the gyro as it happens, the accelerometer corrects the gyro drift.
+ *
+ *  The posture follows from the up direction, with hysteresis: face up,
+ *  face down (the clear side down) and on the edge. In between the last
+ *  posture holds.
+ *  ============================================================================
+ */
+#ifndef _ATTITUDE_H_
+#define _ATTITUDE_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+// 1 g, and 1 rad, in the Q14 fixed point of the estimate
+#define ATTITUDE_ONE        (1 << 14)
+// Of the pull towards the accelerometer
+#define ATTITUDE_TAU_MS     200
+
+typedef enum {
+    POSTURE_UNKNOWN = 0,    // before the first sample
+    POSTURE_FACE_UP,
+    POSTURE_FACE_DOWN,
+    POSTURE_ON_EDGE
+} Posture;
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    int32_t up[3];          // Q14, x y z of the device
+    int32_t accel[3];       // Q14, of the previous sample
+    Posture posture;
+} Attitude;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void attitudeReset(Attitude *attitude);
+// motion as for detectSample: ax, ay, az in g, gx, gy, gz in deg/s
+Posture attitudeSample(Attitude *attitude, const float motion[6], uint32_t periodMs);
+
+#endif
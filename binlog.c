@@ -0,0 +1,155 @@
+/** ============================================================================
+ *  @file       binlog.c
+ *
+ *  @brief      Deferred binary log.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <xdc/std.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "binlog.h"
+#include "serial.h"
+
+/* -----------------------------------------------------------------------------
+*  Local types
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    uint32_t tick;
+    uint8_t id;
+    uint8_t count;
+    uint16_t seq;
+    uint32_t args[BINLOG_MAX_ARGS];
+} BinlogRecord;
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static BinlogRecord ring[BINLOG_RING_RECORDS];
+static uint16_t ringHead = 0;   // records written
+static uint16_t ringTail = 0;   // records drained
+static uint16_t seq = 0;
+static uint32_t lost = 0;
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+// Frame payload, little endian: tick u32, id u8, count u8, seq u16, count * u32
+static uint8_t binlogEncode(const BinlogRecord *r, uint8_t *out)
+{
+    uint8_t length = 0;
+    uint8_t i;
+
+    out[length++] = r->tick;
+    out[length++] = r->tick >> 8;
+    out[length++] = r->tick >> 16;
+    out[length++] = r->tick >> 24;
+    out[length++] = r->id;
+    out[length++] = r->count;
+    out[length++] = r->seq;
+    out[length++] = r->seq >> 8;
+    for (i = 0; i < r->count; i++) {
+        out[length++] = r->args[i];
+        out[length++] = r->args[i] >> 8;
+        out[length++] = r->args[i] >> 16;
+        out[length++] = r->args[i] >> 24;
+    }
+    return length;
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          binlogWrite
+ *
+ * @brief       Store one record, use the LOGn macros
+ *
+ * @descr       Callable from any context, never blocks.
+ *
+ * @return      -
+ */
+void binlogWrite(BinlogFormatId id, uint8_t count, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    BinlogRecord *r;
+    UInt key;
+
+    key = Hwi_disable();
+    if ((uint16_t)(ringHead - ringTail) >= BINLOG_RING_RECORDS) {
+        lost++;
+        Hwi_restore(key);
+        return;
+    }
+    r = &ring[ringHead % BINLOG_RING_RECORDS];
+    r->tick = Clock_getTicks();
+    r->id = id;
+    r->count = count;
+    r->seq = seq++;
+    r->args[0] = a;
+    r->args[1] = b;
+    r->args[2] = c;
+    r->args[3] = d;
+    ringHead++;
+    Hwi_restore(key);
+}
+
+/*******************************************************************************
+ * @fn          binlogDrain
+ *
+ * @brief       Move records to the serial port while it has room
+ *
+ * @descr       Call from one task only. Records lost while the ring was
+ *              full are reported with a LOG_LOST record once it has drained.
+ *
+ * @return      Number of records still waiting
+ */
+int binlogDrain(void)
+{
+    uint8_t frame[8 + 4 * BINLOG_MAX_ARGS];
+    BinlogRecord r;
+    uint8_t length;
+    int lostRecord;
+    UInt key;
+
+    while (1) {
+        key = Hwi_disable();
+        lostRecord = (ringTail == ringHead);
+        if (!lostRecord) {
+            r = ring[ringTail % BINLOG_RING_RECORDS];
+        } else if (lost) {
+            r.tick = Clock_getTicks();
+            r.id = LOG_LOST;
+            r.count = 1;
+            r.seq = seq;
+            r.args[0] = lost;
+        } else {
+            Hwi_restore(key);
+            return 0;
+        }
+        Hwi_restore(key);
+
+        length = binlogEncode(&r, frame);
+        if (!serialSend(SERIAL_FRAME_LOG, frame, length)) {
+            break;
+        }
+
+        key = Hwi_disable();
+        if (lostRecord) {
+            lost -= r.args[0];
+        } else {
+            ringTail++;
+        }
+        Hwi_restore(key);
+    }
+    return (uint16_t)(ringHead - ringTail);
+}
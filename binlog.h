@@ -0,0 +1,60 @@
+/** ============================================================================
+ *  @file       binlog.h
+ *
+ *  @brief      Deferred binary log.
+ *
+ *  A log call stores a timestamp, a format id and up to BINLOG_MAX_ARGS
+ *  raw 32-bit arguments in a RAM ring, with interrupts disabled for a
+ *  handful of cycles. It never blocks: when the ring is full the record
+ *  is counted as lost. binlogDrain() moves the records to the serial port
+ *  as SERIAL_FRAME_LOG frames, host/logdec renders them as text.
+ *  ============================================================================
+ */
+#ifndef _BINLOG_H_
+#define _BINLOG_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+#include "binlog_formats.h"
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+// Power of two, so the indexes can wrap freely
+#ifndef BINLOG_RING_RECORDS
+#define BINLOG_RING_RECORDS 32
+#endif
+
+/* -----------------------------------------------------------------------------
+*                                          Macros
+* ------------------------------------------------------------------------------
+*/
+#define LOG0(id)                binlogWrite(id, 0, 0, 0, 0, 0)
+#define LOG1(id, a)             binlogWrite(id, 1, (uint32_t)(a), 0, 0, 0)
+#define LOG2(id, a, b)          binlogWrite(id, 2, (uint32_t)(a), (uint32_t)(b), 0, 0)
+#define LOG3(id, a, b, c)       binlogWrite(id, 3, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), 0)
+#define LOG4(id, a, b, c, d)    binlogWrite(id, 4, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d))
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void binlogWrite(BinlogFormatId id, uint8_t count, uint32_t a, uint32_t b, uint32_t c, uint32_t d);
+int binlogDrain(void);
+
+// Raw bits of a float argument
+static inline uint32_t binlogFloat(float value)
+{
+    union {
+        float f;
+        uint32_t u;
+    } bits;
+
+    bits.f = value;
+    return bits.u;
+}
+
+#endif
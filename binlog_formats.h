@@ -0,0 +1,66 @@
+/** ============================================================================
+ *  @file       binlog_formats.h
+ *
+ *  @brief      Formats of the binary log, shared with host/logdec.
+ *
+ *  The device only stores the id of a format and its raw arguments, the
+ *  host decoder renders the text. Append new formats at the end, so logs
+ *  from older firmware still decode. Conversions: %d %i %u %x %X %c %f.
+ *  Pass floats with binlogFloat(). Strings cannot be logged.
+ *  ============================================================================
+ */
+#ifndef _BINLOG_FORMATS_H_
+#define _BINLOG_FORMATS_H_
+
+// Clock.tickPeriod in empty.cfg, the record timestamps are Clock ticks
+#define BINLOG_TICK_US      10
+#define BINLOG_MAX_ARGS     4
+
+//      id                      format
+#define BINLOG_FORMATS(X) \
+    X(LOG_LOST,                 "%u log records lost") \
+    X(LOG_BOOT,                 "Hello world!") \
+    X(LOG_GAME_OVER,            "Game over") \
+    X(LOG_GATEWAY_WARNING,      "Warning from the gateway") \
+    X(LOG_CHANNEL_CHANGED,      "Channel changed to %d") \
+    X(LOG_CHANNEL_SCAN_FAILED,  "Channel scan failed") \
+    X(LOG_MPU_POWER_ON,         "MPU9250: Power ON") \
+    X(LOG_MPU_SETUP,            "MPU9250: Setup and calibration...") \
+    X(LOG_MPU_SETUP_OK,         "MPU9250: Setup and calibration OK") \
+    X(LOG_MPU_SETUP_START,      "MPU9250: Setup start...") \
+    X(LOG_MPU_SETUP_DONE,       "MPU9250: Setup OK") \
+    X(LOG_MPU_WRITE_FAILED,     "MPU9250: write=%x data=%x FAILED") \
+    X(LOG_MPU_READ_FAILED,      "MPU9250: read=%x count=%x FAILED") \
+    X(LOG_OPT_CONFIG,           "OPT3001: Config write %d (1 = ok)") \
+    X(LOG_OPT_READ_FAILED,      "OPT3001: Data read failed!") \
+    X(LOG_SHUTDOWN,             "Shutting down...") \
+    X(LOG_SESSION_STARTED,      "Data session started") \
+    X(LOG_SESSION_ENDED,        "Data session ended") \
+    X(LOG_FOOD_SELECTED,        "Selected food = %d") \
+    X(LOG_FEEDING,              "Feeding... (food %d)") \
+    X(LOG_SLEEPING,             "Sleeping...") \
+    X(LOG_EXERCISING,           "Exercising...") \
+    X(LOG_BEING_PET,            "Being pet...") \
+    X(LOG_EVENT_STATS,          "Events: %u handled, %u dropped, latency avg %u us, max %u us") \
+    X(LOG_BUTTON_STATS,         "Buttons: %u edges, %u bounces, %u lost") \
+    X(LOG_FLASHLOG_OPEN,        "Flash log: open %d (1 = ok), next page %u, wear %u..%u") \
+    X(LOG_FLASHLOG_STATS,       "Flash log: %u pages written, %u records dropped") \
+    X(LOG_FLASH_OFFLOAD_DONE,   "Flash log: offload done") \
+    X(LOG_MPU_CALIBRATION_USED, "MPU9250: saved calibration from %.1f C used") \
+    X(LOG_MPU_CALIBRATION_OLD,  "MPU9250: saved calibration from %.1f C, now %.1f C") \
+    X(LOG_MPU_CALIBRATION_SAVED,"MPU9250: calibration at %.1f C saved %d (1 = ok)") \
+    X(LOG_BOOT_TIME,            "Boot: first sample %u ms after BIOS start, MPU setup %u ms, saved calibration %d") \
+    X(LOG_STREAM,               "Streaming %d, %u IMU samples sent, %u dropped") \
+    X(LOG_PARAM_SET,            "Parameter %u set to %.3f") \
+    X(LOG_EXERCISE_RHYTHM,      "Exercising at %.1f Hz") \
+    X(LOG_EXERCISE_DONE,        "Exercise done: %u reps") \
+    X(LOG_POSTURE,              "Posture %d (1 face up, 2 face down, 3 on the edge)")
+
+#define BINLOG_ENUM(id, format) id,
+typedef enum {
+    BINLOG_FORMATS(BINLOG_ENUM)
+    LOG_FORMAT_COUNT
+} BinlogFormatId;
+#undef BINLOG_ENUM
+
+#endif
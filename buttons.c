@@ -0,0 +1,330 @@
+/** ============================================================================
+ *  @file       buttons.c
+ *
+ *  @brief      Button gesture engine.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Swi.h>
+
+#include "buttons.h"
+
+/* -----------------------------------------------------------------------------
+*  Constants
+* ------------------------------------------------------------------------------
+*/
+// Power of two, so the indexes can wrap freely
+#define EDGE_RING_LENGTH 16
+#define MS_TO_TICKS(ms) ((uint32_t)(ms) * 1000 / Clock_tickPeriod)
+
+// Swi trigger bits: new edges, then one debounce and one gesture timer per button
+#define TRIGGER_EDGES       0x01
+#define TRIGGER_DEBOUNCE(i) (0x02 << (i))
+#define TRIGGER_GESTURE(i)  (0x02 << (BUTTONS_MAX + (i)))
+
+/* -----------------------------------------------------------------------------
+*  Local types
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    PIN_Id pin;
+    uint32_t tick;
+} ButtonEdge;
+
+typedef enum {
+    GESTURE_IDLE = 0,
+    GESTURE_PRESSED,        // waiting for the release or the long push
+    GESTURE_HELD,           // long push posted, repeating while held
+    GESTURE_WAIT_SECOND,    // released, waiting for a second push
+    GESTURE_SECOND_PRESSED
+} GesturePhase;
+
+typedef struct {
+    uint8_t pressed;        // debounced level
+    uint8_t settling;       // edges seen, debounce timer running
+    uint8_t phase;          // GesturePhase
+    uint8_t repeats;
+    uint32_t edgeTick;      // first edge since the level was stable
+    Clock_Struct debounceClock;
+    Clock_Struct gestureClock;
+} ButtonState;
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static Swi_Struct swiStruct;
+static Swi_Handle hSwi = NULL;
+
+// Written only by the interrupt (head) and the Swi (tail)
+static ButtonEdge ring[EDGE_RING_LENGTH];
+static volatile uint8_t ringHead = 0;
+static volatile uint8_t ringTail = 0;
+
+static const ButtonConfig *buttons = NULL;
+static uint8_t buttonCount = 0;
+static ButtonState state[BUTTONS_MAX];
+static ButtonStats stats;
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+static void buttonsPost(EventType type, uint8_t arg)
+{
+    if (type != BUTTON_NO_EVENT) {
+        eventPost(type, arg);
+    }
+}
+
+// (Re)starts a one-shot timer, a zero timeout would never expire
+static void buttonsStartClock(Clock_Struct *clock, uint32_t ticks)
+{
+    Clock_Handle handle = Clock_handle(clock);
+
+    Clock_stop(handle);
+    Clock_setTimeout(handle, ticks ? ticks : 1);
+    Clock_start(handle);
+}
+
+// Time left of a delay that started at tick
+static uint32_t buttonsRemaining(uint16_t ms, uint32_t tick)
+{
+    uint32_t elapsed = Clock_getTicks() - tick;
+    uint32_t delay = MS_TO_TICKS(ms);
+
+    return elapsed < delay ? delay - elapsed : 0;
+}
+
+/*******************************************************************************
+ * @fn          buttonsLevelChanged
+ *
+ * @brief       Gesture state machine, runs when the debounced level changes
+ *
+ * @descr       The gesture times are measured from the first edge of the
+ *              change, not from the end of the debounce.
+ */
+static void buttonsLevelChanged(uint8_t i)
+{
+    const ButtonConfig *cfg = &buttons[i];
+    ButtonState *s = &state[i];
+
+    if (s->pressed) {
+        if (s->phase == GESTURE_IDLE) {
+            s->phase = GESTURE_PRESSED;
+            buttonsStartClock(&s->gestureClock, buttonsRemaining(cfg->longPushMs, s->edgeTick));
+        } else if (s->phase == GESTURE_WAIT_SECOND) {
+            Clock_stop(Clock_handle(&s->gestureClock));
+            s->phase = GESTURE_SECOND_PRESSED;
+        }
+        return;
+    }
+
+    switch (s->phase) {
+    case GESTURE_PRESSED:
+        Clock_stop(Clock_handle(&s->gestureClock));
+        if (cfg->doubleTap != BUTTON_NO_EVENT) {
+            s->phase = GESTURE_WAIT_SECOND;
+            buttonsStartClock(&s->gestureClock, buttonsRemaining(cfg->doubleTapMs, s->edgeTick));
+        } else {
+            s->phase = GESTURE_IDLE;
+            buttonsPost(cfg->shortPush, 0);
+        }
+        break;
+    case GESTURE_HELD:
+        Clock_stop(Clock_handle(&s->gestureClock));
+        s->phase = GESTURE_IDLE;
+        break;
+    case GESTURE_SECOND_PRESSED:
+        s->phase = GESTURE_IDLE;
+        buttonsPost(cfg->doubleTap, 0);
+        break;
+    default:
+        // Released without a push seen, e.g. the push that woke the device up
+        break;
+    }
+}
+
+/*******************************************************************************
+ * @fn          buttonsGestureTimeout
+ *
+ * @brief       Long push, repeat and double tap deadlines
+ */
+static void buttonsGestureTimeout(uint8_t i)
+{
+    const ButtonConfig *cfg = &buttons[i];
+    ButtonState *s = &state[i];
+
+    // Restarted after it expired, this deadline is gone
+    if (Clock_isActive(Clock_handle(&s->gestureClock))) {
+        return;
+    }
+
+    switch (s->phase) {
+    case GESTURE_PRESSED:
+        s->phase = GESTURE_HELD;
+        s->repeats = 0;
+        buttonsPost(cfg->longPush, 0);
+        if (cfg->holdRepeat != BUTTON_NO_EVENT) {
+            buttonsStartClock(&s->gestureClock, MS_TO_TICKS(cfg->repeatMs));
+        }
+        break;
+    case GESTURE_HELD:
+        if (s->repeats < 255) {
+            s->repeats++;
+        }
+        buttonsPost(cfg->holdRepeat, s->repeats);
+        buttonsStartClock(&s->gestureClock, MS_TO_TICKS(cfg->repeatMs));
+        break;
+    case GESTURE_WAIT_SECOND:
+        s->phase = GESTURE_IDLE;
+        buttonsPost(cfg->shortPush, 0);
+        break;
+    default:
+        break;
+    }
+}
+
+// Bottom half, runs in Swi context
+static Void buttonsSwiFxn(UArg arg0, UArg arg1)
+{
+    UInt trigger = Swi_getTrigger();
+    uint8_t pressed;
+    uint8_t i;
+
+    // Every edge restarts the debounce of its button
+    while (ringTail != ringHead) {
+        const ButtonEdge *edge = &ring[ringTail % EDGE_RING_LENGTH];
+        for (i = 0; i < buttonCount; i++) {
+            if (buttons[i].pin == edge->pin) {
+                if (!state[i].settling) {
+                    state[i].settling = 1;
+                    state[i].edgeTick = edge->tick;
+                }
+                buttonsStartClock(&state[i].debounceClock, MS_TO_TICKS(buttons[i].debounceMs));
+                break;
+            }
+        }
+        ringTail++;
+    }
+
+    for (i = 0; i < buttonCount; i++) {
+        // A new edge may have restarted the debounce after it expired
+        if ((trigger & TRIGGER_DEBOUNCE(i)) && !Clock_isActive(Clock_handle(&state[i].debounceClock))) {
+            state[i].settling = 0;
+            // The buttons are active low
+            pressed = !PIN_getInputValue(buttons[i].pin);
+            if (pressed == state[i].pressed) {
+                stats.bounces++;
+            } else {
+                state[i].pressed = pressed;
+                buttonsLevelChanged(i);
+            }
+        }
+        if (trigger & TRIGGER_GESTURE(i)) {
+            buttonsGestureTimeout(i);
+        }
+    }
+}
+
+// Clock function, hands the expired timer to the Swi
+static Void buttonsClkFxn(UArg mask)
+{
+    Swi_or(hSwi, (UInt)mask);
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          buttonsOpen
+ *
+ * @brief       Set up the buttons, call before BIOS_start
+ *
+ * @descr       The config table must stay valid, it is not copied.
+ *              Register buttonsPinFxn as the callback of the button pins.
+ *
+ * @return      -
+ */
+void buttonsOpen(const ButtonConfig *config, uint8_t count)
+{
+    Swi_Params swiParams;
+    Clock_Params clkParams;
+    uint8_t i;
+
+    if (count > BUTTONS_MAX) {
+        System_abort("Too many buttons");
+    }
+    buttons = config;
+    buttonCount = count;
+    memset(state, 0, sizeof(state));
+    memset(&stats, 0, sizeof(stats));
+
+    Swi_Params_init(&swiParams);
+    swiParams.priority = 1;
+    swiParams.trigger = 0;
+    Swi_construct(&swiStruct, (Swi_FuncPtr)buttonsSwiFxn, &swiParams, NULL);
+    hSwi = Swi_handle(&swiStruct);
+
+    for (i = 0; i < count; i++) {
+        Clock_Params_init(&clkParams);
+        clkParams.period = 0;
+        clkParams.startFlag = FALSE;
+        clkParams.arg = TRIGGER_DEBOUNCE(i);
+        Clock_construct(&state[i].debounceClock, (Clock_FuncPtr)buttonsClkFxn, 1, &clkParams);
+        clkParams.arg = TRIGGER_GESTURE(i);
+        Clock_construct(&state[i].gestureClock, (Clock_FuncPtr)buttonsClkFxn, 1, &clkParams);
+    }
+}
+
+/*******************************************************************************
+ * @fn          buttonsPinFxn
+ *
+ * @brief       PIN interrupt callback of the buttons
+ *
+ * @descr       Top half: only timestamps the edge, the level is read after
+ *              the debounce.
+ *
+ * @return      -
+ */
+void buttonsPinFxn(PIN_Handle handle, PIN_Id pinId)
+{
+    ButtonEdge *edge;
+
+    stats.edges++;
+    if ((uint8_t)(ringHead - ringTail) >= EDGE_RING_LENGTH) {
+        stats.overruns++;
+        return;
+    }
+    edge = &ring[ringHead % EDGE_RING_LENGTH];
+    edge->pin = pinId;
+    edge->tick = Clock_getTicks();
+    ringHead++;
+    Swi_or(hSwi, TRIGGER_EDGES);
+}
+
+/*******************************************************************************
+ * @fn          buttonsGetStats
+ *
+ * @brief       Copy the edge statistics
+ *
+ * @return      -
+ */
+void buttonsGetStats(ButtonStats *out)
+{
+    UInt key = Hwi_disable();
+    *out = stats;
+    Hwi_restore(key);
+}
@@ -0,0 +1,60 @@
+/** ============================================================================
+ *  @file       buttons.h
+ *
+ *  @brief      Button gesture engine.
+ *
+ *  The PIN interrupt callback only timestamps the edge and puts it in a
+ *  ring buffer. A Swi takes the edges from the ring and runs a gesture
+ *  state machine per button. Debouncing, long press, double tap and
+ *  hold-repeat are timed with one-shot Clocks, so nothing polls and the
+ *  CPU only wakes on edges and on the gesture deadlines.
+ *  ============================================================================
+ */
+#ifndef _BUTTONS_H_
+#define _BUTTONS_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include "Board.h"
+#include "events.h"
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+#define BUTTONS_MAX         2
+// Leave a gesture unused
+#define BUTTON_NO_EVENT     EVENT_COUNT
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    PIN_Id pin;
+    EventType shortPush;    // released before longPushMs
+    EventType longPush;     // posted while still held
+    EventType doubleTap;    // second push within doubleTapMs of the release
+    EventType holdRepeat;   // every repeatMs after the long push, arg counts up
+    uint16_t debounceMs;    // the level must be stable this long
+    uint16_t longPushMs;
+    uint16_t doubleTapMs;
+    uint16_t repeatMs;
+} ButtonConfig;
+
+typedef struct {
+    uint32_t edges;         // edges captured by the interrupt
+    uint32_t overruns;      // edges lost because the ring was full
+    uint32_t bounces;       // edges that did not change the debounced level
+} ButtonStats;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void buttonsOpen(const ButtonConfig *config, uint8_t count);
+void buttonsPinFxn(PIN_Handle handle, PIN_Id pinId);
+void buttonsGetStats(ButtonStats *stats);
+
+#endif
@@ -0,0 +1,124 @@
+/** ============================================================================
+ *  @file       calib.c
+ *
+ *  @brief      MPU9250 calibration kept in the external flash.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <string.h>
+
+#include <xdc/std.h>
+
+#include "calib.h"
+#include "extflash.h"
+#include "serial.h"
+
+/* -----------------------------------------------------------------------------
+*  Constants
+* ------------------------------------------------------------------------------
+*/
+#define CALIB_MAGIC             0x4C414331  // "CAL1"
+#define CALIB_ERASED            0xFFFFFFFF
+
+/* -----------------------------------------------------------------------------
+*  Local types
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t crc;           // CRC-16/CCITT-FALSE of the calibration
+    Mpu9250Calibration calibration;
+} CalibRecord;
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+static uint16_t calibCrc(const Mpu9250Calibration *calibration)
+{
+    return serialCrc16(0xFFFF, (const uint8_t *)calibration, sizeof(*calibration));
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          calibLoad
+ *
+ * @brief       Read the newest saved calibration
+ *
+ * @descr       Call from a task.
+ *
+ * @return      1 if a valid calibration was found
+ */
+int calibLoad(Mpu9250Calibration *calibration)
+{
+    CalibRecord record;
+    int found = 0;
+    int i;
+
+    if (!extflashOpen()) {
+        return 0;
+    }
+    for (i = 0; i < CALIB_SLOTS; i++) {
+        extflashRead(CALIB_ADDRESS + i * CALIB_SLOT_SIZE, &record, sizeof(record));
+        if (record.magic == CALIB_ERASED) {
+            break;
+        }
+        if (record.magic == CALIB_MAGIC && record.version == CALIB_VERSION &&
+            record.crc == calibCrc(&record.calibration)) {
+            *calibration = record.calibration;
+            found = 1;
+        }
+    }
+    return found;
+}
+
+/*******************************************************************************
+ * @fn          calibSave
+ *
+ * @brief       Save a calibration after the earlier ones
+ *
+ * @descr       Call from a task. Waits for the flash, up to an erase.
+ *
+ * @return      1 if saved
+ */
+int calibSave(const Mpu9250Calibration *calibration)
+{
+    CalibRecord record;
+    uint32_t magic;
+    int i;
+
+    if (!extflashOpen()) {
+        return 0;
+    }
+    // The first blank slot, or a fresh sector when there is none
+    for (i = 0; i < CALIB_SLOTS; i++) {
+        extflashRead(CALIB_ADDRESS + i * CALIB_SLOT_SIZE, &magic, sizeof(magic));
+        if (magic == CALIB_ERASED) {
+            break;
+        }
+    }
+    if (i == CALIB_SLOTS) {
+        extflashErase(CALIB_ADDRESS);
+        i = 0;
+    }
+
+    memset(&record, 0xFF, sizeof(record));
+    record.magic = CALIB_MAGIC;
+    record.version = CALIB_VERSION;
+    record.calibration = *calibration;
+    record.crc = calibCrc(calibration);
+    extflashProgram(CALIB_ADDRESS + i * CALIB_SLOT_SIZE, &record, sizeof(record));
+
+    // Read back once the program is done
+    extflashRead(CALIB_ADDRESS + i * CALIB_SLOT_SIZE, &record, sizeof(record));
+    return record.magic == CALIB_MAGIC && record.crc == calibCrc(calibration);
+}
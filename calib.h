@@ -0,0 +1,46 @@
+/** ============================================================================
+ *  @file       calib.h
+ *
+ *  @brief      MPU9250 calibration kept in the external flash.
+ *
+ *  The self test and the bias measurement of mpu9250_setup take most of
+ *  the boot. Their results are saved once and reused at the next boots,
+ *  as long as the die temperature is close to the one they were measured
+ *  at. The records are appended to one sector below the flash log, so the
+ *  sector is erased only every CALIB_SLOTS saves. A record is valid when
+ *  its magic, version and CRC match, the newest valid one is used.
+ *  ============================================================================
+ */
+#ifndef _CALIB_H_
+#define _CALIB_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+#include "sensors/mpu9250.h"
+#include "flashlog_format.h"
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+// The last sector before the flash log
+#define CALIB_ADDRESS           (FLASHLOG_BASE - FLASHLOG_SECTOR_SIZE)
+#define CALIB_SLOT_SIZE         128
+#define CALIB_SLOTS             (FLASHLOG_SECTOR_SIZE / CALIB_SLOT_SIZE)
+
+// Bump when Mpu9250Calibration changes, older records are then ignored
+#define CALIB_VERSION           1
+
+// A calibration is redone when the die is this much warmer or colder, C
+#define CALIB_MAX_TEMP_DELTA    10.0
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+int calibLoad(Mpu9250Calibration *calibration);
+int calibSave(const Mpu9250Calibration *calibration);
+
+#endif
@@ -0,0 +1,318 @@
+/** ============================================================================
+ *  @file       console.c
+ *
+ *  @brief      Binary command console on the serial port.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <string.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include "console.h"
+#include "serial.h"
+#include "params.h"
+#include "events.h"
+#include "stream.h"
+#include "flashlog.h"
+#include "calib.h"
+#include "cycles.h"
+#include "binlog.h"
+
+/* -----------------------------------------------------------------------------
+*  Constants
+* ------------------------------------------------------------------------------
+*/
+// Room for the longest results, CONSOLE_GET_CALIBRATION
+#define CONSOLE_MAX_REPLY   64
+
+// Polled until the UART task has opened the serial port
+#define CONSOLE_WAIT_MS     100
+
+// A reply is retried once per ms while the transmit ring is full
+#define CONSOLE_SEND_TRIES  50
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static const ConsoleBenchFxn *benchFxns = NULL;
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+static uint8_t *put16(uint8_t *p, uint16_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t value)
+{
+    put16(p, value);
+    return put16(p + 2, value >> 16);
+}
+
+static uint8_t *putFloat(uint8_t *p, float value)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    return put32(p, bits);
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static float getFloat(const uint8_t *p)
+{
+    uint32_t bits = get16(p) | ((uint32_t)get16(p + 2) << 16);
+    float value;
+
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint8_t *getStats(uint8_t *p)
+{
+    SerialStats serial;
+    EventStats events;
+    StreamStats stream;
+    FlashlogStats flash;
+
+    serialGetStats(&serial);
+    eventGetStats(&events);
+    streamGetStats(&stream);
+    flashlogGetStats(&flash);
+
+    p = put32(p, Clock_getTicks());
+    p = put32(p, serial.dropped);
+    p = put32(p, serial.bad);
+    p = put32(p, events.handled);
+    p = put32(p, events.dropped);
+    p = put32(p, events.maxLatencyUs);
+    p = put32(p, stream.sent);
+    p = put32(p, stream.dropped);
+    p = put32(p, flash.written);
+    return put32(p, flash.dropped);
+}
+
+static uint8_t *getParam(uint8_t *p, ParamId id)
+{
+    float min, max;
+
+    paramRange(id, &min, &max);
+    *p++ = id;
+    p = putFloat(p, paramGet(id));
+    p = putFloat(p, min);
+    return putFloat(p, max);
+}
+
+static uint8_t *getCalibration(uint8_t *p, const Mpu9250Calibration *calibration)
+{
+    int i;
+
+    p = putFloat(p, calibration->temperature);
+    for (i = 0; i < 6; i++) {
+        p = putFloat(p, calibration->selfTest[i]);
+    }
+    for (i = 0; i < 3; i++) {
+        p = putFloat(p, calibration->gyroBias[i]);
+    }
+    for (i = 0; i < 3; i++) {
+        p = putFloat(p, calibration->accelBias[i]);
+    }
+    return p;
+}
+
+// Each run is measured alone, runs that span a restart of the counter are left out
+static uint8_t *bench(uint8_t *p, ConsoleBench id, uint16_t count)
+{
+    uint32_t min = 0xFFFFFFFF, max = 0, cycles, start, epoch;
+    uint64_t total = 0;
+    uint16_t runs = 0;
+    uint16_t i;
+
+    for (i = 0; i < count; i++) {
+        if (!cyclesRunning()) {
+            cyclesStart();
+        }
+        epoch = cyclesEpoch;
+        start = cyclesNow();
+        benchFxns[id]();
+        cycles = cyclesNow() - start;
+        if (!cyclesRunning() || epoch != cyclesEpoch) {
+            continue;
+        }
+        runs++;
+        total += cycles;
+        if (cycles < min) {
+            min = cycles;
+        }
+        if (cycles > max) {
+            max = cycles;
+        }
+    }
+
+    *p++ = id;
+    p = put16(p, runs);
+    p = put32(p, runs ? min : 0);
+    p = put32(p, runs ? total / runs : 0);
+    return put32(p, max);
+}
+
+// Runs one command, the results go after the reply header
+static ConsoleStatus execute(const uint8_t *args, int length, uint8_t cmd, uint8_t **results)
+{
+    Mpu9250Calibration calibration;
+    uint8_t *p = *results;
+    uint16_t count;
+
+    switch (cmd) {
+    case CONSOLE_PING:
+        if (length != 0) {
+            return CONSOLE_BAD_LENGTH;
+        }
+        *p++ = CONSOLE_VERSION;
+        p = put32(p, Clock_getTicks());
+        break;
+    case CONSOLE_GET_STATS:
+        if (length != 0) {
+            return CONSOLE_BAD_LENGTH;
+        }
+        p = getStats(p);
+        break;
+    case CONSOLE_GET_PARAM:
+        if (length != 1) {
+            return CONSOLE_BAD_LENGTH;
+        }
+        if (args[0] >= PARAM_COUNT) {
+            return CONSOLE_BAD_ARGUMENT;
+        }
+        p = getParam(p, (ParamId)args[0]);
+        break;
+    case CONSOLE_SET_PARAM:
+        if (length != 5) {
+            return CONSOLE_BAD_LENGTH;
+        }
+        if (args[0] >= PARAM_COUNT || !paramSet((ParamId)args[0], getFloat(args + 1))) {
+            return CONSOLE_BAD_ARGUMENT;
+        }
+        LOG2(LOG_PARAM_SET, args[0], binlogFloat(paramGet((ParamId)args[0])));
+        *p++ = args[0];
+        p = putFloat(p, paramGet((ParamId)args[0]));
+        break;
+    case CONSOLE_SELF_TEST:
+        if (length != 0) {
+            return CONSOLE_BAD_LENGTH;
+        }
+        if (!eventPost(EVENT_CALIBRATE, 0)) {
+            return CONSOLE_FAILED;
+        }
+        break;
+    case CONSOLE_GET_CALIBRATION:
+        if (length != 0) {
+            return CONSOLE_BAD_LENGTH;
+        }
+        if (!calibLoad(&calibration)) {
+            return CONSOLE_FAILED;
+        }
+        p = getCalibration(p, &calibration);
+        break;
+    case CONSOLE_BENCH:
+        if (length != 3) {
+            return CONSOLE_BAD_LENGTH;
+        }
+        count = get16(args + 1);
+        if (args[0] >= CONSOLE_BENCH_COUNT || count == 0 || count > CONSOLE_MAX_BENCH_COUNT ||
+            benchFxns == NULL || benchFxns[args[0]] == NULL) {
+            return CONSOLE_BAD_ARGUMENT;
+        }
+        p = bench(p, (ConsoleBench)args[0], count);
+        break;
+    case CONSOLE_STREAM:
+        if (length != 1) {
+            return CONSOLE_BAD_LENGTH;
+        }
+        if (!eventPost(EVENT_STREAM, args[0] != 0)) {
+            return CONSOLE_FAILED;
+        }
+        break;
+    default:
+        return CONSOLE_UNKNOWN;
+    }
+    *results = p;
+    return CONSOLE_OK;
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          consoleOpen
+ *
+ * @brief       Set the benchmarks up
+ *
+ * @descr       The table is indexed by ConsoleBench and must stay valid, a
+ *              NULL entry is a benchmark the application does not have.
+ *
+ * @return      -
+ */
+void consoleOpen(const ConsoleBenchFxn *benches)
+{
+    benchFxns = benches;
+}
+
+/*******************************************************************************
+ * @fn          consoleTaskFxn
+ *
+ * @brief       Console task, answers the commands from the serial port
+ *
+ * @descr       Runs until reset. Benchmarks run at the priority of this
+ *              task, keep it at or below the sensor task.
+ *
+ * @return      -
+ */
+Void consoleTaskFxn(UArg arg0, UArg arg1)
+{
+    uint8_t frame[CONSOLE_MAX_FRAME];
+    uint8_t reply[CONSOLE_MAX_REPLY];
+    uint8_t *results;
+    int length;
+    int tries;
+
+    while (1) {
+        length = serialReceive(frame, sizeof(frame));
+        if (length == 0) {
+            Task_sleep(CONSOLE_WAIT_MS * 1000 / Clock_tickPeriod);
+            continue;
+        }
+        // cmd and tag at least, other frame types are not for us
+        if (frame[0] != SERIAL_FRAME_COMMAND || length < 3) {
+            continue;
+        }
+        reply[0] = frame[1];
+        reply[1] = frame[2];
+        results = reply + CONSOLE_REPLY_HEADER;
+        reply[2] = execute(frame + 3, length - 3, frame[1], &results);
+        // A reply is worth waiting for, the stream may fill the ring
+        for (tries = 0; tries < CONSOLE_SEND_TRIES; tries++) {
+            if (serialSend(SERIAL_FRAME_REPLY, reply, results - reply)) {
+                break;
+            }
+            Task_sleep(1000 / Clock_tickPeriod);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+/** ============================================================================
+ *  @file       console.h
+ *
+ *  @brief      Binary command console on the serial port.
+ *
+ *  A task of its own reads command frames from the host and answers each
+ *  with a reply frame, see console_format.h for the protocol and
+ *  host/console for a command line client. Parameters are changed in
+ *  params.h, anything owned by the state machine goes there as an event.
+ *  ============================================================================
+ */
+#ifndef _CONSOLE_H_
+#define _CONSOLE_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+#include <xdc/std.h>
+#include "console_format.h"
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+// Longest command frame, type byte included
+#define CONSOLE_MAX_FRAME   32
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+// One run of a benchmark
+typedef void (*ConsoleBenchFxn)(void);
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void consoleOpen(const ConsoleBenchFxn *benches);
+Void consoleTaskFxn(UArg arg0, UArg arg1);
+
+#endif
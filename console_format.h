@@ -0,0 +1,94 @@
+/** ============================================================================
+ *  @file       console_format.h
+ *
+ *  @brief      Binary command protocol of the serial console, shared with
+ *              host/console.
+ *
+ *  The host sends a SERIAL_FRAME_COMMAND frame (see serial.h) and gets
+ *  one SERIAL_FRAME_REPLY frame back per command:
+ *      command:  cmd u8, tag u8, arguments
+ *      reply:    cmd u8, tag u8, status u8, results
+ *  The tag is chosen by the host and echoed, so a script can match the
+ *  replies to its commands. Results follow only with CONSOLE_OK. All
+ *  fields are little endian.
+ *
+ *  Command                 Arguments               Results
+ *  CONSOLE_PING            -                       version u8, tick u32
+ *  CONSOLE_GET_STATS       -                       u32 x CONSOLE_STAT_COUNT
+ *  CONSOLE_GET_PARAM       param u8                param u8, value, min, max float
+ *  CONSOLE_SET_PARAM       param u8, value float   param u8, value float
+ *  CONSOLE_SELF_TEST       -                       -
+ *  CONSOLE_GET_CALIBRATION -                       temperature float, selfTest float x 6,
+ *                                                  gyroBias float x 3, accelBias float x 3
+ *  CONSOLE_BENCH           bench u8, count u16     bench u8, count u16,
+ *                                                  min, average, max cycles u32
+ *  CONSOLE_STREAM          on u8                   -
+ *
+ *  The parameters are listed in params.h. CONSOLE_SELF_TEST runs the MPU
+ *  self test and calibration in the sensor task, the device must lie
+ *  still; CONSOLE_GET_CALIBRATION reads the result once it is saved.
+ *  CONSOLE_BENCH runs a benchmark count times back to back and measures
+ *  each run in CPU cycles (48 per us).
+ *  ============================================================================
+ */
+#ifndef _CONSOLE_FORMAT_H_
+#define _CONSOLE_FORMAT_H_
+
+#define CONSOLE_VERSION         1
+#define CONSOLE_REPLY_HEADER    3
+#define CONSOLE_MAX_BENCH_COUNT 1000
+
+typedef enum {
+    CONSOLE_PING = 0,
+    CONSOLE_GET_STATS,
+    CONSOLE_GET_PARAM,
+    CONSOLE_SET_PARAM,
+    CONSOLE_SELF_TEST,
+    CONSOLE_GET_CALIBRATION,
+    CONSOLE_BENCH,
+    CONSOLE_STREAM,
+    CONSOLE_COMMAND_COUNT
+} ConsoleCommand;
+
+typedef enum {
+    CONSOLE_OK = 0,
+    CONSOLE_UNKNOWN,        // no such command
+    CONSOLE_BAD_LENGTH,     // wrong number of argument bytes
+    CONSOLE_BAD_ARGUMENT,   // e.g. a parameter out of its range
+    CONSOLE_FAILED          // the device could not do it, e.g. no calibration saved
+} ConsoleStatus;
+
+// The CONSOLE_GET_STATS results, in order
+#define CONSOLE_STATS(X) \
+    X(CONSOLE_STAT_TICK)                /* Clock ticks since boot, 10 us */ \
+    X(CONSOLE_STAT_SERIAL_DROPPED)      /* frames the transmit ring had no room for */ \
+    X(CONSOLE_STAT_SERIAL_BAD)          /* received frames with a bad CRC */ \
+    X(CONSOLE_STAT_EVENTS_HANDLED) \
+    X(CONSOLE_STAT_EVENTS_DROPPED) \
+    X(CONSOLE_STAT_EVENT_MAX_LATENCY)   /* us */ \
+    X(CONSOLE_STAT_STREAM_SENT) \
+    X(CONSOLE_STAT_STREAM_DROPPED) \
+    X(CONSOLE_STAT_FLASH_WRITTEN)       /* flash log pages */ \
+    X(CONSOLE_STAT_FLASH_DROPPED)       /* flash log records */
+
+// Benchmarks, implemented by the application, see consoleOpen
+#define CONSOLE_BENCHES(X) \
+    X(CONSOLE_BENCH_FILTER)             /* filterSample of one axis */ \
+    X(CONSOLE_BENCH_DERIVATES)          /* detectSlide of one derivate */ \
+    X(CONSOLE_BENCH_WINDOW)             /* detectSample with the window full */ \
+    X(CONSOLE_BENCH_FORMAT)             /* sprintf of a motion message */ \
+    X(CONSOLE_BENCH_CRC)                /* serialCrc16 of 64 bytes */
+
+#define CONSOLE_ENUM(id) id,
+typedef enum {
+    CONSOLE_STATS(CONSOLE_ENUM)
+    CONSOLE_STAT_COUNT
+} ConsoleStat;
+
+typedef enum {
+    CONSOLE_BENCHES(CONSOLE_ENUM)
+    CONSOLE_BENCH_COUNT
+} ConsoleBench;
+#undef CONSOLE_ENUM
+
+#endif
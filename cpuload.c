@@ -0,0 +1,296 @@
+/** ============================================================================
+ *  @file       cpuload.c
+ *
+ *  @brief      Per-task and per-interrupt CPU time accounting.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "cpuload.h"
+#include "cycles.h"
+#include "events.h"
+
+/* -----------------------------------------------------------------------------
+*  Constants
+* ------------------------------------------------------------------------------
+*/
+// Bucket layout: registered tasks, other tasks, Swis, registered interrupts, other interrupts
+#define BUCKET_IDLE         CPULOAD_MAX_TASKS
+#define BUCKET_SWI          (CPULOAD_MAX_TASKS + 1)
+#define BUCKET_ISR(i)       (CPULOAD_MAX_TASKS + 2 + (i))
+#define BUCKET_ISR_OTHER    BUCKET_ISR(CPULOAD_MAX_ISRS)
+#define BUCKET_COUNT        (BUCKET_ISR_OTHER + 1)
+
+// Swis and interrupts that can be nested
+#define NEST_MAX            8
+
+// Interrupt control and state register, VECTACTIVE is the running vector
+#define ICSR                (*(volatile uint32_t *)0xE000ED04)
+#define ICSR_VECTACTIVE     0x1FF
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static Task_Handle tasks[CPULOAD_MAX_TASKS];
+static int isrs[CPULOAD_MAX_ISRS];
+static uint8_t taskCount = 0;
+static uint8_t isrCount = 0;
+static const char *names[BUCKET_COUNT];
+
+// Only touched with interrupts disabled
+static uint32_t cycles[BUCKET_COUNT];
+static uint32_t lastCycles = 0;
+static uint32_t lastEpoch = 0;          // of cyclesEpoch, when lastCycles was read
+static uint32_t windowStartTick = 0;
+static uint8_t current = BUCKET_IDLE;
+static uint8_t nest[NEST_MAX];
+static uint8_t depth = 0;
+
+static Clock_Struct clockStruct;
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+// Charges the cycles since the last call to the running bucket and switches to next
+static void cpuloadCharge(uint8_t next)
+{
+    uint32_t now;
+
+    if (!cyclesRunning()) {
+        // Lost in standby, the slice before it cannot be measured
+        cyclesStart();
+    }
+    if (lastEpoch != cyclesEpoch) {
+        // Restarted, here or by a probe or the console first
+        lastEpoch = cyclesEpoch;
+        lastCycles = 0;
+    }
+    now = cyclesNow();
+    cycles[current] += now - lastCycles;
+    lastCycles = now;
+    current = next;
+}
+
+static void cpuloadEnter(uint8_t bucket)
+{
+    if (depth < NEST_MAX) {
+        nest[depth] = current;
+    }
+    depth++;
+    cpuloadCharge(bucket);
+}
+
+static void cpuloadLeave(void)
+{
+    if (depth == 0) {
+        return;
+    }
+    depth--;
+    cpuloadCharge(depth < NEST_MAX ? nest[depth] : current);
+}
+
+static uint8_t cpuloadTaskBucket(Task_Handle task)
+{
+    uint8_t i;
+
+    for (i = 0; i < taskCount; i++) {
+        if (tasks[i] == task) {
+            return i;
+        }
+    }
+    return BUCKET_IDLE;
+}
+
+static uint8_t cpuloadIsrBucket(int intNum)
+{
+    uint8_t i;
+
+    for (i = 0; i < isrCount; i++) {
+        if (isrs[i] == intNum) {
+            return BUCKET_ISR(i);
+        }
+    }
+    return BUCKET_ISR_OTHER;
+}
+
+// Clock function, the report itself is made by the state machine task
+static Void cpuloadClkFxn(UArg arg0)
+{
+    eventPost(EVENT_LOAD_REPORT, 0);
+}
+
+/* -----------------------------------------------------------------------------
+*  Kernel hooks
+* ------------------------------------------------------------------------------
+*/
+void cpuloadTaskSwitch(Task_Handle prev, Task_Handle next)
+{
+    UInt key = Hwi_disable();
+    cpuloadCharge(cpuloadTaskBucket(next));
+    Hwi_restore(key);
+}
+
+void cpuloadSwiBegin(Swi_Handle swi)
+{
+    UInt key = Hwi_disable();
+    cpuloadEnter(BUCKET_SWI);
+    Hwi_restore(key);
+}
+
+void cpuloadSwiEnd(Swi_Handle swi)
+{
+    UInt key = Hwi_disable();
+    cpuloadLeave();
+    Hwi_restore(key);
+}
+
+void cpuloadHwiBegin(Hwi_Handle hwi)
+{
+    UInt key = Hwi_disable();
+    cpuloadEnter(cpuloadIsrBucket(ICSR & ICSR_VECTACTIVE));
+    Hwi_restore(key);
+}
+
+void cpuloadHwiEnd(Hwi_Handle hwi)
+{
+    UInt key = Hwi_disable();
+    cpuloadLeave();
+    Hwi_restore(key);
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          cpuloadOpen
+ *
+ * @brief       Start the accounting and post EVENT_LOAD_REPORT periodically
+ *
+ * @descr       Call before BIOS_start. A period of 0 leaves the reports to
+ *              the application.
+ *
+ * @return      -
+ */
+void cpuloadOpen(uint32_t reportPeriodMs)
+{
+    Clock_Params clkParams;
+    uint32_t ticks = reportPeriodMs * (1000 / Clock_tickPeriod);
+
+    names[BUCKET_IDLE] = "idle";
+    names[BUCKET_SWI] = "swi";
+    names[BUCKET_ISR_OTHER] = "isr";
+    memset(cycles, 0, sizeof(cycles));
+    cyclesStart();
+    lastEpoch = cyclesEpoch;
+    lastCycles = cyclesNow();
+    windowStartTick = Clock_getTicks();
+
+    if (ticks == 0) {
+        return;
+    }
+    if (reportPeriodMs > CPULOAD_MAX_PERIOD_MS) {
+        System_abort("CPU load report period too long");
+    }
+    Clock_Params_init(&clkParams);
+    clkParams.period = ticks;
+    clkParams.startFlag = TRUE;
+    Clock_construct(&clockStruct, (Clock_FuncPtr)cpuloadClkFxn, ticks, &clkParams);
+}
+
+/*******************************************************************************
+ * @fn          cpuloadAddTask
+ *
+ * @brief       Give a task its own share, other tasks count as idle
+ *
+ * @return      -
+ */
+void cpuloadAddTask(Task_Handle task, const char *name)
+{
+    if (taskCount == CPULOAD_MAX_TASKS) {
+        System_abort("Too many accounted tasks");
+    }
+    tasks[taskCount] = task;
+    names[taskCount] = name;
+    taskCount++;
+}
+
+/*******************************************************************************
+ * @fn          cpuloadAddIsr
+ *
+ * @brief       Give an interrupt its own share, other interrupts count as isr
+ *
+ * @descr       intNum is the vector number, e.g. INT_RFC_CPE_0.
+ *
+ * @return      -
+ */
+void cpuloadAddIsr(int intNum, const char *name)
+{
+    if (isrCount == CPULOAD_MAX_ISRS) {
+        System_abort("Too many accounted interrupts");
+    }
+    isrs[isrCount] = intNum;
+    names[BUCKET_ISR(isrCount)] = name;
+    isrCount++;
+}
+
+/*******************************************************************************
+ * @fn          cpuloadReport
+ *
+ * @brief       Format the shares of the window since the previous report
+ *
+ * @descr       "sensor:12;uart:3;...;sleep:900", per mille of the wall clock
+ *              time. Starts a new window.
+ *
+ * @return      Length of the report, it is cut to fit in size
+ */
+int cpuloadReport(char *buf, int size)
+{
+    uint32_t snapshot[BUCKET_COUNT];
+    uint64_t wall;
+    uint64_t busy = 0;
+    uint32_t now;
+    int length = 0;
+    uint8_t i;
+    UInt key;
+
+    key = Hwi_disable();
+    cpuloadCharge(current);
+    memcpy(snapshot, cycles, sizeof(snapshot));
+    memset(cycles, 0, sizeof(cycles));
+    now = Clock_getTicks();
+    wall = (uint64_t)(now - windowStartTick) * Clock_tickPeriod * CYCLES_PER_US;
+    windowStartTick = now;
+    Hwi_restore(key);
+
+    if (wall == 0) {
+        wall = 1;
+    }
+    buf[0] = 0;
+    for (i = 0; i < BUCKET_COUNT && length < size; i++) {
+        if (names[i] == NULL) {
+            continue;
+        }
+        busy += snapshot[i];
+        length += snprintf(buf + length, size - length, "%s:%lu;", names[i],
+                           (unsigned long)((uint64_t)snapshot[i] * 1000 / wall));
+    }
+    if (length < size) {
+        length += snprintf(buf + length, size - length, "sleep:%lu",
+                           (unsigned long)(busy < wall ? (wall - busy) * 1000 / wall : 0));
+    }
+    return length < size ? length : size - 1;
+}
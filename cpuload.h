@@ -0,0 +1,48 @@
+/** ============================================================================
+ *  @file       cpuload.h
+ *
+ *  @brief      Per-task and per-interrupt CPU time accounting.
+ *
+ *  Task switch, Hwi and Swi hooks (see empty.cfg) charge the cycles since
+ *  the previous hook to whatever was running: a task, an interrupt or the
+ *  Swis. Time the CPU spent asleep is the rest of the wall clock time.
+ *  The shares are reported per window, in per mille.
+ *  ============================================================================
+ */
+#ifndef _CPULOAD_H_
+#define _CPULOAD_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Swi.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+#define CPULOAD_MAX_TASKS   4
+#define CPULOAD_MAX_ISRS    4
+// The cycle counts are 32 bits, a window must stay under 89 s at 48 MHz
+#define CPULOAD_MAX_PERIOD_MS 60000
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void cpuloadOpen(uint32_t reportPeriodMs);
+void cpuloadAddTask(Task_Handle task, const char *name);
+void cpuloadAddIsr(int intNum, const char *name);
+int cpuloadReport(char *buf, int size);
+
+// Kernel hooks, installed in empty.cfg
+void cpuloadTaskSwitch(Task_Handle prev, Task_Handle next);
+void cpuloadSwiBegin(Swi_Handle swi);
+void cpuloadSwiEnd(Swi_Handle swi);
+void cpuloadHwiBegin(Hwi_Handle hwi);
+void cpuloadHwiEnd(Hwi_Handle hwi);
+
+#endif
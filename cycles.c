@@ -0,0 +1,38 @@
+/** ============================================================================
+ *  @file       cycles.c
+ *
+ *  @brief      CPU cycle counter of the Cortex-M3 (DWT CYCCNT).
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include "cycles.h"
+
+/* -----------------------------------------------------------------------------
+*  Global variables
+* ------------------------------------------------------------------------------
+*/
+volatile uint32_t cyclesEpoch = 0;
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          cyclesStart
+ *
+ * @brief       Enable the trace block and start the counter from zero
+ *
+ * @return      -
+ */
+void cyclesStart(void)
+{
+    CYCLES_DEMCR |= CYCLES_DEMCR_TRCENA;
+    CYCLES_DWT_CYCCNT = 0;
+    CYCLES_DWT_CTRL |= CYCLES_CYCCNTENA;
+    cyclesEpoch++;
+}
@@ -0,0 +1,59 @@
+/** ============================================================================
+ *  @file       cycles.h
+ *
+ *  @brief      CPU cycle counter of the Cortex-M3 (DWT CYCCNT).
+ *
+ *  The counter runs at the CPU clock (48 MHz) and stops while the CPU
+ *  sleeps. The debug block loses its settings in standby, so callers check
+ *  cyclesRunning() and restart the counter when it has stopped. Each restart
+ *  bumps cyclesEpoch.
+ *  ============================================================================
+ */
+#ifndef _CYCLES_H_
+#define _CYCLES_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+#define CYCLES_PER_US       48
+
+#ifdef SIM_HOST
+// host/sim keeps the registers in variables and counts the virtual time
+extern volatile uint32_t simDemcr, simDwtCtrl, simDwtCyccnt;
+#define CYCLES_DEMCR        simDemcr
+#define CYCLES_DWT_CTRL     simDwtCtrl
+#define CYCLES_DWT_CYCCNT   simDwtCyccnt
+#else
+#define CYCLES_DEMCR        (*(volatile uint32_t *)0xE000EDFC)
+#define CYCLES_DWT_CTRL     (*(volatile uint32_t *)0xE0001000)
+#define CYCLES_DWT_CYCCNT   (*(volatile uint32_t *)0xE0001004)
+#endif
+#define CYCLES_DEMCR_TRCENA 0x01000000
+#define CYCLES_CYCCNTENA    0x00000001
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+// Counts the (re)starts of the counter, a measurement that spans one is void
+extern volatile uint32_t cyclesEpoch;
+
+void cyclesStart(void);
+
+static inline int cyclesRunning(void)
+{
+    return (CYCLES_DWT_CTRL & CYCLES_CYCCNTENA) != 0;
+}
+
+static inline uint32_t cyclesNow(void)
+{
+    return CYCLES_DWT_CYCCNT;
+}
+
+#endif
@@ -0,0 +1,267 @@
+/** ============================================================================
+ *  @file       detect.c
+ *
+ *  @brief      Exercise and petting detection from the MPU samples.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <math.h>
+#include <string.h>
+
+#include "detect.h"
+#include "probe.h"
+
+/* -----------------------------------------------------------------------------
+*  Global variables
+* ------------------------------------------------------------------------------
+*/
+// The coefficients of DETECT_FILTER, computed by the compiler
+const Biquad detectSections[DETECT_SECTIONS] = {
+    DETECT_FILTER(FILTER_SECTION)
+};
+
+/* -----------------------------------------------------------------------------
+*  Local Functions
+* ------------------------------------------------------------------------------
+*/
+// A threshold of an axis, raised to the noise floor
+static float limit(float threshold, const DetectConfig *config, int axis)
+{
+    return threshold > config->floor[axis] ? threshold : config->floor[axis];
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          detectReset
+ *
+ * @brief       Empty the window
+ *
+ * @return      -
+ */
+void detectReset(Detector *detector)
+{
+    memset(detector, 0, sizeof(*detector));
+    detectTriggerReset(&detector->trigger);
+}
+
+/*******************************************************************************
+ * @fn          detectSample
+ *
+ * @brief       Add a sample and check the window
+ *
+ * @descr       The window is checked once it is full, that is with every
+ *              sample from the DETECT_WINDOW:th after a reset on. The first
+ *              sample settles the filters. The rhythm follows every sample.
+ *              With DETECT_EXERCISE the frequency of the exercise is set,
+ *              with DETECT_EXERCISE_END its reps.
+ *
+ * @return      DETECT_EXERCISE, DETECT_PET and DETECT_EXERCISE_END as detected
+ */
+int detectSample(Detector *detector, float time, const float motion[6], const DetectConfig *config)
+{
+    int result = 0;
+    int rhythmic;
+    float value;
+    int i;
+
+    rhythmic = rhythmSample(&detector->rhythm, motion, config->samplePeriod, config->rhythmAmplitude,
+                            config->rhythmPurity);
+
+    if (detector->samples == 0) {
+        for (i = 0; i < 6; i++) {
+            detector->filtered[i] = filterStart(detectSections, DETECT_SECTIONS, detector->filters[i], motion[i]);
+        }
+        detector->samples++;
+        return 0;
+    }
+
+    // Smoothed, the derivates of this sample into the window
+    for (i = 0; i < 6; i++) {
+        value = filterSample(detectSections, DETECT_SECTIONS, detector->filters[i], motion[i]);
+        PROBE_START(PROBE_DERIVATES);
+        detectSlide(detector->derivates[i], DETECT_SLOPES, detector->index,
+                    fabsf(value - detector->filtered[i]) / config->samplePeriod, &detector->sums[i]);
+        PROBE_STOP(PROBE_DERIVATES);
+        detector->filtered[i] = value;
+    }
+    detector->times[detector->index] = time;
+    detector->index = detector->index == DETECT_SLOPES - 1 ? 0 : detector->index + 1;
+
+    if (detector->samples < DETECT_WINDOW - 1) {
+        detector->samples++;
+        return 0;
+    }
+
+    // Average derivates, and of the last samples
+    for (i = 0; i < 6; i++) {
+        detector->averages[i] = detector->sums[i].window / DETECT_SLOPES;
+    }
+    for (i = 0; i < 3; i++) {
+        detector->recent[i] = detector->sums[i].recent / DETECT_RECENT;
+    }
+
+    // The gestures that start now
+    result = detectTrigger(&detector->trigger, time, detector->averages, detector->recent, rhythmic, config);
+
+    // The reps count from the first crossing in the rhythm window
+    if (result & DETECT_EXERCISE) {
+        detector->repSignal = detector->rhythm.signal;
+        detector->repStart = detector->rhythm.crossings[detector->repSignal] -
+                             rhythmWindowCrossings(&detector->rhythm, detector->repSignal);
+        detector->frequency = rhythmFrequency(&detector->rhythm);
+    }
+    if (result & DETECT_EXERCISE_END) {
+        detector->reps = detector->rhythm.crossings[detector->repSignal] - detector->repStart;
+    }
+    return result;
+}
+
+/*******************************************************************************
+ * @fn          detectNoiseGain
+ *
+ * @brief       Noise gain of the smoothing and the difference
+ *
+ * @descr       Of detectSections, computed at the first call.
+ *
+ * @return      The standard deviation of the change of a smoothed axis from
+ *              sample to sample, per that of the noise of the axis
+ */
+float detectNoiseGain(void)
+{
+    static float gain = 0;
+
+    if (gain == 0) {
+        gain = filterNoiseGain(detectSections, DETECT_SECTIONS);
+    }
+    return gain;
+}
+
+/*******************************************************************************
+ * @fn          detectSlide
+ *
+ * @brief       Slide a ring of derivates on by a value
+ *
+ * @descr       The value replaces the oldest one, at index, and the sums
+ *              follow: of the ring and of its last DETECT_RECENT values, at
+ *              least as many as in the ring. Each time the ring has gone
+ *              round, at index length - 1, they are summed over again, so
+ *              the rounding does not add up.
+ *
+ * @return      -
+ */
+void detectSlide(float *ring, int length, int index, float value, DetectSums *sums)
+{
+    int i;
+
+    sums->window += value - ring[index];
+    sums->recent += value - ring[index >= DETECT_RECENT ? index - DETECT_RECENT : index - DETECT_RECENT + length];
+    ring[index] = value;
+
+    if (index == length - 1) {
+        sums->window = 0;
+        for (i = 0; i < length; i++) {
+            sums->window += ring[i];
+        }
+        sums->recent = 0;
+        for (i = length - DETECT_RECENT; i < length; i++) {
+            sums->recent += ring[i];
+        }
+    }
+}
+
+/*******************************************************************************
+ * @fn          detectTriggerReset
+ *
+ * @brief       No gestures going on, none detected
+ *
+ * @return      -
+ */
+void detectTriggerReset(DetectTrigger *trigger)
+{
+    trigger->active = 0;
+    trigger->detected = 0;
+    // Long enough ago for any refractory period
+    trigger->last[0] = -1e9f;
+    trigger->last[1] = -1e9f;
+}
+
+/*******************************************************************************
+ * @fn          detectTrigger
+ *
+ * @brief       Detect the gestures that start
+ *
+ * @descr       A gesture starts when both the window and its last
+ *              DETECT_RECENT samples are over its threshold, unless it was
+ *              detected within the refractory period. Exercise also needs
+ *              to be rhythmic. It goes on until the average of the last
+ *              samples falls below the release fraction of the threshold, a
+ *              pause in the gesture; the end of a detected exercise is
+ *              reported too.
+ *
+ * @return      DETECT_EXERCISE and DETECT_PET as started, DETECT_EXERCISE_END
+ */
+int detectTrigger(DetectTrigger *trigger, float time, const float *averageDerivates, const float *recentDerivates,
+                  int rhythmic, const DetectConfig *config)
+{
+    int over = checkAverageDerivates(averageDerivates, config) & checkAverageDerivates(recentDerivates, config);
+    int result = 0;
+
+    if (!rhythmic) {
+        over &= ~DETECT_EXERCISE;
+    }
+
+    // Paused gestures
+    if (recentDerivates[2] < limit(config->exercise, config, 2) * config->release) {
+        trigger->active &= ~DETECT_EXERCISE;
+        if (trigger->detected & DETECT_EXERCISE) {
+            result |= DETECT_EXERCISE_END;
+        }
+    }
+    if (recentDerivates[0] < limit(config->pet, config, 0) * config->release &&
+        recentDerivates[1] < limit(config->pet, config, 1) * config->release) {
+        trigger->active &= ~DETECT_PET;
+    }
+    trigger->detected &= trigger->active;
+
+    if ((over & DETECT_EXERCISE) && !(trigger->active & DETECT_EXERCISE) &&
+        time - trigger->last[0] >= config->refractory) {
+        result |= DETECT_EXERCISE;
+        trigger->last[0] = time;
+    }
+    if ((over & DETECT_PET) && !(trigger->active & DETECT_PET) && time - trigger->last[1] >= config->refractory) {
+        result |= DETECT_PET;
+        trigger->last[1] = time;
+    }
+    trigger->active |= over;
+    trigger->detected |= result & (DETECT_EXERCISE | DETECT_PET);
+    return result;
+}
+
+
+/* Checks the average derivates against the thresholds, raised to the noise floors.
+ * Parameters:
+ * - const float *averageDerivates: Array containing the average derivate values.
+ * - const DetectConfig *config: The thresholds.
+ * Returns:
+ * - DETECT_EXERCISE and DETECT_PET for the gestures over the thresholds, 0 otherwise.
+ */
+int checkAverageDerivates(const float *averageDerivates, const DetectConfig *config) {
+    int result = 0;
+
+    if (averageDerivates[2] > limit(config->exercise, config, 2)) {
+        result |= DETECT_EXERCISE;
+    }
+    if ((averageDerivates[0] > limit(config->pet, config, 0) || averageDerivates[1] > limit(config->pet, config, 1)) &&
+        averageDerivates[2] < limit(config->petMaxVertical, config, 2)) {
+        result |= DETECT_PET;
+    }
+    return result;
+}
@@ -0,0 +1,131 @@
+/** ============================================================================
+ *  @file       detect.h
+ *
+ *  @brief      Exercise and petting detection from the MPU samples.
+ *
+ *  The pipeline of the sensor task, free of the RTOS and the parameters so
+ *  host/replay runs the same code on recorded traces. Each axis is
+ *  smoothed as its samples come, by the biquad cascade of DETECT_FILTER
+ *  (see filter.h), and differentiated; the absolute derivates are averaged
+ *  over the last DETECT_WINDOW samples by running sums, so a sample costs
+ *  the same whatever the window. Exercise is a vertical (z) average above
+ *  the exercise threshold, petting an x or y average above the pet
+ *  threshold while the vertical one stays below the pet vertical limit.
+ *  Exercise also needs a rhythm (see rhythm.h), so a single jolt is not
+ *  exercise; its frequency is known at the start and its repetitions when
+ *  it ends.
+ *
+ *  The window slides on by one sample also over a detection. A gesture is
+ *  detected once when it starts, when also the average of the last
+ *  DETECT_RECENT samples is over the threshold: it goes on until that
+ *  average falls below the release fraction of the threshold (hysteresis),
+ *  and it is not detected again within the refractory period of the last
+ *  detection. With the history kept, a gesture repeated after a pause is
+ *  detected within DETECT_RECENT samples.
+ *  ============================================================================
+ */
+#ifndef _DETECT_H_
+#define _DETECT_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+
+#include "tuned.h"
+#include "filter.h"
+#include "rhythm.h"
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+// In samples, tuned on recorded traces (see tuned.h); at most 255
+#define DETECT_WINDOW       TUNED_DETECT_WINDOW
+#define DETECT_SMOOTH       TUNED_DETECT_SMOOTH
+#define DETECT_SLOPES       (DETECT_WINDOW - 1)
+// Of the sample rate, where the noise passes a little less than through a moving average of
+// DETECT_SMOOTH samples, with more of the gestures below it
+#define DETECT_CUTOFF       (0.55 / DETECT_SMOOTH)
+// The smoothing of each axis, filter.h sections of type, frequency of the sample rate, Q;
+// host/score/tune scales the frequencies with its smoothing. A Butterworth low-pass of order 2.
+#define DETECT_FILTER(X) \
+    X(FILTER_LOWPASS, DETECT_CUTOFF, 0.7071)
+#define DETECT_SECTIONS     (0 DETECT_FILTER(FILTER_COUNT))
+// The last samples that start and pause a gesture
+#define DETECT_RECENT       5
+
+// Results of detectSample
+#define DETECT_EXERCISE     0x01
+#define DETECT_PET          0x02
+#define DETECT_EXERCISE_END 0x04
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+// The thresholds are in g/s and deg/s/s, see params.h
+typedef struct {
+    float samplePeriod;     // s
+    float exercise;
+    float pet;
+    float petMaxVertical;
+    float release;          // of the threshold, ends a gesture
+    float refractory;       // s
+    float rhythmAmplitude;  // g, of the exercise rhythm
+    float rhythmPurity;     // of the band energy in the rhythm
+    float floor[3];         // ax, ay, az thresholds at least, above the noise (see noise.h); 0 for none
+} DetectConfig;
+
+// The gestures going on
+typedef struct {
+    int active;                         // DETECT_EXERCISE and DETECT_PET
+    int detected;                       // of the active ones
+    float last[2];                      // s, of the last exercise and pet detection
+} DetectTrigger;
+
+// Running sums of a ring of derivates, see detectSlide
+typedef struct {
+    float window;
+    float recent;                       // of the last DETECT_RECENT
+} DetectSums;
+
+typedef struct {
+    BiquadState filters[6][DETECT_SECTIONS];    // ax, ay, az, gx, gy, gz
+    float filtered[6];                  // of the last sample
+    float derivates[6][DETECT_SLOPES];  // rings, absolute
+    float times[DETECT_SLOPES];         // s, of the samples of the derivates
+    DetectSums sums[6];
+    float averages[6];
+    float recent[3];                    // ax, ay, az of the last DETECT_RECENT derivates
+    int index;                          // of the oldest derivate in the rings
+    int samples;                        // since the reset, up to DETECT_WINDOW
+    DetectTrigger trigger;
+    Rhythm rhythm;
+    // The exercise, from its DETECT_EXERCISE to its DETECT_EXERCISE_END
+    int repSignal;                      // of the rhythm
+    uint32_t repStart;                  // crossings before the exercise
+    float frequency;                    // Hz
+    uint32_t reps;
+} Detector;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void detectReset(Detector *detector);
+int detectSample(Detector *detector, float time, const float motion[6], const DetectConfig *config);
+
+// The noise gain of the smoothing and the difference, see filterNoiseGain
+float detectNoiseGain(void);
+
+// The stages, also benchmarked on their own and run by host/score/tune
+extern const Biquad detectSections[DETECT_SECTIONS];
+void detectSlide(float *ring, int length, int index, float value, DetectSums *sums);
+int checkAverageDerivates(const float *averageDerivates, const DetectConfig *config);
+// The hysteresis and the refractory period, also for host/score/tune
+void detectTriggerReset(DetectTrigger *trigger);
+int detectTrigger(DetectTrigger *trigger, float time, const float *averageDerivates, const float *recentDerivates,
+                  int rhythmic, const DetectConfig *config);
+
+#endif
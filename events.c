@@ -0,0 +1,130 @@
+/** ============================================================================
+ *  @file       events.c
+ *
+ *  @brief      Application event queue on a Mailbox.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Mailbox.h>
+
+#include "events.h"
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+// The Mailbox is constructed on a static buffer, the heap is too small for it
+static Mailbox_Struct mailboxStruct;
+static Mailbox_Handle hMailbox = NULL;
+static uint8_t mailboxBuf[EVENT_QUEUE_LENGTH * (sizeof(Mailbox_MbxElem) + sizeof(Event))];
+
+static EventStats stats;
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          eventsOpen
+ *
+ * @brief       Create the event queue, call before BIOS_start
+ *
+ * @return      -
+ */
+void eventsOpen(void)
+{
+    Mailbox_Params mbxParams;
+
+    Mailbox_Params_init(&mbxParams);
+    mbxParams.buf = mailboxBuf;
+    mbxParams.bufSize = sizeof(mailboxBuf);
+    Mailbox_construct(&mailboxStruct, sizeof(Event), EVENT_QUEUE_LENGTH, &mbxParams, NULL);
+    hMailbox = Mailbox_handle(&mailboxStruct);
+    if (hMailbox == NULL) {
+        System_abort("Event queue create failed");
+    }
+    memset(&stats, 0, sizeof(stats));
+}
+
+/*******************************************************************************
+ * @fn          eventPost
+ *
+ * @brief       Queue an event
+ *
+ * @descr       Never blocks, so it can be called from interrupt callbacks.
+ *
+ * @return      1 if queued, 0 if the queue was full and the event was dropped
+ */
+int eventPost(EventType type, uint8_t arg)
+{
+    Event event;
+    UInt key;
+
+    event.type = type;
+    event.arg = arg;
+    event.tick = Clock_getTicks();
+
+    if (!Mailbox_post(hMailbox, &event, BIOS_NO_WAIT)) {
+        key = Hwi_disable();
+        stats.dropped++;
+        Hwi_restore(key);
+        return 0;
+    }
+    return 1;
+}
+
+/*******************************************************************************
+ * @fn          eventPend
+ *
+ * @brief       Wait for the next event
+ *
+ * @descr       Only the state machine task pends, it also keeps the
+ *              latency statistics.
+ *
+ * @return      1 if an event was received, 0 on timeout
+ */
+int eventPend(Event *event, uint32_t timeout)
+{
+    uint32_t latencyUs;
+    UInt key;
+
+    if (!Mailbox_pend(hMailbox, event, timeout)) {
+        return 0;
+    }
+
+    latencyUs = (Clock_getTicks() - event->tick) * Clock_tickPeriod;
+    key = Hwi_disable();
+    stats.handled++;
+    stats.totalLatencyUs += latencyUs;
+    if (latencyUs > stats.maxLatencyUs) {
+        stats.maxLatencyUs = latencyUs;
+    }
+    Hwi_restore(key);
+    return 1;
+}
+
+/*******************************************************************************
+ * @fn          eventGetStats
+ *
+ * @brief       Copy the queue statistics
+ *
+ * @return      -
+ */
+void eventGetStats(EventStats *out)
+{
+    UInt key = Hwi_disable();
+    *out = stats;
+    Hwi_restore(key);
+}
@@ -0,0 +1,76 @@
+/** ============================================================================
+ *  @file       events.h
+ *
+ *  @brief      Application event queue.
+ *
+ *  Interrupt callbacks and tasks post events, the state machine task pends
+ *  on them and handles them in order. Every event carries the Clock tick
+ *  it was posted at, so the queue can measure how long an event waited
+ *  before the state machine reacted to it.
+ *  ============================================================================
+ */
+#ifndef _EVENTS_H_
+#define _EVENTS_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+// Events that can wait in the queue at the same time
+#define EVENT_QUEUE_LENGTH 16
+
+typedef enum {
+    EVENT_SHUTDOWN = 0,     // power button long push
+    EVENT_POWER_BUTTON,     // power button short push
+    EVENT_POWER_DOUBLE,     // power button double tap
+    EVENT_BUTTON,           // upper button short push
+    EVENT_BUTTON_DOUBLE,    // upper button double tap
+    EVENT_FEED,             // upper button long push
+    EVENT_SLEEP,            // dark for 10 seconds (arg 0) or laid face down (arg 1)
+    EVENT_WAKE,             // light again after sleeping
+    EVENT_EXERCISE,         // arg the frequency in 0.1 Hz
+    EVENT_PET,
+    EVENT_WARNING,          // gateway warning beep
+    EVENT_GAME_OVER,
+    EVENT_STACK_REPORT,     // periodic stack usage report
+    EVENT_LOAD_REPORT,      // periodic CPU load report
+    EVENT_PROBE_DUMP,       // gateway asked for the probe statistics
+    EVENT_FLASH_DUMP,       // gateway asked for the flash log over the serial port
+    EVENT_CALIBRATE,        // gateway asked for a new MPU calibration
+    EVENT_STREAM,           // gateway turned the bench streaming on (arg 1) or off (arg 0)
+    EVENT_EXERCISE_END,     // exercise paused, arg the reps (at most 255)
+    EVENT_COUNT
+} EventType;
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    uint8_t type;           // EventType
+    uint8_t arg;            // event specific argument
+    uint32_t tick;          // Clock tick when posted
+} Event;
+
+typedef struct {
+    uint32_t handled;       // events taken from the queue
+    uint32_t dropped;       // events lost because the queue was full
+    uint32_t maxLatencyUs;  // longest post to pend time
+    uint32_t totalLatencyUs;
+} EventStats;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void eventsOpen(void);
+int eventPost(EventType type, uint8_t arg);
+int eventPend(Event *event, uint32_t timeout);
+void eventGetStats(EventStats *stats);
+
+#endif
@@ -0,0 +1,290 @@
+/** ============================================================================
+ *  @file       extflash.c
+ *
+ *  @brief      Driver for the external MX25R8035F SPI flash.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <xdc/std.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/drivers/PIN.h>
+#include <ti/drivers/SPI.h>
+
+#include "Board.h"
+#include "extflash.h"
+
+/* -----------------------------------------------------------------------------
+*  Constants
+* ------------------------------------------------------------------------------
+*/
+#define CMD_WRITE_ENABLE        0x06
+#define CMD_READ_STATUS         0x05
+#define CMD_FAST_READ           0x0B
+#define CMD_PAGE_PROGRAM        0x02
+#define CMD_SECTOR_ERASE        0x20
+#define CMD_JEDEC_ID            0x9F
+#define CMD_DEEP_POWER_DOWN     0xB9
+#define CMD_RELEASE_POWER_DOWN  0xAB
+
+#define STATUS_WIP              0x01
+
+// Macronix, MX25R8035F
+#define JEDEC_MANUFACTURER      0xC2
+#define JEDEC_DEVICE            0x2814
+
+#define SPI_BIT_RATE            4000000
+// Longest transfer the SPI DMA takes at once
+#define SPI_MAX_TRANSFER        1024
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static Semaphore_Struct lockStruct;
+static Semaphore_Handle hLock = NULL;
+static SPI_Handle hSpi = NULL;
+static PIN_Handle hCsPin = NULL;
+static PIN_State csPinState;
+
+static PIN_Config csPinConfig[] = {
+    Board_SPI_FLASH_CS | PIN_GPIO_OUTPUT_EN | PIN_GPIO_HIGH | PIN_PUSHPULL | PIN_DRVSTR_MIN,
+    PIN_TERMINATE
+};
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+static void select(void)
+{
+    PIN_setOutputValue(hCsPin, Board_SPI_FLASH_CS, Board_FLASH_CS_ON);
+}
+
+static void deselect(void)
+{
+    PIN_setOutputValue(hCsPin, Board_SPI_FLASH_CS, Board_FLASH_CS_OFF);
+}
+
+// One transfer inside the current chip select, NULL buffers are allowed
+static void transfer(const void *tx, void *rx, uint16_t length)
+{
+    SPI_Transaction transaction;
+    uint16_t count;
+
+    while (length) {
+        count = length > SPI_MAX_TRANSFER ? SPI_MAX_TRANSFER : length;
+        transaction.count = count;
+        transaction.txBuf = (void *)tx;
+        transaction.rxBuf = rx;
+        SPI_transfer(hSpi, &transaction);
+        if (tx) {
+            tx = (const uint8_t *)tx + count;
+        }
+        if (rx) {
+            rx = (uint8_t *)rx + count;
+        }
+        length -= count;
+    }
+}
+
+static void command(uint8_t cmd)
+{
+    select();
+    transfer(&cmd, NULL, 1);
+    deselect();
+}
+
+// Command byte and a 24-bit address
+static void addressed(uint8_t cmd, uint32_t address, uint8_t extra)
+{
+    uint8_t header[5] = {cmd, address >> 16, address >> 8, address, 0};
+
+    transfer(header, NULL, 4 + extra);
+}
+
+static int busy(void)
+{
+    uint8_t cmd = CMD_READ_STATUS;
+    uint8_t status;
+
+    select();
+    transfer(&cmd, NULL, 1);
+    transfer(NULL, &status, 1);
+    deselect();
+    return (status & STATUS_WIP) != 0;
+}
+
+// Program and erase take milliseconds, let the other tasks run meanwhile
+static void waitReady(void)
+{
+    while (busy()) {
+        Task_sleep(1000 / Clock_tickPeriod);
+    }
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          extflashOpen
+ *
+ * @brief       Wake the flash up and check that it answers
+ *
+ * @descr       Call from a task, Board_initSPI() must have been called.
+ *              Every user may call it, the flash is opened only once.
+ *
+ * @return      1 if the MX25R8035F was found
+ */
+int extflashOpen(void)
+{
+    Semaphore_Params semParams;
+    SPI_Params spiParams;
+    uint8_t cmd = CMD_JEDEC_ID;
+    uint8_t id[3];
+
+    if (hSpi != NULL) {
+        return 1;
+    }
+    if (hLock == NULL) {
+        Semaphore_Params_init(&semParams);
+        semParams.mode = Semaphore_Mode_BINARY;
+        Semaphore_construct(&lockStruct, 1, &semParams);
+        hLock = Semaphore_handle(&lockStruct);
+    }
+    hCsPin = PIN_open(&csPinState, csPinConfig);
+    if (hCsPin == NULL) {
+        return 0;
+    }
+    SPI_Params_init(&spiParams);
+    spiParams.mode = SPI_MASTER;
+    spiParams.bitRate = SPI_BIT_RATE;
+    spiParams.dataSize = 8;
+    spiParams.frameFormat = SPI_POL0_PHA0;
+    spiParams.transferMode = SPI_MODE_BLOCKING;
+    hSpi = SPI_open(Board_SPI0, &spiParams);
+    if (hSpi == NULL) {
+        PIN_close(hCsPin);
+        return 0;
+    }
+
+    // The flash may sleep since boot, it wakes in 35 us
+    command(CMD_RELEASE_POWER_DOWN);
+    Task_sleep(100 / Clock_tickPeriod + 1);
+
+    select();
+    transfer(&cmd, NULL, 1);
+    transfer(NULL, id, 3);
+    deselect();
+    if (id[0] != JEDEC_MANUFACTURER || ((id[1] << 8) | id[2]) != JEDEC_DEVICE) {
+        extflashClose();
+        return 0;
+    }
+    return 1;
+}
+
+/*******************************************************************************
+ * @fn          extflashClose
+ *
+ * @brief       Put the flash to deep power down and release the SPI
+ *
+ * @return      -
+ */
+void extflashClose(void)
+{
+    Semaphore_pend(hLock, BIOS_WAIT_FOREVER);
+    waitReady();
+    command(CMD_DEEP_POWER_DOWN);
+    SPI_close(hSpi);
+    PIN_close(hCsPin);
+    hSpi = NULL;
+    hCsPin = NULL;
+    Semaphore_post(hLock);
+}
+
+/*******************************************************************************
+ * @fn          extflashBusy
+ *
+ * @brief       Is a program or erase still running
+ *
+ * @return      1 if busy
+ */
+int extflashBusy(void)
+{
+    int result;
+
+    Semaphore_pend(hLock, BIOS_WAIT_FOREVER);
+    result = busy();
+    Semaphore_post(hLock);
+    return result;
+}
+
+/*******************************************************************************
+ * @fn          extflashRead
+ *
+ * @brief       Read any amount of bytes from any address
+ *
+ * @return      -
+ */
+void extflashRead(uint32_t address, void *data, uint16_t length)
+{
+    Semaphore_pend(hLock, BIOS_WAIT_FOREVER);
+    waitReady();
+    select();
+    // Fast read, one dummy byte after the address
+    addressed(CMD_FAST_READ, address, 1);
+    transfer(NULL, data, length);
+    deselect();
+    Semaphore_post(hLock);
+}
+
+/*******************************************************************************
+ * @fn          extflashProgram
+ *
+ * @brief       Start programming bytes within one page
+ *
+ * @descr       The bytes must not cross a page boundary and must have been
+ *              erased. Returns while the chip is still programming.
+ *
+ * @return      -
+ */
+void extflashProgram(uint32_t address, const void *data, uint16_t length)
+{
+    Semaphore_pend(hLock, BIOS_WAIT_FOREVER);
+    waitReady();
+    command(CMD_WRITE_ENABLE);
+    select();
+    addressed(CMD_PAGE_PROGRAM, address, 0);
+    transfer(data, NULL, length);
+    deselect();
+    Semaphore_post(hLock);
+}
+
+/*******************************************************************************
+ * @fn          extflashErase
+ *
+ * @brief       Start erasing the sector of an address
+ *
+ * @descr       Returns while the chip is still erasing, that takes up to
+ *              240 ms.
+ *
+ * @return      -
+ */
+void extflashErase(uint32_t address)
+{
+    Semaphore_pend(hLock, BIOS_WAIT_FOREVER);
+    waitReady();
+    command(CMD_WRITE_ENABLE);
+    select();
+    addressed(CMD_SECTOR_ERASE, address, 0);
+    deselect();
+    Semaphore_post(hLock);
+}
@@ -0,0 +1,42 @@
+/** ============================================================================
+ *  @file       extflash.h
+ *
+ *  @brief      Driver for the external MX25R8035F SPI flash.
+ *
+ *  1 MB, erased in 4 kB sectors and programmed in 256 byte pages. Program
+ *  and erase only start the operation, the chip works on its own while
+ *  the caller goes on, extflashBusy() tells when it is done. Reads and new
+ *  operations wait for the previous one first. Transfers of more than a
+ *  few bytes are moved by the SPI driver's DMA.
+ *  Each call is atomic between tasks, a sequence of calls is not. Call
+ *  from tasks only.
+ *  ============================================================================
+ */
+#ifndef _EXTFLASH_H_
+#define _EXTFLASH_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+#define EXTFLASH_SIZE           0x100000
+#define EXTFLASH_SECTOR_SIZE    4096
+#define EXTFLASH_PAGE_SIZE      256
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+int extflashOpen(void);
+void extflashClose(void);
+int extflashBusy(void);
+void extflashRead(uint32_t address, void *data, uint16_t length);
+void extflashProgram(uint32_t address, const void *data, uint16_t length);
+void extflashErase(uint32_t address);
+
+#endif
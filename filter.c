@@ -0,0 +1,163 @@
+/** ============================================================================
+ *  @file       filter.c
+ *
+ *  @brief      Biquad IIR filters in fixed point, cascaded.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <math.h>
+
+#include "filter.h"
+#include "probe.h"
+
+/* -----------------------------------------------------------------------------
+*  Constants
+* ------------------------------------------------------------------------------
+*/
+#define FILTER_SAMPLE_MAX   2147483647.0f
+// Of the impulse response that gives the noise gain
+#define FILTER_NOISE_SAMPLES 256
+
+/* -----------------------------------------------------------------------------
+*  Local Functions
+* ------------------------------------------------------------------------------
+*/
+static int32_t toFixed(float value)
+{
+    float fixed = value * (1 << FILTER_SAMPLE_Q);
+
+    if (fixed >= FILTER_SAMPLE_MAX) {
+        return INT32_MAX;
+    }
+    if (fixed <= -FILTER_SAMPLE_MAX) {
+        return -INT32_MAX;
+    }
+    return (int32_t)fixed;
+}
+
+// The gain of a section at 0 Hz
+static float dcGain(const Biquad *section)
+{
+    float a = (float)(1 << FILTER_Q) + section->a[0] + section->a[1];
+
+    return a != 0 ? ((float)section->b[0] + section->b[1] + section->b[2]) / a : 0;
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          filterStart
+ *
+ * @brief       Settle the states of a cascade at a value
+ *
+ * @descr       Each section has seen the value at its input for long, and
+ *              passes it on by its gain at 0 Hz: a start without the step
+ *              from 0.
+ *
+ * @return      The output, the value by the gain of the cascade at 0 Hz
+ */
+float filterStart(const Biquad *sections, int count, BiquadState *states, float value)
+{
+    int32_t x = toFixed(value);
+    int i;
+
+    for (i = 0; i < count; i++) {
+        states[i].x[0] = states[i].x[1] = x;
+        x = toFixed((float)x / (1 << FILTER_SAMPLE_Q) * dcGain(&sections[i]));
+        states[i].y[0] = states[i].y[1] = x;
+    }
+    return (float)x / (1 << FILTER_SAMPLE_Q);
+}
+
+/*******************************************************************************
+ * @fn          filterSample
+ *
+ * @brief       Run a sample through a cascade
+ *
+ * @return      The filtered sample
+ */
+float filterSample(const Biquad *sections, int count, BiquadState *states, float value)
+{
+    int32_t x = toFixed(value);
+    int64_t sum;
+    int i;
+    PROBE_START(PROBE_FILTER);
+
+    for (i = 0; i < count; i++) {
+        sum = (int64_t)sections[i].b[0] * x + (int64_t)sections[i].b[1] * states[i].x[0] +
+              (int64_t)sections[i].b[2] * states[i].x[1] - (int64_t)sections[i].a[0] * states[i].y[0] -
+              (int64_t)sections[i].a[1] * states[i].y[1];
+        states[i].x[1] = states[i].x[0];
+        states[i].x[0] = x;
+        states[i].y[1] = states[i].y[0];
+        x = (int32_t)((sum + (1 << (FILTER_Q - 1))) >> FILTER_Q);
+        states[i].y[0] = x;
+    }
+
+    PROBE_STOP(PROBE_FILTER);
+    return (float)x / (1 << FILTER_SAMPLE_Q);
+}
+
+/*******************************************************************************
+ * @fn          filterNoiseGain
+ *
+ * @brief       Gain of a cascade on the change of white noise
+ *
+ * @descr       The change of the output from sample to sample is the
+ *              noise filtered by the cascade and the difference, and its
+ *              variance the noise variance times the energy of their
+ *              impulse response, here of its first FILTER_NOISE_SAMPLES.
+ *              A moving average of n samples has a gain of sqrt(2) / n.
+ *
+ * @return      The standard deviation of the change per that of the noise
+ */
+float filterNoiseGain(const Biquad *sections, int count)
+{
+    double x[FILTER_MAX_SECTIONS][2] = {{0}};
+    double y[FILTER_MAX_SECTIONS][2] = {{0}};
+    double value, output, previous = 0, energy = 0;
+    int n, i;
+
+    for (n = 0; n < FILTER_NOISE_SAMPLES; n++) {
+        value = n == 0 ? 1 : 0;
+        for (i = 0; i < count && i < FILTER_MAX_SECTIONS; i++) {
+            output = ((double)sections[i].b[0] * value + (double)sections[i].b[1] * x[i][0] +
+                      (double)sections[i].b[2] * x[i][1] - (double)sections[i].a[0] * y[i][0] -
+                      (double)sections[i].a[1] * y[i][1]) / (1 << FILTER_Q);
+            x[i][1] = x[i][0];
+            x[i][0] = value;
+            y[i][1] = y[i][0];
+            y[i][0] = output;
+            value = output;
+        }
+        energy += (value - previous) * (value - previous);
+        previous = value;
+    }
+    return (float)sqrt(energy);
+}
+
+/*******************************************************************************
+ * @fn          filterDesign
+ *
+ * @brief       Coefficients of a section
+ *
+ * @descr       Those of FILTER_SECTION, for a frequency known only at run
+ *              time, as host/score/tune searching the smoothing.
+ *
+ * @return      -
+ */
+void filterDesign(Biquad *section, FilterType type, double frequency, double q)
+{
+    section->b[0] = FILTER_FIXED(FILTER_B0(type, frequency, q));
+    section->b[1] = FILTER_FIXED(FILTER_B1(type, frequency, q));
+    section->b[2] = FILTER_FIXED(FILTER_B2(type, frequency, q));
+    section->a[0] = FILTER_FIXED(FILTER_A1(frequency, q));
+    section->a[1] = FILTER_FIXED(FILTER_A2(frequency, q));
+}
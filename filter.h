@@ -0,0 +1,104 @@
+/** ============================================================================
+ *  @file       filter.h
+ *
+ *  @brief      Biquad IIR filters in fixed point, cascaded.
+ *
+ *  A section is the low-pass, high-pass or band-pass (0 dB peak) of the
+ *  audio EQ cookbook, at a frequency given as a fraction of the sample
+ *  rate and a Q. FILTER_SECTION expands to its coefficients as a constant
+ *  expression, so a table of sections is computed by the compiler: the
+ *  sine and cosine are series, folded to the first quarter. A Butterworth
+ *  low-pass of order 2 is one section of Q 0.7071, of order 4 two of Q
+ *  0.5412 and 1.3066.
+ *
+ *  The samples run through in direct form I, Q16 of the unit of the
+ *  input (g, deg/s) with Q28 coefficients and 64 bit sums, for the CPU
+ *  without an FPU. Each filtered signal has a state of its own for each
+ *  section; the cost of a sample is constant.
+ *  ============================================================================
+ */
+#ifndef _FILTER_H_
+#define _FILTER_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+typedef enum {
+    FILTER_LOWPASS = 0,
+    FILTER_HIGHPASS,
+    FILTER_BANDPASS
+} FilterType;
+
+// Of the coefficients, |a1| < 2 fits
+#define FILTER_Q            28
+// Of the samples, up to 32767 g or deg/s
+#define FILTER_SAMPLE_Q     16
+// At most, in a cascade
+#define FILTER_MAX_SECTIONS 4
+
+#define FILTER_PI           3.14159265358979
+// Series to x^12, within 1e-9 up to pi / 2
+#define FILTER_TCOS(x)      (1 - (x) * (x) / 2 * (1 - (x) * (x) / 12 * (1 - (x) * (x) / 30 * \
+                             (1 - (x) * (x) / 56 * (1 - (x) * (x) / 90 * (1 - (x) * (x) / 132))))))
+#define FILTER_TSIN(x)      ((x) * (1 - (x) * (x) / 6 * (1 - (x) * (x) / 20 * (1 - (x) * (x) / 42 * \
+                             (1 - (x) * (x) / 72 * (1 - (x) * (x) / 110 * (1 - (x) * (x) / 156)))))))
+// Of w = 2 pi frequency, 0 to pi
+#define FILTER_COS(w)       ((w) <= FILTER_PI / 2 ? FILTER_TCOS(w) : -FILTER_TCOS(FILTER_PI - (w)))
+#define FILTER_SIN(w)       ((w) <= FILTER_PI / 2 ? FILTER_TSIN(w) : FILTER_TSIN(FILTER_PI - (w)))
+
+// The cookbook coefficients normalized by a0, a section passes all from half the sample rate on
+#define FILTER_W(f)         (2 * FILTER_PI * (f))
+#define FILTER_C(f)         FILTER_COS(FILTER_W(f))
+#define FILTER_ALPHA(f, q)  (FILTER_SIN(FILTER_W(f)) / (2 * (q)))
+#define FILTER_A0(f, q)     (1 + FILTER_ALPHA(f, q))
+#define FILTER_B0(t, f, q)  ((f) >= 0.5 ? 1 : ((t) == FILTER_LOWPASS ? (1 - FILTER_C(f)) / 2 : \
+                             (t) == FILTER_HIGHPASS ? (1 + FILTER_C(f)) / 2 : FILTER_ALPHA(f, q)) / FILTER_A0(f, q))
+#define FILTER_B1(t, f, q)  ((f) >= 0.5 ? 0 : ((t) == FILTER_LOWPASS ? 1 - FILTER_C(f) : \
+                             (t) == FILTER_HIGHPASS ? -(1 + FILTER_C(f)) : 0) / FILTER_A0(f, q))
+#define FILTER_B2(t, f, q)  ((f) >= 0.5 ? 0 : (t) == FILTER_BANDPASS ? -FILTER_B0(t, f, q) : FILTER_B0(t, f, q))
+#define FILTER_A1(f, q)     ((f) >= 0.5 ? 0 : -2 * FILTER_C(f) / FILTER_A0(f, q))
+#define FILTER_A2(f, q)     ((f) >= 0.5 ? 0 : (1 - FILTER_ALPHA(f, q)) / FILTER_A0(f, q))
+
+#define FILTER_FIXED(x)     ((int32_t)((x) * (1 << FILTER_Q) + ((x) < 0 ? -0.5 : 0.5)))
+
+// An initializer of a Biquad, for an X macro table of type, frequency, q
+#define FILTER_SECTION(type, frequency, q) \
+    {{FILTER_FIXED(FILTER_B0(type, frequency, q)), FILTER_FIXED(FILTER_B1(type, frequency, q)), \
+      FILTER_FIXED(FILTER_B2(type, frequency, q))}, \
+     {FILTER_FIXED(FILTER_A1(frequency, q)), FILTER_FIXED(FILTER_A2(frequency, q))}},
+// The sections of such a table, as (0 TABLE(FILTER_COUNT))
+#define FILTER_COUNT(type, frequency, q) + 1
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    int32_t b[3];           // Q28
+    int32_t a[2];           // Q28, a1 and a2, a0 is 1
+} Biquad;
+
+typedef struct {
+    int32_t x[2];           // Q16, the last inputs, newest first
+    int32_t y[2];           // Q16, the last outputs
+} BiquadState;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+// Settled at the value, as after a long constant input; returns the output
+float filterStart(const Biquad *sections, int count, BiquadState *states, float value);
+float filterSample(const Biquad *sections, int count, BiquadState *states, float value);
+// Of the change from sample to sample of the output, per standard deviation of white noise in
+float filterNoiseGain(const Biquad *sections, int count);
+// The coefficients of FILTER_SECTION, at run time
+void filterDesign(Biquad *section, FilterType type, double frequency, double q);
+
+#endif
@@ -0,0 +1,387 @@
+/** ============================================================================
+ *  @file       flashlog.c
+ *
+ *  @brief      Append-only ring log of data sessions on the external flash.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <string.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include "flashlog.h"
+#include "extflash.h"
+#include "serial.h"
+
+/* -----------------------------------------------------------------------------
+*  Constants
+* ------------------------------------------------------------------------------
+*/
+#define FLASHLOG_END            (FLASHLOG_BASE + FLASHLOG_SIZE)
+#define FLASHLOG_SECTORS        (FLASHLOG_SIZE / FLASHLOG_SECTOR_SIZE)
+#define PAGES_PER_SECTOR        (FLASHLOG_SECTOR_SIZE / FLASHLOG_PAGE_SIZE)
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static Semaphore_Struct lockStruct;
+static Semaphore_Handle hLock = NULL;
+static int mounted = 0;
+
+// One page fills while the other waits for the flash
+static uint8_t pages[2][FLASHLOG_PAGE_SIZE];
+static uint8_t active = 0;
+static uint16_t fill = 0;       // record bytes in the active page
+static uint8_t pending = 0;     // the other page is full
+
+static uint32_t head;           // address of the next page to program
+static uint16_t wear;           // erase count of the head's sector
+static uint8_t erased;          // the head's sector is erased for this round
+
+static FlashlogStats stats;
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+static uint16_t get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put16(uint8_t *p, uint16_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t value)
+{
+    put16(p, value);
+    put16(p + 2, value >> 16);
+}
+
+static uint32_t nextAddress(uint32_t address, uint32_t step)
+{
+    address += step;
+    return address >= FLASHLOG_END ? address - FLASHLOG_SIZE : address;
+}
+
+// Finds the newest page from the sector headers, the log goes on after it
+static void flashlogMount(void)
+{
+    uint8_t header[FLASHLOG_HEADER_SIZE];
+    uint32_t address;
+    uint32_t newest = 0;
+    uint32_t seq;
+    uint16_t sectorWear;
+    int found = 0;
+    int i;
+
+    stats.minWear = 0xFFFF;
+    stats.maxWear = 0;
+    for (i = 0; i < FLASHLOG_SECTORS; i++) {
+        address = FLASHLOG_BASE + i * FLASHLOG_SECTOR_SIZE;
+        extflashRead(address, header, sizeof(header));
+        if (get16(header) != FLASHLOG_MAGIC) {
+            continue;
+        }
+        seq = get32(header + 4);
+        sectorWear = get16(header + 8);
+        if (sectorWear < stats.minWear) {
+            stats.minWear = sectorWear;
+        }
+        if (sectorWear > stats.maxWear) {
+            stats.maxWear = sectorWear;
+        }
+        if (!found || (int32_t)(seq - stats.seq) > 0) {
+            found = 1;
+            newest = address;
+            stats.seq = seq;
+            wear = sectorWear;
+        }
+    }
+    if (!found) {
+        // Blank or foreign flash, start from the beginning
+        stats.minWear = 0;
+        stats.seq = 0;
+        head = FLASHLOG_BASE;
+        erased = 0;
+        return;
+    }
+
+    // Pages of a sector are written in order, the first blank one is next
+    head = newest;
+    erased = 1;
+    for (i = 0; i < PAGES_PER_SECTOR; i++, head += FLASHLOG_PAGE_SIZE) {
+        extflashRead(head, header, sizeof(header));
+        if (get16(header) == FLASHLOG_ERASED) {
+            break;
+        }
+        stats.seq = get32(header + 4) + 1;
+    }
+    if (i == PAGES_PER_SECTOR) {
+        head = nextAddress(newest, FLASHLOG_SECTOR_SIZE);
+        erased = 0;
+    }
+}
+
+// Starts the next step of writing the waiting page, if the flash is idle.
+// Call with the lock held.
+static void flashlogProgram(void)
+{
+    uint8_t *page = pages[active ^ 1];
+    uint8_t header[FLASHLOG_HEADER_SIZE];
+    uint16_t length;
+    uint16_t crc;
+
+    if (!pending || extflashBusy()) {
+        return;
+    }
+    if (!erased) {
+        // Entering a sector, the oldest data goes. Its erase count moves on.
+        extflashRead(head, header, sizeof(header));
+        wear = get16(header) == FLASHLOG_MAGIC ? get16(header + 8) + 1 : 1;
+        if (wear > stats.maxWear) {
+            stats.maxWear = wear;
+        }
+        extflashErase(head);
+        erased = 1;
+        return;
+    }
+
+    length = get16(page + 2);
+    put16(page + 8, wear);
+    crc = serialCrc16(0xFFFF, page, FLASHLOG_CRC_OFFSET);
+    crc = serialCrc16(crc, page + FLASHLOG_HEADER_SIZE, length);
+    put16(page + FLASHLOG_CRC_OFFSET, crc);
+    extflashProgram(head, page, FLASHLOG_HEADER_SIZE + length);
+
+    head = nextAddress(head, FLASHLOG_PAGE_SIZE);
+    if (head % FLASHLOG_SECTOR_SIZE == 0) {
+        erased = 0;
+    }
+    pending = 0;
+    stats.written++;
+}
+
+// Closes the active page and hands it to the flash. Call with the lock held.
+static int flashlogSeal(void)
+{
+    uint8_t *page = pages[active];
+
+    flashlogProgram();
+    if (pending) {
+        return 0;
+    }
+    put16(page, FLASHLOG_MAGIC);
+    put16(page + 2, fill);
+    put32(page + 4, stats.seq++);
+    active ^= 1;
+    fill = 0;
+    pending = 1;
+    flashlogProgram();
+    return 1;
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          flashlogOpen
+ *
+ * @brief       Open the flash and find where the log goes on
+ *
+ * @descr       Call once from a task. Board_initSPI() must have been called.
+ *
+ * @return      1 if the flash was found
+ */
+int flashlogOpen(void)
+{
+    Semaphore_Params semParams;
+
+    Semaphore_Params_init(&semParams);
+    semParams.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&lockStruct, 1, &semParams);
+    hLock = Semaphore_handle(&lockStruct);
+
+    memset(&stats, 0, sizeof(stats));
+    if (!extflashOpen()) {
+        return 0;
+    }
+    flashlogMount();
+    mounted = 1;
+    return 1;
+}
+
+/*******************************************************************************
+ * @fn          flashlogAppend
+ *
+ * @brief       Append one record
+ *
+ * @descr       Never waits for the flash. The record is dropped if both RAM
+ *              pages are full, i.e. the flash is still erasing.
+ *
+ * @return      1 if stored, 0 if dropped
+ */
+int flashlogAppend(FlashlogRecordType type, const void *data, uint8_t length)
+{
+    uint8_t *record;
+
+    if (!mounted || length > FLASHLOG_PAYLOAD_SIZE - FLASHLOG_RECORD_HEADER) {
+        return 0;
+    }
+    Semaphore_pend(hLock, BIOS_WAIT_FOREVER);
+    if (fill + FLASHLOG_RECORD_HEADER + length > FLASHLOG_PAYLOAD_SIZE && !flashlogSeal()) {
+        stats.dropped++;
+        Semaphore_post(hLock);
+        return 0;
+    }
+    record = pages[active] + FLASHLOG_HEADER_SIZE + fill;
+    record[0] = type;
+    record[1] = length;
+    memcpy(record + FLASHLOG_RECORD_HEADER, data, length);
+    fill += FLASHLOG_RECORD_HEADER + length;
+    Semaphore_post(hLock);
+    return 1;
+}
+
+/*******************************************************************************
+ * @fn          flashlogPoll
+ *
+ * @brief       Move a full page on to the flash
+ *
+ * @descr       Call often while logging, e.g. once per sampling round.
+ *
+ * @return      -
+ */
+void flashlogPoll(void)
+{
+    if (!mounted || !pending) {
+        return;
+    }
+    Semaphore_pend(hLock, BIOS_WAIT_FOREVER);
+    flashlogProgram();
+    Semaphore_post(hLock);
+}
+
+/*******************************************************************************
+ * @fn          flashlogFlush
+ *
+ * @brief       Write everything appended so far
+ *
+ * @descr       Blocks until the flash is done, the rest of the active page
+ *              is left unused. Call at the end of a session or before
+ *              power down.
+ *
+ * @return      -
+ */
+void flashlogFlush(void)
+{
+    if (!mounted) {
+        return;
+    }
+    Semaphore_pend(hLock, BIOS_WAIT_FOREVER);
+    while (pending || fill) {
+        if (fill && !pending) {
+            flashlogSeal();
+        } else {
+            flashlogProgram();
+        }
+        if (pending) {
+            Task_sleep(1000 / Clock_tickPeriod);
+        }
+    }
+    while (extflashBusy()) {
+        Task_sleep(1000 / Clock_tickPeriod);
+    }
+    Semaphore_post(hLock);
+}
+
+/*******************************************************************************
+ * @fn          flashlogRewind
+ *
+ * @brief       Start a readout from the oldest data
+ *
+ * @return      -
+ */
+void flashlogRewind(FlashlogCursor *cursor)
+{
+    // The sector after the head's one is the oldest, the head's is the newest
+    cursor->address = nextAddress(head - head % FLASHLOG_SECTOR_SIZE, FLASHLOG_SECTOR_SIZE);
+    cursor->left = mounted ? FLASHLOG_SIZE : 0;
+}
+
+/*******************************************************************************
+ * @fn          flashlogRead
+ *
+ * @brief       Read the next piece of the written pages
+ *
+ * @descr       Returns raw page bytes, headers included, at most up to the
+ *              end of a page. Blank pages and sectors are skipped quickly.
+ *              *address gets the flash address of the bytes.
+ *
+ * @return      Number of bytes read, 0 at the end of the log
+ */
+uint16_t flashlogRead(FlashlogCursor *cursor, void *data, uint16_t size, uint32_t *address)
+{
+    uint8_t magic[2];
+    uint16_t count = 0;
+    uint32_t step;
+
+    if (!mounted) {
+        return 0;
+    }
+    Semaphore_pend(hLock, BIOS_WAIT_FOREVER);
+    while (cursor->left) {
+        if (cursor->address % FLASHLOG_PAGE_SIZE == 0) {
+            extflashRead(cursor->address, magic, sizeof(magic));
+            if (get16(magic) == FLASHLOG_ERASED) {
+                // A blank first page means a blank sector
+                step = cursor->address % FLASHLOG_SECTOR_SIZE ? FLASHLOG_PAGE_SIZE : FLASHLOG_SECTOR_SIZE;
+                cursor->address = nextAddress(cursor->address, step);
+                cursor->left -= step;
+                continue;
+            }
+        }
+        count = FLASHLOG_PAGE_SIZE - cursor->address % FLASHLOG_PAGE_SIZE;
+        if (count > size) {
+            count = size;
+        }
+        extflashRead(cursor->address, data, count);
+        *address = cursor->address;
+        cursor->address = nextAddress(cursor->address, count);
+        cursor->left -= count;
+        break;
+    }
+    Semaphore_post(hLock);
+    return count;
+}
+
+/*******************************************************************************
+ * @fn          flashlogGetStats
+ *
+ * @brief       Copy of the log statistics
+ *
+ * @return      -
+ */
+void flashlogGetStats(FlashlogStats *copy)
+{
+    *copy = stats;
+}
@@ -0,0 +1,55 @@
+/** ============================================================================
+ *  @file       flashlog.h
+ *
+ *  @brief      Append-only ring log of data sessions on the external flash.
+ *
+ *  Records are collected in a RAM page and programmed a whole page at a
+ *  time. A full page is handed to the flash while the next one fills, so
+ *  appending never waits for a program or an erase, flashlogPoll() moves
+ *  the pages on. The sectors are taken in turn around the ring, so they
+ *  all wear evenly, and each page carries its sector's erase count. The
+ *  oldest sector is erased when the ring wraps. See flashlog_format.h for
+ *  the layout, host/flashparse reads a dumped image.
+ *  All functions are task-safe, call them from tasks only.
+ *  ============================================================================
+ */
+#ifndef _FLASHLOG_H_
+#define _FLASHLOG_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+#include "flashlog_format.h"
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    uint32_t written;   // pages programmed since boot
+    uint32_t dropped;   // records dropped while both pages were full
+    uint32_t seq;       // seq of the next page
+    uint16_t minWear;   // fewest and most erases of a used sector
+    uint16_t maxWear;
+} FlashlogStats;
+
+// Position of a sequential readout, oldest data first
+typedef struct {
+    uint32_t address;
+    uint32_t left;      // bytes of the ring not visited yet
+} FlashlogCursor;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+int flashlogOpen(void);
+int flashlogAppend(FlashlogRecordType type, const void *data, uint8_t length);
+void flashlogPoll(void);
+void flashlogFlush(void);
+void flashlogRewind(FlashlogCursor *cursor);
+uint16_t flashlogRead(FlashlogCursor *cursor, void *data, uint16_t size, uint32_t *address);
+void flashlogGetStats(FlashlogStats *stats);
+
+#endif
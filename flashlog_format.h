@@ -0,0 +1,43 @@
+/** ============================================================================
+ *  @file       flashlog_format.h
+ *
+ *  @brief      On-flash layout of the data session log, shared with
+ *              host/flashparse.
+ *
+ *  The log is a ring of 256 byte pages in the region below. Each page is
+ *  written exactly once, whole, and starts with a header:
+ *      magic u16, length u16, seq u32, wear u16, crc u16
+ *  length is the number of record bytes after the header, seq counts the
+ *  written pages since the log was created and wear is the number of
+ *  times the page's sector has been erased. The crc is CRC-16/CCITT-FALSE
+ *  over the header up to wear and the record bytes. An erased page reads
+ *  as magic 0xFFFF. All fields are little endian.
+ *
+ *  A record is type u8, length u8 and length bytes of data. Records
+ *  never cross pages.
+ *  ============================================================================
+ */
+#ifndef _FLASHLOG_FORMAT_H_
+#define _FLASHLOG_FORMAT_H_
+
+// The first 64 kB of the flash are left for firmware images and settings
+#define FLASHLOG_BASE           0x10000
+#define FLASHLOG_SIZE           0xF0000
+#define FLASHLOG_SECTOR_SIZE    4096
+#define FLASHLOG_PAGE_SIZE      256
+
+#define FLASHLOG_MAGIC          0x4C47
+#define FLASHLOG_ERASED         0xFFFF
+#define FLASHLOG_HEADER_SIZE    12
+#define FLASHLOG_CRC_OFFSET     10
+#define FLASHLOG_PAYLOAD_SIZE   (FLASHLOG_PAGE_SIZE - FLASHLOG_HEADER_SIZE)
+#define FLASHLOG_RECORD_HEADER  2
+
+// Record types and their data
+typedef enum {
+    FLASHLOG_SESSION = 1,   // tick u32, started u8 (1 = start, 0 = end)
+    FLASHLOG_MOTION  = 2,   // tick u32, ax ay az gx gy gz float
+    FLASHLOG_LIGHT   = 3    // tick u32, lux float
+} FlashlogRecordType;
+
+#endif
@@ -0,0 +1,192 @@
+/* capture: writes the bench stream of the tamagotchi as Debug/data.csv lines.
+ *
+ * Reads the raw serial stream from stdin, after the gateway command
+ * STREAM:1, and prints one line per IMU sample in the format of the
+ * data.csv captures made from the debug console:
+ *     <time s>,ax,ay,az,gx,gy,gz
+ * acceleration in g, rotation in deg/s. The raw samples are scaled with
+ * the latest scale frame, samples before the first one are skipped. With
+ * -l the light samples go to their own file as <time s>,lux. With -p the
+ * time is printed in seconds to 5 decimals and the values to 4, instead
+ * of the whole seconds and 2 decimals of data.csv. Other frames are
+ * ignored, a summary goes to stderr: samples, lost samples and bad frames.
+ *
+ * Build: gcc -O2 -I../.. -o capture capture.c
+ * Usage: stty -F /dev/ttyACM0 921600 raw && ./capture [-p] [-l light.csv] < /dev/ttyACM0 > data.csv
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "serial.h"
+#include "stream_format.h"
+
+// Clock.tickPeriod in empty.cfg, the samples carry Clock ticks
+#define TICK_US 10
+#define FRAME_MAX 1024
+
+static unsigned long badFrames = 0;
+static unsigned long samples = 0;
+static unsigned long skipped = 0;
+static unsigned long lost = 0;
+static int lastSeq = -1;
+static int precise = 0;
+static FILE *lightFile = NULL;
+
+static int haveScale = 0;
+static float aRes, gRes;
+static float accelBias[3];
+
+static int16_t le16(const uint8_t *p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float lefloat(const uint8_t *p) {
+    union {
+        uint32_t u;
+        float f;
+    } bits;
+
+    bits.u = le32(p);
+    return bits.f;
+}
+
+// The time column, whole seconds like systemTime in data.csv
+static void printTime(FILE *file, uint32_t tick) {
+    if (precise) {
+        fprintf(file, "%.5f", tick * (TICK_US / 1e6));
+    } else {
+        fprintf(file, "%d", (int)(tick / (1000000 / TICK_US)));
+    }
+}
+
+// The same conversion as mpu9250_get_data
+static void imuSample(const uint8_t *data, int length) {
+    const char *format = precise ? ",%.4f" : ",%.2f";
+    int16_t raw[7];
+    int seq, i;
+
+    if (length != STREAM_IMU_SIZE) {
+        badFrames++;
+        return;
+    }
+    seq = data[4] | (data[5] << 8);
+    // The device counts the samples it had no room for too
+    if (lastSeq >= 0) {
+        lost += (seq - lastSeq - 1) & 0xFFFF;
+    }
+    lastSeq = seq;
+    if (!haveScale) {
+        skipped++;
+        return;
+    }
+    for (i = 0; i < 7; i++) {
+        raw[i] = le16(data + 6 + 2 * i);
+    }
+
+    printTime(stdout, le32(data));
+    for (i = 0; i < 3; i++) {
+        printf(format, raw[i] * aRes - accelBias[i]);
+    }
+    for (i = 4; i < 7; i++) {
+        printf(format, raw[i] * gRes);
+    }
+    putchar('\n');
+    samples++;
+}
+
+static void lightSample(const uint8_t *data, int length) {
+    if (length != STREAM_LIGHT_SIZE) {
+        badFrames++;
+        return;
+    }
+    if (lightFile) {
+        printTime(lightFile, le32(data));
+        fprintf(lightFile, precise ? ",%.4f\n" : ",%.2f\n", lefloat(data + 4));
+    }
+}
+
+static void scale(const uint8_t *data, int length) {
+    int i;
+
+    if (length != STREAM_SCALE_SIZE) {
+        badFrames++;
+        return;
+    }
+    aRes = lefloat(data);
+    gRes = lefloat(data + 4);
+    for (i = 0; i < 3; i++) {
+        accelBias[i] = lefloat(data + 8 + 4 * i);
+    }
+    haveScale = 1;
+}
+
+static void frame(const uint8_t *data, int length) {
+    if (length < 3 || serialCrc16(0xFFFF, data, length - 2) != (data[length - 2] | (data[length - 1] << 8))) {
+        badFrames++;
+        return;
+    }
+    length -= 2;
+    switch (data[0]) {
+    case SERIAL_FRAME_IMU:
+        imuSample(data + 1, length - 1);
+        break;
+    case SERIAL_FRAME_LIGHT:
+        lightSample(data + 1, length - 1);
+        break;
+    case SERIAL_FRAME_IMU_SCALE:
+        scale(data + 1, length - 1);
+        break;
+    default:
+        // Text, log and flash frames, see host/logdec
+        break;
+    }
+}
+
+int main(int argc, char **argv) {
+    static uint8_t data[FRAME_MAX];
+    int length = 0;
+    int escaped = 0;
+    int c, i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0) {
+            precise = 1;
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            lightFile = fopen(argv[++i], "w");
+            if (!lightFile) {
+                perror(argv[i]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "usage: capture [-p] [-l light.csv] < serial-stream > data.csv\n");
+            return 1;
+        }
+    }
+
+    while ((c = getchar()) != EOF) {
+        if (c == SERIAL_FLAG) {
+            if (length > 0) {
+                frame(data, length);
+            }
+            length = 0;
+            escaped = 0;
+        } else if (c == SERIAL_ESCAPE) {
+            escaped = 1;
+        } else if (length < FRAME_MAX) {
+            data[length++] = escaped ? c ^ SERIAL_ESCAPE_XOR : c;
+            escaped = 0;
+        }
+    }
+    fprintf(stderr, "capture: %lu samples, %lu lost, %lu before the scale, %lu bad frames\n",
+            samples, lost, skipped, badFrames);
+    if (lightFile) {
+        fclose(lightFile);
+    }
+    return 0;
+}
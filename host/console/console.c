@@ -0,0 +1,297 @@
+/* console: command line client of the serial console of the tamagotchi.
+ *
+ * Sends one command (see console_format.h), waits for its reply and prints
+ * the results as text, one value per line, so the tool can be scripted.
+ * The other frames on the line (log, stream) are skipped, decode them with
+ * host/logdec when needed. Exits with 1 if the device refused the command
+ * or did not answer in time.
+ *
+ *     console <tty> ping
+ *     console <tty> stats
+ *     console <tty> params                     all parameters with their ranges
+ *     console <tty> get <param>
+ *     console <tty> set <param> <value>
+ *     console <tty> selftest                   the device must lie still
+ *     console <tty> calibration
+ *     console <tty> bench <name>|all [count]
+ *     console <tty> stream on|off
+ *
+ * Parameter and benchmark names are those of params.h and console_format.h
+ * in lower case without the prefix, e.g. "set sample_period_ms 50".
+ *
+ * Build: gcc -O2 -I../.. -o console console.c
+ * Usage: ./console /dev/ttyACM0 bench all 100
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/select.h>
+
+#include "serial.h"
+#include "params.h"
+#include "console_format.h"
+
+#define FRAME_MAX 1024
+// The self test result is read later, this covers a benchmark of 1000 runs
+#define REPLY_TIMEOUT_S 5
+
+#define NAME_STRING(id, ...) #id,
+static const char *paramNames[] = {
+    PARAMS(NAME_STRING)
+};
+static const char *statNames[] = {
+    CONSOLE_STATS(NAME_STRING)
+};
+static const char *benchNames[] = {
+    CONSOLE_BENCHES(NAME_STRING)
+};
+#undef NAME_STRING
+
+static const char *statusNames[] = {
+    "ok", "unknown command", "bad length", "bad argument", "failed"
+};
+
+static int fd = -1;
+static uint8_t nextTag = 0;
+
+static uint16_t le16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float lefloat(const uint8_t *p) {
+    union {
+        uint32_t u;
+        float f;
+    } bits;
+
+    bits.u = le32(p);
+    return bits.f;
+}
+
+static void putfloat(uint8_t *p, float value) {
+    union {
+        uint32_t u;
+        float f;
+    } bits;
+
+    bits.f = value;
+    p[0] = bits.u;
+    p[1] = bits.u >> 8;
+    p[2] = bits.u >> 16;
+    p[3] = bits.u >> 24;
+}
+
+// "PARAM_SAMPLE_PERIOD_MS" matches "sample_period_ms"
+static int lookup(const char **names, int count, const char *prefix, const char *name) {
+    const char *full;
+    int i, j;
+
+    for (i = 0; i < count; i++) {
+        full = names[i] + strlen(prefix);
+        for (j = 0; full[j] && tolower((unsigned char)full[j]) == name[j]; j++) {
+        }
+        if (!full[j] && !name[j]) {
+            return i;
+        }
+    }
+    fprintf(stderr, "console: unknown name %s\n", name);
+    exit(1);
+}
+
+static void lower(const char *name, const char *prefix) {
+    for (name += strlen(prefix); *name; name++) {
+        putchar(tolower((unsigned char)*name));
+    }
+}
+
+static int openTty(const char *path) {
+    struct termios tio;
+
+    fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return 0;
+    }
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, B921600);
+        cfsetospeed(&tio, B921600);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    return 1;
+}
+
+static void putByte(uint8_t *out, int *length, uint8_t c) {
+    if (c == SERIAL_FLAG || c == SERIAL_ESCAPE) {
+        out[(*length)++] = SERIAL_ESCAPE;
+        c ^= SERIAL_ESCAPE_XOR;
+    }
+    out[(*length)++] = c;
+}
+
+static void sendCommand(uint8_t cmd, uint8_t tag, const uint8_t *args, int count) {
+    uint8_t frame[64];
+    uint8_t out[2 * sizeof(frame) + 2];
+    uint16_t crc;
+    int length = 0;
+    int i;
+
+    frame[0] = SERIAL_FRAME_COMMAND;
+    frame[1] = cmd;
+    frame[2] = tag;
+    memcpy(frame + 3, args, count);
+    count += 3;
+    crc = serialCrc16(0xFFFF, frame, count);
+    frame[count++] = crc;
+    frame[count++] = crc >> 8;
+
+    out[length++] = SERIAL_FLAG;
+    for (i = 0; i < count; i++) {
+        putByte(out, &length, frame[i]);
+    }
+    out[length++] = SERIAL_FLAG;
+    if (write(fd, out, length) != length) {
+        perror("console: write");
+        exit(1);
+    }
+}
+
+// Reads frames until the reply with the tag, returns the length of its results
+static int waitReply(uint8_t tag, uint8_t *results) {
+    static uint8_t data[FRAME_MAX];
+    static int length = 0;
+    static int escaped = 0;
+    struct timeval timeout = {REPLY_TIMEOUT_S, 0};
+    fd_set fds;
+    uint8_t c;
+
+    while (1) {
+        FD_ZERO(&fds);
+        FD_SET(fd, &fds);
+        if (select(fd + 1, &fds, NULL, NULL, &timeout) <= 0 || read(fd, &c, 1) != 1) {
+            fprintf(stderr, "console: no reply\n");
+            exit(1);
+        }
+        if (c == SERIAL_FLAG) {
+            if (length >= 3 + CONSOLE_REPLY_HEADER && data[0] == SERIAL_FRAME_REPLY && data[2] == tag &&
+                serialCrc16(0xFFFF, data, length - 2) == (data[length - 2] | (data[length - 1] << 8))) {
+                if (data[3] != CONSOLE_OK) {
+                    fprintf(stderr, "console: %s\n", data[3] < 5 ? statusNames[data[3]] : "error");
+                    exit(1);
+                }
+                memcpy(results, data + 1 + CONSOLE_REPLY_HEADER, length - 3 - CONSOLE_REPLY_HEADER);
+                length -= 3 + CONSOLE_REPLY_HEADER;
+                return length;
+            }
+            length = 0;
+            escaped = 0;
+        } else if (c == SERIAL_ESCAPE) {
+            escaped = 1;
+        } else if (length < FRAME_MAX) {
+            data[length++] = escaped ? c ^ SERIAL_ESCAPE_XOR : c;
+            escaped = 0;
+        }
+    }
+}
+
+static int command(uint8_t cmd, const uint8_t *args, int count, uint8_t *results) {
+    uint8_t tag = nextTag++;
+
+    sendCommand(cmd, tag, args, count);
+    return waitReply(tag, results);
+}
+
+static void printParam(const uint8_t *r) {
+    lower(paramNames[r[0]], "PARAM_");
+    printf(" %g (%g..%g)\n", lefloat(r + 1), lefloat(r + 5), lefloat(r + 9));
+}
+
+static void bench(int id, uint16_t count) {
+    uint8_t args[3] = {id, count, count >> 8};
+    uint8_t r[FRAME_MAX];
+
+    command(CONSOLE_BENCH, args, 3, r);
+    lower(benchNames[r[0]], "CONSOLE_BENCH_");
+    printf(" runs %u min %u avg %u max %u cycles, min %.1f us\n", le16(r + 1),
+           le32(r + 3), le32(r + 7), le32(r + 11), le32(r + 3) / 48.0);
+}
+
+int main(int argc, char **argv) {
+    uint8_t args[8];
+    uint8_t r[FRAME_MAX];
+    int count, i;
+
+    if (argc < 3 || !openTty(argv[1])) {
+        fprintf(stderr, "usage: console <tty> ping|stats|params|get|set|selftest|calibration|bench|stream ...\n");
+        return 1;
+    }
+
+    if (strcmp(argv[2], "ping") == 0) {
+        command(CONSOLE_PING, NULL, 0, r);
+        printf("version %u, up %.2f s\n", r[0], le32(r + 1) / 100000.0);
+    } else if (strcmp(argv[2], "stats") == 0) {
+        count = command(CONSOLE_GET_STATS, NULL, 0, r) / 4;
+        for (i = 0; i < count && i < CONSOLE_STAT_COUNT; i++) {
+            lower(statNames[i], "CONSOLE_STAT_");
+            printf(" %u\n", le32(r + 4 * i));
+        }
+    } else if (strcmp(argv[2], "params") == 0) {
+        for (i = 0; i < PARAM_COUNT; i++) {
+            args[0] = i;
+            command(CONSOLE_GET_PARAM, args, 1, r);
+            printParam(r);
+        }
+    } else if (strcmp(argv[2], "get") == 0 && argc == 4) {
+        args[0] = lookup(paramNames, PARAM_COUNT, "PARAM_", argv[3]);
+        command(CONSOLE_GET_PARAM, args, 1, r);
+        printParam(r);
+    } else if (strcmp(argv[2], "set") == 0 && argc == 5) {
+        args[0] = lookup(paramNames, PARAM_COUNT, "PARAM_", argv[3]);
+        putfloat(args + 1, atof(argv[4]));
+        command(CONSOLE_SET_PARAM, args, 5, r);
+        lower(paramNames[r[0]], "PARAM_");
+        printf(" %g\n", lefloat(r + 1));
+    } else if (strcmp(argv[2], "selftest") == 0) {
+        command(CONSOLE_SELF_TEST, NULL, 0, r);
+        printf("self test started, read the result with \"calibration\"\n");
+    } else if (strcmp(argv[2], "calibration") == 0) {
+        command(CONSOLE_GET_CALIBRATION, NULL, 0, r);
+        printf("temperature %.1f\n", lefloat(r));
+        for (i = 0; i < 6; i++) {
+            printf("self_test_%s%c %.1f %%\n", i < 3 ? "accel_" : "gyro_", 'x' + i % 3, lefloat(r + 4 + 4 * i));
+        }
+        for (i = 0; i < 3; i++) {
+            printf("gyro_bias_%c %.3f\n", 'x' + i, lefloat(r + 28 + 4 * i));
+        }
+        for (i = 0; i < 3; i++) {
+            printf("accel_bias_%c %.4f\n", 'x' + i, lefloat(r + 40 + 4 * i));
+        }
+    } else if (strcmp(argv[2], "bench") == 0 && (argc == 4 || argc == 5)) {
+        count = argc == 5 ? atoi(argv[4]) : 100;
+        if (strcmp(argv[3], "all") == 0) {
+            for (i = 0; i < CONSOLE_BENCH_COUNT; i++) {
+                bench(i, count);
+            }
+        } else {
+            bench(lookup(benchNames, CONSOLE_BENCH_COUNT, "CONSOLE_BENCH_", argv[3]), count);
+        }
+    } else if (strcmp(argv[2], "stream") == 0 && argc == 4) {
+        args[0] = strcmp(argv[3], "on") == 0;
+        command(CONSOLE_STREAM, args, 1, r);
+    } else {
+        fprintf(stderr, "console: bad command\n");
+        return 1;
+    }
+    close(fd);
+    return 0;
+}
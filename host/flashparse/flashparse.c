@@ -0,0 +1,172 @@
+/* flashparse: reads the data session log out of an external flash image.
+ *
+ * The image is a dump of the whole flash, file offset = flash address,
+ * e.g. from "logdec -i flash.bin" after a FLASHDUMP command. The pages of
+ * the log (see flashlog_format.h) are checked, put in write order and
+ * their records printed as CSV, one sample per line:
+ *     session,<time s>,start|end
+ *     motion,<time s>,ax,ay,az,gx,gy,gz
+ *     light,<time s>,lux
+ * A summary goes to stderr: pages, bad pages, missing pages and wear.
+ *
+ * Build: gcc -O2 -I../.. -o flashparse flashparse.c
+ * Usage: ./flashparse flash.bin > sessions.csv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "flashlog_format.h"
+#include "serial.h"
+
+// Clock.tickPeriod in empty.cfg, the records carry Clock ticks
+#define TICK_US 10
+#define PAGE_COUNT (FLASHLOG_SIZE / FLASHLOG_PAGE_SIZE)
+
+typedef struct {
+    uint32_t seq;
+    const uint8_t *page;
+} Page;
+
+static uint16_t le16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float lefloat(const uint8_t *p) {
+    union {
+        uint32_t u;
+        float f;
+    } bits;
+
+    bits.u = le32(p);
+    return bits.f;
+}
+
+// Write order, the seq may have wrapped around 2^32
+static int compareSeq(const void *a, const void *b) {
+    int32_t diff = (int32_t)(((const Page *)a)->seq - ((const Page *)b)->seq);
+    return (diff > 0) - (diff < 0);
+}
+
+// Returns 0 if the page is damaged
+static int checkPage(const uint8_t *page) {
+    uint16_t length = le16(page + 2);
+    uint16_t crc;
+
+    if (length > FLASHLOG_PAYLOAD_SIZE) {
+        return 0;
+    }
+    crc = serialCrc16(0xFFFF, page, FLASHLOG_CRC_OFFSET);
+    crc = serialCrc16(crc, page + FLASHLOG_HEADER_SIZE, length);
+    return crc == le16(page + FLASHLOG_CRC_OFFSET);
+}
+
+// Returns the number of malformed records
+static int printRecords(const uint8_t *page) {
+    const uint8_t *record = page + FLASHLOG_HEADER_SIZE;
+    const uint8_t *end = record + le16(page + 2);
+    uint8_t type, length;
+    double time;
+    int i;
+
+    while (record + FLASHLOG_RECORD_HEADER <= end) {
+        type = record[0];
+        length = record[1];
+        record += FLASHLOG_RECORD_HEADER;
+        if (record + length > end || length < 4) {
+            return 1;
+        }
+        time = le32(record) * (TICK_US / 1e6);
+        switch (type) {
+        case FLASHLOG_SESSION:
+            printf("session,%.5f,%s\n", time, length > 4 && record[4] ? "start" : "end");
+            break;
+        case FLASHLOG_MOTION:
+            printf("motion,%.5f", time);
+            for (i = 4; i + 4 <= length; i += 4) {
+                printf(",%.3f", lefloat(record + i));
+            }
+            putchar('\n');
+            break;
+        case FLASHLOG_LIGHT:
+            printf("light,%.5f,%.2f\n", time, length >= 8 ? lefloat(record + 4) : 0.0f);
+            break;
+        default:
+            printf("unknown-%d,%.5f\n", type, time);
+            break;
+        }
+        record += length;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static uint8_t image[FLASHLOG_BASE + FLASHLOG_SIZE];
+    static Page pages[PAGE_COUNT];
+    FILE *file;
+    size_t size;
+    const uint8_t *page;
+    int count = 0;
+    int bad = 0;
+    int malformed = 0;
+    unsigned long missing = 0;
+    unsigned minWear = 0xFFFF, maxWear = 0, wear;
+    int i;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: flashparse flash.bin\n");
+        return 1;
+    }
+    file = fopen(argv[1], "rb");
+    if (!file) {
+        perror(argv[1]);
+        return 1;
+    }
+    // A short image reads as blank flash
+    memset(image, 0xFF, sizeof(image));
+    size = fread(image, 1, sizeof(image), file);
+    fclose(file);
+    if (size <= FLASHLOG_BASE) {
+        fprintf(stderr, "flashparse: %s ends before the log region\n", argv[1]);
+        return 1;
+    }
+
+    for (i = 0; i < PAGE_COUNT; i++) {
+        page = image + FLASHLOG_BASE + i * FLASHLOG_PAGE_SIZE;
+        if (le16(page) == FLASHLOG_ERASED) {
+            continue;
+        }
+        if (le16(page) != FLASHLOG_MAGIC || !checkPage(page)) {
+            bad++;
+            continue;
+        }
+        wear = le16(page + 8);
+        minWear = wear < minWear ? wear : minWear;
+        maxWear = wear > maxWear ? wear : maxWear;
+        pages[count].seq = le32(page + 4);
+        pages[count].page = page;
+        count++;
+    }
+    qsort(pages, count, sizeof(Page), compareSeq);
+
+    for (i = 0; i < count; i++) {
+        if (i > 0) {
+            missing += pages[i].seq - pages[i - 1].seq - 1;
+        }
+        malformed += printRecords(pages[i].page);
+    }
+
+    fprintf(stderr, "flashparse: %d pages", count);
+    if (count) {
+        fprintf(stderr, " (seq %lu..%lu), wear %u..%u",
+                (unsigned long)pages[0].seq, (unsigned long)pages[count - 1].seq, minWear, maxWear);
+    }
+    fprintf(stderr, ", %d bad pages, %lu missing pages, %d malformed\n", bad, missing, malformed);
+    return 0;
+}
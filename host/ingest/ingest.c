@@ -0,0 +1,406 @@
+/* Gateway-side ingest parser for the tamagotchi radio protocol.
+ *
+ * Frames are split on ',' and '\n' with a 16 byte wide SSE2 scan when the
+ * compiler targets it, and a plain byte loop otherwise. Keys are dispatched
+ * on their length first so that each field costs at most one short memcmp.
+ */
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "ingest.h"
+
+// Column indices of the motion fields
+enum { IMU_AX, IMU_AY, IMU_AZ, IMU_GX, IMU_GY, IMU_GZ, IMU_FIELDS };
+#define IMU_ALL ((1 << IMU_FIELDS) - 1)
+
+// A frame carries at most a handful of events
+#define FRAME_MAX_EVENTS 4
+
+typedef struct {
+    uint16_t id;
+    unsigned imuMask;
+    int32_t imu[IMU_FIELDS];
+    int hasLight;
+    int32_t lux;
+    int events;
+    uint8_t eventKind[FRAME_MAX_EVENTS];
+    int32_t eventValue[FRAME_MAX_EVENTS];
+    int malformed;
+} Frame;
+
+
+/* Finds the next field or frame delimiter (',' or '\n').
+ * Parameters:
+ * - const char *p: Where to start looking.
+ * - const char *end: One past the last byte of the buffer.
+ * Returns:
+ * - Pointer to the delimiter, or end if there is none.
+ */
+static const char *findDelimiter(const char *p, const char *end) {
+#if defined(__SSE2__)
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, comma), _mm_cmpeq_epi8(chunk, newline));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != ',' && *p != '\n') {
+        p++;
+    }
+    return p;
+}
+
+
+/* Parses a decimal number printed with %.2f into hundredths.
+ * A single fractional digit is scaled up and a third one is rounded away,
+ * so values printed with other precisions are still accepted.
+ * Parameters:
+ * - const char *s: Start of the number, not NUL terminated.
+ * - size_t len: Length of the number.
+ * - int32_t *out: Where the value in hundredths is stored.
+ * Returns:
+ * - 1 on success, 0 if the text is not a number or does not fit.
+ */
+int ingest_parse_fixed2(const char *s, size_t len, int32_t *out) {
+    const char *end = s + len;
+    int negative = 0;
+    int digits = 0;
+    int64_t value = 0;
+    int fraction = 0;
+
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = (*s == '-');
+        s++;
+    }
+    while (s < end && (unsigned)(*s - '0') < 10) {
+        value = value * 10 + (*s - '0');
+        s++;
+        if (++digits > 9) {
+            return 0;
+        }
+    }
+    value *= 100;
+    if (s < end && *s == '.') {
+        s++;
+        if (s < end && (unsigned)(*s - '0') < 10) {
+            value += (*s++ - '0') * 10;
+            fraction++;
+        }
+        if (s < end && (unsigned)(*s - '0') < 10) {
+            value += (*s++ - '0');
+            fraction++;
+        }
+        if (s < end && (unsigned)(*s - '0') < 10) {
+            value += (*s - '0') >= 5;
+            fraction++;
+        }
+        while (s < end && (unsigned)(*s - '0') < 10) {
+            s++;
+        }
+    }
+    if (s != end || (digits == 0 && fraction == 0) || value > INT32_MAX) {
+        return 0;
+    }
+
+    *out = (int32_t)(negative ? -value : value);
+    return 1;
+}
+
+
+// Parses the hexadecimal device address of the id field
+static int parseId(const char *s, size_t len, uint16_t *out) {
+    uint32_t value = 0;
+    size_t i;
+
+    if (len == 0 || len > 4) {
+        return 0;
+    }
+    for (i = 0; i < len; i++) {
+        char c = s[i];
+        if ((unsigned)(c - '0') < 10) {
+            value = (value << 4) | (uint32_t)(c - '0');
+        } else if ((unsigned)((c | 0x20) - 'a') < 6) {
+            value = (value << 4) | (uint32_t)((c | 0x20) - 'a' + 10);
+        } else {
+            return 0;
+        }
+    }
+    *out = (uint16_t)value;
+    return 1;
+}
+
+
+// Parses a small unsigned integer such as the amount of an EAT event
+static int parseUint(const char *s, size_t len, int32_t *out) {
+    int32_t value = 0;
+    size_t i;
+
+    if (len == 0 || len > 9) {
+        return 0;
+    }
+    for (i = 0; i < len; i++) {
+        if ((unsigned)(s[i] - '0') >= 10) {
+            return 0;
+        }
+        value = value * 10 + (s[i] - '0');
+    }
+    *out = value;
+    return 1;
+}
+
+
+/* Parses the "a;b;c" value of an ACTIVATE field.
+ * The three amounts are packed as (a << 16) | (b << 8) | c.
+ */
+static int parseActivate(const char *s, size_t len, int32_t *out) {
+    const char *end = s + len;
+    int32_t packed = 0;
+    int parts = 0;
+
+    while (parts < 3) {
+        const char *sep = s;
+        int32_t part;
+        while (sep < end && *sep != ';') {
+            sep++;
+        }
+        if (!parseUint(s, (size_t)(sep - s), &part) || part > 255) {
+            return 0;
+        }
+        packed = (packed << 8) | part;
+        parts++;
+        if (sep == end) {
+            break;
+        }
+        s = sep + 1;
+    }
+    if (parts != 3) {
+        return 0;
+    }
+    *out = packed;
+    return 1;
+}
+
+
+static void addEvent(Frame *frame, uint8_t kind, int32_t value) {
+    if (frame->events < FRAME_MAX_EVENTS) {
+        frame->eventKind[frame->events] = kind;
+        frame->eventValue[frame->events] = value;
+        frame->events++;
+    }
+}
+
+
+/* Decodes one key:value field into the frame being assembled.
+ * Unknown keys (MSG1, MSG2, ...) are skipped.
+ */
+static void parseField(Frame *frame, const char *field, size_t len) {
+    const char *colon = memchr(field, ':', len);
+    const char *value;
+    size_t keyLen, valueLen;
+    int32_t number = 0;
+    int ok = 1;
+
+    if (colon == NULL) {
+        return;
+    }
+    keyLen = (size_t)(colon - field);
+    value = colon + 1;
+    valueLen = len - keyLen - 1;
+
+    switch (keyLen) {
+    case 2:
+        if (field[0] == 'i' && field[1] == 'd') {
+            ok = parseId(value, valueLen, &frame->id);
+        } else if ((field[0] == 'a' || field[0] == 'g') && (unsigned)(field[1] - 'x') < 3) {
+            int column = (field[0] == 'g' ? IMU_GX : IMU_AX) + (field[1] - 'x');
+            ok = ingest_parse_fixed2(value, valueLen, &frame->imu[column]);
+            frame->imuMask |= 1u << column;
+        }
+        break;
+    case 3:
+        if (memcmp(field, "EAT", 3) == 0) {
+            ok = parseUint(value, valueLen, &number);
+            addEvent(frame, INGEST_EVENT_EAT, number);
+        } else if (memcmp(field, "PET", 3) == 0) {
+            ok = parseUint(value, valueLen, &number);
+            addEvent(frame, INGEST_EVENT_PET, number);
+        }
+        break;
+    case 5:
+        if (memcmp(field, "light", 5) == 0) {
+            ok = ingest_parse_fixed2(value, valueLen, &frame->lux);
+            frame->hasLight = 1;
+        }
+        break;
+    case 7:
+        if (memcmp(field, "session", 7) == 0) {
+            if (valueLen == 5 && memcmp(value, "start", 5) == 0) {
+                addEvent(frame, INGEST_EVENT_SESSION_START, 0);
+            } else if (valueLen == 3 && memcmp(value, "end", 3) == 0) {
+                addEvent(frame, INGEST_EVENT_SESSION_END, 0);
+            } else {
+                ok = 0;
+            }
+        }
+        break;
+    case 8:
+        if (memcmp(field, "EXERCISE", 8) == 0) {
+            ok = parseUint(value, valueLen, &number);
+            addEvent(frame, INGEST_EVENT_EXERCISE, number);
+        } else if (memcmp(field, "ACTIVATE", 8) == 0) {
+            ok = parseActivate(value, valueLen, &number);
+            addEvent(frame, INGEST_EVENT_ACTIVATE, number);
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (!ok) {
+        frame->malformed = 1;
+    }
+}
+
+
+// Appends the rows of a finished frame to the batch tables
+static void commitFrame(IngestBatch *batch, const Frame *frame) {
+    int i;
+
+    batch->frames++;
+    if (frame->malformed || (frame->imuMask != 0 && frame->imuMask != IMU_ALL)) {
+        batch->malformed++;
+        return;
+    }
+
+    if (frame->imuMask == IMU_ALL) {
+        IngestImuTable *t = &batch->imu;
+        size_t row = t->count++;
+        t->id[row] = frame->id;
+        t->ax[row] = frame->imu[IMU_AX];
+        t->ay[row] = frame->imu[IMU_AY];
+        t->az[row] = frame->imu[IMU_AZ];
+        t->gx[row] = frame->imu[IMU_GX];
+        t->gy[row] = frame->imu[IMU_GY];
+        t->gz[row] = frame->imu[IMU_GZ];
+    }
+    if (frame->hasLight) {
+        IngestLightTable *t = &batch->light;
+        size_t row = t->count++;
+        t->id[row] = frame->id;
+        t->lux[row] = frame->lux;
+    }
+    for (i = 0; i < frame->events; i++) {
+        IngestEventTable *t = &batch->events;
+        size_t row = t->count++;
+        t->id[row] = frame->id;
+        t->kind[row] = frame->eventKind[i];
+        t->value[row] = frame->eventValue[i];
+    }
+}
+
+
+// Empties all tables of the batch. The storage itself is reused.
+void ingest_batch_reset(IngestBatch *batch) {
+    batch->imu.count = 0;
+    batch->light.count = 0;
+    batch->events.count = 0;
+    batch->frames = 0;
+    batch->malformed = 0;
+}
+
+
+/* Tells whether the next frame might not fit in the batch.
+ * Returns:
+ * - 1 if any table has less room than one frame can use, 0 otherwise.
+ */
+int ingest_batch_full(const IngestBatch *batch) {
+    return batch->imu.count >= INGEST_BATCH_ROWS
+        || batch->light.count >= INGEST_BATCH_ROWS
+        || batch->events.count > INGEST_BATCH_ROWS - FRAME_MAX_EVENTS;
+}
+
+
+/* Parses a single frame, e.g. one radio payload.
+ * Parameters:
+ * - IngestBatch *batch: Batch receiving the decoded rows.
+ * - const char *frame: Frame text, not NUL terminated. A trailing newline or
+ *                      NUL is allowed.
+ * - size_t len: Length of the frame.
+ * Returns:
+ * - 1 if the frame was stored, 0 if the batch is full and must be flushed.
+ */
+int ingest_parse_frame(IngestBatch *batch, const char *frame, size_t len) {
+    const char *end = frame + len;
+    Frame f;
+
+    if (ingest_batch_full(batch)) {
+        return 0;
+    }
+    while (end > frame && (end[-1] == '\0' || end[-1] == '\n' || end[-1] == '\r')) {
+        end--;
+    }
+
+    memset(&f, 0, sizeof(f));
+    f.id = INGEST_NO_ID;
+    while (frame < end) {
+        const char *delim = findDelimiter(frame, end);
+        parseField(&f, frame, (size_t)(delim - frame));
+        frame = delim + 1;
+    }
+    commitFrame(batch, &f);
+    return 1;
+}
+
+
+/* Parses newline separated frames, e.g. a gateway log or a socket buffer.
+ * Parsing stops early when the batch fills up or when the buffer ends in
+ * the middle of a frame; the caller keeps the unconsumed tail for the next
+ * call.
+ * Parameters:
+ * - IngestBatch *batch: Batch receiving the decoded rows.
+ * - const char *buf: Buffer holding the frames.
+ * - size_t len: Length of the buffer.
+ * Returns:
+ * - Number of bytes consumed from buf.
+ */
+size_t ingest_parse_stream(IngestBatch *batch, const char *buf, size_t len) {
+    const char *p = buf;
+    const char *end = buf + len;
+    const char *frameStart = buf;
+    Frame f;
+
+    memset(&f, 0, sizeof(f));
+    f.id = INGEST_NO_ID;
+
+    while (p < end) {
+        const char *delim = findDelimiter(p, end);
+        if (delim == end) {
+            break;
+        }
+        if (p == frameStart && ingest_batch_full(batch)) {
+            break;
+        }
+        parseField(&f, p, (size_t)(delim - p - (delim > p && delim[-1] == '\r')));
+        p = delim + 1;
+        if (*delim == '\n') {
+            if (p - frameStart > 1) {
+                commitFrame(batch, &f);
+            }
+            memset(&f, 0, sizeof(f));
+            f.id = INGEST_NO_ID;
+            frameStart = p;
+        }
+    }
+    return (size_t)(frameStart - buf);
+}
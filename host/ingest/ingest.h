@@ -0,0 +1,88 @@
+/* Gateway-side ingest parser for the tamagotchi radio protocol.
+ *
+ * The device sends ASCII key/value frames such as
+ *   id:0301,ax:0.01,ay:-0.02,az:-1.00,gx:0.31,gy:-0.09,gz:0.11
+ *   id:0301,light:12.34
+ *   id:0301,EAT:3,MSG1:Eating
+ *   id:0301,session:start
+ *
+ * The parser never allocates. Frames are decoded straight into a caller
+ * owned IngestBatch whose columns are plain fixed size arrays, one table per
+ * frame kind. The %.2f fields are parsed as fixed point hundredths, so no
+ * floating point is involved on the hot path.
+ */
+
+#ifndef INGEST_H_
+#define INGEST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Rows per table in one batch
+#define INGEST_BATCH_ROWS 4096
+
+// Device id used when a frame has no id field (e.g. a bare "light:%.2f")
+#define INGEST_NO_ID 0xFFFF
+
+// Event kinds, one per event key of the protocol
+enum ingest_event {
+    INGEST_EVENT_EAT = 1,
+    INGEST_EVENT_PET,
+    INGEST_EVENT_EXERCISE,
+    INGEST_EVENT_ACTIVATE,
+    INGEST_EVENT_SESSION_START,
+    INGEST_EVENT_SESSION_END
+};
+
+// Motion samples. Values are hundredths of g and deg/s.
+typedef struct {
+    size_t count;
+    uint16_t id[INGEST_BATCH_ROWS];
+    int32_t ax[INGEST_BATCH_ROWS];
+    int32_t ay[INGEST_BATCH_ROWS];
+    int32_t az[INGEST_BATCH_ROWS];
+    int32_t gx[INGEST_BATCH_ROWS];
+    int32_t gy[INGEST_BATCH_ROWS];
+    int32_t gz[INGEST_BATCH_ROWS];
+} IngestImuTable;
+
+// Light samples. Values are hundredths of lux.
+typedef struct {
+    size_t count;
+    uint16_t id[INGEST_BATCH_ROWS];
+    int32_t lux[INGEST_BATCH_ROWS];
+} IngestLightTable;
+
+// Pet events (EAT:n, PET:n, EXERCISE:n, ACTIVATE:..., session:start/end)
+typedef struct {
+    size_t count;
+    uint16_t id[INGEST_BATCH_ROWS];
+    uint8_t kind[INGEST_BATCH_ROWS];
+    int32_t value[INGEST_BATCH_ROWS];
+} IngestEventTable;
+
+typedef struct {
+    IngestImuTable imu;
+    IngestLightTable light;
+    IngestEventTable events;
+    size_t frames;      // Frames seen, including ones that produced no row
+    size_t malformed;   // Frames rejected because a numeric field did not parse
+} IngestBatch;
+
+void ingest_batch_reset(IngestBatch *batch);
+int ingest_batch_full(const IngestBatch *batch);
+
+int ingest_parse_frame(IngestBatch *batch, const char *frame, size_t len);
+size_t ingest_parse_stream(IngestBatch *batch, const char *buf, size_t len);
+
+int ingest_parse_fixed2(const char *s, size_t len, int32_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INGEST_H_ */
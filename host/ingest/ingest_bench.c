@@ -0,0 +1,257 @@
+/* Benchmark of the ingest parser against a naive strtok/strtod parser.
+ *
+ * Build and run on the gateway host:
+ *   gcc -O2 -march=native -o ingest_bench ingest_bench.c ingest.c
+ *   ./ingest_bench [frames]
+ *
+ * A synthetic corpus with the same mix of frames as a data session (mostly
+ * motion samples, one light sample per ten, a few pet events) is parsed by
+ * both parsers. Both must agree on every decoded value before the timings
+ * are printed. The edge cases of the number parser are checked first.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ingest.h"
+
+#define DEFAULT_FRAMES 2000000
+
+// Checksums of the decoded columns, used to compare the parsers
+typedef struct {
+    long long imuRows;
+    long long lightRows;
+    long long eventRows;
+    long long sum;
+} Totals;
+
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+// Random value in [-range, range] with two decimals, printed like the device does
+static double randomValue(double range) {
+    return ((rand() % 20001) - 10000) / 10000.0 * range;
+}
+
+
+/* Builds a newline separated corpus of frames.
+ * Returns:
+ * - Malloc'd buffer, its length is stored in *len.
+ */
+static char *buildCorpus(long frames, size_t *len) {
+    size_t capacity = (size_t)frames * 72 + 1;
+    char *buf = malloc(capacity);
+    size_t used = 0;
+    long i;
+
+    if (buf == NULL) {
+        return NULL;
+    }
+    srand(301);
+    for (i = 0; i < frames; i++) {
+        int kind = i % 20;
+        if (kind < 17) {
+            used += sprintf(buf + used, "id:0301,ax:%.2f,ay:%.2f,az:%.2f,gx:%.2f,gy:%.2f,gz:%.2f\n",
+                            randomValue(2), randomValue(2), randomValue(2),
+                            randomValue(250), randomValue(250), randomValue(250));
+        } else if (kind == 17) {
+            used += sprintf(buf + used, "id:0301,light:%.2f\n", (rand() % 100000) / 100.0);
+        } else if (kind == 18) {
+            used += sprintf(buf + used, "id:0301,EAT:%d,MSG1:Eating\n", rand() % 5 + 1);
+        } else {
+            used += sprintf(buf + used, "id:0301,PET:3,MSG1:Being pet\n");
+        }
+    }
+    *len = used;
+    return buf;
+}
+
+
+/* Checks ingest_parse_fixed2 on the edges of what it accepts.
+ * Returns:
+ * - The number of failed cases.
+ */
+static int checkEdges(void) {
+    static const struct {
+        const char *text;
+        int ok;
+        int32_t value;
+    } cases[] = {
+        {"1.5", 1, 150},
+        {"-0.125", 1, -13},
+        {"21474836.47", 1, INT32_MAX},
+        {"-21474836.47", 1, -INT32_MAX},
+        {"21474836.48", 0, 0},
+        {"123456789", 0, 0},
+        {"1234567890", 0, 0},
+        {"", 0, 0},
+        {"-", 0, 0},
+        {"1.2x", 0, 0},
+    };
+    int failed = 0;
+    size_t i;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int32_t value = 0;
+        int ok = ingest_parse_fixed2(cases[i].text, strlen(cases[i].text), &value);
+        if (ok != cases[i].ok || (ok && value != cases[i].value)) {
+            fprintf(stderr, "ingest_parse_fixed2(\"%s\"): %d, %ld\n", cases[i].text, ok, (long)value);
+            failed++;
+        }
+    }
+    return failed;
+}
+
+
+static void addBatch(Totals *totals, const IngestBatch *batch) {
+    size_t i;
+
+    totals->imuRows += batch->imu.count;
+    totals->lightRows += batch->light.count;
+    totals->eventRows += batch->events.count;
+    for (i = 0; i < batch->imu.count; i++) {
+        totals->sum += batch->imu.ax[i] + batch->imu.ay[i] + batch->imu.az[i]
+                     + batch->imu.gx[i] + batch->imu.gy[i] + batch->imu.gz[i];
+    }
+    for (i = 0; i < batch->light.count; i++) {
+        totals->sum += batch->light.lux[i];
+    }
+    for (i = 0; i < batch->events.count; i++) {
+        totals->sum += batch->events.value[i];
+    }
+}
+
+
+static void runIngest(const char *buf, size_t len, IngestBatch *batch, Totals *totals) {
+    size_t offset = 0;
+
+    memset(totals, 0, sizeof(*totals));
+    ingest_batch_reset(batch);
+    while (offset < len) {
+        size_t used = ingest_parse_stream(batch, buf + offset, len - offset);
+        offset += used;
+        addBatch(totals, batch);
+        ingest_batch_reset(batch);
+        if (used == 0) {
+            break;
+        }
+    }
+}
+
+
+// Rounds like the device's %.2f output so both parsers can be compared
+static long long hundredths(double value) {
+    return (long long)(value * 100.0 + (value < 0 ? -0.5 : 0.5));
+}
+
+
+/* The baseline: copy each line, strtok it on ',' and convert with strtod.
+ * This is how the gateway scripts parsed frames before.
+ */
+static void runNaive(const char *buf, size_t len, Totals *totals) {
+    const char *p = buf;
+    const char *end = buf + len;
+    char line[128];
+
+    memset(totals, 0, sizeof(*totals));
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        size_t n = (size_t)((nl ? nl : end) - p);
+        double imu[6];
+        int imuFields = 0;
+        char *field;
+
+        if (n >= sizeof(line)) {
+            n = sizeof(line) - 1;
+        }
+        memcpy(line, p, n);
+        line[n] = '\0';
+        p = nl ? nl + 1 : end;
+
+        for (field = strtok(line, ","); field != NULL; field = strtok(NULL, ",")) {
+            char *colon = strchr(field, ':');
+            if (colon == NULL) {
+                continue;
+            }
+            *colon = '\0';
+            if (strlen(field) == 2 && (field[0] == 'a' || field[0] == 'g') && field[1] >= 'x' && field[1] <= 'z') {
+                imu[(field[0] == 'g' ? 3 : 0) + field[1] - 'x'] = strtod(colon + 1, NULL);
+                imuFields++;
+            } else if (strcmp(field, "light") == 0) {
+                totals->lightRows++;
+                totals->sum += hundredths(strtod(colon + 1, NULL));
+            } else if (strcmp(field, "EAT") == 0 || strcmp(field, "PET") == 0) {
+                totals->eventRows++;
+                totals->sum += strtol(colon + 1, NULL, 10);
+            }
+        }
+        if (imuFields == 6) {
+            int i;
+            totals->imuRows++;
+            for (i = 0; i < 6; i++) {
+                totals->sum += hundredths(imu[i]);
+            }
+        }
+    }
+}
+
+
+int main(int argc, char **argv) {
+    long frames = argc > 1 ? atol(argv[1]) : DEFAULT_FRAMES;
+    static IngestBatch batch;
+    Totals fast, naive;
+    size_t len;
+    double start, tFast, tNaive;
+    char *corpus;
+
+    if (frames <= 0) {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return 1;
+    }
+    if (checkEdges() != 0) {
+        return 1;
+    }
+    corpus = buildCorpus(frames, &len);
+    if (corpus == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    // Warm up caches before timing
+    runIngest(corpus, len, &batch, &fast);
+
+    start = now();
+    runIngest(corpus, len, &batch, &fast);
+    tFast = now() - start;
+
+    start = now();
+    runNaive(corpus, len, &naive);
+    tNaive = now() - start;
+
+    if (fast.imuRows != naive.imuRows || fast.lightRows != naive.lightRows
+        || fast.eventRows != naive.eventRows || fast.sum != naive.sum) {
+        fprintf(stderr, "MISMATCH: ingest imu=%lld light=%lld events=%lld sum=%lld, "
+                        "naive imu=%lld light=%lld events=%lld sum=%lld\n",
+                fast.imuRows, fast.lightRows, fast.eventRows, fast.sum,
+                naive.imuRows, naive.lightRows, naive.eventRows, naive.sum);
+        free(corpus);
+        return 1;
+    }
+
+    printf("corpus: %ld frames, %.1f MB\n", frames, len / 1e6);
+    printf("ingest: %8.3f s  %12.0f frames/s  %8.1f MB/s\n", tFast, frames / tFast, len / 1e6 / tFast);
+    printf("naive:  %8.3f s  %12.0f frames/s  %8.1f MB/s\n", tNaive, frames / tNaive, len / 1e6 / tNaive);
+    printf("speedup: %.1fx\n", tNaive / tFast);
+
+    free(corpus);
+    return 0;
+}
@@ -0,0 +1,230 @@
+/* logdec: decodes the framed serial output of the tamagotchi.
+ *
+ * Reads the raw serial stream from stdin and prints one line per frame:
+ * text frames as they are, binary log records rendered with the formats
+ * of binlog_formats.h. Frames with a bad CRC are counted and skipped.
+ * With -i, flash log offload frames are written into a flash image file,
+ * blank (0xFF) where nothing was received. Read it with host/flashparse.
+ *
+ * Build: gcc -O2 -I../.. -o logdec logdec.c
+ * Usage: stty -F /dev/ttyACM0 921600 raw && ./logdec [-i flash.bin] < /dev/ttyACM0
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "binlog_formats.h"
+#include "serial.h"
+#include "extflash.h"
+
+#define FRAME_MAX 1024
+
+#define BINLOG_FORMAT(id, format) format,
+static const char *formats[] = {
+    BINLOG_FORMATS(BINLOG_FORMAT)
+};
+#undef BINLOG_FORMAT
+
+static unsigned long badFrames = 0;
+static int lastSeq = -1;
+static FILE *image = NULL;
+static unsigned long flashBytes = 0;
+
+static uint32_t le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Prints a format with raw 32-bit arguments, only the conversions the
+ * device side may use.
+ */
+static void render(const char *format, const uint32_t *args, int count) {
+    char spec[16];
+    int used = 0;
+    int length;
+    union {
+        uint32_t u;
+        float f;
+    } bits;
+
+    while (*format) {
+        if (*format != '%') {
+            putchar(*format++);
+            continue;
+        }
+        // Copy the conversion with its flags and width
+        length = 0;
+        spec[length++] = *format++;
+        while (*format && strchr("-+ #0123456789.", *format) && length < (int)sizeof(spec) - 2) {
+            spec[length++] = *format++;
+        }
+        if (*format == '%') {
+            putchar('%');
+            format++;
+            continue;
+        }
+        spec[length++] = *format;
+        spec[length] = '\0';
+        if (used >= count) {
+            printf("<missing>");
+        } else {
+            switch (*format) {
+            case 'd':
+            case 'i':
+                printf(spec, (int32_t)args[used]);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'c':
+                printf(spec, args[used]);
+                break;
+            case 'f':
+                bits.u = args[used];
+                printf(spec, (double)bits.f);
+                break;
+            default:
+                printf("<bad %%%c>", *format);
+                break;
+            }
+            used++;
+        }
+        if (*format) {
+            format++;
+        }
+    }
+}
+
+static void logRecord(const uint8_t *data, int length) {
+    uint32_t args[BINLOG_MAX_ARGS];
+    uint32_t tick;
+    int id, count, seq, i;
+
+    if (length < 8) {
+        badFrames++;
+        return;
+    }
+    tick = le32(data);
+    id = data[4];
+    count = data[5];
+    seq = data[6] | (data[7] << 8);
+    if (count > BINLOG_MAX_ARGS || length != 8 + 4 * count) {
+        badFrames++;
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        args[i] = le32(data + 8 + 4 * i);
+    }
+    // A gap in the sequence means frames were lost on the line
+    if (lastSeq >= 0 && seq != ((lastSeq + 1) & 0xFFFF) && id != LOG_LOST) {
+        printf("[logdec] %d records missing\n", (seq - lastSeq - 1) & 0xFFFF);
+    }
+    if (id != LOG_LOST) {
+        lastSeq = seq;
+    }
+
+    printf("%10.5f ", tick * (BINLOG_TICK_US / 1e6));
+    if (id < LOG_FORMAT_COUNT) {
+        render(formats[id], args, count);
+    } else {
+        printf("unknown format %d", id);
+    }
+    putchar('\n');
+}
+
+// Raw flash bytes at their address in the image
+static void flashChunk(const uint8_t *data, int length) {
+    uint32_t address;
+
+    if (length < 4) {
+        badFrames++;
+        return;
+    }
+    address = le32(data);
+    length -= 4;
+    if (!image || address + length > EXTFLASH_SIZE) {
+        return;
+    }
+    fseek(image, address, SEEK_SET);
+    fwrite(data + 4, 1, length, image);
+    flashBytes += length;
+}
+
+static void frame(const uint8_t *data, int length) {
+    if (length < 3 || serialCrc16(0xFFFF, data, length - 2) != (data[length - 2] | (data[length - 1] << 8))) {
+        badFrames++;
+        return;
+    }
+    length -= 2;
+    switch (data[0]) {
+    case SERIAL_FRAME_TEXT:
+        fwrite(data + 1, 1, length - 1, stdout);
+        if (length < 2 || data[length - 1] != '\n') {
+            putchar('\n');
+        }
+        break;
+    case SERIAL_FRAME_LOG:
+        logRecord(data + 1, length - 1);
+        break;
+    case SERIAL_FRAME_FLASH:
+        flashChunk(data + 1, length - 1);
+        break;
+    case SERIAL_FRAME_IMU:
+    case SERIAL_FRAME_LIGHT:
+    case SERIAL_FRAME_IMU_SCALE:
+        // Bench stream, see host/capture
+        break;
+    case SERIAL_FRAME_COMMAND:
+    case SERIAL_FRAME_REPLY:
+        // Serial console, see host/console
+        break;
+    default:
+        badFrames++;
+        break;
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    static uint8_t data[FRAME_MAX];
+    int length = 0;
+    int escaped = 0;
+    int c;
+
+    if (argc == 3 && strcmp(argv[1], "-i") == 0) {
+        image = fopen(argv[2], "wb");
+        if (!image) {
+            perror(argv[2]);
+            return 1;
+        }
+        for (c = 0; c < EXTFLASH_SIZE; c++) {
+            fputc(0xFF, image);
+        }
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: logdec [-i flash.bin] < serial-stream\n");
+        return 1;
+    }
+
+    while ((c = getchar()) != EOF) {
+        if (c == SERIAL_FLAG) {
+            if (length > 0) {
+                frame(data, length);
+            }
+            length = 0;
+            escaped = 0;
+        } else if (c == SERIAL_ESCAPE) {
+            escaped = 1;
+        } else if (length < FRAME_MAX) {
+            data[length++] = escaped ? c ^ SERIAL_ESCAPE_XOR : c;
+            escaped = 0;
+        }
+    }
+    if (badFrames) {
+        fprintf(stderr, "logdec: %lu bad frames\n", badFrames);
+    }
+    if (image) {
+        fprintf(stderr, "logdec: %lu flash bytes written to %s\n", flashBytes, argv[2]);
+        fclose(image);
+    }
+    return 0;
+}
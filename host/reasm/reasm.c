@@ -0,0 +1,155 @@
+/* Gateway-side reassembler for fragmented radio messages.
+ *
+ * Uses the same fragment code as the device (wireless/fragment.c), built
+ * with room for the largest possible message:
+ *   gcc -O2 -DFRAGMENT_MAX_FRAGMENTS=255 -I../../wireless -o reasm reasm.c ../../wireless/fragment.c
+ *
+ * Input, one received packet per line, as logged by the gateway:
+ *   <time_ms> <sender_hex> <payload_hex>
+ * Output, one complete message per line:
+ *   <time_ms> <sender_hex> <length> <message>
+ * The message is printed as text when it is printable and as hex otherwise.
+ * With -r only the raw bytes of the complete messages are written, which is
+ * what a bulk transfer (e.g. a log dump) is saved with.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fragment.h"
+
+// Senders that can have a message in flight at the same time
+#define MAX_SENDERS 16
+
+#define LINE_MAX_BYTES 1024
+
+static Fragment_Reassembly_t slots[MAX_SENDERS];
+
+
+/* Picks the reassembly buffer of a sender: its active one, a free one,
+ * or as a last resort the one that has been silent the longest.
+ */
+static Fragment_Reassembly_t *slotFor(uint16_t sender) {
+    Fragment_Reassembly_t *oldest = &slots[0];
+    Fragment_Reassembly_t *freeSlot = NULL;
+    int i;
+
+    for (i = 0; i < MAX_SENDERS; i++) {
+        if (slots[i].Active && slots[i].Sender == sender) {
+            return &slots[i];
+        }
+        if (!slots[i].Active && freeSlot == NULL) {
+            freeSlot = &slots[i];
+        }
+        if (slots[i].LastTime < oldest->LastTime) {
+            oldest = &slots[i];
+        }
+    }
+    return freeSlot ? freeSlot : oldest;
+}
+
+
+// Decodes a hex string, returns the number of bytes or -1
+static int parseHex(const char *hex, uint8_t *out, int max) {
+    int n = 0;
+
+    while (isxdigit((unsigned char)hex[0]) && isxdigit((unsigned char)hex[1])) {
+        unsigned byte;
+        if (n == max || sscanf(hex, "%2x", &byte) != 1) {
+            return -1;
+        }
+        out[n++] = (uint8_t)byte;
+        hex += 2;
+    }
+    return n;
+}
+
+
+static void printMessage(unsigned long time, uint16_t sender, const uint8_t *data, int len, int raw) {
+    int printable = 1;
+    int i;
+
+    if (raw) {
+        fwrite(data, 1, len, stdout);
+        return;
+    }
+    for (i = 0; i < len; i++) {
+        if (!isprint(data[i]) && !(data[i] == 0 && i == len - 1)) {
+            printable = 0;
+            break;
+        }
+    }
+    printf("%lu %04x %d ", time, sender, len);
+    if (printable) {
+        printf("%.*s\n", len, (const char *)data);
+    } else {
+        for (i = 0; i < len; i++) {
+            printf("%02x", data[i]);
+        }
+        printf("\n");
+    }
+}
+
+
+int main(int argc, char **argv) {
+    char line[LINE_MAX_BYTES];
+    uint8_t frame[FRAGMENT_PAYLOAD_MAX + 1];
+    unsigned long complete = 0, dropped = 0, errors = 0;
+    int raw = (argc > 1 && strcmp(argv[1], "-r") == 0);
+    int i;
+
+    if (argc > 2 || (argc == 2 && !raw)) {
+        fprintf(stderr, "usage: %s [-r] < packets.txt\n", argv[0]);
+        return 1;
+    }
+
+    for (i = 0; i < MAX_SENDERS; i++) {
+        Fragment_Reset(&slots[i]);
+    }
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        unsigned long time;
+        unsigned sender;
+        char hex[LINE_MAX_BYTES];
+        Fragment_Reassembly_t *slot;
+        int len;
+
+        if (sscanf(line, "%lu %x %1023s", &time, &sender, hex) != 3) {
+            continue;
+        }
+        len = parseHex(hex, frame, FRAGMENT_PAYLOAD_MAX);
+        if (len < 0) {
+            errors++;
+            continue;
+        }
+
+        for (i = 0; i < MAX_SENDERS; i++) {
+            dropped += Fragment_Expire(&slots[i], (uint32_t)time);
+        }
+
+        slot = slotFor((uint16_t)sender);
+        switch (Fragment_Accept(slot, (uint16_t)sender, frame, (uint8_t)len, (uint32_t)time)) {
+        case FRAGMENT_RESULT_NOT_FRAGMENT:
+            printMessage(time, (uint16_t)sender, frame, len, raw);
+            break;
+        case FRAGMENT_RESULT_COMPLETE:
+            printMessage(time, (uint16_t)sender, slot->Data, slot->Length, raw);
+            complete++;
+            break;
+        case FRAGMENT_RESULT_PENDING:
+            break;
+        default:
+            errors++;
+            break;
+        }
+    }
+
+    for (i = 0; i < MAX_SENDERS; i++) {
+        dropped += slots[i].Active;
+    }
+    fprintf(stderr, "reassembled %lu messages, %lu timed out or unfinished, %lu bad packets\n",
+            complete, dropped, errors);
+    return 0;
+}
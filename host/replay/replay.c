@@ -0,0 +1,270 @@
+/* replay: runs recorded motion traces through the gesture detection of the
+ * sensor task.
+ *
+ * detect.c is compiled as is, with the parameters of params.h. Each trace
+ * (see trace.h) goes through a detector of its own at the sample period,
+ * after the noise and bias correction of noise.c as in the sensor task,
+ * and each detection is printed as
+ *     <file>,<time s>,exercise|pet,<latency s>
+ * The latency is from the onset, the first sample since the last pause in
+ * the window whose derivate on a detecting axis (z for exercise, x or y
+ * for petting) is over the threshold, to the detection. A pause is
+ * DETECT_RECENT derivates below the release level. A summary of each trace and of all of
+ * them goes to stderr: samples, detections, latencies, and the time a
+ * sample takes in the detector and in all, mapping and parsing included.
+ *
+ * -s changes a parameter, named as in params.h in lower case without the
+ * prefix, e.g. -s exercise_threshold 4. -q prints only the summaries.
+ *
+ * Build: gcc -O2 -DPROBE_EXCLUDE -I../.. -o replay replay.c trace.c ../../detect.c ../../filter.c ../../rhythm.c \
+ *            ../../noise.c ../../params.c -lm
+ * Usage: ./replay [-q] [-s name value]... trace.csv...
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <math.h>
+
+#include "detect.h"
+#include "noise.h"
+#include "params.h"
+#include "trace.h"
+
+// Samples parsed ahead and then timed through the detector together
+#define BATCH 4096
+
+typedef struct {
+    double time;
+    float motion[6];
+} Sample;
+
+typedef struct {
+    uint64_t samples;
+    uint64_t bytes;
+    uint64_t exercise;
+    uint64_t pet;
+    uint64_t latencies;
+    double latencySum;
+    double latencyMin;
+    double latencyMax;
+    double detectNs;
+    double totalNs;
+} Totals;
+
+#define NAME_STRING(id, ...) #id,
+static const char *paramNames[] = {
+    PARAMS(NAME_STRING)
+};
+#undef NAME_STRING
+
+static Sample batch[BATCH];
+static Detector detector;
+static int quiet = 0;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int lookup(const char *name)
+{
+    const char *full;
+    int i, j;
+
+    for (i = 0; i < PARAM_COUNT; i++) {
+        full = paramNames[i] + strlen("PARAM_");
+        for (j = 0; full[j] && tolower((unsigned char)full[j]) == name[j]; j++) {
+        }
+        if (!full[j] && !name[j]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// The first sample since the last pause with a derivate over the threshold on one of the axes
+static double onset(const Detector *d, int axisMask, float threshold, float release)
+{
+    int start = 0, quiet = 0;
+    int axis, k, below;
+
+    // From the oldest derivate in the rings
+    for (k = 0; k < DETECT_SLOPES; k++) {
+        for (axis = 0, below = 1; axis < 3; axis++) {
+            if ((axisMask & (1 << axis)) && d->derivates[axis][(d->index + k) % DETECT_SLOPES] >= threshold * release) {
+                below = 0;
+            }
+        }
+        quiet = below ? quiet + 1 : 0;
+        if (quiet >= DETECT_RECENT) {
+            start = k + 1;
+        }
+    }
+    for (k = start; k < DETECT_SLOPES; k++) {
+        for (axis = 0; axis < 3; axis++) {
+            if ((axisMask & (1 << axis)) && d->derivates[axis][(d->index + k) % DETECT_SLOPES] > threshold) {
+                return d->times[(d->index + k) % DETECT_SLOPES];
+            }
+        }
+    }
+    return d->times[(d->index + DETECT_SLOPES - 1) % DETECT_SLOPES];
+}
+
+static void detection(const char *path, Totals *totals, const char *kind, double time, double start)
+{
+    double latency = time - start;
+
+    if (!quiet) {
+        printf("%s,%.3f,%s,%.3f\n", path, time, kind, latency);
+    }
+    if (totals->latencies == 0 || latency < totals->latencyMin) {
+        totals->latencyMin = latency;
+    }
+    if (totals->latencies == 0 || latency > totals->latencyMax) {
+        totals->latencyMax = latency;
+    }
+    totals->latencies++;
+    totals->latencySum += latency;
+}
+
+static void add(Totals *sum, const Totals *t)
+{
+    if (t->latencies && (sum->latencies == 0 || t->latencyMin < sum->latencyMin)) {
+        sum->latencyMin = t->latencyMin;
+    }
+    if (t->latencies && (sum->latencies == 0 || t->latencyMax > sum->latencyMax)) {
+        sum->latencyMax = t->latencyMax;
+    }
+    sum->samples += t->samples;
+    sum->bytes += t->bytes;
+    sum->exercise += t->exercise;
+    sum->pet += t->pet;
+    sum->latencies += t->latencies;
+    sum->latencySum += t->latencySum;
+    sum->detectNs += t->detectNs;
+    sum->totalNs += t->totalNs;
+}
+
+static void summary(const char *name, const Totals *t)
+{
+    fprintf(stderr, "%s: %llu samples, %llu exercise, %llu pet", name, (unsigned long long)t->samples,
+            (unsigned long long)t->exercise, (unsigned long long)t->pet);
+    if (t->latencies) {
+        fprintf(stderr, ", latency %.2f/%.2f/%.2f s min/avg/max", t->latencyMin,
+                t->latencySum / t->latencies, t->latencyMax);
+    }
+    if (t->samples) {
+        fprintf(stderr, ", %.0f ns a sample detecting, %.0f in all, %.0f MB/s", t->detectNs / t->samples,
+                t->totalNs / t->samples, t->totalNs > 0 ? t->bytes * 1e3 / t->totalNs : 0);
+    }
+    fprintf(stderr, "\n");
+}
+
+static int replay(const char *path, const DetectConfig *defaults, Totals *totals)
+{
+    TraceReader *reader = malloc(sizeof(TraceReader));
+    DetectConfig config;
+    Noise noise;
+    double start = now();
+    double detectStart;
+    float threshold;
+    int count, result, i;
+
+    memset(totals, 0, sizeof(*totals));
+    if (!reader || !traceOpen(reader, path, defaults->samplePeriod)) {
+        free(reader);
+        return 0;
+    }
+    config = *defaults;
+    detectReset(&detector);
+    noiseReset(&noise);
+    do {
+        for (count = 0; count < BATCH && traceNext(reader, &batch[count].time, batch[count].motion); count++) {
+        }
+        detectStart = now();
+        for (i = 0; i < count; i++) {
+            noiseSample(&noise, batch[i].motion);
+            noiseFloors(&noise, config.samplePeriod, detectNoiseGain(), paramGet(PARAM_NOISE_MARGIN), config.floor);
+            result = detectSample(&detector, (float)batch[i].time, batch[i].motion, &config);
+            if (result & DETECT_EXERCISE) {
+                totals->exercise++;
+                threshold = fmaxf(config.exercise, config.floor[2]);
+                detection(path, totals, "exercise", batch[i].time, onset(&detector, 0x4, threshold, config.release));
+            }
+            if (result & DETECT_PET) {
+                totals->pet++;
+                threshold = fmaxf(config.pet, fmaxf(config.floor[0], config.floor[1]));
+                detection(path, totals, "pet", batch[i].time, onset(&detector, 0x3, threshold, config.release));
+            }
+        }
+        totals->detectNs += now() - detectStart;
+        totals->samples += count;
+    } while (count == BATCH);
+
+    totals->bytes = reader->size;
+    totals->totalNs = now() - start;
+    if (reader->badLines) {
+        fprintf(stderr, "%s: %llu of %llu lines skipped\n", path, (unsigned long long)reader->badLines,
+                (unsigned long long)reader->lines);
+    }
+    traceClose(reader);
+    free(reader);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    DetectConfig config;
+    Totals totals, all;
+    int files = 0;
+    int failed = 0;
+    int param;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 2 < argc && (param = lookup(argv[i + 1])) >= 0 &&
+                   paramSet(param, atof(argv[i + 2]))) {
+            i += 2;
+        } else {
+            break;
+        }
+    }
+    if (i == argc || argv[i][0] == '-') {
+        fprintf(stderr, "usage: replay [-q] [-s name value]... trace.csv...\n");
+        return 1;
+    }
+
+    config.samplePeriod = paramGet(PARAM_SAMPLE_PERIOD_MS) / 1000;
+    config.exercise = paramGet(PARAM_EXERCISE_THRESHOLD);
+    config.pet = paramGet(PARAM_PET_THRESHOLD);
+    config.petMaxVertical = paramGet(PARAM_PET_MAX_VERTICAL);
+    config.release = paramGet(PARAM_RELEASE);
+    config.refractory = paramGet(PARAM_REFRACTORY_MS) / 1000;
+    config.rhythmAmplitude = paramGet(PARAM_RHYTHM_AMPLITUDE);
+    config.rhythmPurity = paramGet(PARAM_RHYTHM_PURITY);
+
+    memset(&all, 0, sizeof(all));
+    for (; i < argc; i++) {
+        if (!replay(argv[i], &config, &totals)) {
+            failed = 1;
+            continue;
+        }
+        summary(argv[i], &totals);
+        add(&all, &totals);
+        files++;
+    }
+    if (files > 1) {
+        summary("all", &all);
+    }
+    return failed;
+}
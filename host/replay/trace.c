@@ -0,0 +1,193 @@
+/* Streaming reader of motion traces, see trace.h.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "trace.h"
+
+static const double powers[] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+                                1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+
+// A decimal number at *p, strtod for the rare exponent. 0 if there is none.
+static int parseNumber(const char **p, const char *end, double *value)
+{
+    const char *s = *p;
+    char copy[64];
+    uint64_t mantissa = 0;
+    int decimals = 0;
+    int negative = 0;
+    int count = 0;
+
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = *s++ == '-';
+    }
+    for (; s < end && *s >= '0' && *s <= '9'; s++) {
+        if (count++ < 18) {
+            mantissa = mantissa * 10 + (*s - '0');
+        } else {
+            decimals--;
+        }
+    }
+    if (s < end && *s == '.') {
+        for (s++; s < end && *s >= '0' && *s <= '9'; s++) {
+            if (count++ < 18) {
+                mantissa = mantissa * 10 + (*s - '0');
+                decimals++;
+            }
+        }
+    }
+    if (count == 0 || decimals < -18) {
+        return 0;
+    }
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        for (s++; s < end && (*s == '-' || *s == '+' || (*s >= '0' && *s <= '9')); s++) {
+        }
+        if ((size_t)(s - *p) >= sizeof(copy)) {
+            return 0;
+        }
+        memcpy(copy, *p, s - *p);
+        copy[s - *p] = '\0';
+        *value = strtod(copy, NULL);
+    } else if (decimals >= 0) {
+        *value = (negative ? -1.0 : 1.0) * mantissa / powers[decimals];
+    } else {
+        *value = (negative ? -1.0 : 1.0) * mantissa * powers[-decimals];
+    }
+    *p = s;
+    return 1;
+}
+
+// The next line that parses, 0 at the end of the file
+static int readRow(TraceReader *r, TraceRow *row)
+{
+    const char *p, *end, *line;
+    double value;
+    int i;
+
+    while (r->pos < r->size) {
+        line = r->data + r->pos;
+        end = memchr(line, '\n', r->size - r->pos);
+        if (!end) {
+            end = r->data + r->size;
+        }
+        r->pos = end - r->data + 1;
+        r->lines++;
+
+        p = line;
+        if (!parseNumber(&p, end, &row->time)) {
+            r->badLines++;
+            continue;
+        }
+        for (i = 0; i < 6; i++) {
+            if (p >= end || *p++ != ',' || !parseNumber(&p, end, &value)) {
+                break;
+            }
+            row->motion[i] = (float)value;
+        }
+        if (i < 6) {
+            r->badLines++;
+            continue;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+// The lines of the next time, spread over a second when there are several
+static int readGroup(TraceReader *r)
+{
+    TraceRow row;
+    int i;
+
+    r->groupCount = 0;
+    r->groupPos = 0;
+    if (r->hasPending) {
+        r->group[r->groupCount++] = r->pending;
+        r->hasPending = 0;
+    }
+    while (readRow(r, &row)) {
+        if (r->groupCount > 0 && (row.time != r->group[0].time || r->groupCount == TRACE_GROUP_MAX)) {
+            r->pending = row;
+            r->hasPending = 1;
+            break;
+        }
+        r->group[r->groupCount++] = row;
+    }
+    for (i = 1; i < r->groupCount; i++) {
+        r->group[i].time += (double)i / r->groupCount;
+    }
+    return r->groupCount > 0;
+}
+
+int traceOpen(TraceReader *r, const char *path, double period)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    memset(r, 0, sizeof(*r));
+    r->period = period;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 0;
+    }
+    r->size = st.st_size;
+    if (r->size > 0) {
+        r->data = mmap(NULL, r->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (r->data == MAP_FAILED) {
+            perror(path);
+            close(fd);
+            return 0;
+        }
+        madvise((void *)r->data, r->size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    return 1;
+}
+
+int traceNext(TraceReader *r, double *time, float motion[6])
+{
+    const TraceRow *row;
+
+    for (;;) {
+        if (r->groupPos == r->groupCount && !readGroup(r)) {
+            return 0;
+        }
+        row = &r->group[r->groupPos++];
+        if (r->samples == 0) {
+            r->start = row->time;
+            r->due = row->time;
+        }
+        // Within a microsecond, the times of a capture are rounded
+        if (row->time < r->due - 1e-6) {
+            continue;
+        }
+        // As the sensor task: the next sample a period on, or now when late
+        r->due += r->period;
+        if (r->due < row->time) {
+            r->due = row->time;
+        }
+        *time = row->time - r->start;
+        memcpy(motion, row->motion, sizeof(row->motion));
+        r->samples++;
+        return 1;
+    }
+}
+
+void traceClose(TraceReader *r)
+{
+    if (r->data && r->size > 0) {
+        munmap((void *)r->data, r->size);
+    }
+    r->data = NULL;
+}
@@ -0,0 +1,51 @@
+/* Streaming reader of motion traces for the host tools of the detector.
+ *
+ * A trace is a Debug/data.csv capture, <time s>,ax,ay,az,gx,gy,gz a line
+ * in g and deg/s, from host/capture or the debug console. The file is
+ * mapped, not read, so traces of any size stream through at the speed of
+ * the page cache. The lines that share a whole second in the old captures
+ * are spread evenly over it; lines that do not parse, e.g. a header, are
+ * skipped and counted.
+ *
+ * The samples come out at the detection rate, as the sensor task would
+ * have read them: the first line at or after each sample period. A trace
+ * recorded slower than the period gives all of its lines.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Lines of one second in a whole second capture, more are not spread
+#define TRACE_GROUP_MAX 4096
+
+typedef struct {
+    double time;
+    float motion[6];
+} TraceRow;
+
+typedef struct {
+    const char *data;
+    size_t size;
+    size_t pos;
+    double period;
+    double due;
+    double start;
+    TraceRow group[TRACE_GROUP_MAX];
+    int groupCount;
+    int groupPos;
+    TraceRow pending;
+    int hasPending;
+    uint64_t lines;
+    uint64_t badLines;
+    uint64_t samples;
+} TraceReader;
+
+// Maps the file, 0 with a message on stderr if it cannot be read
+int traceOpen(TraceReader *reader, const char *path, double period);
+// The next sample, the time from the first line of the trace; 0 at the end
+int traceNext(TraceReader *reader, double *time, float motion[6]);
+void traceClose(TraceReader *reader);
+
+#endif
@@ -0,0 +1,245 @@
+/* Labeled traces and their scores, see corpus.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "corpus.h"
+
+// The light samples the sensor task keeps, one a second
+#define SLEEP_SAMPLES 10
+
+const char *classNames[CLASS_COUNT] = {"exercise", "pet", "sleep", "idle"};
+
+static FILE *openBeside(const char *tracePath, const char *extension, char *path, size_t size)
+{
+    const char *dot = strrchr(tracePath, '.');
+    const char *slash = strrchr(tracePath, '/');
+    int length = dot && (!slash || dot > slash) ? (int)(dot - tracePath) : (int)strlen(tracePath);
+
+    snprintf(path, size, "%.*s%s", length, tracePath, extension);
+    return fopen(path, "r");
+}
+
+// The time of the first sample of the trace, the light is timed from it
+static double traceStart(const char *tracePath)
+{
+    char line[256];
+    double start = 0;
+    FILE *file = fopen(tracePath, "r");
+
+    while (file && fgets(line, sizeof(line), file) && sscanf(line, "%lf,", &start) != 1) {
+    }
+    if (file) {
+        fclose(file);
+    }
+    return start;
+}
+
+static int loadLight(Labels *labels, const char *tracePath)
+{
+    char path[4096], line[256];
+    int capacity = 0;
+    double time, start;
+    float lux;
+    FILE *file;
+    int i;
+
+    if (!(file = openBeside(tracePath, ".light", path, sizeof(path)))) {
+        return 1;
+    }
+    start = traceStart(tracePath);
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "%lf,%f", &time, &lux) != 2) {
+            continue;
+        }
+        if (labels->lightCount == capacity) {
+            capacity = capacity ? 2 * capacity : 1024;
+            labels->light = realloc(labels->light, capacity * sizeof(Light));
+        }
+        labels->light[labels->lightCount].time = time;
+        labels->light[labels->lightCount].lux = lux;
+        labels->lightCount++;
+    }
+    fclose(file);
+    for (i = 0; i < labels->lightCount; i++) {
+        labels->light[i].time -= start;
+    }
+    return 1;
+}
+
+int corpusLoad(Labels *labels, const char *tracePath)
+{
+    char path[4096], line[256], name[32];
+    Range range;
+    FILE *file;
+    int capacity = 0;
+    int number = 0;
+    int i;
+
+    memset(labels, 0, sizeof(*labels));
+    if (!(file = openBeside(tracePath, ".labels", path, sizeof(path)))) {
+        perror(path);
+        return 0;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        number++;
+        if (strchr(line, '#')) {
+            *strchr(line, '#') = '\0';
+        }
+        if (strspn(line, " \t\r\n") == strlen(line)) {
+            continue;
+        }
+        if (sscanf(line, "%lf %lf %31s", &range.start, &range.end, name) != 3 || range.end < range.start) {
+            fprintf(stderr, "%s:%d: bad label\n", path, number);
+            break;
+        }
+        for (i = 0; i < CLASS_COUNT && strcasecmp(name, classNames[i]) != 0; i++) {
+        }
+        if (i == CLASS_COUNT) {
+            fprintf(stderr, "%s:%d: unknown class %s\n", path, number, name);
+            break;
+        }
+        range.type = i;
+        if (labels->rangeCount == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            labels->ranges = realloc(labels->ranges, capacity * sizeof(Range));
+        }
+        labels->ranges[labels->rangeCount++] = range;
+    }
+    if (!feof(file)) {
+        fclose(file);
+        corpusFree(labels);
+        return 0;
+    }
+    fclose(file);
+    return loadLight(labels, tracePath);
+}
+
+void corpusFree(Labels *labels)
+{
+    free(labels->ranges);
+    free(labels->light);
+    memset(labels, 0, sizeof(*labels));
+}
+
+void hitAdd(HitList *list, double time, Class type)
+{
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? 2 * list->capacity : 256;
+        list->hits = realloc(list->hits, list->capacity * sizeof(Hit));
+    }
+    list->hits[list->count].time = time;
+    list->hits[list->count].type = type;
+    list->count++;
+}
+
+void corpusSleep(const Labels *labels, float darkLux, HitList *list)
+{
+    int filled = 0;
+    int dark = 0;   // of the last filled samples
+    int i;
+
+    // As the sensor task: when the 10 samples are all dark they start over, otherwise they slide on
+    for (i = 0; i < labels->lightCount; i++) {
+        filled++;
+        dark = labels->light[i].lux > darkLux ? 0 : dark + 1;
+        if (filled < SLEEP_SAMPLES) {
+            continue;
+        }
+        if (dark >= SLEEP_SAMPLES) {
+            hitAdd(list, labels->light[i].time, CLASS_SLEEP);
+            filled = 0;
+            dark = 0;
+        } else {
+            filled--;
+        }
+    }
+}
+
+static int matches(const Range *range, const Hit *hit, double grace)
+{
+    return hit->type == range->type && hit->time >= range->start && hit->time <= range->end + grace;
+}
+
+void scoreTrace(const Labels *labels, const HitList *list, double duration, double grace, int keepTtd,
+                Score scores[CLASS_COUNT])
+{
+    double labeled = 0;
+    int r, h, first;
+
+    for (r = 0; r < labels->rangeCount; r++) {
+        const Range *range = &labels->ranges[r];
+        Score *s = &scores[range->type];
+
+        s->ranges++;
+        s->labeled += range->end - range->start;
+        labeled += range->end - range->start;
+        // The first hit in time, the lists merge several detectors
+        first = -1;
+        for (h = 0; h < list->count; h++) {
+            if (matches(range, &list->hits[h], grace) && (first < 0 || list->hits[h].time < list->hits[first].time)) {
+                first = h;
+            }
+        }
+        if (first >= 0) {
+            s->detected++;
+            s->ttdSum += list->hits[first].time - range->start;
+            if (keepTtd) {
+                s->ttd = realloc(s->ttd, (s->ttdCount + 1) * sizeof(double));
+                s->ttd[s->ttdCount++] = list->hits[first].time - range->start;
+            }
+        }
+    }
+    // The time without labels is idle
+    if (duration > labeled) {
+        scores[CLASS_IDLE].labeled += duration - labeled;
+    }
+
+    for (h = 0; h < list->count; h++) {
+        scores[list->hits[h].type].detections++;
+        for (r = 0; r < labels->rangeCount && !matches(&labels->ranges[r], &list->hits[h], grace); r++) {
+        }
+        if (r < labels->rangeCount) {
+            scores[list->hits[h].type].correct++;
+        }
+    }
+}
+
+void scoreAdd(Score scores[CLASS_COUNT], const Score add[CLASS_COUNT])
+{
+    int i;
+
+    for (i = 0; i < CLASS_COUNT; i++) {
+        scores[i].ranges += add[i].ranges;
+        scores[i].detected += add[i].detected;
+        scores[i].detections += add[i].detections;
+        scores[i].correct += add[i].correct;
+        scores[i].labeled += add[i].labeled;
+        scores[i].ttdSum += add[i].ttdSum;
+    }
+}
+
+double scoreF1(const Score *score)
+{
+    double precision, recall;
+
+    if (!score->ranges || !score->detections || !score->correct) {
+        return 0;
+    }
+    precision = (double)score->correct / score->detections;
+    recall = (double)score->detected / score->ranges;
+    return 2 * precision * recall / (precision + recall);
+}
+
+void scoreFree(Score scores[CLASS_COUNT])
+{
+    int i;
+
+    for (i = 0; i < CLASS_COUNT; i++) {
+        free(scores[i].ttd);
+    }
+    memset(scores, 0, CLASS_COUNT * sizeof(Score));
+}
@@ -0,0 +1,89 @@
+/* Labeled traces and their scores, for score and tune.
+ *
+ * The labels of a trace (see ../replay/trace.h) are next to it, the same
+ * name with .labels for .csv, one time range a line in seconds from the
+ * start of the trace:
+ *     # start end class
+ *     12.0 30.5 exercise
+ *     41 55 pet
+ * The classes are exercise, pet, sleep and idle; time without a label is
+ * idle too. The light samples of the trace, if there are any, are in the
+ * same name with .light, <time s>,lux a line as from capture -l.
+ *
+ * A detection of a class is correct within a range of that class or up to
+ * the grace after its end, the detection lags. A range is detected if a
+ * correct detection falls in it, its time to detect is from the start of
+ * the range to the first one.
+ */
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stdint.h>
+
+typedef enum {
+    CLASS_EXERCISE,
+    CLASS_PET,
+    CLASS_SLEEP,
+    CLASS_IDLE,
+    CLASS_COUNT
+} Class;
+
+typedef struct {
+    double start;
+    double end;
+    Class type;
+} Range;
+
+typedef struct {
+    double time;    // s from the start of the trace
+    float lux;
+} Light;
+
+typedef struct {
+    Range *ranges;
+    int rangeCount;
+    Light *light;   // NULL without a light file
+    int lightCount;
+} Labels;
+
+typedef struct {
+    double time;
+    Class type;
+} Hit;
+
+typedef struct {
+    Hit *hits;
+    int count;
+    int capacity;
+} HitList;
+
+typedef struct {
+    uint32_t ranges;
+    uint32_t detected;
+    uint32_t detections;
+    uint32_t correct;
+    double labeled;     // s
+    double ttdSum;      // s, of the detected ranges
+    double *ttd;        // each of them, if kept
+    uint32_t ttdCount;
+} Score;
+
+extern const char *classNames[CLASS_COUNT];
+
+// The labels and the light of the trace, 0 with a message on stderr if the labels cannot be read
+int corpusLoad(Labels *labels, const char *tracePath);
+void corpusFree(Labels *labels);
+
+void hitAdd(HitList *list, double time, Class type);
+// The sleep of the sensor task from the light: the last 10 samples all at or below darkLux
+void corpusSleep(const Labels *labels, float darkLux, HitList *list);
+
+// Adds the ranges and the detections of a trace of duration s to scores, keepTtd keeps each time to detect
+void scoreTrace(const Labels *labels, const HitList *list, double duration, double grace, int keepTtd,
+                Score scores[CLASS_COUNT]);
+void scoreAdd(Score scores[CLASS_COUNT], const Score add[CLASS_COUNT]);
+// Of the precision and the recall, 0 without ranges or detections
+double scoreF1(const Score *score);
+void scoreFree(Score scores[CLASS_COUNT]);
+
+#endif
@@ -0,0 +1,178 @@
+/* Work-stealing thread pool, see pool.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "pool.h"
+
+#define MAX_THREADS 256
+
+typedef struct {
+    PoolFunction function;
+    void *arg;
+} Task;
+
+// Oldest at head, newest at tail - 1
+typedef struct {
+    Task *tasks;
+    int head;
+    int tail;
+    int capacity;
+    pthread_mutex_t lock;
+} Queue;
+
+static Queue queues[MAX_THREADS];
+static pthread_t threads[MAX_THREADS];
+static int threadCount = 0;
+static int nextQueue = 0;
+static int queued = 0;      // submitted, not yet taken
+static int pending = 0;     // submitted, not yet done
+static int stopping = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+
+static void push(Queue *q, Task task)
+{
+    pthread_mutex_lock(&q->lock);
+    if (q->head > 0 && q->tail == q->capacity) {
+        memmove(q->tasks, q->tasks + q->head, (q->tail - q->head) * sizeof(Task));
+        q->tail -= q->head;
+        q->head = 0;
+    }
+    if (q->tail == q->capacity) {
+        q->capacity = q->capacity ? 2 * q->capacity : 64;
+        q->tasks = realloc(q->tasks, q->capacity * sizeof(Task));
+    }
+    q->tasks[q->tail++] = task;
+    pthread_mutex_unlock(&q->lock);
+}
+
+// The newest of its own queue, or the oldest of the first other with any
+static int take(int self, Task *task)
+{
+    Queue *q;
+    int found = 0;
+    int i;
+
+    for (i = 0; i < threadCount && !found; i++) {
+        q = &queues[(self + i) % threadCount];
+        pthread_mutex_lock(&q->lock);
+        if (q->tail > q->head) {
+            *task = i == 0 ? q->tasks[--q->tail] : q->tasks[q->head++];
+            found = 1;
+        }
+        pthread_mutex_unlock(&q->lock);
+    }
+    if (found) {
+        __atomic_sub_fetch(&queued, 1, __ATOMIC_SEQ_CST);
+    }
+    return found;
+}
+
+static void run(Task *task)
+{
+    task->function(task->arg);
+    if (__atomic_sub_fetch(&pending, 1, __ATOMIC_SEQ_CST) == 0) {
+        pthread_mutex_lock(&lock);
+        pthread_cond_broadcast(&done);
+        pthread_mutex_unlock(&lock);
+    }
+}
+
+static void *worker(void *arg)
+{
+    int self = (int)(intptr_t)arg;
+    Task task;
+
+    for (;;) {
+        if (take(self, &task)) {
+            run(&task);
+            continue;
+        }
+        pthread_mutex_lock(&lock);
+        while (!stopping && __atomic_load_n(&queued, __ATOMIC_SEQ_CST) <= 0) {
+            pthread_cond_wait(&work, &lock);
+        }
+        if (stopping) {
+            pthread_mutex_unlock(&lock);
+            return NULL;
+        }
+        pthread_mutex_unlock(&lock);
+    }
+}
+
+void poolStart(int count)
+{
+    int i;
+
+    if (count <= 0) {
+        count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    threadCount = count < 1 ? 1 : count > MAX_THREADS ? MAX_THREADS : count;
+    stopping = 0;
+    for (i = 0; i < threadCount; i++) {
+        memset(&queues[i], 0, sizeof(Queue));
+        pthread_mutex_init(&queues[i].lock, NULL);
+    }
+    // The caller is thread 0
+    for (i = 1; i < threadCount; i++) {
+        pthread_create(&threads[i], NULL, worker, (void *)(intptr_t)i);
+    }
+}
+
+int poolThreads(void)
+{
+    return threadCount;
+}
+
+void poolSubmit(PoolFunction function, void *arg)
+{
+    Task task = {function, arg};
+
+    __atomic_add_fetch(&pending, 1, __ATOMIC_SEQ_CST);
+    push(&queues[nextQueue], task);
+    nextQueue = (nextQueue + 1) % threadCount;
+    pthread_mutex_lock(&lock);
+    __atomic_add_fetch(&queued, 1, __ATOMIC_SEQ_CST);
+    pthread_cond_signal(&work);
+    pthread_mutex_unlock(&lock);
+}
+
+void poolWait(void)
+{
+    Task task;
+
+    while (take(0, &task)) {
+        run(&task);
+    }
+    pthread_mutex_lock(&lock);
+    while (__atomic_load_n(&pending, __ATOMIC_SEQ_CST) > 0) {
+        pthread_cond_wait(&done, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void poolStop(void)
+{
+    int i;
+
+    pthread_mutex_lock(&lock);
+    stopping = 1;
+    pthread_cond_broadcast(&work);
+    pthread_mutex_unlock(&lock);
+    for (i = 1; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (i = 0; i < threadCount; i++) {
+        free(queues[i].tasks);
+        pthread_mutex_destroy(&queues[i].lock);
+    }
+    threadCount = 0;
+}
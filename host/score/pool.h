@@ -0,0 +1,23 @@
+/* Work-stealing thread pool of the host tools.
+ *
+ * Each thread has a queue of its own; the submitted tasks are dealt to
+ * the queues in turn, a thread runs the newest task of its own queue and,
+ * when that is empty, steals the oldest of another. Tasks of uneven size,
+ * e.g. traces of any length, so keep all the threads busy to the end. The
+ * thread calling poolWait works along.
+ */
+#ifndef POOL_H
+#define POOL_H
+
+typedef void (*PoolFunction)(void *arg);
+
+// Threads in all, the caller included; 0 for one a core
+void poolStart(int threads);
+int poolThreads(void);
+// From the thread of poolStart only
+void poolSubmit(PoolFunction function, void *arg);
+// Runs tasks until all the submitted are done
+void poolWait(void);
+void poolStop(void);
+
+#endif
@@ -0,0 +1,246 @@
+/* score: precision, recall and time to detect of the gesture detection on a
+ * labeled trace corpus.
+ *
+ * The traces (see ../replay/trace.h) and their labels are described in
+ * corpus.h. They go through noise.c and detect.c as in host/replay, and
+ * for sleep through the posture of attitude.c and, when they have light
+ * samples, the darkness rule of the sensor task, in parallel on all cores
+ * (-j to change). A detection of a class is correct within a range of
+ * that class or up to -g seconds (default 1) after its end, the window
+ * lags.
+ *
+ * Printed per class: ranges, detected, recall, detections, correct,
+ * precision, time to detect (median, 90th percentile, max) and the false
+ * detections per hour. Idle is only counted. -v prints the scores of each
+ * trace too, -s changes a parameter as in host/replay.
+ *
+ * Build: gcc -O2 -pthread -DPROBE_EXCLUDE -I../.. -I../replay -o score score.c corpus.c pool.c \
+ *            ../replay/trace.c ../../detect.c ../../filter.c ../../rhythm.c ../../attitude.c ../../noise.c \
+ *            ../../params.c -lm
+ * Usage: ./score [-j threads] [-g grace s] [-v] [-s name value]... trace.csv...
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "detect.h"
+#include "attitude.h"
+#include "noise.h"
+#include "params.h"
+#include "trace.h"
+#include "corpus.h"
+#include "pool.h"
+
+typedef struct {
+    const char *path;
+    Labels labels;
+    HitList hits;
+    uint64_t samples;
+    double duration;
+    int ok;
+} Job;
+
+#define NAME_STRING(id, ...) #id,
+static const char *paramNames[] = {
+    PARAMS(NAME_STRING)
+};
+#undef NAME_STRING
+
+static DetectConfig config;
+static double grace = 1.0;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int lookup(const char *name)
+{
+    const char *full;
+    int i, j;
+
+    for (i = 0; i < PARAM_COUNT; i++) {
+        full = paramNames[i] + strlen("PARAM_");
+        for (j = 0; full[j] && tolower((unsigned char)full[j]) == name[j]; j++) {
+        }
+        if (!full[j] && !name[j]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// A task of the pool
+static void run(void *arg)
+{
+    Job *job = arg;
+    TraceReader *reader = malloc(sizeof(TraceReader));
+    Detector detector;
+    DetectConfig local = config;
+    Noise noise;
+    Attitude attitude;
+    Posture posture = POSTURE_UNKNOWN;
+    float motion[6];
+    double time = 0;
+    int result;
+
+    if (!reader || !corpusLoad(&job->labels, job->path) || !traceOpen(reader, job->path, config.samplePeriod)) {
+        free(reader);
+        return;
+    }
+    detectReset(&detector);
+    attitudeReset(&attitude);
+    noiseReset(&noise);
+    while (traceNext(reader, &time, motion)) {
+        noiseSample(&noise, motion);
+        noiseFloors(&noise, local.samplePeriod, detectNoiseGain(), paramGet(PARAM_NOISE_MARGIN), local.floor);
+        result = detectSample(&detector, (float)time, motion, &local);
+        // As the sensor task, laid face down is sleep at once
+        if (attitudeSample(&attitude, motion, (uint32_t)paramGet(PARAM_SAMPLE_PERIOD_MS)) != posture) {
+            posture = attitude.posture;
+            if (posture == POSTURE_FACE_DOWN) {
+                hitAdd(&job->hits, time, CLASS_SLEEP);
+            }
+        }
+        if (result & DETECT_EXERCISE) {
+            hitAdd(&job->hits, time, CLASS_EXERCISE);
+        }
+        if (result & DETECT_PET) {
+            hitAdd(&job->hits, time, CLASS_PET);
+        }
+    }
+    corpusSleep(&job->labels, paramGet(PARAM_DARK_LUX), &job->hits);
+    job->samples = reader->samples;
+    job->duration = time;
+    job->ok = 1;
+    traceClose(reader);
+    free(reader);
+}
+
+static int compare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static double percentile(const Score *s, double p)
+{
+    return s->ttd[(uint32_t)(p * (s->ttdCount - 1) + 0.5)];
+}
+
+static void print(const char *title, Score scores[CLASS_COUNT], double hours)
+{
+    Score *s;
+    int i;
+
+    printf("%s\n%-9s %7s %8s %7s %10s %8s %9s %18s %12s\n", title, "class", "ranges", "detected", "recall",
+           "detections", "correct", "precision", "ttd p50/p90/max s", "false/hour");
+    for (i = 0; i < CLASS_COUNT; i++) {
+        s = &scores[i];
+        if (i == CLASS_IDLE) {
+            printf("%-9s %7u %8s %7s %10s %8s %9s %18s %12s   %.0f s labeled\n", classNames[i], s->ranges,
+                   "-", "-", "-", "-", "-", "-", "-", s->labeled);
+            continue;
+        }
+        printf("%-9s %7u %8u %7.3f %10u %8u %9.3f", classNames[i], s->ranges, s->detected,
+               s->ranges ? (double)s->detected / s->ranges : 0, s->detections, s->correct,
+               s->detections ? (double)s->correct / s->detections : 0);
+        if (s->ttdCount) {
+            qsort(s->ttd, s->ttdCount, sizeof(double), compare);
+            printf("     %4.2f/%4.2f/%4.2f", percentile(s, 0.5), percentile(s, 0.9), s->ttd[s->ttdCount - 1]);
+        } else {
+            printf(" %18s", "-");
+        }
+        printf(" %12.1f\n", hours > 0 ? (s->detections - s->correct) / hours : 0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Score all[CLASS_COUNT], one[CLASS_COUNT];
+    Job *jobs;
+    int jobCount;
+    int threadCount = 0;
+    int verbose = 0;
+    int failed = 0;
+    uint64_t samples = 0;
+    double hours = 0;
+    double start;
+    int param;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threadCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            grace = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = 1;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 2 < argc && (param = lookup(argv[i + 1])) >= 0 &&
+                   paramSet(param, atof(argv[i + 2]))) {
+            i += 2;
+        } else {
+            break;
+        }
+    }
+    if (i == argc || argv[i][0] == '-') {
+        fprintf(stderr, "usage: score [-j threads] [-g grace s] [-v] [-s name value]... trace.csv...\n");
+        return 1;
+    }
+
+    config.samplePeriod = paramGet(PARAM_SAMPLE_PERIOD_MS) / 1000;
+    config.exercise = paramGet(PARAM_EXERCISE_THRESHOLD);
+    config.pet = paramGet(PARAM_PET_THRESHOLD);
+    config.petMaxVertical = paramGet(PARAM_PET_MAX_VERTICAL);
+    config.release = paramGet(PARAM_RELEASE);
+    config.refractory = paramGet(PARAM_REFRACTORY_MS) / 1000;
+    config.rhythmAmplitude = paramGet(PARAM_RHYTHM_AMPLITUDE);
+    config.rhythmPurity = paramGet(PARAM_RHYTHM_PURITY);
+
+    jobCount = argc - i;
+    jobs = calloc(jobCount, sizeof(Job));
+    start = now();
+    poolStart(threadCount);
+    for (param = 0; param < jobCount; param++) {
+        jobs[param].path = argv[i + param];
+        poolSubmit(run, &jobs[param]);
+    }
+    poolWait();
+
+    memset(all, 0, sizeof(all));
+    memset(one, 0, sizeof(one));
+    for (i = 0; i < jobCount; i++) {
+        if (!jobs[i].ok) {
+            failed = 1;
+            continue;
+        }
+        scoreTrace(&jobs[i].labels, &jobs[i].hits, jobs[i].duration, grace, 1, all);
+        samples += jobs[i].samples;
+        hours += jobs[i].duration / 3600;
+        if (verbose) {
+            scoreTrace(&jobs[i].labels, &jobs[i].hits, jobs[i].duration, grace, 1, one);
+            print(jobs[i].path, one, jobs[i].duration / 3600);
+            scoreFree(one);
+        }
+    }
+    print("all traces", all, hours);
+    printf("%d traces, %.2f hours, %llu samples in %.2f s on %d threads\n", jobCount, hours,
+           (unsigned long long)samples, now() - start, poolThreads());
+    scoreFree(all);
+    poolStop();
+    for (i = 0; i < jobCount; i++) {
+        corpusFree(&jobs[i].labels);
+        free(jobs[i].hits.hits);
+    }
+    free(jobs);
+    return failed;
+}
@@ -0,0 +1,196 @@
+/* synth: writes a synthetic labeled corpus for score, until recorded traces
+ * are labeled.
+ *
+ * Each trace is <dir>/synth_NNN.csv at the capture rate (-r, default 200 Hz)
+ * in the format of capture -p, with its synth_NNN.labels and the light of
+ * each second in synth_NNN.light (see corpus.h). A trace is a random
+ * sequence of ranges:
+ *     idle      lying still face up, with a single jolt now and then, in the
+ *               light or a third of the time in a dim room, 3 to 15 lux
+ *     exercise  shaken up and down, 1.5 to 3 Hz, 0.8 to 2 g
+ *     pet       slid back and forth along x or y, 0.8 to 2 Hz, 0.2 to 0.8 g,
+ *               turning about z
+ *     sleep     lying still face down, the sensor covered, 0 to 4 lux
+ * with the noise of the unit modelled in host/sim and a quarter of a second
+ * of turning between ranges. The same seed (-s) gives the same corpus.
+ *
+ * Build: gcc -O2 -o synth synth.c -lm
+ * Usage: ./synth [-s seed] [-n traces] [-m minutes] [-r rate Hz] dir
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define PI 3.14159265358979f
+#define ACCEL_NOISE 0.0025f     // g
+#define GYRO_NOISE 0.08f        // deg/s
+#define TURN_TIME 0.25          // s
+
+typedef enum {
+    RANGE_IDLE,
+    RANGE_EXERCISE,
+    RANGE_PET,
+    RANGE_SLEEP,
+    RANGE_COUNT
+} RangeType;
+
+static const char *rangeNames[RANGE_COUNT] = {"idle", "exercise", "pet", "sleep"};
+// Length of the ranges, s
+static const double rangeMin[RANGE_COUNT] = {5, 6, 6, 10};
+static const double rangeMax[RANGE_COUNT] = {30, 20, 20, 40};
+
+static unsigned long long state;
+
+static double uniform(void)
+{
+    // xorshift64*, the corpus must not depend on the libc
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return ((state * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double between(double low, double high)
+{
+    return low + (high - low) * uniform();
+}
+
+static float gauss(float sigma)
+{
+    double u = uniform();
+
+    return (float)(sigma * sqrt(-2 * log(u > 0 ? u : 1e-300)) * cos(2 * PI * uniform()));
+}
+
+static int writeTrace(const char *dir, int number, double minutes, double rate)
+{
+    char path[4096];
+    FILE *data, *labels, *light;
+    RangeType type = RANGE_IDLE;
+    double time = 0, end = 0, start = 0, jolt = -1;
+    double frequency = 0, amplitude = 0, lux = 0;
+    // z of the accelerometer, -1 g lying face up as the MPU of the unit reads
+    float up = -1, lastUp = -1;
+    float m[6];
+    int axis = 0;
+    int j;
+    long i, count = (long)(minutes * 60 * rate);
+
+    snprintf(path, sizeof(path), "%s/synth_%03d.csv", dir, number);
+    if (!(data = fopen(path, "w"))) {
+        perror(path);
+        return 0;
+    }
+    snprintf(path, sizeof(path), "%s/synth_%03d.labels", dir, number);
+    if (!(labels = fopen(path, "w"))) {
+        perror(path);
+        fclose(data);
+        return 0;
+    }
+    snprintf(path, sizeof(path), "%s/synth_%03d.light", dir, number);
+    if (!(light = fopen(path, "w"))) {
+        perror(path);
+        fclose(labels);
+        fclose(data);
+        return 0;
+    }
+    fprintf(labels, "# start end class\n");
+
+    for (i = 0; i < count; i++) {
+        time = i / rate;
+        if (time >= end) {
+            // The next range, never the same twice in a row
+            RangeType next = (RangeType)(uniform() * RANGE_COUNT);
+            if (next == type) {
+                next = (RangeType)((next + 1) % RANGE_COUNT);
+            }
+            type = next;
+            start = time;
+            end = time + between(rangeMin[type], rangeMax[type]);
+            if (end > count / rate) {
+                end = count / rate;
+            }
+            lastUp = up;
+            up = type == RANGE_SLEEP ? 1 : -1;
+            axis = uniform() < 0.5 ? 0 : 1;
+            frequency = type == RANGE_EXERCISE ? between(1.5, 3) : between(0.8, 2);
+            amplitude = type == RANGE_EXERCISE ? between(0.8, 2) : between(0.2, 0.8);
+            jolt = type == RANGE_IDLE && uniform() < 0.5 ? between(start + 1, end) : -1;
+            if (type == RANGE_SLEEP) {
+                lux = between(0, 4);
+            } else if (type == RANGE_IDLE && uniform() < 0.33) {
+                lux = between(3, 15);
+            } else {
+                lux = between(50, 400);
+            }
+            fprintf(labels, "%.3f %.3f %s\n", start, end, rangeNames[type]);
+        }
+
+        memset(m, 0, sizeof(m));
+        // Turning over between face up and face down, about x
+        if (time - start < TURN_TIME && up != lastUp) {
+            float angle = (float)(PI * (time - start) / TURN_TIME);
+            m[1] = sinf(angle);
+            m[2] = lastUp * cosf(angle);
+            m[3] = lastUp * 180 / TURN_TIME;
+        } else {
+            m[2] = up;
+        }
+        if (type == RANGE_EXERCISE) {
+            m[2] += (float)(amplitude * sin(2 * PI * frequency * (time - start)));
+            m[3] += 20 * (float)sin(2 * PI * frequency * (time - start) + 1);
+        } else if (type == RANGE_PET) {
+            m[axis] += (float)(amplitude * sin(2 * PI * frequency * (time - start)));
+            m[2] += (float)(0.05 * sin(4 * PI * frequency * (time - start)));
+            m[5] += (float)(40 * amplitude * cos(2 * PI * frequency * (time - start)));
+        } else if (jolt >= 0 && time >= jolt && time < jolt + 0.1) {
+            // A knock on the table: half a sine on z
+            m[2] += 1.5f * (float)sin(PI * (time - jolt) / 0.1);
+        }
+        for (j = 0; j < 6; j++) {
+            m[j] += gauss(j < 3 ? ACCEL_NOISE : GYRO_NOISE);
+        }
+        fprintf(data, "%.5f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", time, m[0], m[1], m[2], m[3], m[4], m[5]);
+        if (i % (long)rate == 0) {
+            fprintf(light, "%.5f,%.4f\n", time, lux * between(0.95, 1.05));
+        }
+    }
+    fclose(light);
+    fclose(labels);
+    fclose(data);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    double minutes = 10, rate = 200;
+    int traces = 16;
+    int i, n;
+
+    state = 1;
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            state = strtoull(argv[++i], NULL, 0) | 1;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            traces = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            minutes = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rate = atof(argv[++i]);
+        } else {
+            break;
+        }
+    }
+    if (i != argc - 1 || rate <= 0 || minutes <= 0) {
+        fprintf(stderr, "usage: synth [-s seed] [-n traces] [-m minutes] [-r rate Hz] dir\n");
+        return 1;
+    }
+    for (n = 0; n < traces; n++) {
+        if (!writeTrace(argv[i], n, minutes, rate)) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,553 @@
+/* tune: searches the detection constants on a labeled trace corpus and
+ * writes them as tuned.h.
+ *
+ * The corpus is as for score (see corpus.h). Searched are the window and
+ * the smoothing of detect.h, over the lists of -W and -S, and for each
+ * pair the exercise, pet and pet vertical thresholds, by coordinate
+ * descent on a grid of 0.25 from the params.h defaults; the darkness
+ * limit on its own, on a grid of 0.5 lux, from the light samples. A
+ * setting scores the mean F1 of exercise and petting, or the F1 of sleep,
+ * less 0.01 for each second of the mean time to detect.
+ *
+ * Fast because the window slides on over detections, so its averages do
+ * not depend on the thresholds. For each window and smoothing the averages
+ * of every sample are computed once, with the stages of detect.c and the
+ * filter of detect.h at the frequencies scaled by the smoothing, and a
+ * threshold setting is a scan of them through detectTrigger that only
+ * compares. The rhythm of the exercise does not depend on them either and
+ * is followed once, when loading, as is the posture that adds to the
+ * sleep of the darkness limit. The release, the refractory period and the
+ * rhythm limits are those of params.h. The thresholds are searched without
+ * the noise floors of noise.c, which only raise thresholds set below the
+ * noise.
+ * At the compiled window and smoothing the scan is first checked against
+ * detectSample on every trace. Loading, the averages and the scans are
+ * tasks of a work-stealing pool on all cores (-j to change).
+ *
+ * The header goes to -o (default stdout), the scores of the defaults and
+ * of the tuned constants to stderr.
+ *
+ * Build: gcc -O2 -pthread -DPROBE_EXCLUDE -I../.. -I../replay -o tune tune.c corpus.c pool.c \
+ *            ../replay/trace.c ../../detect.c ../../filter.c ../../rhythm.c ../../attitude.c ../../params.c -lm
+ * Usage: ./tune [-j threads] [-g grace s] [-W windows] [-S smoothings] [-o tuned.h] trace.csv...
+ *        e.g. ./tune -W 30,40,50 -S 2,3 -o ../../tuned.h corpus/synth_*.csv
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "detect.h"
+#include "attitude.h"
+#include "params.h"
+#include "trace.h"
+#include "corpus.h"
+#include "pool.h"
+
+#define MAX_SHAPES 32
+#define MAX_WINDOW 255
+#define MAX_STEPS 64
+#define MAX_ROUNDS 4
+#define THRESHOLD_STEP 0.25f
+#define DARK_STEP 0.5f
+// Of the score, for each second of the mean time to detect
+#define TTD_WEIGHT 0.01
+
+typedef struct {
+    const char *path;
+    Labels labels;
+    double *times;
+    float *motion[3];       // ax, ay, az
+    float *averages;        // ax, ay, az of the window ending at each sample and of its last samples
+    uint8_t *rhythmic;      // of each sample
+    HitList reference;      // of detectSample at the defaults
+    HitList posture;        // sleep, laid face down
+    int count;
+    double duration;
+    int ok;
+} Trace;
+
+typedef struct {
+    int window;
+    int smooth;
+    DetectConfig config;
+    float darkLux;
+} Setting;
+
+typedef struct {
+    const Setting *setting;
+    int first;              // trace
+    int last;
+    int sleep;              // scores the darkness limit instead
+    Score scores[CLASS_COUNT];
+} Scan;
+
+static Trace *traces;
+static int traceCount;
+static double grace = 1.0;
+static int shapeWindow;     // of the averages
+static Biquad shapeSections[DETECT_SECTIONS];
+static Setting defaults;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int parseList(const char *text, int *values, int max)
+{
+    int count = 0;
+    char *end;
+
+    while (*text && count < max) {
+        values[count++] = (int)strtol(text, &end, 10);
+        if (end == text) {
+            return 0;
+        }
+        text = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+/* ---- Tasks ---- */
+
+static void load(void *arg)
+{
+    Trace *t = arg;
+    TraceReader *reader = malloc(sizeof(TraceReader));
+    Detector detector;
+    Rhythm rhythm;
+    Attitude attitude;
+    Posture posture = POSTURE_UNKNOWN;
+    int capacity = 0;
+    float motion[6];
+    double time = 0;
+    int result, i;
+
+    if (!reader || !corpusLoad(&t->labels, t->path) ||
+        !traceOpen(reader, t->path, defaults.config.samplePeriod)) {
+        free(reader);
+        return;
+    }
+    detectReset(&detector);
+    rhythmReset(&rhythm, defaults.config.samplePeriod);
+    attitudeReset(&attitude);
+    while (traceNext(reader, &time, motion)) {
+        if (t->count == capacity) {
+            capacity = capacity ? 2 * capacity : 4096;
+            t->times = realloc(t->times, capacity * sizeof(double));
+            t->rhythmic = realloc(t->rhythmic, capacity);
+            for (i = 0; i < 3; i++) {
+                t->motion[i] = realloc(t->motion[i], capacity * sizeof(float));
+            }
+        }
+        t->times[t->count] = time;
+        for (i = 0; i < 3; i++) {
+            t->motion[i][t->count] = motion[i];
+        }
+        t->rhythmic[t->count] = (uint8_t)rhythmSample(&rhythm, motion, defaults.config.samplePeriod,
+                                                       defaults.config.rhythmAmplitude, defaults.config.rhythmPurity);
+        t->count++;
+        if (attitudeSample(&attitude, motion, (uint32_t)paramGet(PARAM_SAMPLE_PERIOD_MS)) != posture) {
+            posture = attitude.posture;
+            if (posture == POSTURE_FACE_DOWN) {
+                hitAdd(&t->posture, time, CLASS_SLEEP);
+            }
+        }
+
+        result = detectSample(&detector, (float)time, motion, &defaults.config);
+        if (result & DETECT_EXERCISE) {
+            hitAdd(&t->reference, time, CLASS_EXERCISE);
+        }
+        if (result & DETECT_PET) {
+            hitAdd(&t->reference, time, CLASS_PET);
+        }
+    }
+    t->duration = time;
+    t->averages = malloc((t->count ? t->count : 1) * 6 * sizeof(float));
+    t->ok = 1;
+    traceClose(reader);
+    free(reader);
+}
+
+// The averages of detectSample for each window end of the shape
+static void average(void *arg)
+{
+    Trace *t = arg;
+    BiquadState states[DETECT_SECTIONS];
+    DetectSums sums;
+    float ring[MAX_WINDOW];
+    float value, previous;
+    int slopeCount = shapeWindow - 1;
+    int axis, n, index;
+
+    for (axis = 0; axis < 3 && t->count > 0; axis++) {
+        memset(ring, 0, sizeof(ring));
+        memset(&sums, 0, sizeof(sums));
+        previous = filterStart(shapeSections, DETECT_SECTIONS, states, t->motion[axis][0]);
+        for (n = 1, index = 0; n < t->count; n++) {
+            value = filterSample(shapeSections, DETECT_SECTIONS, states, t->motion[axis][n]);
+            detectSlide(ring, slopeCount, index, fabsf(value - previous) / defaults.config.samplePeriod, &sums);
+            previous = value;
+            index = index == slopeCount - 1 ? 0 : index + 1;
+            if (n >= shapeWindow - 1) {
+                t->averages[6 * n + axis] = sums.window / slopeCount;
+                t->averages[6 * n + 3 + axis] = sums.recent / DETECT_RECENT;
+            }
+        }
+    }
+}
+
+// The detections of detectSample at the setting, from the averages
+static void detect(const Trace *t, const Setting *s, HitList *hits)
+{
+    DetectTrigger trigger;
+    int result, n;
+
+    hits->count = 0;
+    detectTriggerReset(&trigger);
+    for (n = s->window - 1; n < t->count; n++) {
+        result = detectTrigger(&trigger, (float)t->times[n], &t->averages[6 * n], &t->averages[6 * n + 3],
+                               t->rhythmic[n], &s->config);
+        if (result & DETECT_EXERCISE) {
+            hitAdd(hits, t->times[n], CLASS_EXERCISE);
+        }
+        if (result & DETECT_PET) {
+            hitAdd(hits, t->times[n], CLASS_PET);
+        }
+    }
+}
+
+static void scan(void *arg)
+{
+    Scan *scan = arg;
+    HitList hits = {NULL, 0, 0};
+    int i, h;
+
+    for (i = scan->first; i < scan->last; i++) {
+        if (!traces[i].ok) {
+            continue;
+        }
+        hits.count = 0;
+        if (scan->sleep) {
+            for (h = 0; h < traces[i].posture.count; h++) {
+                hitAdd(&hits, traces[i].posture.hits[h].time, CLASS_SLEEP);
+            }
+            corpusSleep(&traces[i].labels, scan->setting->darkLux, &hits);
+        } else {
+            detect(&traces[i], scan->setting, &hits);
+        }
+        scoreTrace(&traces[i].labels, &hits, traces[i].duration, grace, 0, scan->scores);
+    }
+    free(hits.hits);
+}
+
+/* ---- Search ---- */
+
+static double objective(const Score scores[CLASS_COUNT], int sleep)
+{
+    uint32_t detected;
+    double ttd, f1;
+
+    if (sleep) {
+        f1 = scoreF1(&scores[CLASS_SLEEP]);
+        detected = scores[CLASS_SLEEP].detected;
+        ttd = scores[CLASS_SLEEP].ttdSum;
+    } else {
+        f1 = (scoreF1(&scores[CLASS_EXERCISE]) + scoreF1(&scores[CLASS_PET])) / 2;
+        detected = scores[CLASS_EXERCISE].detected + scores[CLASS_PET].detected;
+        ttd = scores[CLASS_EXERCISE].ttdSum + scores[CLASS_PET].ttdSum;
+    }
+    return f1 - (detected ? TTD_WEIGHT * ttd / detected : 0);
+}
+
+// Scores the settings over all the traces, in chunks so the threads share even a few settings
+static void evaluate(const Setting *settings, int count, int sleep, Score scores[][CLASS_COUNT])
+{
+    int chunks = 4 * poolThreads() / count + 1;
+    Scan *scans;
+    int s, c;
+
+    if (chunks > traceCount) {
+        chunks = traceCount;
+    }
+    scans = calloc(count * chunks, sizeof(Scan));
+    for (s = 0; s < count; s++) {
+        for (c = 0; c < chunks; c++) {
+            Scan *p = &scans[s * chunks + c];
+            p->setting = &settings[s];
+            p->first = (int)((long)traceCount * c / chunks);
+            p->last = (int)((long)traceCount * (c + 1) / chunks);
+            p->sleep = sleep;
+            poolSubmit(scan, p);
+        }
+    }
+    poolWait();
+    memset(scores, 0, count * sizeof(scores[0]));
+    for (s = 0; s < count; s++) {
+        for (c = 0; c < chunks; c++) {
+            scoreAdd(scores[s], scans[s * chunks + c].scores);
+        }
+    }
+    free(scans);
+}
+
+static float *threshold(Setting *s, int which)
+{
+    return which == 0 ? &s->config.exercise : which == 1 ? &s->config.pet : &s->config.petMaxVertical;
+}
+
+// Moves one value over its grid, the others fixed; 1 if it changed
+static int sweep(Setting *best, double *bestScore, float *(*value)(Setting *, int), int which, float step,
+                 int sleep, Score bestScores[CLASS_COUNT])
+{
+    Setting settings[MAX_STEPS];
+    Score scores[MAX_STEPS][CLASS_COUNT];
+    double score;
+    int changed = 0;
+    int i;
+
+    for (i = 0; i < MAX_STEPS; i++) {
+        settings[i] = *best;
+        *value(&settings[i], which) = step * (i + 1);
+    }
+    evaluate(settings, MAX_STEPS, sleep, scores);
+    for (i = 0; i < MAX_STEPS; i++) {
+        score = objective(scores[i], sleep);
+        if (score > *bestScore + 1e-12) {
+            *bestScore = score;
+            *best = settings[i];
+            memcpy(bestScores, scores[i], sizeof(scores[i]));
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+static float *darkLux(Setting *s, int which)
+{
+    (void)which;
+    return &s->darkLux;
+}
+
+// The averages of the shape for all the traces
+static void shape(int window, int smooth)
+{
+    int i;
+
+    shapeWindow = window;
+    // The table of detect.h, at the frequencies of the smoothing
+    i = 0;
+#define SHAPE_SECTION(type, frequency, q) \
+    filterDesign(&shapeSections[i++], type, smooth == DETECT_SMOOTH ? (frequency) : \
+                 (frequency) * DETECT_SMOOTH / smooth, q);
+    DETECT_FILTER(SHAPE_SECTION)
+#undef SHAPE_SECTION
+    for (i = 0; i < traceCount; i++) {
+        if (traces[i].ok) {
+            poolSubmit(average, &traces[i]);
+        }
+    }
+    poolWait();
+}
+
+// The scan against detectSample, at the compiled shape and the defaults
+static int check(void)
+{
+    HitList hits = {NULL, 0, 0};
+    int i, h;
+
+    for (i = 0; i < traceCount; i++) {
+        if (!traces[i].ok) {
+            continue;
+        }
+        detect(&traces[i], &defaults, &hits);
+        for (h = 0; h < hits.count && h < traces[i].reference.count &&
+                    hits.hits[h].time == traces[i].reference.hits[h].time &&
+                    hits.hits[h].type == traces[i].reference.hits[h].type; h++) {
+        }
+        if (h < hits.count || h < traces[i].reference.count) {
+            fprintf(stderr, "%s: the scan differs from detectSample at detection %d\n", traces[i].path, h);
+            free(hits.hits);
+            return 0;
+        }
+    }
+    free(hits.hits);
+    return 1;
+}
+
+static void report(const char *title, const Setting *s, const Score scores[CLASS_COUNT])
+{
+    int i;
+
+    fprintf(stderr, "%s: window %d, smooth %d, exercise %g, pet %g, pet vertical %g, dark %g lux\n", title,
+            s->window, s->smooth, s->config.exercise, s->config.pet, s->config.petMaxVertical, s->darkLux);
+    for (i = CLASS_EXERCISE; i <= CLASS_SLEEP; i++) {
+        fprintf(stderr, "    %-9s recall %.3f, precision %.3f, F1 %.3f, time to detect %.2f s\n", classNames[i],
+                scores[i].ranges ? (double)scores[i].detected / scores[i].ranges : 0,
+                scores[i].detections ? (double)scores[i].correct / scores[i].detections : 0,
+                scoreF1(&scores[i]), scores[i].detected ? scores[i].ttdSum / scores[i].detected : 0);
+    }
+}
+
+static void writeHeader(FILE *file, const Setting *s, const Score scores[CLASS_COUNT], double hours)
+{
+    fprintf(file, "/** ============================================================================\n"
+                  " *  @file       tuned.h\n"
+                  " *\n"
+                  " *  @brief      Detection constants tuned on a labeled trace corpus.\n"
+                  " *\n"
+                  " *  Generated by host/score/tune, do not edit. The defaults of params.h and\n"
+                  " *  the window of detect.h.\n");
+    fprintf(file, " *  %d traces, %.1f hours: F1 exercise %.3f, pet %.3f, sleep %.3f.\n", traceCount, hours,
+            scoreF1(&scores[CLASS_EXERCISE]), scoreF1(&scores[CLASS_PET]), scoreF1(&scores[CLASS_SLEEP]));
+    fprintf(file, " *  ============================================================================\n"
+                  " */\n"
+                  "#ifndef _TUNED_H_\n"
+                  "#define _TUNED_H_\n\n");
+    fprintf(file, "#define TUNED_DETECT_WINDOW         %d\n", s->window);
+    fprintf(file, "#define TUNED_DETECT_SMOOTH         %d\n", s->smooth);
+    fprintf(file, "#define TUNED_EXERCISE_THRESHOLD    %g\n", s->config.exercise);
+    fprintf(file, "#define TUNED_PET_THRESHOLD         %g\n", s->config.pet);
+    fprintf(file, "#define TUNED_PET_MAX_VERTICAL      %g\n", s->config.petMaxVertical);
+    fprintf(file, "#define TUNED_DARK_LUX              %g\n", s->darkLux);
+    fprintf(file, "\n#endif\n");
+}
+
+int main(int argc, char **argv)
+{
+    int windows[MAX_SHAPES] = {20, 30, 40, 50, 60, 70};
+    int smooths[MAX_SHAPES] = {1, 2, 3, 4, 5};
+    int windowCount = 6, smoothCount = 5;
+    Score defaultScores[CLASS_COUNT], bestScores[CLASS_COUNT], shapeScores[CLASS_COUNT];
+    Score sleepScores[1][CLASS_COUNT];
+    Setting best, current;
+    double bestScore = -1e9, score;
+    double hours = 0;
+    const char *output = NULL;
+    int threadCount = 0;
+    double start = now();
+    FILE *file;
+    int w, s, i, round;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threadCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            grace = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-W") == 0 && i + 1 < argc &&
+                   (windowCount = parseList(argv[++i], windows, MAX_SHAPES)) > 0) {
+        } else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc &&
+                   (smoothCount = parseList(argv[++i], smooths, MAX_SHAPES)) > 0) {
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            break;
+        }
+    }
+    if (i == argc || argv[i][0] == '-') {
+        fprintf(stderr, "usage: tune [-j threads] [-g grace s] [-W windows] [-S smoothings] [-o tuned.h] "
+                        "trace.csv...\n");
+        return 1;
+    }
+
+    defaults.window = DETECT_WINDOW;
+    defaults.smooth = DETECT_SMOOTH;
+    defaults.config.samplePeriod = paramGet(PARAM_SAMPLE_PERIOD_MS) / 1000;
+    defaults.config.exercise = paramGet(PARAM_EXERCISE_THRESHOLD);
+    defaults.config.pet = paramGet(PARAM_PET_THRESHOLD);
+    defaults.config.petMaxVertical = paramGet(PARAM_PET_MAX_VERTICAL);
+    defaults.config.release = paramGet(PARAM_RELEASE);
+    defaults.config.refractory = paramGet(PARAM_REFRACTORY_MS) / 1000;
+    defaults.config.rhythmAmplitude = paramGet(PARAM_RHYTHM_AMPLITUDE);
+    defaults.config.rhythmPurity = paramGet(PARAM_RHYTHM_PURITY);
+    defaults.darkLux = paramGet(PARAM_DARK_LUX);
+
+    traceCount = argc - i;
+    traces = calloc(traceCount, sizeof(Trace));
+    poolStart(threadCount);
+    for (w = 0; w < traceCount; w++) {
+        traces[w].path = argv[i + w];
+        poolSubmit(load, &traces[w]);
+    }
+    poolWait();
+    for (w = 0; w < traceCount; w++) {
+        if (!traces[w].ok) {
+            return 1;
+        }
+        hours += traces[w].duration / 3600;
+    }
+    fprintf(stderr, "%d traces, %.1f hours loaded in %.1f s on %d threads\n", traceCount, hours, now() - start,
+            poolThreads());
+
+    shape(DETECT_WINDOW, DETECT_SMOOTH);
+    if (!check()) {
+        return 1;
+    }
+    evaluate(&defaults, 1, 0, &defaultScores);
+    evaluate(&defaults, 1, 1, sleepScores);
+    defaultScores[CLASS_SLEEP] = sleepScores[0][CLASS_SLEEP];
+    report("defaults", &defaults, defaultScores);
+
+    for (w = 0; w < windowCount; w++) {
+        for (s = 0; s < smoothCount; s++) {
+            if (windows[w] > MAX_WINDOW || smooths[s] < 1 || windows[w] - 1 < DETECT_RECENT) {
+                fprintf(stderr, "window %d, smooth %d: skipped\n", windows[w], smooths[s]);
+                continue;
+            }
+            shape(windows[w], smooths[s]);
+            current = defaults;
+            current.window = windows[w];
+            current.smooth = smooths[s];
+            evaluate(&current, 1, 0, &shapeScores);
+            score = objective(shapeScores, 0);
+            for (round = 0; round < MAX_ROUNDS; round++) {
+                int changed = 0;
+                for (i = 0; i < 3; i++) {
+                    changed |= sweep(&current, &score, threshold, i, THRESHOLD_STEP, 0, shapeScores);
+                }
+                if (!changed) {
+                    break;
+                }
+            }
+            fprintf(stderr, "window %d, smooth %d: score %.4f, exercise %g, pet %g, pet vertical %g\n",
+                    windows[w], smooths[s], score, current.config.exercise, current.config.pet,
+                    current.config.petMaxVertical);
+            if (score > bestScore) {
+                bestScore = score;
+                best = current;
+                memcpy(bestScores, shapeScores, sizeof(bestScores));
+            }
+        }
+    }
+    if (bestScore == -1e9) {
+        fprintf(stderr, "no window and smoothing to search\n");
+        return 1;
+    }
+
+    // The darkness limit has nothing to do with the motion
+    score = objective(sleepScores[0], 1);
+    sweep(&best, &score, darkLux, 0, DARK_STEP, 1, sleepScores[0]);
+    bestScores[CLASS_SLEEP] = sleepScores[0][CLASS_SLEEP];
+    report("tuned", &best, bestScores);
+    fprintf(stderr, "searched in %.1f s\n", now() - start);
+
+    file = output ? fopen(output, "w") : stdout;
+    if (!file) {
+        perror(output);
+        return 1;
+    }
+    writeHeader(file, &best, bestScores, hours);
+    if (output) {
+        fclose(file);
+    }
+    poolStop();
+    return 0;
+}
@@ -0,0 +1,508 @@
+/* Host simulator: the TI drivers of the board.
+ *
+ * PIN: the buttons are inputs set by the scenario, the outputs go to the
+ * models (MPU power, flash chip select) or are counted (LED).
+ * I2C: transfers go to the models by address and take the bus time.
+ * UART: the written bytes go to the -s file, as from the real serial port,
+ * and complete at the baud rate; reads get the bytes of the scenario.
+ * SPI: the external flash model. Timer: the buzzer tones are traced.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/drivers/PIN.h>
+#include <ti/drivers/pin/PINCC26XX.h>
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/UART.h>
+#include <ti/drivers/SPI.h>
+#include <ti/drivers/Power.h>
+#include <driverlib/timer.h>
+#include <driverlib/ioc.h>
+
+#include "Board.h"
+#include "serial.h"
+#include "sim.h"
+
+#define PIN_COUNT           32
+#define SERIAL_RX_SIZE      4096
+// The timer of the buzzer runs at the CPU clock
+#define TIMER_HZ            48000000
+
+const PIN_Config BoardGpioInitTable[] = {
+    Board_STK_LED1 | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW,
+    Board_KEY_LEFT | PIN_INPUT_EN | PIN_PULLUP,
+    Board_KEY_RIGHT | PIN_INPUT_EN | PIN_PULLUP,
+    Board_BUZZER | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW,
+    Board_MPU_POWER | PIN_GPIO_OUTPUT_EN | PIN_GPIO_HIGH,
+    Board_SPI_FLASH_CS | PIN_GPIO_OUTPUT_EN | PIN_GPIO_HIGH,
+    PIN_TERMINATE
+};
+
+typedef struct {
+    PIN_Config config;
+    PIN_Handle owner;
+    int output;
+    int input;
+} Pin;
+
+struct SimI2C {
+    int open;
+    uint32_t bitRate;
+};
+
+struct SimUart {
+    int open;
+    UART_Params params;
+};
+
+struct SimSpi {
+    int open;
+    uint32_t bitRate;
+};
+
+static Pin pins[PIN_COUNT];
+static struct SimI2C i2c;
+static struct SimUart uart;
+static struct SimSpi spi;
+static SimDriverStats stats;
+
+static FILE *serialFile = NULL;
+static uint8_t rx[SERIAL_RX_SIZE];
+static size_t rxHead = 0;
+static size_t rxCount = 0;
+static int txInFrame = 0;
+
+static uint32_t timerLoad = 0;
+static uint32_t timerPrescale = 0;
+static int toneOn = 0;
+
+/* ---- PIN ---- */
+
+static void pinOutput(PIN_Id id, int level)
+{
+    if (pins[id].output == level) {
+        return;
+    }
+    pins[id].output = level;
+    switch (id) {
+    case Board_MPU_POWER:
+        mpuModelPower(level == Board_MPU_POWER_ON);
+        break;
+    case Board_SPI_FLASH_CS:
+        flashModelSelect(level == Board_FLASH_CS_ON);
+        break;
+    case Board_LED1:
+        stats.ledToggles++;
+        if (simVerbose) {
+            simTrace("led", "%s", level ? "on" : "off");
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+int PIN_init(const PIN_Config config[])
+{
+    PIN_Id id;
+    int i;
+
+    for (i = 0; i < PIN_COUNT; i++) {
+        pins[i].input = 1;
+    }
+    for (i = 0; config[i] != PIN_TERMINATE; i++) {
+        id = PIN_ID(config[i]);
+        pins[id].config = config[i];
+        pins[id].output = -1;
+        if (config[i] & PIN_GPIO_OUTPUT_EN) {
+            pinOutput(id, (config[i] & PIN_GPIO_HIGH) != 0);
+        }
+    }
+    return PIN_SUCCESS;
+}
+
+PIN_Handle PIN_open(PIN_State *state, const PIN_Config config[])
+{
+    PIN_Id id;
+    int i;
+
+    for (i = 0; config[i] != PIN_TERMINATE; i++) {
+        if (pins[PIN_ID(config[i])].owner) {
+            return NULL;
+        }
+    }
+    state->pins = 0;
+    state->callback = NULL;
+    for (i = 0; config[i] != PIN_TERMINATE; i++) {
+        id = PIN_ID(config[i]);
+        pins[id].owner = state;
+        pins[id].config = config[i];
+        state->pins |= (uint64_t)1 << id;
+        if (config[i] & PIN_GPIO_OUTPUT_EN) {
+            pinOutput(id, (config[i] & PIN_GPIO_HIGH) != 0);
+        }
+    }
+    return state;
+}
+
+void PIN_close(PIN_Handle handle)
+{
+    int i;
+
+    for (i = 0; i < PIN_COUNT; i++) {
+        if (pins[i].owner == handle) {
+            pins[i].owner = NULL;
+        }
+    }
+}
+
+int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callback)
+{
+    handle->callback = callback;
+    return PIN_SUCCESS;
+}
+
+int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, uint32_t value)
+{
+    if (pinId >= PIN_COUNT || pins[pinId].owner != handle) {
+        return 1;
+    }
+    pinOutput(pinId, value != 0);
+    return PIN_SUCCESS;
+}
+
+uint32_t PIN_getInputValue(PIN_Id pinId)
+{
+    return pins[pinId].input;
+}
+
+uint32_t PIN_getOutputValue(PIN_Id pinId)
+{
+    return pins[pinId].output > 0;
+}
+
+int PINCC26XX_setMux(PIN_Handle handle, PIN_Id pinId, int32_t mux)
+{
+    if (pinId == Board_BUZZER && mux == IOC_PORT_GPIO && toneOn) {
+        toneOn = 0;
+        if (simVerbose) {
+            simTrace("buzzer", "off");
+        }
+    }
+    return PIN_SUCCESS;
+}
+
+int PINCC26XX_setWakeup(const PIN_Config config[])
+{
+    return PIN_SUCCESS;
+}
+
+void simPinInput(uint8_t pin, int level)
+{
+    Pin *p = &pins[pin];
+
+    if (p->input == level) {
+        return;
+    }
+    p->input = level;
+    if (p->owner && p->owner->callback &&
+        (p->config & (level ? PIN_IRQ_POSEDGE : PIN_IRQ_NEGEDGE))) {
+        p->owner->callback(p->owner, pin);
+    }
+}
+
+/* ---- I2C ---- */
+
+void I2C_init(void)
+{
+}
+
+void I2C_Params_init(I2C_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+    params->bitRate = I2C_100kHz;
+}
+
+I2C_Handle I2C_open(unsigned int index, I2C_Params *params)
+{
+    if (index != 0 || i2c.open) {
+        return NULL;
+    }
+    i2c.open = 1;
+    i2c.bitRate = params->bitRate == I2C_400kHz ? 400000 : 100000;
+    return &i2c;
+}
+
+void I2C_close(I2C_Handle handle)
+{
+    handle->open = 0;
+}
+
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction)
+{
+    // Start, address and 9 bits a byte, a repeated start and address before a read
+    uint32_t bits = 1 + 9 * (1 + transaction->writeCount) +
+                    (transaction->readCount ? 1 + 9 * (1 + transaction->readCount) : 0) + 1;
+    uint64_t ticks;
+    int ok;
+
+    switch (transaction->slaveAddress) {
+    case Board_MPU9250_ADDR:
+        ok = mpuModelTransfer(transaction->writeBuf, transaction->writeCount,
+                              transaction->readBuf, transaction->readCount);
+        break;
+    case Board_OPT3001_ADDR:
+        ok = optModelTransfer(transaction->writeBuf, transaction->writeCount,
+                              transaction->readBuf, transaction->readCount);
+        break;
+    default:
+        ok = 0;
+        break;
+    }
+    stats.i2cTransfers++;
+    stats.i2cBytes += transaction->writeCount + transaction->readCount;
+    if (!ok) {
+        // Ends at the address byte
+        stats.i2cNacks++;
+        bits = 10;
+    }
+    ticks = ((uint64_t)bits * SIM_TICKS_PER_SECOND + handle->bitRate - 1) / handle->bitRate;
+    stats.i2cBusTicks += ticks;
+    simBusy(ticks);
+    return ok;
+}
+
+/* ---- UART ---- */
+
+static void uartWriteDone(void *arg)
+{
+    uintptr_t count = (uintptr_t)arg;
+
+    if (uart.params.writeCallback) {
+        uart.params.writeCallback(&uart, NULL, count);
+    }
+}
+
+void UART_init(void)
+{
+}
+
+void UART_Params_init(UART_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+    params->readTimeout = ~(uint32_t)0;
+    params->writeTimeout = ~(uint32_t)0;
+    params->baudRate = 115200;
+    params->dataLength = UART_LEN_8;
+}
+
+UART_Handle UART_open(unsigned int index, UART_Params *params)
+{
+    if (index != 0 || uart.open) {
+        return NULL;
+    }
+    uart.open = 1;
+    uart.params = *params;
+    return &uart;
+}
+
+void UART_close(UART_Handle handle)
+{
+    handle->open = 0;
+}
+
+int UART_write(UART_Handle handle, const void *buffer, size_t size)
+{
+    const uint8_t *bytes = buffer;
+    // 10 bits a byte
+    uint64_t ticks = ((uint64_t)size * 10 * SIM_TICKS_PER_SECOND + handle->params.baudRate - 1) /
+                     handle->params.baudRate;
+    size_t i;
+
+    if (serialFile) {
+        fwrite(buffer, 1, size, serialFile);
+    }
+    for (i = 0; i < size; i++) {
+        if (bytes[i] == SERIAL_FLAG) {
+            stats.serialFrames += txInFrame;
+            txInFrame = 0;
+        } else {
+            // A frame has bytes between its flags
+            txInFrame = 1;
+        }
+    }
+    stats.serialBytes += size;
+    if (handle->params.writeMode == UART_MODE_CALLBACK) {
+        simSchedule(simNow + (ticks ? ticks : 1), uartWriteDone, (void *)(uintptr_t)size);
+        return 0;
+    }
+    simBusy(ticks);
+    return size;
+}
+
+int UART_read(UART_Handle handle, void *buffer, size_t size)
+{
+    uint8_t *bytes = buffer;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        while (rxCount == 0) {
+            if (!simWait(rx, handle->params.readTimeout == ~(uint32_t)0 ? SIM_FOREVER
+                                                                      : handle->params.readTimeout)) {
+                return i;
+            }
+        }
+        bytes[i] = rx[rxHead];
+        rxHead = (rxHead + 1) % SERIAL_RX_SIZE;
+        rxCount--;
+    }
+    return size;
+}
+
+void simSerialInput(const uint8_t *data, size_t length)
+{
+    size_t i;
+
+    for (i = 0; i < length && rxCount < SERIAL_RX_SIZE; i++) {
+        rx[(rxHead + rxCount++) % SERIAL_RX_SIZE] = data[i];
+    }
+    simWake(rx);
+}
+
+int simSerialOutput(const char *path)
+{
+    serialFile = fopen(path, "wb");
+    if (!serialFile) {
+        perror(path);
+        return 0;
+    }
+    return 1;
+}
+
+/* ---- SPI ---- */
+
+void SPI_init(void)
+{
+}
+
+void SPI_Params_init(SPI_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+    params->bitRate = 1000000;
+    params->dataSize = 8;
+}
+
+SPI_Handle SPI_open(unsigned int index, SPI_Params *params)
+{
+    if (index != 0 || spi.open) {
+        return NULL;
+    }
+    spi.open = 1;
+    spi.bitRate = params->bitRate;
+    return &spi;
+}
+
+void SPI_close(SPI_Handle handle)
+{
+    handle->open = 0;
+}
+
+bool SPI_transfer(SPI_Handle handle, SPI_Transaction *transaction)
+{
+    const uint8_t *tx = transaction->txBuf;
+    uint8_t *rxBuf = transaction->rxBuf;
+    uint8_t in;
+    size_t i;
+
+    for (i = 0; i < transaction->count; i++) {
+        in = flashModelExchange(tx ? tx[i] : 0);
+        if (rxBuf) {
+            rxBuf[i] = in;
+        }
+    }
+    simBusy(((uint64_t)transaction->count * 8 * SIM_TICKS_PER_SECOND + handle->bitRate - 1) / handle->bitRate);
+    return true;
+}
+
+/* ---- Power ---- */
+
+int Power_init(void)
+{
+    return 0;
+}
+
+int Power_setDependency(unsigned int resourceId)
+{
+    return 0;
+}
+
+int Power_releaseDependency(unsigned int resourceId)
+{
+    return 0;
+}
+
+int Power_setConstraint(unsigned int constraintId)
+{
+    return 0;
+}
+
+int Power_releaseConstraint(unsigned int constraintId)
+{
+    return 0;
+}
+
+// Only the power button wakes the device, that is a new run
+int Power_shutdown(unsigned int shutdownState, uint32_t shutdownTime)
+{
+    simTrace("power", "shutdown");
+    simStop("shutdown");
+    simWait(NULL, SIM_FOREVER);
+    return 0;
+}
+
+/* ---- Timers, the buzzer ---- */
+
+void TimerConfigure(uint32_t base, uint32_t config)
+{
+}
+
+void TimerEnable(uint32_t base, uint32_t timer)
+{
+    uint32_t ticks = (timerPrescale << 16) | timerLoad;
+
+    toneOn = 1;
+    stats.tones++;
+    if (simVerbose && ticks) {
+        simTrace("buzzer", "%u Hz", TIMER_HZ / ticks);
+    }
+}
+
+void TimerDisable(uint32_t base, uint32_t timer)
+{
+}
+
+void TimerLoadSet(uint32_t base, uint32_t timer, uint32_t value)
+{
+    timerLoad = value;
+}
+
+void TimerPrescaleSet(uint32_t base, uint32_t timer, uint32_t value)
+{
+    timerPrescale = value;
+}
+
+void TimerMatchSet(uint32_t base, uint32_t timer, uint32_t value)
+{
+}
+
+void TimerPrescaleMatchSet(uint32_t base, uint32_t timer, uint32_t value)
+{
+}
+
+void simGetDriverStats(SimDriverStats *copy)
+{
+    *copy = stats;
+}
@@ -0,0 +1,170 @@
+/* Host simulator: the MX25R8035F SPI flash, 1 MB.
+ *
+ * The commands of extflash.c: JEDEC ID, status, write enable, page
+ * program, sector erase, fast read and deep power down. Programming only
+ * clears bits and wraps within the page; program and erase start at the
+ * chip select rising edge and keep the chip busy for their typical time.
+ * The contents can be loaded from and saved to an image file, so a run can
+ * carry on from the flash log of an earlier one.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define FLASH_SIZE              (1024 * 1024)
+#define PAGE_SIZE               256
+#define SECTOR_SIZE             4096
+
+#define CMD_WRITE_ENABLE        0x06
+#define CMD_READ_STATUS         0x05
+#define CMD_FAST_READ           0x0B
+#define CMD_PAGE_PROGRAM        0x02
+#define CMD_SECTOR_ERASE        0x20
+#define CMD_JEDEC_ID            0x9F
+#define CMD_DEEP_POWER_DOWN     0xB9
+#define CMD_RELEASE_POWER_DOWN  0xAB
+
+#define STATUS_WIP              0x01
+#define STATUS_WEL              0x02
+
+#define PROGRAM_TICKS           SIM_TICKS(0.00085)
+#define ERASE_TICKS             SIM_TICKS(0.04)
+
+static const uint8_t jedecId[3] = {0xC2, 0x28, 0x14};
+
+static uint8_t memory[FLASH_SIZE];
+static int initialized = 0;
+static int selected = 0;
+static int poweredDown = 0;
+static int writeEnabled = 0;
+static uint64_t busyUntil = 0;
+static uint32_t pagesProgrammed = 0;
+
+// The command within the current chip select
+static uint8_t command;
+static uint32_t position;
+static uint32_t address;
+static int programmed;
+
+static void init(void)
+{
+    if (!initialized) {
+        memset(memory, 0xFF, sizeof(memory));
+        initialized = 1;
+    }
+}
+
+static int busy(void)
+{
+    return simNow < busyUntil;
+}
+
+void flashModelSelect(int select)
+{
+    init();
+    if (select) {
+        position = 0;
+        address = 0;
+        programmed = 0;
+    } else if (selected && position > 0) {
+        // Program and erase start when the chip is deselected
+        if (command == CMD_PAGE_PROGRAM && programmed) {
+            busyUntil = simNow + PROGRAM_TICKS;
+            writeEnabled = 0;
+            pagesProgrammed++;
+        } else if (command == CMD_SECTOR_ERASE && position == 4 && writeEnabled) {
+            memset(memory + (address & ~(SECTOR_SIZE - 1)) % FLASH_SIZE, 0xFF, SECTOR_SIZE);
+            busyUntil = simNow + ERASE_TICKS;
+            writeEnabled = 0;
+        } else if (command == CMD_WRITE_ENABLE && !busy()) {
+            writeEnabled = 1;
+        } else if (command == CMD_DEEP_POWER_DOWN && !busy()) {
+            poweredDown = 1;
+        } else if (command == CMD_RELEASE_POWER_DOWN) {
+            poweredDown = 0;
+        }
+    }
+    selected = select;
+}
+
+uint8_t flashModelExchange(uint8_t in)
+{
+    uint32_t n;
+    uint8_t out = 0xFF;
+
+    if (!selected) {
+        return out;
+    }
+    n = position++;
+    if (n == 0) {
+        command = in;
+        return out;
+    }
+    if (poweredDown || (busy() && command != CMD_READ_STATUS)) {
+        return out;
+    }
+    switch (command) {
+    case CMD_READ_STATUS:
+        out = (busy() ? STATUS_WIP : 0) | (writeEnabled ? STATUS_WEL : 0);
+        break;
+    case CMD_JEDEC_ID:
+        out = n <= 3 ? jedecId[n - 1] : 0xFF;
+        break;
+    case CMD_FAST_READ:
+    case CMD_PAGE_PROGRAM:
+    case CMD_SECTOR_ERASE:
+        if (n <= 3) {
+            address = (address << 8) | in;
+        } else if (command == CMD_FAST_READ && n >= 5) {
+            out = memory[(address + n - 5) % FLASH_SIZE];
+        } else if (command == CMD_PAGE_PROGRAM && writeEnabled) {
+            memory[((address & ~(PAGE_SIZE - 1)) + ((address + n - 4) & (PAGE_SIZE - 1))) % FLASH_SIZE] &= in;
+            programmed = 1;
+        }
+        break;
+    default:
+        break;
+    }
+    return out;
+}
+
+int flashModelLoad(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+
+    init();
+    if (!file) {
+        // A new image, erased
+        return 1;
+    }
+    if (fread(memory, 1, sizeof(memory), file) != sizeof(memory)) {
+        fprintf(stderr, "%s: not a %d byte flash image\n", path, FLASH_SIZE);
+        fclose(file);
+        return 0;
+    }
+    fclose(file);
+    return 1;
+}
+
+int flashModelSave(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+
+    init();
+    if (!file || fwrite(memory, 1, sizeof(memory), file) != sizeof(memory)) {
+        perror(path);
+        if (file) {
+            fclose(file);
+        }
+        return 0;
+    }
+    fclose(file);
+    return 1;
+}
+
+uint32_t flashModelPagesProgrammed(void)
+{
+    return pagesProgrammed;
+}
@@ -0,0 +1,13 @@
+/* Host simulator: NVIC, the radio interrupts are not modelled */
+#ifndef SIM_INTERRUPT_H
+#define SIM_INTERRUPT_H
+
+#include <inc/hw_ints.h>
+
+static inline void IntPendClear(uint32_t interrupt) { (void)interrupt; }
+static inline void IntEnable(uint32_t interrupt) { (void)interrupt; }
+static inline void IntDisable(uint32_t interrupt) { (void)interrupt; }
+static inline int IntMasterEnable(void) { return 0; }
+static inline int IntMasterDisable(void) { return 0; }
+
+#endif
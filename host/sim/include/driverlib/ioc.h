@@ -0,0 +1,41 @@
+/* Host simulator: CC26XX IO controller ids */
+#ifndef SIM_IOC_H
+#define SIM_IOC_H
+
+#define IOID_0  0
+#define IOID_1  1
+#define IOID_2  2
+#define IOID_3  3
+#define IOID_4  4
+#define IOID_5  5
+#define IOID_6  6
+#define IOID_7  7
+#define IOID_8  8
+#define IOID_9  9
+#define IOID_10 10
+#define IOID_11 11
+#define IOID_12 12
+#define IOID_13 13
+#define IOID_14 14
+#define IOID_15 15
+#define IOID_16 16
+#define IOID_17 17
+#define IOID_18 18
+#define IOID_19 19
+#define IOID_20 20
+#define IOID_21 21
+#define IOID_22 22
+#define IOID_23 23
+#define IOID_24 24
+#define IOID_25 25
+#define IOID_26 26
+#define IOID_27 27
+#define IOID_28 28
+#define IOID_29 29
+#define IOID_30 30
+#define IOID_31 31
+
+#define IOC_PORT_GPIO               0x00
+#define IOC_PORT_MCU_PORT_EVENT0    0x17
+
+#endif
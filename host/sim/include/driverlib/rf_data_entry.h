@@ -0,0 +1,12 @@
+/* Host simulator: radio data entries, only the types comm_lib.h names */
+#ifndef SIM_RF_DATA_ENTRY_H
+#define SIM_RF_DATA_ENTRY_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t *pCurrEntry;
+    uint8_t *pLastEntry;
+} dataQueue_t;
+
+#endif
@@ -0,0 +1,22 @@
+/* Host simulator: general purpose timers, only the buzzer PWM */
+#ifndef SIM_TIMER_H
+#define SIM_TIMER_H
+
+#include <stdint.h>
+
+#define GPT0_BASE               0x40010000
+#define TIMER_A                 0x00FF
+#define TIMER_B                 0xFF00
+#define TIMER_BOTH              0xFFFF
+#define TIMER_CFG_SPLIT_PAIR    0x04000000
+#define TIMER_CFG_A_PWM         0x0000000A
+
+void TimerConfigure(uint32_t base, uint32_t config);
+void TimerEnable(uint32_t base, uint32_t timer);
+void TimerDisable(uint32_t base, uint32_t timer);
+void TimerLoadSet(uint32_t base, uint32_t timer, uint32_t value);
+void TimerPrescaleSet(uint32_t base, uint32_t timer, uint32_t value);
+void TimerMatchSet(uint32_t base, uint32_t timer, uint32_t value);
+void TimerPrescaleMatchSet(uint32_t base, uint32_t timer, uint32_t value);
+
+#endif
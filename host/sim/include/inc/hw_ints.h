@@ -0,0 +1,10 @@
+/* Host simulator: CC26XX interrupt vector numbers */
+#ifndef SIM_HW_INTS_H
+#define SIM_HW_INTS_H
+
+#include <stdint.h>
+
+#define INT_RFC_CPE_1   25
+#define INT_RFC_CPE_0   26
+
+#endif
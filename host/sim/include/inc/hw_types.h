@@ -0,0 +1,9 @@
+/* Host simulator: register access is not available */
+#ifndef SIM_HW_TYPES_H
+#define SIM_HW_TYPES_H
+
+#include <stdint.h>
+
+#define __STATIC_INLINE static inline
+
+#endif
@@ -0,0 +1,41 @@
+/* Host simulator: ti.drivers.I2C, transfers go to the device models */
+#ifndef SIM_I2C_H
+#define SIM_I2C_H
+
+#include <xdc/std.h>
+
+typedef enum {
+    I2C_100kHz = 0,
+    I2C_400kHz = 1
+} I2C_BitRate;
+
+typedef enum {
+    I2C_MODE_BLOCKING = 0,
+    I2C_MODE_CALLBACK
+} I2C_TransferMode;
+
+typedef struct {
+    void *writeBuf;
+    size_t writeCount;
+    void *readBuf;
+    size_t readCount;
+    uint_least8_t slaveAddress;
+    void *arg;
+} I2C_Transaction;
+
+typedef struct {
+    I2C_TransferMode transferMode;
+    void *transferCallbackFxn;
+    I2C_BitRate bitRate;
+    uintptr_t custom;
+} I2C_Params;
+
+typedef struct SimI2C *I2C_Handle;
+
+void I2C_init(void);
+void I2C_Params_init(I2C_Params *params);
+I2C_Handle I2C_open(unsigned int index, I2C_Params *params);
+void I2C_close(I2C_Handle handle);
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction);
+
+#endif
@@ -0,0 +1,47 @@
+/* Host simulator: ti.drivers.PIN, the pins live in host/sim/drivers.c */
+#ifndef SIM_PIN_H
+#define SIM_PIN_H
+
+#include <xdc/std.h>
+
+typedef uint32_t PIN_Config;
+typedef uint8_t PIN_Id;
+
+#define PIN_ID(config)          ((config) & 0xFF)
+#define PIN_UNASSIGNED          0xFF
+#define PIN_TERMINATE           0xFE
+#define PIN_SUCCESS             0
+
+#define PIN_GPIO_OUTPUT_EN      (1 << 8)
+#define PIN_GPIO_LOW            (0 << 9)
+#define PIN_GPIO_HIGH           (1 << 9)
+#define PIN_INPUT_EN            (1 << 10)
+#define PIN_PULLUP              (1 << 11)
+#define PIN_PULLDOWN            (1 << 12)
+#define PIN_PUSHPULL            0
+#define PIN_OPENDRAIN           (1 << 13)
+#define PIN_DRVSTR_MIN          0
+#define PIN_DRVSTR_MED          (1 << 14)
+#define PIN_DRVSTR_MAX          (1 << 15)
+#define PIN_IRQ_DIS             0
+#define PIN_IRQ_NEGEDGE         (1 << 16)
+#define PIN_IRQ_POSEDGE         (1 << 17)
+#define PIN_IRQ_BOTHEDGES       (PIN_IRQ_NEGEDGE | PIN_IRQ_POSEDGE)
+
+typedef struct PIN_State_s *PIN_Handle;
+typedef void (*PIN_IntCb)(PIN_Handle handle, PIN_Id pinId);
+
+typedef struct PIN_State_s {
+    uint64_t pins;              // bit per PIN_Id
+    PIN_IntCb callback;
+} PIN_State;
+
+int PIN_init(const PIN_Config config[]);
+PIN_Handle PIN_open(PIN_State *state, const PIN_Config config[]);
+void PIN_close(PIN_Handle handle);
+int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callback);
+int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, uint32_t value);
+uint32_t PIN_getInputValue(PIN_Id pinId);
+uint32_t PIN_getOutputValue(PIN_Id pinId);
+
+#endif
@@ -0,0 +1,14 @@
+/* Host simulator: ti.drivers.Power, a shutdown ends the run */
+#ifndef SIM_POWER_H
+#define SIM_POWER_H
+
+#include <xdc/std.h>
+
+int Power_init(void);
+int Power_setDependency(unsigned int resourceId);
+int Power_releaseDependency(unsigned int resourceId);
+int Power_setConstraint(unsigned int constraintId);
+int Power_releaseConstraint(unsigned int constraintId);
+int Power_shutdown(unsigned int shutdownState, uint32_t shutdownTime);
+
+#endif
@@ -0,0 +1,36 @@
+/* Host simulator: ti.drivers.SPI, the bus has the external flash model */
+#ifndef SIM_SPI_H
+#define SIM_SPI_H
+
+#include <xdc/std.h>
+
+typedef enum { SPI_MASTER = 0, SPI_SLAVE } SPI_Mode;
+typedef enum { SPI_POL0_PHA0 = 0, SPI_POL0_PHA1, SPI_POL1_PHA0, SPI_POL1_PHA1 } SPI_FrameFormat;
+typedef enum { SPI_MODE_BLOCKING = 0, SPI_MODE_CALLBACK } SPI_TransferMode;
+
+typedef struct {
+    size_t count;
+    void *txBuf;
+    void *rxBuf;
+    void *arg;
+} SPI_Transaction;
+
+typedef struct {
+    SPI_TransferMode transferMode;
+    uint32_t transferTimeout;
+    void *transferCallbackFxn;
+    SPI_Mode mode;
+    uint32_t bitRate;
+    uint32_t dataSize;
+    SPI_FrameFormat frameFormat;
+} SPI_Params;
+
+typedef struct SimSpi *SPI_Handle;
+
+void SPI_init(void);
+void SPI_Params_init(SPI_Params *params);
+SPI_Handle SPI_open(unsigned int index, SPI_Params *params);
+void SPI_close(SPI_Handle handle);
+bool SPI_transfer(SPI_Handle handle, SPI_Transaction *transaction);
+
+#endif
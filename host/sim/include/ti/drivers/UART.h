@@ -0,0 +1,42 @@
+/* Host simulator: ti.drivers.UART, see sim.h for where the bytes go */
+#ifndef SIM_UART_H
+#define SIM_UART_H
+
+#include <xdc/std.h>
+
+typedef struct SimUart *UART_Handle;
+typedef void (*UART_Callback)(UART_Handle handle, void *buf, size_t count);
+
+typedef enum { UART_MODE_BLOCKING = 0, UART_MODE_CALLBACK } UART_Mode;
+typedef enum { UART_RETURN_FULL = 0, UART_RETURN_NEWLINE } UART_ReturnMode;
+typedef enum { UART_DATA_BINARY = 0, UART_DATA_TEXT } UART_DataMode;
+typedef enum { UART_ECHO_OFF = 0, UART_ECHO_ON } UART_Echo;
+typedef enum { UART_LEN_5 = 0, UART_LEN_6, UART_LEN_7, UART_LEN_8 } UART_LEN;
+typedef enum { UART_STOP_ONE = 0, UART_STOP_TWO } UART_STOP;
+typedef enum { UART_PAR_NONE = 0, UART_PAR_EVEN, UART_PAR_ODD } UART_PAR;
+
+typedef struct {
+    UART_Mode readMode;
+    UART_Mode writeMode;
+    uint32_t readTimeout;
+    uint32_t writeTimeout;
+    UART_Callback readCallback;
+    UART_Callback writeCallback;
+    UART_ReturnMode readReturnMode;
+    UART_DataMode readDataMode;
+    UART_DataMode writeDataMode;
+    UART_Echo readEcho;
+    uint32_t baudRate;
+    UART_LEN dataLength;
+    UART_STOP stopBits;
+    UART_PAR parityType;
+} UART_Params;
+
+void UART_init(void);
+void UART_Params_init(UART_Params *params);
+UART_Handle UART_open(unsigned int index, UART_Params *params);
+void UART_close(UART_Handle handle);
+int UART_write(UART_Handle handle, const void *buffer, size_t size);
+int UART_read(UART_Handle handle, void *buffer, size_t size);
+
+#endif
@@ -0,0 +1,13 @@
+/* Host simulator: CC26XX I2C pin configuration */
+#ifndef SIM_I2CCC26XX_H
+#define SIM_I2CCC26XX_H
+
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/PIN.h>
+
+typedef struct {
+    uint8_t pinSDA;
+    uint8_t pinSCL;
+} I2CCC26XX_I2CPinCfg;
+
+#endif
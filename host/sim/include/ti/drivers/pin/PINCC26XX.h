@@ -0,0 +1,13 @@
+/* Host simulator: CC26XX pin extensions */
+#ifndef SIM_PINCC26XX_H
+#define SIM_PINCC26XX_H
+
+#include <ti/drivers/PIN.h>
+
+#define PINCC26XX_WAKEUP_POSEDGE    (1 << 18)
+#define PINCC26XX_WAKEUP_NEGEDGE    (1 << 19)
+
+int PINCC26XX_setMux(PIN_Handle handle, PIN_Id pinId, int32_t mux);
+int PINCC26XX_setWakeup(const PIN_Config config[]);
+
+#endif
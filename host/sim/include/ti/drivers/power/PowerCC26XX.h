@@ -0,0 +1,10 @@
+/* Host simulator: CC26XX power resources */
+#ifndef SIM_POWERCC26XX_H
+#define SIM_POWERCC26XX_H
+
+#include <ti/drivers/Power.h>
+
+#define PowerCC26XX_PERIPH_GPT0     0
+#define PowerCC26XX_SB_DISALLOW     0
+
+#endif
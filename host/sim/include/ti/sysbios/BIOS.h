@@ -0,0 +1,13 @@
+/* Host simulator: the kernel runs on virtual time, see host/sim/kernel.c */
+#ifndef SIM_BIOS_H
+#define SIM_BIOS_H
+
+#include <xdc/std.h>
+#include <xdc/runtime/Error.h>
+
+#define BIOS_WAIT_FOREVER   (~(UInt32)0)
+#define BIOS_NO_WAIT        0
+
+void BIOS_start(void);
+
+#endif
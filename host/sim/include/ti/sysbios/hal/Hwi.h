@@ -0,0 +1,19 @@
+/* Host simulator: ti.sysbios.hal.Hwi, interrupts run between tasks */
+#ifndef SIM_HWI_H
+#define SIM_HWI_H
+
+#include <xdc/std.h>
+
+typedef struct SimHwi *Hwi_Handle;
+
+typedef struct {
+    size_t hwiStackPeak;
+    size_t hwiStackSize;
+    Ptr hwiStackBase;
+} Hwi_StackInfo;
+
+UInt Hwi_disable(void);
+void Hwi_restore(UInt key);
+Bool Hwi_getStackInfo(Hwi_StackInfo *info, Bool computeStackDepth);
+
+#endif
@@ -0,0 +1,46 @@
+/* Host simulator: ti.sysbios.knl.Clock on the virtual clock */
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <xdc/std.h>
+#include <xdc/runtime/Error.h>
+
+// As in empty.cfg
+#define Clock_tickPeriod ((UInt32)10)
+
+typedef void (*Clock_FuncPtr)(UArg arg);
+
+typedef struct {
+    UInt32 period;
+    Bool startFlag;
+    UArg arg;
+} Clock_Params;
+
+typedef struct Clock_Struct {
+    Clock_FuncPtr fxn;
+    UInt32 timeout;
+    UInt32 period;
+    UArg arg;
+    Bool active;
+    uint64_t due;
+    struct Clock_Struct *next;
+} Clock_Struct;
+
+typedef Clock_Struct *Clock_Handle;
+
+void Clock_Params_init(Clock_Params *params);
+Clock_Handle Clock_create(Clock_FuncPtr fxn, UInt32 timeout, const Clock_Params *params, Error_Block *eb);
+void Clock_construct(Clock_Struct *clock, Clock_FuncPtr fxn, UInt32 timeout, const Clock_Params *params);
+UInt32 Clock_getTicks(void);
+void Clock_start(Clock_Handle clock);
+void Clock_stop(Clock_Handle clock);
+void Clock_setTimeout(Clock_Handle clock, UInt32 timeout);
+void Clock_setPeriod(Clock_Handle clock, UInt32 period);
+Bool Clock_isActive(Clock_Handle clock);
+
+static inline Clock_Handle Clock_handle(Clock_Struct *clock)
+{
+    return clock;
+}
+
+#endif
@@ -0,0 +1,40 @@
+/* Host simulator: ti.sysbios.knl.Mailbox, a ring of fixed size messages */
+#ifndef SIM_MAILBOX_H
+#define SIM_MAILBOX_H
+
+#include <xdc/std.h>
+#include <xdc/runtime/Error.h>
+
+// Per message overhead in the buffer, as on the target
+typedef struct {
+    Ptr next;
+    Ptr prev;
+} Mailbox_MbxElem;
+
+typedef struct {
+    Ptr buf;
+    UInt bufSize;
+} Mailbox_Params;
+
+typedef struct {
+    uint8_t *data;
+    size_t msgSize;
+    UInt numMsgs;
+    UInt head;
+    UInt count;
+} Mailbox_Struct;
+
+typedef Mailbox_Struct *Mailbox_Handle;
+
+void Mailbox_Params_init(Mailbox_Params *params);
+void Mailbox_construct(Mailbox_Struct *mbx, size_t msgSize, UInt numMsgs, const Mailbox_Params *params, Error_Block *eb);
+Bool Mailbox_pend(Mailbox_Handle mbx, Ptr msg, UInt32 timeout);
+Bool Mailbox_post(Mailbox_Handle mbx, Ptr msg, UInt32 timeout);
+Int Mailbox_getNumPendingMsgs(Mailbox_Handle mbx);
+
+static inline Mailbox_Handle Mailbox_handle(Mailbox_Struct *mbx)
+{
+    return mbx;
+}
+
+#endif
@@ -0,0 +1,36 @@
+/* Host simulator: ti.sysbios.knl.Semaphore */
+#ifndef SIM_SEMAPHORE_H
+#define SIM_SEMAPHORE_H
+
+#include <xdc/std.h>
+#include <xdc/runtime/Error.h>
+
+typedef enum {
+    Semaphore_Mode_COUNTING = 0,
+    Semaphore_Mode_BINARY = 1
+} Semaphore_Mode;
+
+typedef struct {
+    Semaphore_Mode mode;
+} Semaphore_Params;
+
+typedef struct {
+    Int count;
+    Semaphore_Mode mode;
+} Semaphore_Struct;
+
+typedef Semaphore_Struct *Semaphore_Handle;
+
+void Semaphore_Params_init(Semaphore_Params *params);
+void Semaphore_construct(Semaphore_Struct *sem, Int count, const Semaphore_Params *params);
+Semaphore_Handle Semaphore_create(Int count, const Semaphore_Params *params, Error_Block *eb);
+Bool Semaphore_pend(Semaphore_Handle sem, UInt32 timeout);
+void Semaphore_post(Semaphore_Handle sem);
+Int Semaphore_getCount(Semaphore_Handle sem);
+
+static inline Semaphore_Handle Semaphore_handle(Semaphore_Struct *sem)
+{
+    return sem;
+}
+
+#endif
@@ -0,0 +1,41 @@
+/* Host simulator: ti.sysbios.knl.Swi, run to completion before any task */
+#ifndef SIM_SWI_H
+#define SIM_SWI_H
+
+#include <xdc/std.h>
+#include <xdc/runtime/Error.h>
+
+typedef void (*Swi_FuncPtr)(UArg arg0, UArg arg1);
+
+typedef struct {
+    UArg arg0;
+    UArg arg1;
+    UInt priority;
+    UInt trigger;
+} Swi_Params;
+
+typedef struct {
+    Swi_FuncPtr fxn;
+    UArg arg0;
+    UArg arg1;
+    UInt initTrigger;
+    UInt trigger;
+    Bool posted;
+} Swi_Struct;
+
+typedef Swi_Struct *Swi_Handle;
+
+void Swi_Params_init(Swi_Params *params);
+void Swi_construct(Swi_Struct *swi, Swi_FuncPtr fxn, const Swi_Params *params, Error_Block *eb);
+void Swi_post(Swi_Handle swi);
+void Swi_or(Swi_Handle swi, UInt mask);
+UInt Swi_getTrigger(void);
+UInt Swi_disable(void);
+void Swi_restore(UInt key);
+
+static inline Swi_Handle Swi_handle(Swi_Struct *swi)
+{
+    return swi;
+}
+
+#endif
@@ -0,0 +1,33 @@
+/* Host simulator: ti.sysbios.knl.Task, cooperative tasks on virtual time */
+#ifndef SIM_TASK_H
+#define SIM_TASK_H
+
+#include <xdc/std.h>
+#include <xdc/runtime/Error.h>
+
+typedef void (*Task_FuncPtr)(UArg arg0, UArg arg1);
+
+typedef struct {
+    size_t stackSize;
+    Ptr stack;
+    Int priority;
+    UArg arg0;
+    UArg arg1;
+} Task_Params;
+
+typedef struct {
+    Int priority;
+    size_t stackSize;
+    size_t used;
+} Task_Stat;
+
+typedef struct SimTask *Task_Handle;
+
+void Task_Params_init(Task_Params *params);
+Task_Handle Task_create(Task_FuncPtr fxn, const Task_Params *params, Error_Block *eb);
+void Task_sleep(UInt32 ticks);
+void Task_yield(void);
+Task_Handle Task_self(void);
+void Task_stat(Task_Handle task, Task_Stat *stat);
+
+#endif
@@ -0,0 +1,9 @@
+/* Host simulator: xdc.runtime.Error, errors always abort */
+#ifndef SIM_ERROR_H
+#define SIM_ERROR_H
+
+typedef struct {
+    int unused;
+} Error_Block;
+
+#endif
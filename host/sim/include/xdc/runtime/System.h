@@ -0,0 +1,11 @@
+/* Host simulator: xdc.runtime.System */
+#ifndef SIM_SYSTEM_H
+#define SIM_SYSTEM_H
+
+#include <xdc/std.h>
+
+void System_abort(const char *message);
+int System_printf(const char *format, ...);
+void System_flush(void);
+
+#endif
@@ -0,0 +1,26 @@
+/* Host simulator: XDC base types, see host/sim/sim.h */
+#ifndef SIM_XDC_STD_H
+#define SIM_XDC_STD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef void Void;
+typedef char Char;
+typedef int Int;
+typedef unsigned int UInt;
+typedef uint8_t UInt8;
+typedef uint16_t UInt16;
+typedef uint32_t UInt32;
+typedef int32_t Int32;
+typedef bool Bool;
+typedef void *Ptr;
+typedef char *String;
+typedef uintptr_t UArg;
+typedef void (*Fxn)(void);
+
+#define TRUE 1
+#define FALSE 0
+
+#endif
@@ -0,0 +1,690 @@
+/* Host simulator: the TI-RTOS kernel on virtual time.
+ *
+ * Tasks are ucontext coroutines on host sized stacks. The highest priority
+ * ready task runs until it blocks (a sleep, a pend, a bus transfer), tasks
+ * of equal priority in the order they became ready. Waking a task of a
+ * higher priority switches to it at once, as the real kernel would, but
+ * only at a kernel call: nothing preempts a task that computes.
+ *
+ * Clock functions, model callbacks and the scenario run in the scheduler
+ * between the tasks, like interrupts. Swis run to completion when posted,
+ * or when Swi_restore() releases them. Hwi_disable() has nothing to do.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ucontext.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Mailbox.h>
+#include <ti/sysbios/knl/Swi.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+#include "sim.h"
+
+// Host code needs far more stack than the target, Task_stat reports the target size
+#define TASK_STACK_SIZE     (256 * 1024)
+#define SWI_QUEUE_LENGTH    16
+// The DWT counter runs at 48 MHz
+#define CYCLES_PER_TICK     480
+
+typedef enum {
+    TASK_READY,
+    TASK_WAITING,
+    TASK_DONE
+} TaskState;
+
+struct SimTask {
+    ucontext_t context;
+    Task_FuncPtr fxn;
+    UArg arg0;
+    UArg arg1;
+    Int priority;
+    size_t stackSize;
+    TaskState state;
+    uint64_t order;         // FIFO among equal priorities
+    const void *object;     // waited for, NULL for a sleep
+    uint64_t wake;          // timeout
+    int woken;
+    struct SimTask *next;
+};
+
+typedef struct {
+    uint64_t tick;
+    uint64_t order;
+    SimFxn fxn;
+    void *arg;
+} Scheduled;
+
+uint64_t simNow = 0;
+uint64_t simEnd = SIM_FOREVER;
+int simVerbose = 0;
+
+// The cycle counter of cycles.h
+volatile uint32_t simDemcr = 0;
+volatile uint32_t simDwtCtrl = 0;
+volatile uint32_t simDwtCyccnt = 0;
+
+static struct SimTask *tasks = NULL;
+static struct SimTask *current = NULL;
+static ucontext_t schedulerContext;
+static uint64_t order = 0;
+
+static Clock_Struct *clocks = NULL;
+
+static Scheduled *heap = NULL;
+static size_t heapCount = 0;
+static size_t heapSize = 0;
+
+static Swi_Struct *swiQueue[SWI_QUEUE_LENGTH];
+static int swiHead = 0;
+static int swiCount = 0;
+static Swi_Struct *runningSwi = NULL;
+static UInt runningTrigger = 0;
+static UInt swiLocked = 0;
+
+static int stopped = 0;
+static const char *stopReason = "end of the scenario";
+
+/* ---- Scheduled callbacks, a binary heap on (tick, order) ---- */
+
+static int before(const Scheduled *a, const Scheduled *b)
+{
+    return a->tick < b->tick || (a->tick == b->tick && a->order < b->order);
+}
+
+void simSchedule(uint64_t tick, SimFxn fxn, void *arg)
+{
+    Scheduled item = {tick < simNow ? simNow : tick, order++, fxn, arg};
+    size_t i;
+
+    if (heapCount == heapSize) {
+        heapSize = heapSize ? 2 * heapSize : 64;
+        heap = realloc(heap, heapSize * sizeof(*heap));
+    }
+    for (i = heapCount++; i > 0 && before(&item, &heap[(i - 1) / 2]); i = (i - 1) / 2) {
+        heap[i] = heap[(i - 1) / 2];
+    }
+    heap[i] = item;
+}
+
+static Scheduled heapPop(void)
+{
+    Scheduled top = heap[0];
+    Scheduled last = heap[--heapCount];
+    size_t i = 0;
+    size_t child;
+
+    while ((child = 2 * i + 1) < heapCount) {
+        if (child + 1 < heapCount && before(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if (!before(&heap[child], &last)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+/* ---- Tasks ---- */
+
+static struct SimTask *pickReady(void)
+{
+    struct SimTask *best = NULL;
+    struct SimTask *t;
+
+    for (t = tasks; t; t = t->next) {
+        if (t->state == TASK_READY &&
+            (!best || t->priority > best->priority || (t->priority == best->priority && t->order < best->order))) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+// A task woken by the running one may have to run first
+static void preemptCheck(void)
+{
+    struct SimTask *next;
+
+    if (!current || runningSwi) {
+        return;
+    }
+    next = pickReady();
+    if (next && next->priority > current->priority) {
+        swapcontext(&current->context, &schedulerContext);
+    }
+}
+
+static void taskEntry(void)
+{
+    current->fxn(current->arg0, current->arg1);
+    current->state = TASK_DONE;
+    swapcontext(&current->context, &schedulerContext);
+}
+
+int simInTask(void)
+{
+    return current != NULL && !runningSwi;
+}
+
+int simWait(const void *object, uint64_t ticks)
+{
+    if (ticks == 0) {
+        return 0;
+    }
+    if (!simInTask()) {
+        System_abort("sim: a blocking call outside of a task");
+    }
+    current->state = TASK_WAITING;
+    current->object = object;
+    current->wake = ticks == SIM_FOREVER ? SIM_FOREVER : simNow + ticks;
+    current->woken = 0;
+    current->order = order++;
+    swapcontext(&current->context, &schedulerContext);
+    return current->woken;
+}
+
+int simWake(const void *object)
+{
+    struct SimTask *best = NULL;
+    struct SimTask *t;
+
+    for (t = tasks; t; t = t->next) {
+        if (t->state == TASK_WAITING && t->object == object && object &&
+            (!best || t->priority > best->priority || (t->priority == best->priority && t->order < best->order))) {
+            best = t;
+        }
+    }
+    if (!best) {
+        return 0;
+    }
+    best->state = TASK_READY;
+    best->woken = 1;
+    best->order = order++;
+    preemptCheck();
+    return 1;
+}
+
+void simBusy(uint64_t ticks)
+{
+    if (simInTask()) {
+        simWait(NULL, ticks);
+    }
+}
+
+static uint64_t timeout(UInt32 ticks)
+{
+    return ticks == BIOS_WAIT_FOREVER ? SIM_FOREVER : ticks;
+}
+
+void Task_Params_init(Task_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+    params->stackSize = 1024;
+    params->priority = 1;
+}
+
+Task_Handle Task_create(Task_FuncPtr fxn, const Task_Params *params, Error_Block *eb)
+{
+    struct SimTask *task = calloc(1, sizeof(*task));
+    struct SimTask **last;
+
+    task->fxn = fxn;
+    task->arg0 = params->arg0;
+    task->arg1 = params->arg1;
+    task->priority = params->priority;
+    task->stackSize = params->stackSize;
+    task->state = TASK_READY;
+    task->order = order++;
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = malloc(TASK_STACK_SIZE);
+    task->context.uc_stack.ss_size = TASK_STACK_SIZE;
+    task->context.uc_link = NULL;
+    makecontext(&task->context, taskEntry, 0);
+
+    for (last = &tasks; *last; last = &(*last)->next) {
+    }
+    *last = task;
+    return task;
+}
+
+void Task_sleep(UInt32 ticks)
+{
+    simWait(NULL, ticks);
+}
+
+void Task_yield(void)
+{
+    if (simInTask()) {
+        current->order = order++;
+        swapcontext(&current->context, &schedulerContext);
+    }
+}
+
+Task_Handle Task_self(void)
+{
+    return current;
+}
+
+// Host stacks say nothing of the target, the usage is not measured
+void Task_stat(Task_Handle task, Task_Stat *stat)
+{
+    stat->priority = task->priority;
+    stat->stackSize = task->stackSize;
+    stat->used = 0;
+}
+
+/* ---- Swis ---- */
+
+static void swiDispatch(void)
+{
+    Swi_Struct *swi;
+
+    if (swiLocked || runningSwi) {
+        return;
+    }
+    while (swiCount) {
+        swi = swiQueue[swiHead];
+        swiHead = (swiHead + 1) % SWI_QUEUE_LENGTH;
+        swiCount--;
+        runningSwi = swi;
+        runningTrigger = swi->trigger;
+        swi->trigger = swi->initTrigger;
+        swi->posted = FALSE;
+        swi->fxn(swi->arg0, swi->arg1);
+        runningSwi = NULL;
+    }
+    preemptCheck();
+}
+
+static void swiPost(Swi_Struct *swi)
+{
+    if (!swi->posted) {
+        if (swiCount == SWI_QUEUE_LENGTH) {
+            System_abort("sim: too many Swis posted");
+        }
+        swi->posted = TRUE;
+        swiQueue[(swiHead + swiCount++) % SWI_QUEUE_LENGTH] = swi;
+    }
+    swiDispatch();
+}
+
+void Swi_Params_init(Swi_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+}
+
+void Swi_construct(Swi_Struct *swi, Swi_FuncPtr fxn, const Swi_Params *params, Error_Block *eb)
+{
+    swi->fxn = fxn;
+    swi->arg0 = params->arg0;
+    swi->arg1 = params->arg1;
+    swi->initTrigger = params->trigger;
+    swi->trigger = params->trigger;
+    swi->posted = FALSE;
+}
+
+void Swi_post(Swi_Handle swi)
+{
+    swiPost(swi);
+}
+
+void Swi_or(Swi_Handle swi, UInt mask)
+{
+    swi->trigger |= mask;
+    swiPost(swi);
+}
+
+UInt Swi_getTrigger(void)
+{
+    return runningTrigger;
+}
+
+UInt Swi_disable(void)
+{
+    UInt key = swiLocked;
+
+    swiLocked = 1;
+    return key;
+}
+
+void Swi_restore(UInt key)
+{
+    swiLocked = key;
+    swiDispatch();
+}
+
+/* ---- Hwis, nothing interrupts the code ---- */
+
+UInt Hwi_disable(void)
+{
+    return 0;
+}
+
+void Hwi_restore(UInt key)
+{
+}
+
+Bool Hwi_getStackInfo(Hwi_StackInfo *info, Bool computeStackDepth)
+{
+    info->hwiStackPeak = 0;
+    info->hwiStackSize = 768;
+    info->hwiStackBase = NULL;
+    return FALSE;
+}
+
+/* ---- Clocks ---- */
+
+void Clock_Params_init(Clock_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+}
+
+void Clock_construct(Clock_Struct *clock, Clock_FuncPtr fxn, UInt32 timeout, const Clock_Params *params)
+{
+    memset(clock, 0, sizeof(*clock));
+    clock->fxn = fxn;
+    clock->timeout = timeout;
+    clock->period = params ? params->period : 0;
+    clock->arg = params ? params->arg : 0;
+    clock->next = clocks;
+    clocks = clock;
+    if (params && params->startFlag) {
+        Clock_start(clock);
+    }
+}
+
+Clock_Handle Clock_create(Clock_FuncPtr fxn, UInt32 timeout, const Clock_Params *params, Error_Block *eb)
+{
+    Clock_Struct *clock = malloc(sizeof(*clock));
+
+    Clock_construct(clock, fxn, timeout, params);
+    return clock;
+}
+
+UInt32 Clock_getTicks(void)
+{
+    return (UInt32)simNow;
+}
+
+void Clock_start(Clock_Handle clock)
+{
+    if (clock->timeout == 0) {
+        System_abort("sim: Clock_start with a zero timeout");
+    }
+    clock->due = simNow + clock->timeout;
+    clock->active = TRUE;
+}
+
+void Clock_stop(Clock_Handle clock)
+{
+    clock->active = FALSE;
+}
+
+void Clock_setTimeout(Clock_Handle clock, UInt32 timeout)
+{
+    clock->timeout = timeout;
+}
+
+void Clock_setPeriod(Clock_Handle clock, UInt32 period)
+{
+    clock->period = period;
+}
+
+Bool Clock_isActive(Clock_Handle clock)
+{
+    return clock->active;
+}
+
+/* ---- Semaphores ---- */
+
+void Semaphore_Params_init(Semaphore_Params *params)
+{
+    params->mode = Semaphore_Mode_COUNTING;
+}
+
+void Semaphore_construct(Semaphore_Struct *sem, Int count, const Semaphore_Params *params)
+{
+    sem->count = count;
+    sem->mode = params ? params->mode : Semaphore_Mode_COUNTING;
+}
+
+Semaphore_Handle Semaphore_create(Int count, const Semaphore_Params *params, Error_Block *eb)
+{
+    Semaphore_Struct *sem = malloc(sizeof(*sem));
+
+    Semaphore_construct(sem, count, params);
+    return sem;
+}
+
+Bool Semaphore_pend(Semaphore_Handle sem, UInt32 ticks)
+{
+    if (sem->count > 0) {
+        sem->count--;
+        return TRUE;
+    }
+    // A post hands the count straight to the woken task
+    return simWait(sem, timeout(ticks));
+}
+
+void Semaphore_post(Semaphore_Handle sem)
+{
+    if (!simWake(sem)) {
+        sem->count = sem->mode == Semaphore_Mode_BINARY ? 1 : sem->count + 1;
+    }
+}
+
+Int Semaphore_getCount(Semaphore_Handle sem)
+{
+    return sem->count;
+}
+
+/* ---- Mailboxes, readers wait on the mailbox and writers on the byte after it ---- */
+
+void Mailbox_Params_init(Mailbox_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+}
+
+void Mailbox_construct(Mailbox_Struct *mbx, size_t msgSize, UInt numMsgs, const Mailbox_Params *params, Error_Block *eb)
+{
+    mbx->data = malloc(msgSize * numMsgs);
+    mbx->msgSize = msgSize;
+    mbx->numMsgs = numMsgs;
+    mbx->head = 0;
+    mbx->count = 0;
+}
+
+static int mailboxWait(const void *object, uint64_t deadline)
+{
+    if (deadline != SIM_FOREVER && deadline <= simNow) {
+        return 0;
+    }
+    return simWait(object, deadline == SIM_FOREVER ? SIM_FOREVER : deadline - simNow);
+}
+
+Bool Mailbox_pend(Mailbox_Handle mbx, Ptr msg, UInt32 ticks)
+{
+    uint64_t deadline = ticks == BIOS_WAIT_FOREVER ? SIM_FOREVER : simNow + ticks;
+
+    while (mbx->count == 0) {
+        if (!mailboxWait(mbx, deadline)) {
+            return FALSE;
+        }
+    }
+    memcpy(msg, mbx->data + mbx->head * mbx->msgSize, mbx->msgSize);
+    mbx->head = (mbx->head + 1) % mbx->numMsgs;
+    mbx->count--;
+    simWake((uint8_t *)mbx + 1);
+    return TRUE;
+}
+
+Bool Mailbox_post(Mailbox_Handle mbx, Ptr msg, UInt32 ticks)
+{
+    uint64_t deadline = ticks == BIOS_WAIT_FOREVER ? SIM_FOREVER : simNow + ticks;
+
+    while (mbx->count == mbx->numMsgs) {
+        if (!mailboxWait((uint8_t *)mbx + 1, deadline)) {
+            return FALSE;
+        }
+    }
+    memcpy(mbx->data + (mbx->head + mbx->count) % mbx->numMsgs * mbx->msgSize, msg, mbx->msgSize);
+    mbx->count++;
+    simWake(mbx);
+    return TRUE;
+}
+
+Int Mailbox_getNumPendingMsgs(Mailbox_Handle mbx)
+{
+    return mbx->count;
+}
+
+/* ---- System ---- */
+
+void System_abort(const char *message)
+{
+    fflush(stdout);
+    fprintf(stderr, "%10.5f abort: %s\n", (double)simNow / SIM_TICKS_PER_SECOND, message);
+    exit(2);
+}
+
+int System_printf(const char *format, ...)
+{
+    va_list args;
+    int length;
+
+    if (!simVerbose) {
+        return 0;
+    }
+    printf("%10.5f printf ", (double)simNow / SIM_TICKS_PER_SECOND);
+    va_start(args, format);
+    length = vprintf(format, args);
+    va_end(args);
+    return length;
+}
+
+void System_flush(void)
+{
+    fflush(stdout);
+}
+
+void simTrace(const char *source, const char *format, ...)
+{
+    va_list args;
+
+    printf("%10.5f %-7s ", (double)simNow / SIM_TICKS_PER_SECOND, source);
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    putchar('\n');
+}
+
+/* ---- The scheduler ---- */
+
+void simStop(const char *reason)
+{
+    stopped = 1;
+    stopReason = reason;
+}
+
+const char *simStopReason(void)
+{
+    return stopReason;
+}
+
+static uint64_t nextTick(void)
+{
+    uint64_t next = heapCount ? heap[0].tick : SIM_FOREVER;
+    Clock_Struct *clock;
+    struct SimTask *t;
+
+    for (clock = clocks; clock; clock = clock->next) {
+        if (clock->active && clock->due < next) {
+            next = clock->due;
+        }
+    }
+    for (t = tasks; t; t = t->next) {
+        if (t->state == TASK_WAITING && t->wake < next) {
+            next = t->wake;
+        }
+    }
+    return next;
+}
+
+static void advance(uint64_t tick)
+{
+    if (simDwtCtrl & 1) {
+        simDwtCyccnt += (uint32_t)((tick - simNow) * CYCLES_PER_TICK);
+    }
+    simNow = tick;
+}
+
+// Interrupts first, then the Clock Swi, then the timeouts of the tasks
+static void runDue(void)
+{
+    Scheduled item;
+    Clock_Struct *clock;
+    struct SimTask *t;
+    int fired;
+
+    while (heapCount && heap[0].tick <= simNow && !stopped) {
+        item = heapPop();
+        item.fxn(item.arg);
+    }
+    do {
+        fired = 0;
+        for (clock = clocks; clock; clock = clock->next) {
+            if (clock->active && clock->due <= simNow) {
+                if (clock->period) {
+                    clock->due += clock->period;
+                } else {
+                    clock->active = FALSE;
+                }
+                clock->fxn(clock->arg);
+                fired = 1;
+            }
+        }
+    } while (fired);
+    for (t = tasks; t; t = t->next) {
+        if (t->state == TASK_WAITING && t->wake <= simNow) {
+            t->state = TASK_READY;
+            t->woken = 0;
+            t->order = order++;
+        }
+    }
+}
+
+void BIOS_start(void)
+{
+    struct SimTask *task;
+    uint64_t next;
+
+    runDue();
+    while (!stopped) {
+        task = pickReady();
+        if (task) {
+            current = task;
+            swapcontext(&schedulerContext, &task->context);
+            current = NULL;
+            continue;
+        }
+        next = nextTick();
+        if (next > simEnd) {
+            advance(simEnd);
+            break;
+        }
+        advance(next);
+        runDue();
+    }
+}
@@ -0,0 +1,392 @@
+/* Host simulator: the MPU9250 accelerometer and gyroscope on I2C.
+ *
+ * A register file with auto-incrementing reads and writes, the registers
+ * that sensors/mpu9250.c uses behave as on the chip:
+ *
+ * - Sampling: a sample is taken every 1 / (1 kHz / (1 + SMPLRT_DIV)) with
+ *   DLPF_CFG 1 to 6, at 8 kHz with 0 or 7 and at 32 kHz with FCHOICE_B set,
+ *   while the chip is awake (PWR_MGMT_1 SLEEP clear). The data registers
+ *   hold the latest sample, not the motion at the time of the read.
+ * - The motion comes from the scenario, a formula or a recorded trace, at
+ *   the full scales of ACCEL_CONFIG and GYRO_CONFIG. The unit below adds
+ *   its zero rate and zero g offsets and noise; the gyro offset registers
+ *   and changes to the factory accel trims are applied.
+ * - FIFO: 512 bytes, each sample adds the data FIFO_EN selects in register
+ *   order (accel, temperature, gyro x y z). When full the oldest bytes are
+ *   dropped, or with CONFIG FIFO_MODE the new sample. Reading FIFO_R_W
+ *   empty gives the last byte again.
+ * - Self test: the XYZ_ST bits of ACCEL_CONFIG and GYRO_CONFIG add the
+ *   self-test response of the unit to the sample. The factory self-test
+ *   codes are in their registers, MPU9250SelfTest should report the
+ *   deviations of selfTestDeviation.
+ * - INT_STATUS: RAW_DATA_RDY and FIFO_OFLOW when enabled in INT_ENABLE,
+ *   cleared by reading INT_STATUS, or any register with INT_ANYRD_2CLEAR.
+ *
+ * The chip answers only while it is powered.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define REG_SELF_TEST_X_GYRO    0x00
+#define REG_SELF_TEST_X_ACCEL   0x0D
+#define REG_XG_OFFSET_H         0x13
+#define REG_SMPLRT_DIV          0x19
+#define REG_CONFIG              0x1A
+#define REG_GYRO_CONFIG         0x1B
+#define REG_ACCEL_CONFIG        0x1C
+#define REG_FIFO_EN             0x23
+#define REG_INT_PIN_CFG         0x37
+#define REG_INT_ENABLE          0x38
+#define REG_INT_STATUS          0x3A
+#define REG_ACCEL_XOUT_H        0x3B
+#define REG_GYRO_ZOUT_L         0x48
+#define REG_USER_CTRL           0x6A
+#define REG_PWR_MGMT_1          0x6B
+#define REG_FIFO_COUNTH         0x72
+#define REG_FIFO_COUNTL         0x73
+#define REG_FIFO_R_W            0x74
+#define REG_WHO_AM_I            0x75
+#define REG_XA_OFFSET_H         0x77
+#define REG_COUNT               0x80
+
+#define CONFIG_FIFO_MODE        0x40
+#define CONFIG_DLPF_CFG         0x07
+#define GYRO_CONFIG_FCHOICE_B   0x03
+#define FIFO_EN_TEMP            0x80
+#define FIFO_EN_GYRO            0x70
+#define FIFO_EN_GYRO_X          0x40
+#define FIFO_EN_ACCEL           0x08
+#define INT_PIN_CFG_ANYRD_2CLEAR 0x10
+#define INT_FIFO_OFLOW          0x10
+#define INT_RAW_RDY             0x01
+#define USER_CTRL_FIFO_EN       0x40
+#define USER_CTRL_FIFO_RST      0x04
+#define PWR_MGMT_1_RESET        0x80
+#define PWR_MGMT_1_SLEEP        0x40
+#define FIFO_SIZE               512
+#define WHO_AM_I_MPU9250        0x71
+
+// The sample clock counts in thousandths of a tick, 8 and 32 kHz are not whole ticks
+#define SUBTICKS                1000
+#define SUBTICKS_PER_SECOND     ((uint64_t)SIM_TICKS_PER_SECOND * SUBTICKS)
+
+#define ACCEL_LSB_PER_G         16384.0f
+#define GYRO_LSB_PER_DPS        131.0f
+#define TEMP_LSB_PER_C          333.87f
+#define TEMP_OFFSET_C           21.0f
+// The accel offset registers count 0.98 mg in bits 15:1
+#define ACCEL_OFFSET_G          0.00098f
+
+/* The unit. Its offsets are what accelgyrocalMPU9250 measures, noise as
+ * in the data sheet at the 41 Hz bandwidth of initMPU9250. */
+static const float gyroZeroRate[3] = {1.6f, -2.4f, 0.7f};          // deg/s
+static const float accelZeroG[3] = {0.012f, -0.020f, 0.035f};      // g
+#define GYRO_NOISE_DPS          0.08f                              // rms
+#define ACCEL_NOISE_G           0.0025f
+// Accel x y z, gyro x y z
+static const uint8_t selfTestCodes[6] = {0x66, 0x6A, 0x78, 0x5C, 0x61, 0x57};
+static const float selfTestDeviation[6] = {1.5f, -2.0f, 0.5f, 3.0f, -1.0f, 2.0f};   // %
+static const uint8_t accelTrim[6] = {0xE6, 0x2B, 0x1B, 0x5A, 0x26, 0x41};
+
+static uint8_t regs[REG_COUNT];
+static int powered = 0;
+static SimMpuStats stats;
+
+static uint64_t nextSample = 0;     // subticks
+static int16_t latest[7];           // accel, temperature, gyro
+static uint8_t intStatus = 0;
+static uint32_t noiseState = 1;
+
+static uint8_t fifo[FIFO_SIZE];
+static uint16_t fifoHead = 0;
+static uint16_t fifoCount = 0;
+static uint8_t fifoLast = 0;
+
+static int16_t clamp(float value)
+{
+    if (value > 32767.0f) {
+        return 32767;
+    }
+    if (value < -32768.0f) {
+        return -32768;
+    }
+    return (int16_t)lroundf(value);
+}
+
+// Close to normal with a deviation of 1, from 12 uniform numbers
+static float noise(void)
+{
+    float sum = 0;
+    int i;
+
+    for (i = 0; i < 12; i++) {
+        noiseState ^= noiseState << 13;
+        noiseState ^= noiseState >> 17;
+        noiseState ^= noiseState << 5;
+        sum += (float)noiseState / 4294967296.0f;
+    }
+    return sum - 6;
+}
+
+static int16_t reg16(uint8_t reg)
+{
+    return (int16_t)((regs[reg] << 8) | regs[reg + 1]);
+}
+
+// The factory trim of the self-test code, in LSB at 2 g and 250 deg/s
+static float factoryTrim(uint8_t code)
+{
+    return 2620.0f * powf(1.01f, (float)code - 1.0f);
+}
+
+static uint64_t samplePeriod(void)
+{
+    uint8_t dlpf = regs[REG_CONFIG] & CONFIG_DLPF_CFG;
+
+    if (regs[REG_GYRO_CONFIG] & GYRO_CONFIG_FCHOICE_B) {
+        return SUBTICKS_PER_SECOND / 32000;
+    }
+    if (dlpf == 0 || dlpf == 7) {
+        return SUBTICKS_PER_SECOND / 8000;
+    }
+    return SUBTICKS_PER_SECOND / 1000 * (1 + regs[REG_SMPLRT_DIV]);
+}
+
+static int awake(void)
+{
+    return !(regs[REG_PWR_MGMT_1] & PWR_MGMT_1_SLEEP);
+}
+
+static void reset(void)
+{
+    memset(regs, 0, sizeof(regs));
+    memcpy(&regs[REG_SELF_TEST_X_GYRO], &selfTestCodes[3], 3);
+    memcpy(&regs[REG_SELF_TEST_X_ACCEL], &selfTestCodes[0], 3);
+    memcpy(&regs[REG_XA_OFFSET_H], &accelTrim[0], 2);
+    memcpy(&regs[REG_XA_OFFSET_H + 3], &accelTrim[2], 2);
+    memcpy(&regs[REG_XA_OFFSET_H + 6], &accelTrim[4], 2);
+    regs[REG_PWR_MGMT_1] = 0x01;
+    regs[REG_WHO_AM_I] = WHO_AM_I_MPU9250;
+    memset(latest, 0, sizeof(latest));
+    intStatus = 0;
+    fifoHead = 0;
+    fifoCount = 0;
+    nextSample = simNow * SUBTICKS + samplePeriod();
+}
+
+// A sample of the motion at the subtick
+static void measure(uint64_t subtick, int16_t values[7])
+{
+    SimMotion motion;
+    int accelShift = (regs[REG_ACCEL_CONFIG] >> 3) & 3;
+    int gyroShift = (regs[REG_GYRO_CONFIG] >> 3) & 3;
+    float accel, gyro, trim;
+    int i;
+
+    simMotionAt(subtick / SUBTICKS, &motion);
+    for (i = 0; i < 3; i++) {
+        trim = (reg16(REG_XA_OFFSET_H + 3 * i) >> 1) - ((int16_t)((accelTrim[2 * i] << 8) | accelTrim[2 * i + 1]) >> 1);
+        accel = (motion.accel[i] + accelZeroG[i] + ACCEL_NOISE_G * noise() + trim * ACCEL_OFFSET_G) * ACCEL_LSB_PER_G;
+        if (regs[REG_ACCEL_CONFIG] & (0x80 >> i)) {
+            accel += factoryTrim(regs[REG_SELF_TEST_X_ACCEL + i]) * (1 + selfTestDeviation[i] / 100);
+        }
+        values[i] = clamp(accel / (1 << accelShift));
+
+        // The offsets are in 32.8 LSB per deg/s
+        gyro = (motion.gyro[i] + gyroZeroRate[i] + GYRO_NOISE_DPS * noise()) * GYRO_LSB_PER_DPS +
+               reg16(REG_XG_OFFSET_H + 2 * i) * 4;
+        if (regs[REG_GYRO_CONFIG] & (0x80 >> i)) {
+            gyro += factoryTrim(regs[REG_SELF_TEST_X_GYRO + i]) * (1 + selfTestDeviation[3 + i] / 100);
+        }
+        values[4 + i] = clamp(gyro / (1 << gyroShift));
+    }
+    values[3] = clamp((motion.temperature - TEMP_OFFSET_C) * TEMP_LSB_PER_C);
+}
+
+static int fifoRunning(void)
+{
+    return (regs[REG_USER_CTRL] & USER_CTRL_FIFO_EN) && (regs[REG_FIFO_EN] & (FIFO_EN_TEMP | FIFO_EN_GYRO | FIFO_EN_ACCEL));
+}
+
+static void fifoPush(const int16_t values[7])
+{
+    uint8_t bytes[14];
+    int count = 0;
+    int i;
+
+    // Register order: accel, temperature, gyro x y z
+    for (i = 0; i < 7; i++) {
+        if ((i < 3 && (regs[REG_FIFO_EN] & FIFO_EN_ACCEL)) ||
+            (i == 3 && (regs[REG_FIFO_EN] & FIFO_EN_TEMP)) ||
+            (i > 3 && (regs[REG_FIFO_EN] & (FIFO_EN_GYRO_X >> (i - 4))))) {
+            bytes[count++] = (uint16_t)values[i] >> 8;
+            bytes[count++] = values[i];
+        }
+    }
+    if (fifoCount + count > FIFO_SIZE) {
+        stats.fifoOverflows++;
+        if (regs[REG_INT_ENABLE] & INT_FIFO_OFLOW) {
+            intStatus |= INT_FIFO_OFLOW;
+        }
+        if (regs[REG_CONFIG] & CONFIG_FIFO_MODE) {
+            return;
+        }
+        // The oldest bytes make room
+        fifoHead = (fifoHead + fifoCount + count - FIFO_SIZE) % FIFO_SIZE;
+        fifoCount = FIFO_SIZE - count;
+    }
+    for (i = 0; i < count; i++) {
+        fifo[(fifoHead + fifoCount++) % FIFO_SIZE] = bytes[i];
+    }
+    stats.fifoBytesIn += count;
+}
+
+// Takes the samples due by now
+static void update(void)
+{
+    uint64_t now = simNow * SUBTICKS;
+    uint64_t period = samplePeriod();
+    uint64_t due;
+
+    if (!awake()) {
+        nextSample = now + period;
+        return;
+    }
+    if (nextSample > now) {
+        return;
+    }
+    due = (now - nextSample) / period + 1;
+    stats.samples += due;
+    if (!fifoRunning() || (due > FIFO_SIZE && !(regs[REG_CONFIG] & CONFIG_FIFO_MODE))) {
+        // Only the latest samples matter, a full FIFO is overwritten completely
+        if (fifoRunning()) {
+            stats.fifoOverflows += due - FIFO_SIZE;
+            fifoCount = 0;
+            nextSample += (due - FIFO_SIZE) * period;
+            due = FIFO_SIZE;
+        } else {
+            nextSample += (due - 1) * period;
+            due = 1;
+        }
+    }
+    while (due--) {
+        measure(nextSample, latest);
+        if (fifoRunning()) {
+            fifoPush(latest);
+        }
+        nextSample += period;
+    }
+    if (regs[REG_INT_ENABLE] & INT_RAW_RDY) {
+        intStatus |= INT_RAW_RDY;
+    }
+}
+
+static void writeReg(uint8_t reg, uint8_t value)
+{
+    uint64_t period = samplePeriod();
+
+    switch (reg) {
+    case REG_PWR_MGMT_1:
+        if (value & PWR_MGMT_1_RESET) {
+            reset();
+            return;
+        }
+        break;
+    case REG_USER_CTRL:
+        if (value & USER_CTRL_FIFO_RST) {
+            fifoHead = 0;
+            fifoCount = 0;
+            value &= ~USER_CTRL_FIFO_RST;
+        }
+        break;
+    case REG_FIFO_R_W:
+    case REG_INT_STATUS:
+    case REG_WHO_AM_I:
+        return;
+    default:
+        break;
+    }
+    regs[reg] = value;
+    if (samplePeriod() != period) {
+        nextSample = simNow * SUBTICKS + samplePeriod();
+    }
+}
+
+static uint8_t readFifo(void)
+{
+    if (fifoCount) {
+        fifoLast = fifo[fifoHead];
+        fifoHead = (fifoHead + 1) % FIFO_SIZE;
+        fifoCount--;
+        stats.fifoBytesOut++;
+    }
+    return fifoLast;
+}
+
+static uint8_t readReg(uint8_t reg)
+{
+    uint8_t value;
+    int i;
+
+    if (reg >= REG_ACCEL_XOUT_H && reg <= REG_GYRO_ZOUT_L) {
+        i = (reg - REG_ACCEL_XOUT_H) / 2;
+        return (reg - REG_ACCEL_XOUT_H) % 2 ? (uint8_t)latest[i] : (uint16_t)latest[i] >> 8;
+    }
+    switch (reg) {
+    case REG_INT_STATUS:
+        value = intStatus;
+        intStatus = 0;
+        return value;
+    case REG_FIFO_COUNTH:
+        return fifoCount >> 8;
+    case REG_FIFO_COUNTL:
+        return fifoCount;
+    default:
+        return regs[reg];
+    }
+}
+
+void mpuModelPower(int on)
+{
+    if (on && !powered) {
+        reset();
+    }
+    powered = on;
+}
+
+int mpuModelTransfer(const uint8_t *write, size_t writeCount, uint8_t *read, size_t readCount)
+{
+    uint8_t reg;
+    size_t i;
+
+    if (!powered || writeCount == 0) {
+        return 0;
+    }
+    update();
+    reg = write[0] & (REG_COUNT - 1);
+    for (i = 1; i < writeCount; i++) {
+        writeReg(reg, write[i]);
+        reg = (reg + 1) & (REG_COUNT - 1);
+    }
+    for (i = 0; i < readCount; i++) {
+        // The FIFO is read out through the one register
+        if (reg == REG_FIFO_R_W) {
+            read[i] = readFifo();
+            continue;
+        }
+        read[i] = readReg(reg);
+        reg = (reg + 1) & (REG_COUNT - 1);
+    }
+    if (readCount && (regs[REG_INT_PIN_CFG] & INT_PIN_CFG_ANYRD_2CLEAR)) {
+        intStatus = 0;
+    }
+    return 1;
+}
+
+void mpuModelGetStats(SimMpuStats *s)
+{
+    *s = stats;
+}
@@ -0,0 +1,253 @@
+/* mpubench: benchmarks sensors/mpu9250.c against the MPU9250 model of sim.
+ *
+ * The driver runs alone in a task on the virtual time of the simulator,
+ * with the I2C bus at 400 kHz as in project_main.c. Each phase prints the
+ * virtual time it took, the part of it the bus was busy, the transfers
+ * and bytes and the host time per call:
+ *
+ *     setup        mpu9250_setup: self test, bias calibration and init
+ *     calibrated   mpu9250_setup_calibrated with the results of setup
+ *     get_data     mpu9250_get_data, as the sensor task reads a sample
+ *     fifo         the FIFO read out every 10 ms for a second at sample
+ *                  rates of 100 Hz to 8 kHz: the FIFO count, then the
+ *                  whole samples in bursts of the driver's 255 byte limit
+ *
+ * The results of the self test and the calibration follow, for the unit of
+ * mpu9250_model.c. The device lies still, or moves as the trace of -t,
+ * looped.
+ *
+ * Build: gcc -O2 -std=gnu99 -funsigned-char -DSIM_HOST -Iinclude -I../.. -o mpubench mpubench.c kernel.c \
+ *            drivers.c trace.c mpu9250_model.c opt3001_model.c extflash_model.c ../../serial.c \
+ *            ../../binlog.c ../../sensors/mpu9250.c -lm
+ * Usage: ./mpubench [-n get_data calls] [-t trace.csv]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/drivers/I2C.h>
+
+#include "Board.h"
+#include "sensors/mpu9250.h"
+#include "sim.h"
+
+#define FIFO_COUNTH         0x72
+#define FIFO_R_W            0x74
+#define SMPLRT_DIV          0x19
+#define CONFIG              0x1A
+#define FIFO_EN             0x23
+#define USER_CTRL           0x6A
+#define SAMPLE_SIZE         12
+// readByte counts in a byte
+#define BURST_SAMPLES       (255 / SAMPLE_SIZE)
+#define POLL_MS             10
+#define TEMPERATURE_C       25.0f
+
+typedef struct {
+    const char *name;
+    uint64_t start;
+    SimDriverStats drivers;
+    struct timespec host;
+} Phase;
+
+typedef struct {
+    uint32_t hz;
+    uint8_t config;
+    uint8_t divider;
+} FifoRate;
+
+// The driver's own register access, not in mpu9250.h
+void writeByte(uint8_t reg, uint8_t data);
+void readByte(uint8_t reg, uint8_t count, uint8_t *data);
+
+static const FifoRate fifoRates[] = {
+    {100, 0x03, 9},
+    {200, 0x03, 4},
+    {1000, 0x03, 0},
+    {8000, 0x00, 0}
+};
+
+static int trace = -1;
+static unsigned dataCalls = 1000;
+
+void simMotionAt(uint64_t tick, SimMotion *m)
+{
+    memset(m, 0, sizeof(*m));
+    m->accel[2] = -1.0f;
+    m->temperature = TEMPERATURE_C;
+    if (trace >= 0) {
+        simTraceAt(trace, fmod((double)tick / SIM_TICKS_PER_SECOND, simTraceLength(trace)), m);
+    }
+}
+
+float simLightAt(uint64_t tick)
+{
+    return 0;
+}
+
+static double hostNs(const struct timespec *from)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1e9 + (now.tv_nsec - from->tv_nsec);
+}
+
+static void begin(Phase *phase, const char *name)
+{
+    phase->name = name;
+    phase->start = simNow;
+    simGetDriverStats(&phase->drivers);
+    clock_gettime(CLOCK_MONOTONIC, &phase->host);
+}
+
+static void end(const Phase *phase, unsigned calls)
+{
+    SimDriverStats now;
+    double ns = hostNs(&phase->host);
+    uint32_t transfers;
+
+    simGetDriverStats(&now);
+    transfers = now.i2cTransfers - phase->drivers.i2cTransfers;
+    printf("%-12s %9.2f ms, bus %8.2f ms, %6u transfers, %7u bytes", phase->name,
+           (double)(simNow - phase->start) * 1000 / SIM_TICKS_PER_SECOND,
+           (double)(now.i2cBusTicks - phase->drivers.i2cBusTicks) * 1000 / SIM_TICKS_PER_SECOND,
+           transfers, now.i2cBytes - phase->drivers.i2cBytes);
+    if (calls > 1) {
+        printf(", %.1f transfers and %.0f ns host a call", (double)transfers / calls, ns / calls);
+    } else {
+        printf(", %.2f ms host", ns / 1e6);
+    }
+    printf("\n");
+}
+
+// Reads the FIFO out for a second, returns the samples read
+static uint32_t fifoRun(const FifoRate *rate, SimMpuStats *model)
+{
+    uint8_t data[BURST_SAMPLES * SAMPLE_SIZE];
+    uint64_t until = simNow + SIM_TICKS_PER_SECOND;
+    SimMpuStats before;
+    uint32_t samples = 0;
+    uint16_t count;
+    uint16_t burst;
+
+    writeByte(FIFO_EN, 0x00);
+    writeByte(USER_CTRL, 0x04);
+    writeByte(CONFIG, rate->config);
+    writeByte(SMPLRT_DIV, rate->divider);
+    mpuModelGetStats(&before);
+    writeByte(USER_CTRL, 0x40);
+    writeByte(FIFO_EN, 0x78);
+    while (simNow < until) {
+        Task_sleep(POLL_MS * 1000 / Clock_tickPeriod);
+        readByte(FIFO_COUNTH, 2, data);
+        count = ((data[0] << 8) | data[1]) / SAMPLE_SIZE;
+        while (count > 0) {
+            burst = count < BURST_SAMPLES ? count : BURST_SAMPLES;
+            readByte(FIFO_R_W, burst * SAMPLE_SIZE, data);
+            samples += burst;
+            count -= burst;
+        }
+    }
+    writeByte(FIFO_EN, 0x00);
+    mpuModelGetStats(model);
+    model->samples -= before.samples;
+    model->fifoOverflows -= before.fifoOverflows;
+    return samples;
+}
+
+static void bench(UArg arg0, UArg arg1)
+{
+    I2C_Params params;
+    I2C_Handle i2c;
+    Mpu9250Calibration calibration;
+    SimMpuStats model;
+    Phase phase;
+    float ax, ay, az, gx, gy, gz;
+    uint32_t samples;
+    char name[16];
+    unsigned i;
+
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    i2c = I2C_open(Board_I2C, &params);
+    mpuModelPower(1);
+    Task_sleep(100000 / Clock_tickPeriod);
+
+    begin(&phase, "setup");
+    mpu9250_setup(&i2c);
+    end(&phase, 1);
+    mpu9250_get_calibration(&i2c, &calibration);
+
+    begin(&phase, "calibrated");
+    mpu9250_setup_calibrated(&i2c, &calibration);
+    end(&phase, 1);
+
+    begin(&phase, "get_data");
+    for (i = 0; i < dataCalls; i++) {
+        mpu9250_get_data(&i2c, &ax, &ay, &az, &gx, &gy, &gz);
+    }
+    end(&phase, dataCalls);
+
+    for (i = 0; i < sizeof(fifoRates) / sizeof(fifoRates[0]); i++) {
+        snprintf(name, sizeof(name), "fifo %u Hz", fifoRates[i].hz);
+        begin(&phase, name);
+        samples = fifoRun(&fifoRates[i], &model);
+        end(&phase, 1);
+        printf("%-12s %u samples taken, %u read, %u lost\n", "", model.samples, samples, model.fifoOverflows);
+    }
+
+    printf("self test   ");
+    for (i = 0; i < 6; i++) {
+        printf(" %+.2f", calibration.selfTest[i]);
+    }
+    printf(" %% (accel xyz, gyro xyz)\ngyro bias   ");
+    for (i = 0; i < 3; i++) {
+        printf(" %+.3f", calibration.gyroBias[i]);
+    }
+    printf(" deg/s, offsets");
+    for (i = 0; i < 3; i++) {
+        printf(" %d", calibration.gyroOffset[i]);
+    }
+    printf("\naccel bias  ");
+    for (i = 0; i < 3; i++) {
+        printf(" %+.4f", calibration.accelBias[i]);
+    }
+    printf(" g\n");
+    simStop("done");
+}
+
+int main(int argc, char **argv)
+{
+    Task_Params params;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            dataCalls = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            if ((trace = simTraceLoad(argv[++i])) < 0) {
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "usage: mpubench [-n get_data calls] [-t trace.csv]\n");
+            return 1;
+        }
+    }
+    if (dataCalls == 0) {
+        dataCalls = 1;
+    }
+
+    Task_Params_init(&params);
+    params.priority = 1;
+    Task_create(bench, &params, NULL);
+    BIOS_start();
+    return 0;
+}
@@ -0,0 +1,111 @@
+/* Host simulator: the OPT3001 light sensor on I2C.
+ *
+ * Continuous conversions of 100 or 800 ms (the CT bit) of the light of the
+ * scenario. The conversion ready flag (CRF) rises at the end of each
+ * conversion and falls when the configuration is read, the result is in
+ * the exponent and mantissa format of the chip.
+ */
+
+#include <math.h>
+
+#include "sim.h"
+
+#define REG_RESULT              0x00
+#define REG_CONFIG              0x01
+#define REG_MANUFACTURER_ID     0x7E
+#define REG_DEVICE_ID           0x7F
+
+#define CONFIG_RESET            0xC810
+#define CONFIG_WRITABLE         0xFE1F
+#define CONFIG_CT               0x0800
+#define CONFIG_MODE             0x0600
+#define CONFIG_MODE_SHUTDOWN    0x0000
+#define CONFIG_CRF              0x0080
+#define MANUFACTURER_ID         0x5449
+#define DEVICE_ID               0x3001
+
+static uint8_t pointer = REG_RESULT;
+static uint16_t config = CONFIG_RESET;
+static uint64_t startTick = 0;
+static uint64_t flagClearedTick = 0;
+
+static uint64_t conversionTicks(void)
+{
+    return SIM_TICKS((config & CONFIG_CT) ? 0.8 : 0.1);
+}
+
+// The end of the latest conversion, 0 if none has ended yet
+static uint64_t lastConversion(void)
+{
+    uint64_t length = conversionTicks();
+
+    if ((config & CONFIG_MODE) == CONFIG_MODE_SHUTDOWN || simNow < startTick + length) {
+        return 0;
+    }
+    return startTick + (simNow - startTick) / length * length;
+}
+
+static uint16_t encode(float lux)
+{
+    uint16_t exponent = 0;
+    float mantissa;
+
+    if (lux < 0) {
+        lux = 0;
+    }
+    mantissa = lux / 0.01f;
+    while (mantissa > 4095.0f && exponent < 11) {
+        mantissa /= 2;
+        exponent++;
+    }
+    if (mantissa > 4095.0f) {
+        mantissa = 4095.0f;
+    }
+    return (exponent << 12) | (uint16_t)lroundf(mantissa);
+}
+
+static uint16_t readReg(uint8_t reg)
+{
+    uint64_t done = lastConversion();
+    uint16_t value;
+
+    switch (reg) {
+    case REG_RESULT:
+        return done ? encode(simLightAt(done)) : 0;
+    case REG_CONFIG:
+        value = config;
+        if (done && done > flagClearedTick) {
+            value |= CONFIG_CRF;
+        }
+        flagClearedTick = simNow;
+        return value;
+    case REG_MANUFACTURER_ID:
+        return MANUFACTURER_ID;
+    case REG_DEVICE_ID:
+        return DEVICE_ID;
+    default:
+        return 0;
+    }
+}
+
+int optModelTransfer(const uint8_t *write, size_t writeCount, uint8_t *read, size_t readCount)
+{
+    uint16_t value;
+
+    if (writeCount > 0) {
+        pointer = write[0];
+    }
+    if (writeCount >= 3 && pointer == REG_CONFIG) {
+        value = (write[1] << 8) | write[2];
+        if ((value & CONFIG_MODE) != (config & CONFIG_MODE) || (value & CONFIG_CT) != (config & CONFIG_CT)) {
+            startTick = simNow;
+        }
+        config = (config & ~CONFIG_WRITABLE) | (value & CONFIG_WRITABLE);
+    }
+    if (readCount >= 2) {
+        value = readReg(pointer);
+        read[0] = value >> 8;
+        read[1] = value;
+    }
+    return 1;
+}
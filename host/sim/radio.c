@@ -0,0 +1,171 @@
+/* Host simulator: the API of wireless/comm_lib.h without a radio.
+ *
+ * The gateway is the scenario: its messages are queued for the firmware
+ * and whatever the firmware sends is counted and given to the observer.
+ * GetRXFlag() waits for a message instead of returning 0, the comm task
+ * would otherwise poll it forever in zero virtual time.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "wireless/comm_lib.h"
+#include "sim.h"
+
+#define QUEUE_LENGTH        16
+// 250 kbit/s, 32 us a byte, with the PHY and MAC header of 17 bytes
+#define AIRTIME_TICKS(n)    (((n) + 17) * 32 / 10)
+#define NOISE_FLOOR_DBM     (-95)
+// As in project_main.c
+#define GATEWAY_ADDR        0x1234
+
+static char queue[QUEUE_LENGTH][SIM_RADIO_MAX];
+static int head = 0;
+static int count = 0;
+static uint8_t channel = IEEE80154_CHANNEL_FIRST;
+static uint32_t sent = 0;
+static void (*observer)(const char *payload) = NULL;
+
+void simRadioReceive(const char *payload)
+{
+    if (count == QUEUE_LENGTH) {
+        simTrace("radio", "rx queue full, dropped %s", payload);
+        return;
+    }
+    snprintf(queue[(head + count++) % QUEUE_LENGTH], SIM_RADIO_MAX, "%s", payload);
+    simWake(queue);
+}
+
+void simRadioObserve(void (*fxn)(const char *payload))
+{
+    observer = fxn;
+}
+
+uint32_t simRadioSent(void)
+{
+    return sent;
+}
+
+void Init6LoWPAN(void)
+{
+}
+
+int8_t StartReceive6LoWPAN(void)
+{
+    return 1;
+}
+
+uint16_t GetAddr6LoWPAN(void)
+{
+    return IEEE80154_MY_ADDR;
+}
+
+uint8_t GetTXFlag(void)
+{
+    return 0;
+}
+
+uint8_t GetRXFlag(void)
+{
+    while (count == 0) {
+        simWait(queue, SIM_FOREVER);
+    }
+    return 1;
+}
+
+int8_t GetRSSI(void)
+{
+    return -50;
+}
+
+void Send6LoWPAN(uint16_t DestAddr, uint8_t *ptr_Payload, uint8_t u8_length)
+{
+    char payload[SIM_RADIO_MAX];
+
+    // The firmware may count the terminator in the length
+    snprintf(payload, sizeof(payload), "%.*s", (int)u8_length, (const char *)ptr_Payload);
+    sent++;
+    if (simVerbose) {
+        simTrace("radio", "tx %s", payload);
+    }
+    if (observer) {
+        observer(payload);
+    }
+    simBusy(AIRTIME_TICKS(u8_length));
+}
+
+// The gateway reassembles the fragments, the observer gets the whole message
+int16_t SendBulk6LoWPAN(uint16_t DestAddr, uint8_t *ptr_Payload, uint16_t u16_length)
+{
+    char payload[FRAGMENT_MESSAGE_MAX + 1];
+    int fragments;
+
+    if (u16_length <= FRAGMENT_PAYLOAD_MAX) {
+        Send6LoWPAN(DestAddr, ptr_Payload, (uint8_t)u16_length);
+        return 1;
+    }
+    if (u16_length > FRAGMENT_MESSAGE_MAX) {
+        simTrace("radio", "tx of %u bytes refused", u16_length);
+        return -1;
+    }
+    fragments = (u16_length + FRAGMENT_DATA_MAX - 1) / FRAGMENT_DATA_MAX;
+    snprintf(payload, sizeof(payload), "%.*s", (int)u16_length, (const char *)ptr_Payload);
+    sent += fragments;
+    if (simVerbose) {
+        simTrace("radio", "tx %s (%d fragments)", payload, fragments);
+    }
+    if (observer) {
+        observer(payload);
+    }
+    simBusy(fragments * AIRTIME_TICKS(FRAGMENT_HEADER_BYTES) + AIRTIME_TICKS(u16_length) - AIRTIME_TICKS(0));
+    return fragments;
+}
+
+int16_t ReceiveMessage6LoWPAN(uint16_t *senderAddr, char *payload, uint16_t maxLen)
+{
+    int16_t length;
+
+    if (count == 0) {
+        return 0;
+    }
+    snprintf(payload, maxLen, "%s", queue[head]);
+    head = (head + 1) % QUEUE_LENGTH;
+    count--;
+    length = strlen(payload);
+    *senderAddr = GATEWAY_ADDR;
+    if (simVerbose) {
+        simTrace("radio", "rx %s", payload);
+    }
+    return length;
+}
+
+int8_t Receive6LoWPAN(uint16_t *senderAddr, char *payload, uint8_t maxLen)
+{
+    return ReceiveMessage6LoWPAN(senderAddr, payload, maxLen);
+}
+
+// A quiet band, the current channel stays
+int8_t ScanChannels6LoWPAN(int8_t *ptr_Rssi)
+{
+    int i;
+
+    for (i = 0; i < IEEE80154_CHANNEL_COUNT; i++) {
+        ptr_Rssi[i] = NOISE_FLOOR_DBM;
+    }
+    simBusy(IEEE80154_CHANNEL_COUNT * IEEE80154_SCAN_TIME_US / 10);
+    return channel;
+}
+
+int8_t SetChannel6LoWPAN(uint8_t u8_Channel)
+{
+    if (u8_Channel < IEEE80154_CHANNEL_FIRST || u8_Channel >= IEEE80154_CHANNEL_FIRST + IEEE80154_CHANNEL_COUNT) {
+        return 0;
+    }
+    channel = u8_Channel;
+    return 1;
+}
+
+uint8_t GetChannel6LoWPAN(void)
+{
+    return channel;
+}
@@ -0,0 +1,541 @@
+/* sim: runs the firmware of the tamagotchi on the host, on virtual time.
+ *
+ * project_main.c and the modules it uses are compiled unchanged against
+ * the TI-RTOS and driver headers in include/: kernel.c schedules the tasks
+ * on a virtual clock, drivers.c, radio.c and the *_model.c files stand in
+ * for the board. An hour of the device runs in under a second. The
+ * scenario file is the world around the device, one action a line:
+ *
+ *     <time s> light <lux>                    the light from then on
+ *     <time s> still                          lying flat on a table
+ *     <time s> shake <Hz> <g>                 up and down, exercise
+ *     <time s> slide <Hz> <g>                 back and forth along x, petting
+ *     <time s> flip <s>                       turned over about y in s, then lying face down
+ *     <time s> trace <file> [loop]            a recorded motion, e.g. from host/capture
+ *     <time s> press power|upper <ms>         a button push
+ *     <time s> radio <payload>                a gateway message, e.g. 301,BEEP
+ *     <time s> param <name> <value>           a SET_PARAM on the serial console
+ *     <time s> expect event <name> <s>        the event must be posted within s
+ *     <time s> reject event <name> <s>        the event must not be posted within s
+ *     <time s> expect radio <text> <s>        a message containing text must be sent within s
+ *     <time s> reject radio <text> <s>
+ *     <time s> end
+ *
+ * Event names are those of events.h in lower case without the prefix,
+ * parameter names those of params.h. A trace file is a data.csv capture
+ * (see trace.c), relative to the scenario file; the device lies still when
+ * it ends, unless it loops. # starts a comment. The events are
+ * traced as they are posted, -v traces the radio, the buzzer, the LED and
+ * System_printf too. -s writes the serial port output for host/logdec,
+ * -f keeps the external flash in an image file between runs, the image
+ * host/flashparse reads.
+ *
+ * The run ends at the end action, at a shutdown or, without either, after
+ * the last action or expectation. A summary follows: message rates, event
+ * counts and latencies, bus traffic. The exit status is 1 if an
+ * expectation failed and 2 if the firmware aborted.
+ *
+ * Build: gcc -O2 -std=gnu99 -funsigned-char -DSIM_HOST -Dmain=firmwareMain -Iinclude -I../.. -I../../wireless \
+ *            -Wl,--wrap=eventPost -o sim sim.c kernel.c drivers.c radio.c trace.c mpu9250_model.c opt3001_model.c \
+ *            extflash_model.c ../../project_main.c ../../buttons.c ../../buzzer.c ../../sound.c ../../led.c \
+ *            ../../events.c ../../serial.c ../../binlog.c ../../flashlog.c ../../extflash.c ../../calib.c \
+ *            ../../stream.c ../../params.c ../../detect.c ../../filter.c ../../rhythm.c ../../attitude.c \
+ *            ../../noise.c ../../console.c ../../cpuload.c ../../stackmon.c ../../probe.c ../../cycles.c \
+ *            ../../sensors/mpu9250.c ../../sensors/opt3001.c -lm
+ * Usage: ./sim [-v] [-s serial.bin] [-f flash.img] scenarios/daily.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+
+#include "events.h"
+#include "params.h"
+#include "serial.h"
+#include "console_format.h"
+#include "Board.h"
+#include "sim.h"
+
+// The firmware main is renamed on the command line, this is the real one
+#undef main
+
+#define MAX_ACTIONS     1024
+#define MAX_TEXT        SIM_RADIO_MAX
+#define PI              3.14159265f
+#define TEMPERATURE_C   25.0f
+
+typedef enum {
+    ACTION_LIGHT,
+    ACTION_STILL,
+    ACTION_SHAKE,
+    ACTION_SLIDE,
+    ACTION_FLIP,
+    ACTION_TRACE,
+    ACTION_PRESS,
+    ACTION_RADIO,
+    ACTION_PARAM,
+    ACTION_EXPECT_EVENT,
+    ACTION_REJECT_EVENT,
+    ACTION_EXPECT_RADIO,
+    ACTION_REJECT_RADIO,
+    ACTION_END
+} ActionType;
+
+typedef struct {
+    ActionType type;
+    int line;
+    uint64_t tick;
+    uint64_t until;     // expectations
+    float value[2];
+    int id;             // button pin, parameter, event or trace
+    char text[MAX_TEXT];
+    uint64_t met;       // expectations, 0 if not met
+} Action;
+
+typedef struct {
+    ActionType type;
+    uint64_t start;
+    float hz;
+    float g;
+    int trace;
+    int loop;
+} Motion;
+
+int firmwareMain(void);
+int __real_eventPost(EventType type, uint8_t arg);
+
+#define NAME_STRING(id, ...) #id,
+static const char *paramNames[] = {
+    PARAMS(NAME_STRING)
+};
+#undef NAME_STRING
+
+// In the order of EventType
+static const char *eventNames[] = {
+    "shutdown", "power_button", "power_double", "button", "button_double", "feed",
+    "sleep", "wake", "exercise", "pet", "warning", "game_over", "stack_report",
+    "load_report", "probe_dump", "flash_dump", "calibrate", "stream",
+    "exercise_end"
+};
+typedef char eventNamesComplete[sizeof(eventNames) / sizeof(eventNames[0]) == EVENT_COUNT ? 1 : -1];
+
+static Action actions[MAX_ACTIONS];
+static int actionCount = 0;
+static Motion motion = {ACTION_STILL, 0, 0, 0, 0, 0};
+static float lux = 300;
+static uint32_t eventCounts[EVENT_COUNT];
+static uint8_t consoleTag = 0;
+
+/* ---- The world of the scenario ---- */
+
+void simMotionAt(uint64_t tick, SimMotion *m)
+{
+    float t = (float)(tick - motion.start) / SIM_TICKS_PER_SECOND;
+    float w = 2 * PI * motion.hz;
+    double seconds = (double)(tick - motion.start) / SIM_TICKS_PER_SECOND;
+    double length;
+    float angle;
+
+    memset(m, 0, sizeof(*m));
+    // Lying face up the MPU reads -1 g on z, as in Debug/data.csv
+    m->accel[2] = -1.0f;
+    m->temperature = TEMPERATURE_C;
+    switch (motion.type) {
+    case ACTION_TRACE:
+        length = simTraceLength(motion.trace);
+        simTraceAt(motion.trace, motion.loop ? fmod(seconds, length) : seconds, m);
+        break;
+    case ACTION_SHAKE:
+        m->accel[2] += motion.g * sinf(w * t);
+        break;
+    case ACTION_SLIDE:
+        m->accel[0] = motion.g * sinf(w * t);
+        // A hand also turns the device a little
+        m->gyro[2] = 10.0f * motion.g * cosf(w * t);
+        break;
+    case ACTION_FLIP:
+        // Half a turn at an even rate, up turns from -z to +z through +x
+        angle = t < motion.hz ? PI * t / motion.hz : PI;
+        m->accel[0] = sinf(angle);
+        m->accel[2] = -cosf(angle);
+        m->gyro[1] = t < motion.hz ? 180.0f / motion.hz : 0;
+        break;
+    default:
+        break;
+    }
+}
+
+float simLightAt(uint64_t tick)
+{
+    return lux;
+}
+
+static void release(void *arg)
+{
+    simPinInput((uint8_t)(uintptr_t)arg, 1);
+}
+
+static void putByte(uint8_t *out, int *length, uint8_t c)
+{
+    if (c == SERIAL_FLAG || c == SERIAL_ESCAPE) {
+        out[(*length)++] = SERIAL_ESCAPE;
+        c ^= SERIAL_ESCAPE_XOR;
+    }
+    out[(*length)++] = c;
+}
+
+// The frame host/console would send
+static void setParam(int param, float value)
+{
+    uint8_t frame[16];
+    uint8_t out[2 * sizeof(frame) + 2];
+    uint32_t bits;
+    uint16_t crc;
+    int count = 0;
+    int length = 0;
+    int i;
+
+    memcpy(&bits, &value, sizeof(bits));
+    frame[count++] = SERIAL_FRAME_COMMAND;
+    frame[count++] = CONSOLE_SET_PARAM;
+    frame[count++] = consoleTag++;
+    frame[count++] = param;
+    for (i = 0; i < 4; i++) {
+        frame[count++] = bits >> (8 * i);
+    }
+    crc = serialCrc16(0xFFFF, frame, count);
+    frame[count++] = crc;
+    frame[count++] = crc >> 8;
+
+    out[length++] = SERIAL_FLAG;
+    for (i = 0; i < count; i++) {
+        putByte(out, &length, frame[i]);
+    }
+    out[length++] = SERIAL_FLAG;
+    simSerialInput(out, length);
+}
+
+static void runAction(void *arg)
+{
+    Action *a = arg;
+
+    switch (a->type) {
+    case ACTION_LIGHT:
+        lux = a->value[0];
+        break;
+    case ACTION_STILL:
+    case ACTION_SHAKE:
+    case ACTION_SLIDE:
+    case ACTION_FLIP:
+    case ACTION_TRACE:
+        motion.type = a->type;
+        motion.start = simNow;
+        motion.hz = a->value[0];
+        motion.g = a->value[1];
+        motion.trace = a->id;
+        motion.loop = a->type == ACTION_TRACE && a->value[0] != 0;
+        break;
+    case ACTION_PRESS:
+        simPinInput(a->id, 0);
+        simSchedule(simNow + SIM_TICKS(a->value[0] / 1000), release, (void *)(uintptr_t)a->id);
+        break;
+    case ACTION_RADIO:
+        simRadioReceive(a->text);
+        break;
+    case ACTION_PARAM:
+        setParam(a->id, a->value[0]);
+        break;
+    case ACTION_END:
+        simStop("end of the scenario");
+        break;
+    default:
+        // Expectations are checked as the events come
+        break;
+    }
+}
+
+/* ---- Expectations ---- */
+
+static void observe(ActionType expect, ActionType reject, int id, const char *text)
+{
+    Action *a;
+    int i;
+
+    for (i = 0; i < actionCount; i++) {
+        a = &actions[i];
+        if ((a->type == expect || a->type == reject) && !a->met &&
+            simNow >= a->tick && simNow <= a->until &&
+            (text ? strstr(text, a->text) != NULL : a->id == id)) {
+            // Tick 0 is the boot, a match there counts from tick 1
+            a->met = simNow ? simNow : 1;
+            if (a->type == reject) {
+                simTrace("FAIL", "line %d: %s %s", a->line, text ? "radio" : "event", text ? text : eventNames[id]);
+            }
+        }
+    }
+}
+
+int __wrap_eventPost(EventType type, uint8_t arg)
+{
+    if (type < EVENT_COUNT) {
+        eventCounts[type]++;
+        if (type != EVENT_STACK_REPORT && type != EVENT_LOAD_REPORT) {
+            simTrace("event", "%s %u", eventNames[type], arg);
+        }
+        observe(ACTION_EXPECT_EVENT, ACTION_REJECT_EVENT, type, NULL);
+    }
+    return __real_eventPost(type, arg);
+}
+
+static void radioSent(const char *payload)
+{
+    observe(ACTION_EXPECT_RADIO, ACTION_REJECT_RADIO, 0, payload);
+}
+
+// Prints the result of each expectation, returns the number failed
+static int report(void)
+{
+    Action *a;
+    int failed = 0;
+    int i;
+
+    for (i = 0; i < actionCount; i++) {
+        a = &actions[i];
+        if (a->type == ACTION_EXPECT_EVENT || a->type == ACTION_EXPECT_RADIO) {
+            if (a->met) {
+                printf("PASS line %d: %s after %.3f s\n", a->line, a->text,
+                       (double)(a->met - a->tick) / SIM_TICKS_PER_SECOND);
+            } else {
+                printf("FAIL line %d: no %s within %.1f s%s\n", a->line, a->text,
+                       (double)(a->until - a->tick) / SIM_TICKS_PER_SECOND,
+                       a->until > simNow ? ", the run ended first" : "");
+                failed++;
+            }
+        } else if (a->type == ACTION_REJECT_EVENT || a->type == ACTION_REJECT_RADIO) {
+            if (a->met) {
+                printf("FAIL line %d: %s after %.3f s\n", a->line, a->text,
+                       (double)(a->met - a->tick) / SIM_TICKS_PER_SECOND);
+                failed++;
+            } else {
+                printf("PASS line %d: no %s\n", a->line, a->text);
+            }
+        }
+    }
+    return failed;
+}
+
+static void summary(double seconds)
+{
+    SimDriverStats drivers;
+    SimMpuStats mpu;
+    EventStats events;
+    double minutes = (double)simNow / SIM_TICKS_PER_SECOND / 60;
+    int i;
+
+    simGetDriverStats(&drivers);
+    mpuModelGetStats(&mpu);
+    eventGetStats(&events);
+    printf("%.1f s of virtual time in %.2f s, %s\n", (double)simNow / SIM_TICKS_PER_SECOND, seconds, simStopReason());
+    printf("radio: %u messages, %.1f per minute\n", simRadioSent(), minutes > 0 ? simRadioSent() / minutes : 0);
+    printf("events:");
+    for (i = 0; i < EVENT_COUNT; i++) {
+        if (eventCounts[i]) {
+            printf(" %s %u", eventNames[i], eventCounts[i]);
+        }
+    }
+    printf("\nevent latency: max %u us, average %u us, %u dropped\n", events.maxLatencyUs,
+           events.handled ? events.totalLatencyUs / events.handled : 0, events.dropped);
+    printf("serial: %u bytes, %u frames\n", drivers.serialBytes, drivers.serialFrames);
+    printf("i2c: %u transfers, %u bytes, %u nacks, %.3f s busy\n", drivers.i2cTransfers, drivers.i2cBytes,
+           drivers.i2cNacks, (double)drivers.i2cBusTicks / SIM_TICKS_PER_SECOND);
+    printf("mpu: %u samples, fifo %u bytes in, %u out, %u overflows\n", mpu.samples, mpu.fifoBytesIn,
+           mpu.fifoBytesOut, mpu.fifoOverflows);
+    printf("flash: %u pages programmed\n", flashModelPagesProgrammed());
+    printf("buzzer: %u tones, led: %u changes\n", drivers.tones, drivers.ledToggles);
+}
+
+/* ---- The scenario file ---- */
+
+static int lookup(const char **names, int count, const char *prefix, const char *name)
+{
+    const char *full;
+    int i, j;
+
+    for (i = 0; i < count; i++) {
+        full = names[i] + strlen(prefix);
+        for (j = 0; full[j] && tolower((unsigned char)full[j]) == name[j]; j++) {
+        }
+        if (!full[j] && !name[j]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// A path relative to the directory of the scenario
+static void relative(char *out, size_t size, const char *scenario, const char *path)
+{
+    const char *slash = strrchr(scenario, '/');
+
+    if (path[0] == '/' || !slash) {
+        snprintf(out, size, "%s", path);
+    } else {
+        snprintf(out, size, "%.*s/%s", (int)(slash - scenario), scenario, path);
+    }
+}
+
+static int parseLine(char *line, const char *scenario, int number, Action *a)
+{
+    char verb[16], kind[16], name[MAX_TEXT], path[2 * MAX_TEXT];
+    double time, within;
+    int n;
+
+    memset(a, 0, sizeof(*a));
+    a->line = number;
+    if (sscanf(line, "%lf %15s%n", &time, verb, &n) < 2) {
+        return 0;
+    }
+    line += n;
+    a->tick = SIM_TICKS(time);
+    if (strcmp(verb, "light") == 0 && sscanf(line, "%f", &a->value[0]) == 1) {
+        a->type = ACTION_LIGHT;
+    } else if (strcmp(verb, "still") == 0) {
+        a->type = ACTION_STILL;
+    } else if (strcmp(verb, "shake") == 0 && sscanf(line, "%f %f", &a->value[0], &a->value[1]) == 2) {
+        a->type = ACTION_SHAKE;
+    } else if (strcmp(verb, "slide") == 0 && sscanf(line, "%f %f", &a->value[0], &a->value[1]) == 2) {
+        a->type = ACTION_SLIDE;
+    } else if (strcmp(verb, "flip") == 0 && sscanf(line, "%f", &a->value[0]) == 1 && a->value[0] > 0) {
+        a->type = ACTION_FLIP;
+    } else if (strcmp(verb, "trace") == 0 && (n = sscanf(line, "%127s %15s", name, kind)) >= 1) {
+        relative(path, sizeof(path), scenario, name);
+        if ((a->id = simTraceLoad(path)) < 0) {
+            return 0;
+        }
+        a->type = ACTION_TRACE;
+        a->value[0] = n == 2 && strcmp(kind, "loop") == 0;
+    } else if (strcmp(verb, "press") == 0 && sscanf(line, "%15s %f", name, &a->value[0]) == 2 &&
+               (strcmp(name, "power") == 0 || strcmp(name, "upper") == 0)) {
+        a->type = ACTION_PRESS;
+        a->id = strcmp(name, "power") == 0 ? Board_BUTTON1 : Board_BUTTON0;
+    } else if (strcmp(verb, "radio") == 0 && sscanf(line, " %127s", a->text) == 1) {
+        a->type = ACTION_RADIO;
+    } else if (strcmp(verb, "param") == 0 && sscanf(line, "%127s %f", name, &a->value[0]) == 2 &&
+               (a->id = lookup(paramNames, PARAM_COUNT, "PARAM_", name)) >= 0) {
+        a->type = ACTION_PARAM;
+    } else if ((strcmp(verb, "expect") == 0 || strcmp(verb, "reject") == 0) &&
+               sscanf(line, "%15s %127s %lf", kind, name, &within) == 3) {
+        a->until = a->tick + SIM_TICKS(within);
+        snprintf(a->text, sizeof(a->text), "%s", name);
+        if (strcmp(kind, "event") == 0) {
+            a->id = lookup(eventNames, EVENT_COUNT, "", name);
+            if (a->id < 0) {
+                return 0;
+            }
+            a->type = verb[0] == 'e' ? ACTION_EXPECT_EVENT : ACTION_REJECT_EVENT;
+        } else if (strcmp(kind, "radio") == 0) {
+            a->type = verb[0] == 'e' ? ACTION_EXPECT_RADIO : ACTION_REJECT_RADIO;
+        } else {
+            return 0;
+        }
+    } else if (strcmp(verb, "end") == 0) {
+        a->type = ACTION_END;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+static int load(const char *path)
+{
+    char line[256];
+    char *comment;
+    FILE *file = fopen(path, "r");
+    int number = 0;
+    int hasEnd = 0;
+    uint64_t last = 0;
+    int i;
+
+    if (!file) {
+        perror(path);
+        return 0;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        number++;
+        if ((comment = strchr(line, '#'))) {
+            *comment = '\0';
+        }
+        if (strspn(line, " \t\r\n") == strlen(line)) {
+            continue;
+        }
+        if (actionCount == MAX_ACTIONS || !parseLine(line, path, number, &actions[actionCount])) {
+            fprintf(stderr, "%s:%d: bad action\n", path, number);
+            fclose(file);
+            return 0;
+        }
+        actionCount++;
+    }
+    fclose(file);
+
+    for (i = 0; i < actionCount; i++) {
+        simSchedule(actions[i].tick, runAction, &actions[i]);
+        hasEnd |= actions[i].type == ACTION_END;
+        last = actions[i].until > last ? actions[i].until : last;
+        last = actions[i].tick > last ? actions[i].tick : last;
+    }
+    if (!hasEnd) {
+        simEnd = last;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *flashPath = NULL;
+    const char *scenario = NULL;
+    clock_t start;
+    int failed;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            simVerbose = 1;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if (!simSerialOutput(argv[++i])) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            flashPath = argv[++i];
+            if (!flashModelLoad(flashPath)) {
+                return 1;
+            }
+        } else if (!scenario && argv[i][0] != '-') {
+            scenario = argv[i];
+        } else {
+            scenario = NULL;
+            break;
+        }
+    }
+    if (!scenario) {
+        fprintf(stderr, "usage: sim [-v] [-s serial.bin] [-f flash.img] scenario.txt\n");
+        return 1;
+    }
+    if (!load(scenario)) {
+        return 1;
+    }
+    simRadioObserve(radioSent);
+
+    start = clock();
+    firmwareMain();
+    fflush(stdout);
+
+    failed = report();
+    summary((double)(clock() - start) / CLOCKS_PER_SEC);
+    if (flashPath && !flashModelSave(flashPath)) {
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+/* Host simulator: the parts shared by the kernel, the drivers, the device
+ * models and the scenario, see sim.c.
+ *
+ * Time is virtual and counted in Clock ticks of 10 us from the boot. The
+ * firmware code itself runs in zero time; time only passes while a task
+ * sleeps, waits or is blocked in a driver for the duration of a bus
+ * transfer.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SIM_TICKS_PER_SECOND    100000
+#define SIM_TICKS(seconds)      ((uint64_t)((seconds) * SIM_TICKS_PER_SECOND + 0.5))
+#define SIM_FOREVER             UINT64_MAX
+
+/* kernel.c */
+typedef void (*SimFxn)(void *arg);
+
+extern uint64_t simNow;
+// BIOS_start() returns at this tick
+extern uint64_t simEnd;
+extern int simVerbose;
+
+// Calls fxn(arg) at tick, in interrupt context before the tasks of that tick
+void simSchedule(uint64_t tick, SimFxn fxn, void *arg);
+// The running task waits for simWake(object) at most ticks, returns 0 on timeout
+int simWait(const void *object, uint64_t ticks);
+// Readies the longest waiting task of the highest priority, returns 1 if there was one
+int simWake(const void *object);
+// The running task is busy for ticks, e.g. a bus transfer, other tasks run meanwhile
+void simBusy(uint64_t ticks);
+int simInTask(void);
+// Ends the run after the current tick
+void simStop(const char *reason);
+const char *simStopReason(void);
+
+void simTrace(const char *source, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+/* drivers.c */
+void simPinInput(uint8_t pin, int level);
+void simSerialInput(const uint8_t *data, size_t length);
+int simSerialOutput(const char *path);
+
+typedef struct {
+    uint32_t i2cTransfers;
+    uint32_t i2cBytes;
+    uint32_t i2cNacks;
+    uint64_t i2cBusTicks;
+    uint32_t serialBytes;
+    uint32_t serialFrames;
+    uint32_t tones;
+    uint32_t ledToggles;
+} SimDriverStats;
+
+void simGetDriverStats(SimDriverStats *stats);
+
+/* radio.c */
+#define SIM_RADIO_MAX   128
+
+void simRadioReceive(const char *payload);
+// Calls the observer with every message the firmware sends
+void simRadioObserve(void (*observer)(const char *payload));
+uint32_t simRadioSent(void);
+
+/* Device models, the I2C ones return 0 for a NACK */
+typedef struct {
+    float accel[3];     // g
+    float gyro[3];      // deg/s
+    float temperature;  // C
+} SimMotion;
+
+// Provided by the scenario
+void simMotionAt(uint64_t tick, SimMotion *motion);
+float simLightAt(uint64_t tick);
+
+/* trace.c */
+// Loads a data.csv capture, returns its id or -1
+int simTraceLoad(const char *path);
+double simTraceLength(int trace);
+// The accel and gyro of the trace seconds from its start, 0 past its end
+int simTraceAt(int trace, double seconds, SimMotion *motion);
+
+typedef struct {
+    uint32_t samples;       // taken at the sample rate while awake
+    uint32_t fifoBytesIn;
+    uint32_t fifoBytesOut;
+    uint32_t fifoOverflows; // samples lost or cut
+} SimMpuStats;
+
+void mpuModelPower(int on);
+int mpuModelTransfer(const uint8_t *write, size_t writeCount, uint8_t *read, size_t readCount);
+void mpuModelGetStats(SimMpuStats *stats);
+
+int optModelTransfer(const uint8_t *write, size_t writeCount, uint8_t *read, size_t readCount);
+
+void flashModelSelect(int selected);
+uint8_t flashModelExchange(uint8_t in);
+int flashModelLoad(const char *path);
+int flashModelSave(const char *path);
+uint32_t flashModelPagesProgrammed(void);
+
+#endif
@@ -0,0 +1,129 @@
+/* Host simulator: recorded motion traces.
+ *
+ * A trace is a data.csv capture, <time s>,ax,ay,az,gx,gy,gz a line in g
+ * and deg/s, as written by host/capture or copied from the debug console.
+ * The whole seconds of the old captures repeat over the lines of a second,
+ * those lines are spread evenly over it. Lines that do not parse, e.g. a
+ * header, are skipped. The motion between two lines is interpolated.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+#define MAX_TRACES  16
+
+typedef struct {
+    double time;
+    float value[6];
+} TraceSample;
+
+typedef struct {
+    TraceSample *samples;
+    size_t count;
+} Trace;
+
+static Trace traces[MAX_TRACES];
+static int traceCount = 0;
+
+// Spreads the lines that share a time over the second that follows it
+static void spread(Trace *trace)
+{
+    size_t first, last, i;
+
+    for (first = 0; first < trace->count; first = last) {
+        for (last = first + 1; last < trace->count && trace->samples[last].time == trace->samples[first].time; last++) {
+        }
+        for (i = first + 1; i < last; i++) {
+            trace->samples[i].time += (double)(i - first) / (last - first);
+        }
+    }
+}
+
+int simTraceLoad(const char *path)
+{
+    char line[256];
+    Trace *trace;
+    TraceSample s;
+    size_t capacity = 0;
+    double start = 0;
+    FILE *file;
+
+    if (traceCount == MAX_TRACES) {
+        fprintf(stderr, "%s: more than %d traces\n", path, MAX_TRACES);
+        return -1;
+    }
+    if (!(file = fopen(path, "r"))) {
+        perror(path);
+        return -1;
+    }
+    trace = &traces[traceCount];
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "%lf,%f,%f,%f,%f,%f,%f", &s.time, &s.value[0], &s.value[1], &s.value[2],
+                   &s.value[3], &s.value[4], &s.value[5]) != 7) {
+            continue;
+        }
+        if (trace->count == 0) {
+            start = s.time;
+        }
+        s.time -= start;
+        if (trace->count == capacity) {
+            capacity = capacity ? 2 * capacity : 1024;
+            trace->samples = realloc(trace->samples, capacity * sizeof(TraceSample));
+            if (!trace->samples) {
+                fprintf(stderr, "%s: out of memory\n", path);
+                fclose(file);
+                return -1;
+            }
+        }
+        trace->samples[trace->count++] = s;
+    }
+    fclose(file);
+    if (trace->count < 2) {
+        fprintf(stderr, "%s: not a motion trace\n", path);
+        return -1;
+    }
+    spread(trace);
+    return traceCount++;
+}
+
+double simTraceLength(int id)
+{
+    const Trace *trace = &traces[id];
+
+    return trace->samples[trace->count - 1].time;
+}
+
+int simTraceAt(int id, double seconds, SimMotion *motion)
+{
+    const Trace *trace = &traces[id];
+    const TraceSample *a, *b;
+    size_t low = 0, high = trace->count - 1, mid;
+    float f;
+    int i;
+
+    if (seconds < 0 || seconds > trace->samples[high].time) {
+        return 0;
+    }
+    // The last sample at or before seconds
+    while (high - low > 1) {
+        mid = (low + high) / 2;
+        if (trace->samples[mid].time <= seconds) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    a = &trace->samples[low];
+    b = &trace->samples[high];
+    f = b->time > a->time ? (float)((seconds - a->time) / (b->time - a->time)) : 0;
+    if (f > 1) {
+        f = 1;
+    }
+    for (i = 0; i < 3; i++) {
+        motion->accel[i] = a->value[i] + f * (b->value[i] - a->value[i]);
+        motion->gyro[i] = a->value[3 + i] + f * (b->value[3 + i] - a->value[3 + i]);
+    }
+    return 1;
+}
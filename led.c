@@ -0,0 +1,211 @@
+/** ============================================================================
+ *  @file       led.c
+ *
+ *  @brief      Clock driven LED pattern engine.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Swi.h>
+
+#include "led.h"
+
+/* -----------------------------------------------------------------------------
+*  Local types
+* ------------------------------------------------------------------------------
+*/
+// One step: LED on for onMs, then off for offMs, the whole step repeated
+typedef struct {
+    uint16_t onMs;
+    uint16_t offMs;
+    uint8_t repeat;
+} LedStep;
+
+// Patterns without steps just hold the LED at idleLevel
+typedef struct {
+    const LedStep *steps;
+    uint8_t count;
+    uint8_t oneShot;
+    uint8_t idleLevel;
+} LedPatternDef;
+
+/* -----------------------------------------------------------------------------
+*  Pattern table
+* ------------------------------------------------------------------------------
+*/
+static const LedStep blinkSteps[] = {{500, 500, 1}};
+static const LedStep heartbeatSteps[] = {{60, 140, 1}, {60, 1240, 1}};
+// Breathing is a 20 ms pulse train with a rising and falling duty cycle
+static const LedStep breatheSteps[] = {{1, 19, 4}, {2, 18, 4}, {4, 16, 4}, {7, 13, 4},
+                                       {11, 9, 4}, {15, 5, 4}, {19, 1, 8}, {15, 5, 4},
+                                       {11, 9, 4}, {7, 13, 4}, {4, 16, 4}, {2, 18, 4},
+                                       {1, 19, 4}, {0, 600, 1}};
+static const LedStep flashSteps[] = {{150, 0, 1}};
+static const LedStep alertSteps[] = {{100, 100, 8}};
+
+#define STEPS(s) s, sizeof(s) / sizeof(s[0])
+
+static const LedPatternDef patterns[LED_PATTERN_COUNT] = {
+    [LED_PATTERN_OFF]       = {NULL, 0, 0, 0},
+    [LED_PATTERN_ON]        = {NULL, 0, 0, 1},
+    [LED_PATTERN_BLINK]     = {STEPS(blinkSteps), 0, 0},
+    [LED_PATTERN_HEARTBEAT] = {STEPS(heartbeatSteps), 0, 0},
+    [LED_PATTERN_BREATHE]   = {STEPS(breatheSteps), 0, 0},
+    [LED_PATTERN_FLASH]     = {STEPS(flashSteps), 1, 0},
+    [LED_PATTERN_ALERT]     = {STEPS(alertSteps), 1, 0},
+};
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static PIN_Handle hPin = NULL;
+static PIN_Id ledPin;
+static Clock_Handle hClock = NULL;
+
+// Engine state, only touched with Swis disabled or from the Clock function
+static LedPattern background = LED_PATTERN_OFF;
+static LedPattern current = LED_PATTERN_OFF;
+static uint8_t step = 0;
+static uint8_t repeat = 0;
+static uint8_t offPhase = 0;
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+static void ledSchedule(uint16_t ms)
+{
+    Clock_setTimeout(hClock, (uint32_t)ms * 1000 / Clock_tickPeriod);
+    Clock_start(hClock);
+}
+
+/*******************************************************************************
+ * @fn          ledNext
+ *
+ * @brief       Drives the LED to the next edge of the current pattern
+ *
+ * @descr       Steps with a zero length phase are skipped without waking up.
+ *              When a one-shot pattern ends the background pattern resumes.
+ */
+static void ledNext(void)
+{
+    const LedPatternDef *def = &patterns[current];
+
+    while (1) {
+        const LedStep *s;
+
+        if (step >= def->count) {
+            if (def->oneShot) {
+                current = background;
+                def = &patterns[current];
+            }
+            step = 0;
+            repeat = 0;
+            offPhase = 0;
+            if (def->count == 0) {
+                PIN_setOutputValue(hPin, ledPin, def->idleLevel);
+                return;
+            }
+        }
+
+        s = &def->steps[step];
+        if (!offPhase) {
+            offPhase = 1;
+            if (s->onMs) {
+                PIN_setOutputValue(hPin, ledPin, 1);
+                ledSchedule(s->onMs);
+                return;
+            }
+        } else {
+            offPhase = 0;
+            if (++repeat >= s->repeat) {
+                repeat = 0;
+                step++;
+            }
+            if (s->offMs) {
+                PIN_setOutputValue(hPin, ledPin, 0);
+                ledSchedule(s->offMs);
+                return;
+            }
+        }
+    }
+}
+
+// Clock function, runs in Swi context
+static Void ledClkFxn(UArg arg0)
+{
+    ledNext();
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          ledOpen
+ *
+ * @brief       Initialize the pattern engine
+ *
+ * @descr       The pin must already be opened as a GPIO output.
+ *
+ * @return      -
+ */
+void ledOpen(PIN_Handle hPinGpio, PIN_Id pin)
+{
+    Clock_Params clkParams;
+
+    hPin = hPinGpio;
+    ledPin = pin;
+
+    Clock_Params_init(&clkParams);
+    clkParams.period = 0;
+    clkParams.startFlag = FALSE;
+    hClock = Clock_create((Clock_FuncPtr)ledClkFxn, 1, &clkParams, NULL);
+    if (hClock == NULL) {
+        System_abort("LED clock create failed");
+    }
+    PIN_setOutputValue(hPin, ledPin, 0);
+}
+
+/*******************************************************************************
+ * @fn          ledPostPattern
+ *
+ * @brief       Start a pattern
+ *
+ * @descr       A repeating pattern replaces the background pattern. If a
+ *              one-shot pattern is playing, the new background starts when
+ *              it ends. A one-shot pattern starts immediately.
+ *              Call from tasks or Swis, not from Hwis.
+ *
+ * @return      -
+ */
+void ledPostPattern(LedPattern pattern)
+{
+    UInt key;
+
+    if (pattern >= LED_PATTERN_COUNT || hClock == NULL) {
+        return;
+    }
+
+    key = Swi_disable();
+    if (!patterns[pattern].oneShot) {
+        background = pattern;
+    }
+    if (patterns[pattern].oneShot || !patterns[current].oneShot) {
+        Clock_stop(hClock);
+        current = pattern;
+        step = 0;
+        repeat = 0;
+        offPhase = 0;
+        ledNext();
+    }
+    Swi_restore(key);
+}
@@ -0,0 +1,44 @@
+/** ============================================================================
+ *  @file       led.h
+ *
+ *  @brief      Clock driven LED pattern engine.
+ *
+ *  Patterns run from a one-shot Clock, so showing a status costs no task
+ *  time and the CPU only wakes at the pattern's edges. Repeating patterns
+ *  become the background pattern; one-shot patterns play once on top of it
+ *  and then hand the LED back.
+ *  ============================================================================
+ */
+#ifndef _LED_H_
+#define _LED_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include "Board.h"
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+typedef enum {
+    // Repeating (background) patterns
+    LED_PATTERN_OFF = 0,
+    LED_PATTERN_ON,
+    LED_PATTERN_BLINK,
+    LED_PATTERN_HEARTBEAT,
+    LED_PATTERN_BREATHE,
+    // One-shot patterns
+    LED_PATTERN_FLASH,
+    LED_PATTERN_ALERT,
+    LED_PATTERN_COUNT
+} LedPattern;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void ledOpen(PIN_Handle hPinGpio, PIN_Id pin);
+void ledPostPattern(LedPattern pattern);
+
+#endif
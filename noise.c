@@ -0,0 +1,161 @@
+/** ============================================================================
+ *  @file       noise.c
+ *
+ *  @brief      Noise and bias of the MPU axes, followed while lying still.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <math.h>
+#include <string.h>
+
+#include "noise.h"
+
+/* -----------------------------------------------------------------------------
+*  Constants
+* ------------------------------------------------------------------------------
+*/
+// Still: no axis changed more than this from the previous sample, g and deg/s
+#define NOISE_STILL_G       0.05f
+#define NOISE_STILL_DPS     3.0f
+// ...and the gyro reads no turn, deg/s after the bias
+#define NOISE_STILL_TURN    10.0f
+// An accelerometer axis at least this close to gravity points up or down, g
+#define NOISE_GRAVITY       0.9f
+
+// sqrt(2 / pi), the mean of |x| per standard deviation of a normal x
+#define NOISE_MEAN_ABS      0.7978846f
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          noiseReset
+ *
+ * @brief       Forget the noise and the biases
+ *
+ * @return      -
+ */
+void noiseReset(Noise *noise)
+{
+    memset(noise, 0, sizeof(*noise));
+}
+
+/*******************************************************************************
+ * @fn          noiseSample
+ *
+ * @brief       Follow a sample, and correct it by the biases
+ *
+ * @descr       motion is ax, ay, az in g and gx, gy, gz in deg/s, as read.
+ *              The trackers are updated from the raw values when the
+ *              device has been still, the biases are then subtracted.
+ *
+ * @return      1 if the device is still
+ */
+int noiseSample(Noise *noise, float motion[6])
+{
+    int still = noise->samples > 0;
+    int i;
+
+    for (i = 0; i < 6; i++) {
+        if (fabsf(motion[i] - noise->previous[i]) > (i < 3 ? NOISE_STILL_G : NOISE_STILL_DPS) ||
+            (i >= 3 && fabsf(motion[i] - noiseBias(noise, i)) > NOISE_STILL_TURN)) {
+            still = 0;
+        }
+    }
+    noise->still = still ? noise->still + 1 : 0;
+
+    if (noise->still >= NOISE_STILL_SAMPLES) {
+        for (i = 0; i < 6; i++) {
+            welfordAdd(&noise->change[i], motion[i] - noise->previous[i]);
+            if (i >= 3) {
+                welfordAdd(&noise->level[i], motion[i]);
+            } else if (fabsf(motion[i]) > NOISE_GRAVITY) {
+                welfordAdd(&noise->level[i], motion[i] - (motion[i] > 0 ? 1.0f : -1.0f));
+            }
+        }
+    }
+
+    for (i = 0; i < 6; i++) {
+        noise->previous[i] = motion[i];
+        motion[i] -= noiseBias(noise, i);
+    }
+    noise->samples++;
+    return still;
+}
+
+/*******************************************************************************
+ * @fn          noiseBias
+ *
+ * @brief       Bias of an axis
+ *
+ * @return      The bias in g or deg/s, 0 until NOISE_MIN_COUNT still samples
+ */
+float noiseBias(const Noise *noise, int axis)
+{
+    return noise->level[axis].count >= NOISE_MIN_COUNT ? noise->level[axis].mean : 0;
+}
+
+/*******************************************************************************
+ * @fn          noiseDeviation
+ *
+ * @brief       Standard deviation of the noise of an axis
+ *
+ * @descr       A change from sample to sample is the difference of two
+ *              noises, with twice the variance.
+ *
+ * @return      The deviation in g or deg/s, 0 until NOISE_MIN_COUNT still samples
+ */
+float noiseDeviation(const Noise *noise, int axis)
+{
+    return noise->change[axis].count >= NOISE_MIN_COUNT ? sqrtf(noise->change[axis].variance / 2) : 0;
+}
+
+/*******************************************************************************
+ * @fn          noiseFloors
+ *
+ * @brief       Floors of the ax, ay, az thresholds of the detection
+ *
+ * @descr       A derivate is the change of the smoothed samples divided
+ *              by the period, from the noise alone a normal with the noise
+ *              deviation times the gain of the smoothing and the difference
+ *              (see detectNoiseGain). The floors are margin times its mean
+ *              absolute value.
+ *
+ * @return      -
+ */
+void noiseFloors(const Noise *noise, float samplePeriod, float gain, float margin, float floor[3])
+{
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        floor[i] = margin * NOISE_MEAN_ABS * noiseDeviation(noise, i) * gain / samplePeriod;
+    }
+}
+
+/*******************************************************************************
+ * @fn          welfordAdd
+ *
+ * @brief       Add a value to the mean and variance
+ *
+ * @descr       Welford's update, of the population variance. From
+ *              NOISE_MAX_COUNT values on the count stays, the older
+ *              values are forgotten exponentially.
+ *
+ * @return      -
+ */
+void welfordAdd(Welford *welford, float value)
+{
+    float delta = value - welford->mean;
+
+    if (welford->count < NOISE_MAX_COUNT) {
+        welford->count++;
+    }
+    welford->mean += delta / welford->count;
+    welford->variance += (delta * (value - welford->mean) - welford->variance) / welford->count;
+}
@@ -0,0 +1,70 @@
+/** ============================================================================
+ *  @file       noise.h
+ *
+ *  @brief      Noise and bias of the MPU axes, followed while lying still.
+ *
+ *  The boot calibration measures the biases once, at one temperature, and
+ *  the accelerometer bias is not even loaded to the MPU. Here each axis
+ *  has Welford trackers of its level and of its change from sample to
+ *  sample, updated only while the device has been still for
+ *  NOISE_STILL_SAMPLES samples. The level gives the bias: of a gyro axis
+ *  at rest, of an accelerometer axis against the 1 g it reads while it
+ *  points up or down. The change gives the noise, without the level.
+ *
+ *  A tracker counts up to NOISE_MAX_COUNT samples and then forgets the
+ *  oldest exponentially, so the bias follows the temperature. The samples
+ *  are corrected by the biases once NOISE_MIN_COUNT still samples are in,
+ *  and the detection thresholds kept above the noise (see DetectConfig).
+ *  ============================================================================
+ */
+#ifndef _NOISE_H_
+#define _NOISE_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+// Samples of a tracker before it is used, and before it starts forgetting
+#define NOISE_MIN_COUNT     50
+#define NOISE_MAX_COUNT     600
+#define NOISE_STILL_SAMPLES 10
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    uint32_t count;
+    float mean;
+    float variance;
+} Welford;
+
+typedef struct {
+    Welford level[6];                   // ax, ay, az against 1 g, gx, gy, gz
+    Welford change[6];
+    float previous[6];                  // raw
+    uint32_t still;                     // samples still in a row
+    uint32_t samples;
+} Noise;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void noiseReset(Noise *noise);
+// Follows the raw sample and corrects it by the biases, 1 when still
+int noiseSample(Noise *noise, float motion[6]);
+float noiseBias(const Noise *noise, int axis);
+// Standard deviation of an axis, 0 until known
+float noiseDeviation(const Noise *noise, int axis);
+// margin times the average derivate the noise of ax, ay, az alone gives, 0 until known
+void noiseFloors(const Noise *noise, float samplePeriod, float gain, float margin, float floor[3]);
+
+void welfordAdd(Welford *welford, float value);
+
+#endif
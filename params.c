@@ -0,0 +1,76 @@
+/** ============================================================================
+ *  @file       params.c
+ *
+ *  @brief      Runtime tunable parameters.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include "params.h"
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+#define PARAM_DEFAULT(id, value, min, max) value,
+static volatile float values[PARAM_COUNT] = {
+    PARAMS(PARAM_DEFAULT)
+};
+#undef PARAM_DEFAULT
+
+#define PARAM_LIMITS(id, value, min, max) {min, max},
+static const float limits[PARAM_COUNT][2] = {
+    PARAMS(PARAM_LIMITS)
+};
+#undef PARAM_LIMITS
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          paramGet
+ *
+ * @brief       Current value of a parameter
+ *
+ * @return      The value
+ */
+float paramGet(ParamId id)
+{
+    return values[id];
+}
+
+/*******************************************************************************
+ * @fn          paramSet
+ *
+ * @brief       Change a parameter
+ *
+ * @descr       Values outside the range of the parameter are refused.
+ *
+ * @return      1 if changed
+ */
+int paramSet(ParamId id, float value)
+{
+    if (id >= PARAM_COUNT || !(value >= limits[id][0] && value <= limits[id][1])) {
+        return 0;
+    }
+    values[id] = value;
+    return 1;
+}
+
+/*******************************************************************************
+ * @fn          paramRange
+ *
+ * @brief       Smallest and largest allowed value of a parameter
+ *
+ * @return      -
+ */
+void paramRange(ParamId id, float *min, float *max)
+{
+    *min = limits[id][0];
+    *max = limits[id][1];
+}
@@ -0,0 +1,56 @@
+/** ============================================================================
+ *  @file       params.h
+ *
+ *  @brief      Runtime tunable parameters, shared with host/console.
+ *
+ *  Sampling periods and detection thresholds that can be changed over the
+ *  serial console (see console_format.h) without reflashing. The values
+ *  are floats, read with paramGet() wherever the constant used to be. A
+ *  float is written in one store, so the readers need no locking. Changes
+ *  are lost at reset.
+ *  ============================================================================
+ */
+#ifndef _PARAMS_H_
+#define _PARAMS_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+
+#include "tuned.h"
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+// X(id, default, min, max). Append new parameters, the ids are on the wire.
+// The detection defaults are tuned on recorded traces, see tuned.h.
+#define PARAMS(X) \
+    X(PARAM_SAMPLE_PERIOD_MS,       100,                        20,     1000) \
+    X(PARAM_EXERCISE_THRESHOLD,     TUNED_EXERCISE_THRESHOLD,   0,      100) \
+    X(PARAM_PET_THRESHOLD,          TUNED_PET_THRESHOLD,        0,      100) \
+    X(PARAM_PET_MAX_VERTICAL,       TUNED_PET_MAX_VERTICAL,     0,      100) \
+    X(PARAM_DARK_LUX,               TUNED_DARK_LUX,             0,      1000) \
+    X(PARAM_RELEASE,                0.5,                        0,      1) \
+    X(PARAM_REFRACTORY_MS,          1000,                       0,      60000) \
+    X(PARAM_RHYTHM_AMPLITUDE,       0.3,                        0,      4) \
+    X(PARAM_RHYTHM_PURITY,          0.5,                        0,      1) \
+    X(PARAM_NOISE_MARGIN,           3,                          0,      100)
+
+#define PARAM_ENUM(id, value, min, max) id,
+typedef enum {
+    PARAMS(PARAM_ENUM)
+    PARAM_COUNT
+} ParamId;
+#undef PARAM_ENUM
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+float paramGet(ParamId id);
+int paramSet(ParamId id, float value);
+void paramRange(ParamId id, float *min, float *max);
+
+#endif
@@ -0,0 +1,151 @@
+/** ============================================================================
+ *  @file       probe.c
+ *
+ *  @brief      Cycle counter probes for the hot paths.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <string.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+#include "probe.h"
+
+#ifndef PROBE_EXCLUDE
+
+/* -----------------------------------------------------------------------------
+*  Local types
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint16_t bins[PROBE_BINS];  // saturate at 65535
+} Probe;
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static const char * const probeNames[PROBE_COUNT] = {
+    "mpu", "opt", "filter", "deriv", "send", "buzzer", "rhythm", "attitude"
+};
+
+static Probe probes[PROBE_COUNT];
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+static uint8_t probeLog2(uint32_t value)
+{
+    uint8_t bin = 0;
+
+    while (value > 1) {
+        value >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          probeStop
+ *
+ * @brief       Record the cycles since the mark
+ *
+ * @descr       Use PROBE_STOP, it compiles out with PROBE_EXCLUDE.
+ *
+ * @return      -
+ */
+void probeStop(ProbeId id, const ProbeMark *mark)
+{
+    uint32_t cycles = cyclesNow() - mark->cycles;
+    Probe *p = &probes[id];
+    uint8_t bin;
+    UInt key;
+
+    if (!cyclesRunning() || mark->epoch != cyclesEpoch) {
+        return;
+    }
+    bin = probeLog2(cycles);
+
+    key = Hwi_disable();
+    if (p->count == 0 || cycles < p->min) {
+        p->min = cycles;
+    }
+    if (cycles > p->max) {
+        p->max = cycles;
+    }
+    p->count++;
+    p->total += cycles;
+    if (p->bins[bin] != 0xFFFF) {
+        p->bins[bin]++;
+    }
+    Hwi_restore(key);
+}
+
+/*******************************************************************************
+ * @fn          probeReset
+ *
+ * @brief       Clear all probes
+ *
+ * @return      -
+ */
+void probeReset(void)
+{
+    UInt key = Hwi_disable();
+    memset(probes, 0, sizeof(probes));
+    Hwi_restore(key);
+}
+
+/*******************************************************************************
+ * @fn          probeFormat
+ *
+ * @brief       Format one probe
+ *
+ * @descr       "mpu:n,min,avg,max" in cycles, with histogram nonzero
+ *              "bin:count" pairs follow, e.g. " 14:120 15:3".
+ *
+ * @return      Length of the text, it is cut to fit in size
+ */
+int probeFormat(ProbeId id, char *buf, int size, int histogram)
+{
+    Probe p;
+    int length;
+    uint8_t i;
+    UInt key;
+
+    if (id >= PROBE_COUNT) {
+        buf[0] = 0;
+        return 0;
+    }
+    key = Hwi_disable();
+    p = probes[id];
+    Hwi_restore(key);
+
+    length = snprintf(buf, size, "%s:%lu,%lu,%lu,%lu", probeNames[id],
+                      (unsigned long)p.count, (unsigned long)p.min,
+                      (unsigned long)(p.count ? p.total / p.count : 0),
+                      (unsigned long)p.max);
+    for (i = 0; histogram && i < PROBE_BINS && length < size; i++) {
+        if (p.bins[i]) {
+            length += snprintf(buf + length, size - length, " %u:%u", i, p.bins[i]);
+        }
+    }
+    return length < size ? length : size - 1;
+}
+
+#endif /* PROBE_EXCLUDE */
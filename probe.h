@@ -0,0 +1,82 @@
+/** ============================================================================
+ *  @file       probe.h
+ *
+ *  @brief      Cycle counter probes for the hot paths.
+ *
+ *  PROBE_START(id) and PROBE_STOP(id) around a piece of code record how
+ *  many CPU cycles it took: count, min, average, max and a log2 histogram
+ *  per probe. Build with PROBE_EXCLUDE defined to compile all probes out.
+ *
+ *  The counter stops while the CPU sleeps, so a stage that blocks (I2C,
+ *  Task_sleep) is measured as the awake cycles until it returns, which
+ *  includes whatever ran in between. Samples that span a restart of the
+ *  counter are dropped.
+ *  ============================================================================
+ */
+#ifndef _PROBE_H_
+#define _PROBE_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+#include "cycles.h"
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+typedef enum {
+    PROBE_MPU_READ = 0,     // mpu9250_get_data
+    PROBE_OPT_READ,         // opt3001_get_data
+    PROBE_FILTER,           // filterSample, one call
+    PROBE_DERIVATES,        // the derivates and window sums of a sample
+    PROBE_SEND,             // sendMessage, Send6LoWPAN and the restart of RX
+    PROBE_BUZZER,           // soundPlay
+    PROBE_RHYTHM,           // rhythmSample
+    PROBE_ATTITUDE,         // attitudeSample
+    PROBE_COUNT
+} ProbeId;
+
+// Bin i counts the samples of 2^i to 2^(i+1)-1 cycles
+#define PROBE_BINS 32
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    uint32_t cycles;
+    uint32_t epoch;
+} ProbeMark;
+
+/* -----------------------------------------------------------------------------
+*                                          Macros
+* ------------------------------------------------------------------------------
+*/
+#ifndef PROBE_EXCLUDE
+#define PROBE_START(id) ProbeMark probeMark_##id; probeMark(&probeMark_##id)
+#define PROBE_STOP(id)  probeStop(id, &probeMark_##id)
+#else
+#define PROBE_START(id)
+#define PROBE_STOP(id)
+#endif
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+static inline void probeMark(ProbeMark *mark)
+{
+    if (!cyclesRunning()) {
+        cyclesStart();
+    }
+    mark->epoch = cyclesEpoch;
+    mark->cycles = cyclesNow();
+}
+
+void probeStop(ProbeId id, const ProbeMark *mark);
+void probeReset(void);
+int probeFormat(ProbeId id, char *buf, int size, int histogram);
+
+#endif
@@ -16,9 +16,20 @@
  *
  * Also:
  * Food selection: You can choose to feed the creature a selection of foods.
- * Tap the upper button to cycle through the selections. They have different food values.
+ * Tap the upper button to cycle through the selections, double tap to go back. They have different food values.
  *
  * Data collection: Tap the power button to begin data collection. Do so again to stop collecting.
+ * The session is also logged to the external flash, the gateway command FLASHDUMP offloads it.
+ *
+ * The MPU calibration is saved in the external flash and reused at boot. The gateway command
+ * CALIBRATE makes a new one, keep the device still meanwhile.
+ * Double tap the power button to print the input latency statistics.
+ *
+ * Bench captures: the gateway command STREAM:1 streams the raw samples to the serial port at
+ * 200 Hz, STREAM:0 stops it. host/capture writes them as data.csv.
+ *
+ * Serial console: host/console queries the statistics, changes the sampling period and the
+ * detection thresholds (see params.h), starts a self test and runs benchmarks on the device.
  *
  */
 
@@ -36,6 +47,7 @@
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Semaphore.h>
 #include <ti/drivers/PIN.h>
 #include <ti/drivers/pin/PINCC26XX.h>
 #include <ti/drivers/I2C.h>
@@ -43,20 +55,54 @@
 #include <ti/drivers/Power.h>
 #include <ti/drivers/power/PowerCC26XX.h>
 #include <ti/drivers/UART.h>
+#include <ti/drivers/SPI.h>
+#include <inc/hw_ints.h>
 
 /* Board Header files */
 #include "Board.h"
 #include "wireless/comm_lib.h"
 #include "sensors/opt3001.h"
 #include "sensors/mpu9250.h"
-#include "buzzer.h"
+#include "sound.h"
+#include "led.h"
+#include "events.h"
+#include "buttons.h"
+#include "stackmon.h"
+#include "cpuload.h"
+#include "probe.h"
+#include "serial.h"
+#include "binlog.h"
+#include "flashlog.h"
+#include "calib.h"
+#include "stream.h"
+#include "params.h"
+#include "console.h"
+#include "detect.h"
+#include "attitude.h"
+#include "noise.h"
+
+// Network address of the gateway
+#define GATEWAY_ADDR 0x1234
 
 /* Task */
 #define STACKSIZE 2048
-Char sensorTaskStack[2*STACKSIZE];
+Char sensorTaskStack[STACKSIZE];
 Char uartTaskStack[STACKSIZE];
-Char taskStack[STACKSIZE];
 Char commTaskStack[STACKSIZE];
+// The console only parses short frames
+#define CONSOLE_STACKSIZE 1024
+Char consoleTaskStack[CONSOLE_STACKSIZE];
+
+// Stack usage is reported this often, see stackmon.h
+#define STACK_REPORT_PERIOD_MS 60000
+// CPU load stats frame period, see cpuload.h
+#define LOAD_REPORT_PERIOD_MS 10000
+// Serial port speed, the bench stream needs far more than 9600
+#define SERIAL_BAUD_RATE 921600
+// The log ring is drained to the serial port at least this often
+#define LOG_DRAIN_MS 50
+// Flash log bytes per serial frame, escaped it still fits the serial buffer
+#define FLASH_OFFLOAD_CHUNK 128
 
 // MPU power pin global variables
 static PIN_Handle hMpuPin;
@@ -74,25 +120,43 @@ static const I2CCC26XX_I2CPinCfg i2cMPUCfg = {
     .pinSCL = Board_I2C0_SCL1
 };
 
-// Definition of the state machine
-enum state {BOOTING=1, SHUTTING_DOWN, WAITING, BUTTON_PUSH, POWER_BUTTON_PUSH, FEED, SLEEP, EXERCISE, PET, WARNING, GAME_OVER, SENDING_DATA, NOT_SENDING_DATA};
-enum state programState = BOOTING;
+// States of the tamagotchi. The state machine itself runs in the UART task,
+// everything else only posts events to it (see events.h).
+enum state {WAITING=1, SLEEP, EXERCISE, PET, SENDING_DATA, NOT_SENDING_DATA};
+// Detected by the sensor task during one round of its loop
 enum state petState = WAITING;
+// Owned by the state machine
 enum state dataState = NOT_SENDING_DATA;
+// Set while it is dark, the led breathes until the light returns. Owned by the state machine.
+int sleeping = 0;
 
 // Different foods for the tamagotchi. Each food increases the food level by index + 1.
 char foods[5][11] = {"yogurt", "porridge", "hotdog", "kebabfries", "pizza"};
 // Global variable for the currently selected petFood
 int petFood = 0;
 
+// Flash log readout to the serial port, owned by the state machine
+static FlashlogCursor offloadCursor;
+static int offloading = 0;
+
+// Set by the state machine, the sensor task then calibrates the MPU again
+static volatile int calibrateRequested = 0;
+
+// Raw samples to the serial port at full rate, owned by the state machine
+static volatile int streaming = 0;
+
 // Global variable for system time
 float systemTime = 0.0;
 
-// Global variables for MPU9250 data
-float rawMPUData[7][50];
-float cleanMPUData[7][48];
-float derivates[6][47];
-float averageDerivates[6];
+// Gesture detection on the MPU9250 data, see detect.h
+Detector detector;
+// Noise and bias of the MPU axes, see noise.h. Owned by the sensor task.
+Noise noise;
+
+// Held over every radio command that sends, scans or changes the channel and the restart of RX after it:
+// the sensor task, the state machine and the comm task all use the radio
+static Semaphore_Struct radioLockStruct;
+static Semaphore_Handle radioLock;
 
 // Pins' RTOS-variables and configuration
 static PIN_Handle powerButtonHandle;
@@ -113,14 +177,12 @@ PIN_Config powerButtonWakeConfig[] = {
    Board_BUTTON1 | PIN_INPUT_EN | PIN_PULLUP | PINCC26XX_WAKEUP_NEGEDGE,
    PIN_TERMINATE
 };
-float powerButtonWasPushed = 0.0;
 
 // Other button
 PIN_Config buttonConfig[] = {
    Board_BUTTON0  | PIN_INPUT_EN | PIN_PULLUP | PIN_IRQ_BOTHEDGES,
    PIN_TERMINATE
 };
-float buttonWasPushed = 0.0;
 
 // Red led
 PIN_Config ledConfig[] = {
@@ -128,6 +190,13 @@ PIN_Config ledConfig[] = {
    PIN_TERMINATE
 };
 
+// Button gestures, timed in buttons.c.
+// Short push, long push, double tap, hold-repeat; debounce, long push, double tap and repeat times in ms.
+static const ButtonConfig buttonEvents[] = {
+   {Board_BUTTON1, EVENT_POWER_BUTTON, EVENT_SHUTDOWN, EVENT_POWER_DOUBLE, BUTTON_NO_EVENT, 20, 2000, 250, 0},
+   {Board_BUTTON0, EVENT_BUTTON, EVENT_FEED, EVENT_BUTTON_DOUBLE, BUTTON_NO_EVENT, 20, 1000, 250, 0}
+};
+
 // Buzzer
 PIN_Config buzzerConfig[] = {
    Board_BUZZER | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW | PIN_PUSHPULL | PIN_DRVSTR_MAX,
@@ -180,79 +249,28 @@ float buttonSound[2][3] = {{1000, 100000, 0},
                            {1500, 100000, 0}};
 
 // Calculation functions
-void movavg(float *array, uint8_t array_size, uint8_t window_size, float *averages);
-void calculateDerivates(float *array, uint8_t array_size, float *derivates);
-int checkAverageDerivates(float *averageDerivates);
-void playBuzzer(float sound[][3], int notes);
+void detectConfig(DetectConfig *config);
+void handleEvent(Event *event);
+void updateLedBackground();
 void sendMessage(char *payload);
-
-
-// Power button interruption handler
-Void powerFxn(PIN_Handle handle, PIN_Id pinId) {
-
-    // If button is pushed down
-    if (!PIN_getInputValue(pinId)) {
-        powerButtonWasPushed = systemTime;
-    // If button is released
-    } else if (PIN_getInputValue(pinId)) {
-        // Long push
-        if (systemTime >= powerButtonWasPushed + 2) {
-            programState = SHUTTING_DOWN;
-            System_printf("Shutting down...\n");
-            System_flush();
-        // Short push
-        } else if (systemTime > 1) {
-            programState = POWER_BUTTON_PUSH;
-            if (dataState == NOT_SENDING_DATA) {
-                sendMessage("id:0301,session:start\0");
-                sendMessage("id:0301,session:start\0");
-                sendMessage("id:0301,session:start\0");
-                dataState = SENDING_DATA;
-                System_printf("Data session started\n");
-                System_flush();
-            } else {
-                sendMessage("id:0301,session:end\0");
-                dataState = NOT_SENDING_DATA;
-                System_printf("Data session ended\n");
-                System_flush();
-            }
-
-        }
-    }
-}
-
-
-// Other button interruption handler
-void buttonFxn(PIN_Handle handle, PIN_Id pinId) {
-    char output[80];
-    // If button is pushed down
-    if (!PIN_getInputValue(pinId)) {
-        buttonWasPushed = systemTime;
-    // If button is released
-    } else if (PIN_getInputValue(pinId)) {
-        // Long push
-        if (systemTime >= buttonWasPushed + 2) {
-            sprintf(output, "Feeding... (%s)\n", foods[petFood]);
-            System_printf(output);
-            System_flush();
-            petState = FEED;
-            sprintf(output, "id:0301,EAT:%d,MSG1:Eating\0", petFood+1);
-            sendMessage(output);
-        // Short push
-        } else if (systemTime > 1) {
-            programState = BUTTON_PUSH;
-            petFood++;
-            if (petFood == 5) {
-                petFood = 0;
-            }
-            sprintf(output, "Selected food = %s\n", foods[petFood]);
-            System_printf(output);
-            System_flush();
-            sprintf(output, "id:0301,MSG2:Selected food = %s", foods[petFood]);
-            sendMessage(output);
-        }
-    }
-}
+void scanChannels(int moveToBest);
+void logRecord(FlashlogRecordType type, const float *values, int count);
+void logSession(int started);
+int setupMpu(I2C_Handle *i2cMPU, int useSaved);
+void streamMotion(I2C_Handle *i2cMPU, uint32_t until);
+uint32_t samplePeriod(void);
+void sleepUntil(uint32_t tick);
+int offloadFlash(FlashlogCursor *cursor);
+void benchFilter(void);
+void benchDerivates(void);
+void benchWindow(void);
+void benchFormat(void);
+void benchCrc(void);
+
+// Benchmarks of the serial console, in the order of CONSOLE_BENCHES
+static const ConsoleBenchFxn consoleBenches[CONSOLE_BENCH_COUNT] = {
+    benchFilter, benchDerivates, benchWindow, benchFormat, benchCrc
+};
 
 
 // Data transfer task
@@ -260,8 +278,13 @@ Void commTask(UArg arg0, UArg arg1) {
     char payload[80]; // message buffer
     uint16_t senderAddr;
 
+    // Measure the channel occupancy before starting to receive
+    Semaphore_pend(radioLock, BIOS_WAIT_FOREVER);
+    scanChannels(IEEE80154_CHANNEL_AUTO);
+
     // Initialize radio for receiving
     int32_t result = StartReceive6LoWPAN();
+    Semaphore_post(radioLock);
     if(result != true) {
       System_abort("Wireless receive start failed");
     }
@@ -270,91 +293,70 @@ Void commTask(UArg arg0, UArg arg1) {
     while (1) {
         // If true, there is a message waiting
         if (GetRXFlag()) {
-            // Empty the message buffer
-            memset(payload,0,80);
-            // Read a message to the message buffer
-            Receive6LoWPAN(&senderAddr, payload, 80);
+            // Read a message to the message buffer. Fragmented messages
+            // are reassembled first, so nothing is handled until the last
+            // fragment has arrived.
+            if (ReceiveMessage6LoWPAN(&senderAddr, payload, 80) <= 0) {
+                continue;
+            }
             if (strstr(payload, "301,BEEP:Too late")) {
-                System_printf("Game over\n");
-                System_flush();
-                programState = GAME_OVER;
+                LOG0(LOG_GAME_OVER);
+                eventPost(EVENT_GAME_OVER, 0);
             } else if (strstr(payload, "301,BEEP")) {
-                strcat(payload, "\n");
-                System_printf(payload);
-                System_flush();
-                programState = WARNING;
+                LOG0(LOG_GATEWAY_WARNING);
+                eventPost(EVENT_WARNING, 0);
+            } else if (strstr(payload, "301,CHANNEL:")) {
+                // Gateway moves us to another channel
+                Semaphore_pend(radioLock, BIOS_WAIT_FOREVER);
+                if (SetChannel6LoWPAN(atoi(strstr(payload, "CHANNEL:") + 8))) {
+                    LOG1(LOG_CHANNEL_CHANGED, GetChannel6LoWPAN());
+                }
+                StartReceive6LoWPAN();
+                Semaphore_post(radioLock);
+            } else if (strstr(payload, "301,PROBES")) {
+                eventPost(EVENT_PROBE_DUMP, 0);
+            } else if (strstr(payload, "301,FLASHDUMP")) {
+                eventPost(EVENT_FLASH_DUMP, 0);
+            } else if (strstr(payload, "301,CALIBRATE")) {
+                eventPost(EVENT_CALIBRATE, 0);
+            } else if (strstr(payload, "301,STREAM:")) {
+                eventPost(EVENT_STREAM, atoi(strstr(payload, "STREAM:") + 7) != 0);
+            } else if (strstr(payload, "301,CHSCAN")) {
+                Semaphore_pend(radioLock, BIOS_WAIT_FOREVER);
+                scanChannels(0);
+                StartReceive6LoWPAN();
+                Semaphore_post(radioLock);
             }
         }
     }
 }
 
 
-// UART task
+// UART task, also runs the state machine
 Void uartTaskFxn(UArg arg0, UArg arg1) {
-    char output[80];
-    
-    // UART-library settings
-    UART_Handle uart;
-    UART_Params uartParams;
-    
-    // Initialize serial communication
-    UART_Params_init(&uartParams);
-    uartParams.writeDataMode = UART_DATA_TEXT;
-    uartParams.readDataMode = UART_DATA_TEXT;
-    uartParams.readEcho = UART_ECHO_OFF;
-    uartParams.readMode=UART_MODE_BLOCKING;
-    uartParams.baudRate = 9600; // nopeus 9600baud
-    uartParams.dataLength = UART_LEN_8; // 8
-    uartParams.parityType = UART_PAR_NONE; // n
-    uartParams.stopBits = UART_STOP_ONE; // 1
+    Event event;
     
-    // Open the connection to the serial port of the device in the constant Board_UART0
-    uart = UART_open(Board_UART0, &uartParams);
-    if (uart == NULL) {
-      System_abort("Error opening the UART");
-    }
+    // Open the connection to the serial port of the device in the constant Board_UART0.
+    // Everything written to it is framed, decode it with host/logdec.
+    serialOpen(Board_UART0, SERIAL_BAUD_RATE);
+
+    // Play bootingSound
+    soundPlay(bootingSound, 8);
 
+    // State machine: handle the events in the order they were posted.
+    // The log is drained in between, never in the middle of an event,
+    // and so is a flash log offload.
     while (1) {
-        // Play bootingSound
-        if (programState == BOOTING) {
-            playBuzzer(bootingSound, 8);
-            programState = WAITING;
-        }
-        // Play shutDownSound
-        if (programState == SHUTTING_DOWN) {
-            playBuzzer(shutDownSound, 4);
-            programState = WAITING;
-            sendMessage("id:0301,MSG1:Device turned off\0");
-            // Taikamenot
-            PIN_close(powerButtonHandle);
-            PINCC26XX_setWakeup(powerButtonWakeConfig);
-            Power_shutdown(NULL,0);
-        }
-        // Play warningSound
-        if (programState == WARNING) {
-            playBuzzer(warningSound, 4);
-            sendMessage("id:0301,MSG1:WARNING\0");
-            programState = WAITING;
-        }
-        // Play gameOverSound
-        if (programState == GAME_OVER) {
-            playBuzzer(gameOverSound, 3);
-            sendMessage("id:0301,MSG1:Game over\0");
-            programState = WAITING;
+        if (eventPend(&event, LOG_DRAIN_MS * 1000 / Clock_tickPeriod)) {
+            handleEvent(&event);
         }
-        // Power button short push
-        if (programState == POWER_BUTTON_PUSH) {
-            playBuzzer(powerButtonSound, 2);
-            programState = WAITING;
-        }
-        // Button short push
-        if (programState == BUTTON_PUSH) {
-            playBuzzer(buttonSound, 2);
-            programState = WAITING;
+        binlogDrain();
+        if (offloading) {
+            offloading = offloadFlash(&offloadCursor);
+            if (!offloading) {
+                LOG0(LOG_FLASH_OFFLOAD_DONE);
+            }
         }
-
-        // Once per second, you can modify this
-        Task_sleep(1000000 / Clock_tickPeriod);
     }
 }
 
@@ -364,7 +366,6 @@ Void sensorTaskFxn(UArg arg0, UArg arg1) {
     // General variables
     char output[80] = {0};
     int i = 0;
-    int j = 0;
 
     // MPU9250 variables
     float ax, ay, az, gx, gy, gz;
@@ -373,7 +374,11 @@ Void sensorTaskFxn(UArg arg0, UArg arg1) {
     I2C_Params_init(&i2cMPUParams);
     i2cMPUParams.bitRate = I2C_400kHz;
     i2cMPUParams.custom = (uintptr_t)&i2cMPUCfg;
-    int MPUindex = 0;
+    DetectConfig config;
+    int detected = 0;
+    Attitude attitude;
+    Posture posture = POSTURE_UNKNOWN;
+    Posture sampled;
 
     // OPT3001 variables
     I2C_Handle      i2c;
@@ -384,6 +389,24 @@ Void sensorTaskFxn(UArg arg0, UArg arg1) {
     int earlierTime = 0;
     int OPTindex = 0;
     int isDarkEnough = 0;
+    int asleep = 0;
+
+    // Flash log variables
+    int logging = 0;
+    float light = 0;
+    float motion[6];
+    FlashlogStats flashStats;
+
+    // Bench stream variables
+    int streamOn = 0;
+    Mpu9250Scale scale;
+    StreamStats streamStats;
+    uint32_t nextSample;
+
+    // Boot time variables
+    uint32_t setupTicks = 0;
+    int savedCalibration = 0;
+    int firstSample = 1;
 
     // MPU9250 -SENSOR INITIALIZATION
     i2cMPU = I2C_open(Board_I2C, &i2cMPUParams);
@@ -394,14 +417,11 @@ Void sensorTaskFxn(UArg arg0, UArg arg1) {
     PIN_setOutputValue(hMpuPin,Board_MPU_POWER, Board_MPU_POWER_ON);
     // Wait 100ms for the MPU sensor to power up
 	Task_sleep(100000 / Clock_tickPeriod);
-    System_printf("MPU9250: Power ON\n");
-    System_flush();
-    // MPU setup and calibration
-	System_printf("MPU9250: Setup and calibration...\n");
-	System_flush();
-	mpu9250_setup(&i2cMPU);
-	System_printf("MPU9250: Setup and calibration OK\n");
-	System_flush();
+    LOG0(LOG_MPU_POWER_ON);
+    // MPU setup, with the saved calibration if it still holds
+    setupTicks = Clock_getTicks();
+    savedCalibration = setupMpu(&i2cMPU, 1);
+    setupTicks = Clock_getTicks() - setupTicks;
     I2C_close(i2cMPU);
 
 
@@ -411,15 +431,55 @@ Void sensorTaskFxn(UArg arg0, UArg arg1) {
        System_abort("Error Initializing I2C\n");
     }
     // Setup the OPT3001 sensor for use
-    // Before calling the setup function, insert 100ms delay with Task_sleep
-    Task_sleep(100000 / Clock_tickPeriod);
+    // It needs 100ms from power up, that has passed while the MPU powered up
     opt3001_setup(&i2c);
     I2C_close(i2c);
 
+    // Data sessions are also kept in the external flash, for when the gateway is out of range
+    i = flashlogOpen();
+    flashlogGetStats(&flashStats);
+    LOG4(LOG_FLASHLOG_OPEN, i, flashStats.seq, flashStats.minWear, flashStats.maxWear);
+
     earlierTime = (int)systemTime;
+    nextSample = Clock_getTicks();
+    attitudeReset(&attitude);
+    noiseReset(&noise);
 
     while (1) {
 
+        // A new calibration on request, the device should lie still
+        if (calibrateRequested) {
+            calibrateRequested = 0;
+            i2cMPU = I2C_open(Board_I2C, &i2cMPUParams);
+            if (i2cMPU == NULL) {
+                System_abort("Error Initializing I2CMPU\n");
+            }
+            setupMpu(&i2cMPU, 0);
+            I2C_close(i2cMPU);
+        }
+
+        // Follow the bench stream, the host needs the scale before the samples
+        if (streaming != streamOn) {
+            streamOn = streaming;
+            if (streamOn) {
+                mpu9250_get_scale(&scale);
+                streamScale(&scale);
+            }
+            streamGetStats(&streamStats);
+            LOG3(LOG_STREAM, streamOn, streamStats.sent, streamStats.dropped);
+        }
+
+        // Follow the data session, it is closed with a flush so it is complete in the flash
+        if ((dataState == SENDING_DATA) != logging) {
+            logging = !logging;
+            logSession(logging);
+            if (!logging) {
+                flashlogFlush();
+                flashlogGetStats(&flashStats);
+                LOG2(LOG_FLASHLOG_STATS, flashStats.written, flashStats.dropped);
+            }
+        }
+
         // OPT3001 DATA READ
         if ((int)systemTime == earlierTime+1) { // OPT3001 data is read once per second
             earlierTime = (int)systemTime;
@@ -428,17 +488,27 @@ Void sensorTaskFxn(UArg arg0, UArg arg1) {
                System_abort("Error Initializing I2C\n");
             }
             // Read sensor data and print it to the Debug window as string
+            PROBE_START(PROBE_OPT_READ);
             OPTdata[OPTindex] = opt3001_get_data(&i2c);
+            PROBE_STOP(PROBE_OPT_READ);
 
-            if (dataState == SENDING_DATA) {
+            if (logging) {
                 sprintf(output, "id:0301,light:%.2f", OPTdata[OPTindex]);
                 sendMessage(output);
+                light = OPTdata[OPTindex];
+                logRecord(FLASHLOG_LIGHT, &light, 1);
+            }
+            if (streamOn) {
+                streamLight(OPTdata[OPTindex]);
+                // Again once per second, for a capture started midway
+                mpu9250_get_scale(&scale);
+                streamScale(&scale);
             }
 
             // Check whether it has been dark enough for 5 seconds
             if (OPTindex == 9) {
                 for(i = 0; i < 10; i++) {
-                    if(OPTdata[i] > 5) {
+                    if(OPTdata[i] > paramGet(PARAM_DARK_LUX)) {
                         isDarkEnough = 0;
                         break;
                     } else if (i == 9){
@@ -447,10 +517,9 @@ Void sensorTaskFxn(UArg arg0, UArg arg1) {
                 }
                 if (isDarkEnough) {
                     if (petState != PET) {
-                        System_printf("Sleeping...\n");
-                        System_flush();
-                        sendMessage("id:0301,ACTIVATE:1;1;2,MSG1:ZZZ\0");
                         petState = SLEEP;
+                        asleep = 1;
+                        eventPost(EVENT_SLEEP, 0);
                     }
                     memset(OPTdata, 0, 10);
                     OPTindex = 0;
@@ -459,6 +528,11 @@ Void sensorTaskFxn(UArg arg0, UArg arg1) {
                         OPTdata[i] = OPTdata[i+1];
                     }
                     petState = WAITING;
+                    // Lying face down it sleeps on in the light
+                    if (asleep && posture != POSTURE_FACE_DOWN) {
+                        asleep = 0;
+                        eventPost(EVENT_WAKE, 0);
+                    }
                 }
             } else {
                 OPTindex++;
@@ -474,181 +548,529 @@ Void sensorTaskFxn(UArg arg0, UArg arg1) {
         }
 
         // Get data
+        PROBE_START(PROBE_MPU_READ);
         mpu9250_get_data(&i2cMPU, &ax, &ay, &az, &gx, &gy, &gz);
+        PROBE_STOP(PROBE_MPU_READ);
 
-        if (dataState == SENDING_DATA) {
-            sprintf(output, "id:0301,ax:%.2f,ay:%.2f,az:%.2f,gx:%.2f,gy:%.2f,gz:%.2f\0", ax, ay, az, gx, gy, gz);
-            sendMessage(output);
+        // Boot time, from BIOS_start to the first sample
+        if (firstSample) {
+            firstSample = 0;
+            LOG3(LOG_BOOT_TIME, Clock_getTicks() * Clock_tickPeriod / 1000,
+                 setupTicks * Clock_tickPeriod / 1000, savedCalibration);
         }
 
-        // Raw data into an array
-        rawMPUData[0][MPUindex] = systemTime;
-        rawMPUData[1][MPUindex] = ax;
-        rawMPUData[2][MPUindex] = ay;
-        rawMPUData[3][MPUindex] = az;
-        rawMPUData[4][MPUindex] = gx;
-        rawMPUData[5][MPUindex] = gy;
-        rawMPUData[6][MPUindex] = gz;
-
-        // If the rawMPUData array is full, do some calculations
-        if (MPUindex == 49) {
-
-            // Moving averages
-            for (i = 0; i < 7; i++) {
-                movavg(rawMPUData[i], 50, 3, cleanMPUData[i]);
-            }
-
-            // Derivates
-            for (i = 1; i < 7; i++) {
-                calculateDerivates(cleanMPUData[i], 48, derivates[i-1]);
-            }
+        motion[0] = ax;
+        motion[1] = ay;
+        motion[2] = az;
+        motion[3] = gx;
+        motion[4] = gy;
+        motion[5] = gz;
+        // Corrected by the biases followed while lying still
+        noiseSample(&noise, motion);
+        if (logging) {
+            sprintf(output, "id:0301,ax:%.2f,ay:%.2f,az:%.2f,gx:%.2f,gy:%.2f,gz:%.2f\0",
+                    motion[0], motion[1], motion[2], motion[3], motion[4], motion[5]);
+            sendMessage(output);
+            logRecord(FLASHLOG_MOTION, motion, 6);
+        }
 
-            // Average derivates
-            for (i = 0; i < 6; i++) {
-                movavg(derivates[i], 47, 47, &averageDerivates[i]);
-            }
+        // Gesture detection, the thresholds may change between samples. The time is to the tick,
+        // systemTime only moves once a second.
+        detectConfig(&config);
+        detected = detectSample(&detector, Clock_getTicks() * (Clock_tickPeriod / 1e6f), motion, &config);
+        if (detected & DETECT_EXERCISE) {
+            petState = EXERCISE;
+            eventPost(EVENT_EXERCISE, (uint8_t)(detector.frequency * 10 + 0.5f));
+        }
+        if (detected & DETECT_EXERCISE_END) {
+            eventPost(EVENT_EXERCISE_END, detector.reps < 255 ? detector.reps : 255);
+        }
 
-            // If an average derivate was big enough, 'restart' data collection
-            if (checkAverageDerivates(averageDerivates)) {
-                MPUindex = -1;
-            } else {
-                // If no average derivate was big enough, shift rawMPUData values left and continue data collection
-                for (i = 0; i < 7; i++) {
-                    for (j = 0; j < 49; j++) {
-                        rawMPUData[i][j] = rawMPUData[i][j+1];
-                    }
-                }
+        // Laid face down it sleeps at once, without waiting for the dark
+        sampled = attitudeSample(&attitude, motion, (uint32_t)paramGet(PARAM_SAMPLE_PERIOD_MS));
+        if (sampled != posture) {
+            posture = sampled;
+            LOG1(LOG_POSTURE, posture);
+            if (posture == POSTURE_FACE_DOWN && !asleep && petState != PET) {
+                petState = SLEEP;
+                asleep = 1;
+                eventPost(EVENT_SLEEP, 1);
+            } else if (posture != POSTURE_FACE_DOWN && asleep && !isDarkEnough) {
+                asleep = 0;
+                eventPost(EVENT_WAKE, 0);
             }
-
+        }
+        if (detected & DETECT_PET) {
+            petState = PET;
+            eventPost(EVENT_PET, 0);
         }
 
-        if (MPUindex < 49) {
-            MPUindex++;
+        // The bench stream samples at full rate until the next detection sample is due
+        if (streamOn) {
+            streamMotion(&i2cMPU, nextSample + samplePeriod());
         }
 
         I2C_close(i2cMPU);
 
+        // Full flash log pages go on to the flash
+        flashlogPoll();
 
-        // Play sounds
-        if (petState == FEED)
-            playBuzzer(feedSound, 3);
-        else if (petState == SLEEP)
-            playBuzzer(sleepSound, 3);
-        else if (petState == EXERCISE)
-            playBuzzer(exerciseSound, 4);
-        else if (petState == PET)
-            playBuzzer(petSound, 9);
+        // The state machine plays the sounds, sampling goes on meanwhile
         petState = WAITING;
 
-        // Once per 100ms, you can modify this
-        Task_sleep(100000 / Clock_tickPeriod);
+        // Once per PARAM_SAMPLE_PERIOD_MS, counted from the previous sample so the
+        // work above does not stretch the period. When late, e.g. after a
+        // calibration, the period starts over.
+        nextSample += samplePeriod();
+        if ((int32_t)(nextSample - Clock_getTicks()) < 0) {
+            nextSample = Clock_getTicks();
+        }
+        sleepUntil(nextSample);
     }
 }
 
 
-/* Used for calculating moving average for an array of float numbers.
+/* The detection thresholds, from the runtime parameters and the noise.
  * Parameters:
- * - float *array: Original array.
- * - uint8_t array_size: Size of the original array.
- * - uint8_t window_size: How many numbers' average is calculated.
- * - float *averages: The array were the averaged values are stored.
- *                    Note that the size of this array should be at least
- *                    array_size - window_size + 1.
-*/
-void movavg(float *array, uint8_t array_size, uint8_t window_size, float *averages) {
-    float temp = 0;
-    int i = 0;
-    int j = 0;
+ * - DetectConfig *config: Filled in.
+ */
+void detectConfig(DetectConfig *config) {
+    config->samplePeriod = paramGet(PARAM_SAMPLE_PERIOD_MS) / 1000;
+    config->exercise = paramGet(PARAM_EXERCISE_THRESHOLD);
+    config->pet = paramGet(PARAM_PET_THRESHOLD);
+    config->petMaxVertical = paramGet(PARAM_PET_MAX_VERTICAL);
+    config->release = paramGet(PARAM_RELEASE);
+    config->refractory = paramGet(PARAM_REFRACTORY_MS) / 1000;
+    config->rhythmAmplitude = paramGet(PARAM_RHYTHM_AMPLITUDE);
+    config->rhythmPurity = paramGet(PARAM_RHYTHM_PURITY);
+    noiseFloors(&noise, config->samplePeriod, detectNoiseGain(), paramGet(PARAM_NOISE_MARGIN), config->floor);
+}
+
 
-    for(i = 0; i <= array_size - window_size; i++){
-        for(j = 0, temp = 0; j < window_size; j++) {
-            temp += array[i+j];
+/* Reacts to an event from the queue. Only called by the state machine in the UART task,
+ * so the states it changes need no locking.
+ * Parameters:
+ * - Event *event: The event to handle.
+ */
+void handleEvent(Event *event) {
+    char output[80];
+    // Whole reports, sent in fragments
+    static char report[FRAGMENT_MESSAGE_MAX + 1];
+    int length = 0;
+    int i = 0;
+    EventStats stats;
+    ButtonStats buttonStats;
+
+    switch (event->type) {
+    case EVENT_SHUTDOWN:
+        LOG0(LOG_SHUTDOWN);
+        soundPlay(shutDownSound, 4);
+        sendMessage("id:0301,MSG1:Device turned off\0");
+        // The data session so far goes to the flash before the power does
+        flashlogFlush();
+        // The only place to wait for a sound: nothing else runs after this
+        while (soundPlaying()) {
+            Task_sleep(10000 / Clock_tickPeriod);
+        }
+        // Taikamenot
+        PIN_close(powerButtonHandle);
+        PINCC26XX_setWakeup(powerButtonWakeConfig);
+        Power_shutdown(NULL,0);
+        break;
+    case EVENT_POWER_BUTTON:
+        if (dataState == NOT_SENDING_DATA) {
+            sendMessage("id:0301,session:start\0");
+            sendMessage("id:0301,session:start\0");
+            sendMessage("id:0301,session:start\0");
+            dataState = SENDING_DATA;
+            LOG0(LOG_SESSION_STARTED);
+        } else {
+            sendMessage("id:0301,session:end\0");
+            dataState = NOT_SENDING_DATA;
+            LOG0(LOG_SESSION_ENDED);
         }
-        averages[i] = temp / window_size;
+        updateLedBackground();
+        ledPostPattern(LED_PATTERN_FLASH);
+        soundPlay(powerButtonSound, 2);
+        break;
+    case EVENT_BUTTON:
+        petFood++;
+        if (petFood == 5) {
+            petFood = 0;
+        }
+        LOG1(LOG_FOOD_SELECTED, petFood);
+        sprintf(output, "id:0301,MSG2:Selected food = %s", foods[petFood]);
+        sendMessage(output);
+        ledPostPattern(LED_PATTERN_FLASH);
+        soundPlay(buttonSound, 2);
+        break;
+    case EVENT_BUTTON_DOUBLE:
+        // Back to the previous food
+        petFood = (petFood + 4) % 5;
+        LOG1(LOG_FOOD_SELECTED, petFood);
+        sprintf(output, "id:0301,MSG2:Selected food = %s", foods[petFood]);
+        sendMessage(output);
+        ledPostPattern(LED_PATTERN_FLASH);
+        soundPlay(buttonSound, 2);
+        break;
+    case EVENT_POWER_DOUBLE:
+        // Input statistics since boot
+        eventGetStats(&stats);
+        buttonsGetStats(&buttonStats);
+        LOG4(LOG_EVENT_STATS, stats.handled, stats.dropped,
+             stats.handled ? stats.totalLatencyUs / stats.handled : 0, stats.maxLatencyUs);
+        LOG3(LOG_BUTTON_STATS, buttonStats.edges, buttonStats.bounces, buttonStats.overruns);
+        ledPostPattern(LED_PATTERN_FLASH);
+        break;
+    case EVENT_FEED:
+        LOG1(LOG_FEEDING, petFood);
+        sprintf(output, "id:0301,EAT:%d,MSG1:Eating\0", petFood+1);
+        sendMessage(output);
+        ledPostPattern(LED_PATTERN_FLASH);
+        soundPlay(feedSound, 3);
+        break;
+    case EVENT_SLEEP:
+        LOG0(LOG_SLEEPING);
+        sendMessage("id:0301,ACTIVATE:1;1;2,MSG1:ZZZ\0");
+        sleeping = 1;
+        updateLedBackground();
+        soundPlay(sleepSound, 3);
+        break;
+    case EVENT_WAKE:
+        sleeping = 0;
+        updateLedBackground();
+        break;
+    case EVENT_EXERCISE:
+        LOG1(LOG_EXERCISE_RHYTHM, binlogFloat(event->arg / 10.0f));
+        sendMessage("id:0301,EXERCISE:4,MSG1:Exercising\0");
+        ledPostPattern(LED_PATTERN_FLASH);
+        soundPlay(exerciseSound, 4);
+        break;
+    case EVENT_EXERCISE_END:
+        LOG1(LOG_EXERCISE_DONE, event->arg);
+        sprintf(output, "id:0301,MSG2:%u reps\0", event->arg);
+        sendMessage(output);
+        break;
+    case EVENT_PET:
+        LOG0(LOG_BEING_PET);
+        sendMessage("id:0301,PET:3,MSG1:Being pet\0");
+        ledPostPattern(LED_PATTERN_FLASH);
+        soundPlay(petSound, 9);
+        break;
+    case EVENT_WARNING:
+        ledPostPattern(LED_PATTERN_ALERT);
+        soundPlay(warningSound, 4);
+        sendMessage("id:0301,MSG1:WARNING\0");
+        break;
+    case EVENT_GAME_OVER:
+        ledPostPattern(LED_PATTERN_ALERT);
+        soundPlay(gameOverSound, 3);
+        sendMessage("id:0301,MSG1:Game over\0");
+        break;
+    case EVENT_STACK_REPORT:
+        // Peak stack usage, to the gateway and the serial port
+        length = sprintf(report, "id:0301,STACK:");
+        stackmonReport(report + length, sizeof(report) - length, STACKMON_FORMAT_RADIO);
+        sendMessage(report);
+        length = stackmonReport(report, sizeof(report), STACKMON_FORMAT_TEXT);
+        serialSend(SERIAL_FRAME_TEXT, report, length);
+        break;
+#ifndef PROBE_EXCLUDE
+    case EVENT_PROBE_DUMP:
+        // Cycles per stage: histograms to the serial port, the summaries in one message to the gateway
+        for (i = 0; i < PROBE_COUNT; i++) {
+            length = probeFormat((ProbeId)i, report, sizeof(report) - 1, 1);
+            report[length++] = '\n';
+            serialSend(SERIAL_FRAME_TEXT, report, length);
+        }
+        length = sprintf(report, "id:0301,PROBE:");
+        for (i = 0; i < PROBE_COUNT && length < (int)sizeof(report) - 1; i++) {
+            if (i) {
+                report[length++] = ';';
+            }
+            length += probeFormat((ProbeId)i, report + length, sizeof(report) - length, 0);
+        }
+        sendMessage(report);
+        break;
+#endif
+    case EVENT_CALIBRATE:
+        calibrateRequested = 1;
+        ledPostPattern(LED_PATTERN_FLASH);
+        break;
+    case EVENT_STREAM:
+        streaming = event->arg;
+        ledPostPattern(LED_PATTERN_FLASH);
+        break;
+    case EVENT_FLASH_DUMP:
+        // The flash log is sent in pieces between the events, see uartTaskFxn
+        flashlogRewind(&offloadCursor);
+        offloading = 1;
+        break;
+    case EVENT_LOAD_REPORT:
+        // CPU time shares of the last window, to the gateway and the serial port
+        length = sprintf(report, "id:0301,LOAD:");
+        length += cpuloadReport(report + length, sizeof(report) - length - 1);
+        sendMessage(report);
+        report[length++] = '\n';
+        serialSend(SERIAL_FRAME_TEXT, report, length);
+        break;
+    default:
+        break;
     }
 }
 
 
-/* Used for calculating the difference between each two consecutive
- * values in an array of floats, a.k.a. derivates.
- * Parameters:
- * - float *array: Original array.
- * - uint8_t array_size: Size of the original array.
- * - float *derivates: Array where the derivates are stored.
- *                     Note that the size of this array must be
- *                     at least array_size - 1.
- *
-*/
-void calculateDerivates(float *array, uint8_t array_size, float *derivates) {
-    int i = 0;
+/* Sets the led pattern that shows when nothing else is going on: breathing while
+ * sleeping, a heartbeat during a data session and off otherwise.
+ * Called by the state machine.
+ */
+void updateLedBackground() {
+    if (sleeping) {
+        ledPostPattern(LED_PATTERN_BREATHE);
+    } else if (dataState == SENDING_DATA) {
+        ledPostPattern(LED_PATTERN_HEARTBEAT);
+    } else {
+        ledPostPattern(LED_PATTERN_OFF);
+    }
+}
+
 
-    for(i = 0; i <= array_size - 2; i++){
-        derivates[i] = fabs(array[i+1] - array[i]) / 0.1;
+/* Sends messages to the gateway, those longer than a packet in fragments (see SendBulk6LoWPAN).
+ * Only the first FRAGMENT_MESSAGE_MAX bytes go, the reports are formatted to fit.
+ */
+void sendMessage(char *payload) {
+    size_t length = strlen(payload);
+
+    PROBE_START(PROBE_SEND);
+    Semaphore_pend(radioLock, BIOS_WAIT_FOREVER);
+    SendBulk6LoWPAN(GATEWAY_ADDR, (uint8_t *)payload, length < FRAGMENT_MESSAGE_MAX ? length : FRAGMENT_MESSAGE_MAX);
+    // Note! Radio must always be restored to the receiving state.
+    // Note2! Do not check failure, only check failure when initializing (in commTask).
+    StartReceive6LoWPAN();
+    Semaphore_post(radioLock);
+    PROBE_STOP(PROBE_SEND);
+}
+
+
+/* Sets the MPU9250 up. A saved calibration skips the self test and the bias
+ * measurement, unless the die temperature has changed too much since. Otherwise
+ * the MPU is calibrated and the result saved for the next boots, so the device
+ * should lie still.
+ * Parameters:
+ * - I2C_Handle *i2cMPU: The open I2C interface of the MPU.
+ * - int useSaved: Nonzero to use a saved calibration if there is one.
+ * Returns 1 if a saved calibration was used.
+ */
+int setupMpu(I2C_Handle *i2cMPU, int useSaved) {
+    Mpu9250Calibration calibration;
+    float delta = 0;
+
+    if (useSaved && calibLoad(&calibration)) {
+        mpu9250_setup_calibrated(i2cMPU, &calibration);
+        delta = mpu9250_get_temperature(i2cMPU) - calibration.temperature;
+        if (delta <= CALIB_MAX_TEMP_DELTA && delta >= -CALIB_MAX_TEMP_DELTA) {
+            LOG1(LOG_MPU_CALIBRATION_USED, binlogFloat(calibration.temperature));
+            return 1;
+        }
+        LOG2(LOG_MPU_CALIBRATION_OLD, binlogFloat(calibration.temperature),
+             binlogFloat(calibration.temperature + delta));
     }
+
+    LOG0(LOG_MPU_SETUP);
+    mpu9250_setup(i2cMPU);
+    LOG0(LOG_MPU_SETUP_OK);
+    mpu9250_get_calibration(i2cMPU, &calibration);
+    LOG2(LOG_MPU_CALIBRATION_SAVED, binlogFloat(calibration.temperature), calibSave(&calibration));
+    return 0;
 }
 
 
-/* If any average derivate is big enough, this prints which one of the
- * axes it was and how big was the average derivate value.
+/* Streams raw MPU9250 samples to the serial port at STREAM_RATE_HZ, from now
+ * until the given clock tick.
  * Parameters:
- * - float *averageDerivates: Array containing the average derivate values.
- * Returns:
- * - 1 if any of the average derivates is big enough, 0 otherwise.
+ * - I2C_Handle *i2cMPU: The open I2C interface of the MPU.
+ * - uint32_t until: Clock tick of the next detection sample.
  */
-int checkAverageDerivates(float *averageDerivates) {
-    char output[60];
-    if (averageDerivates[2] > 3) {
-        petState = EXERCISE;
-        System_printf("Exercising...\n");
-        System_flush();
-        sendMessage("id:0301,EXERCISE:4,MSG1:Exercising\0");
+void streamMotion(I2C_Handle *i2cMPU, uint32_t until) {
+    uint32_t period = 1000000 / STREAM_RATE_HZ / Clock_tickPeriod;
+    uint32_t next = Clock_getTicks();
+    int16_t raw[7];
+
+    for (; (int32_t)(until - next) > 0; next += period) {
+        sleepUntil(next);
+        mpu9250_get_raw(i2cMPU, raw);
+        streamImu(raw);
     }
-    if ((averageDerivates[0] > 2 || averageDerivates[1] > 2) && averageDerivates[2] < 1) {
-        petState = PET;
-        System_printf("Being pet...\n");
-        System_flush();
-        sendMessage("id:0301,PET:3,MSG1:Being pet\0");
+}
+
+
+/* Returns the detection sampling period in clock ticks, see PARAM_SAMPLE_PERIOD_MS.
+ */
+uint32_t samplePeriod(void) {
+    return (uint32_t)paramGet(PARAM_SAMPLE_PERIOD_MS) * 1000 / Clock_tickPeriod;
+}
+
+
+/* Sleeps until the given clock tick, or not at all if it has passed.
+ * Parameters:
+ * - uint32_t tick: The clock tick to wake up at.
+ */
+void sleepUntil(uint32_t tick) {
+    int32_t wait = (int32_t)(tick - Clock_getTicks());
+
+    if (wait > 0) {
+        Task_sleep(wait);
     }
-    if (averageDerivates[0] > 2 || averageDerivates[1] > 2 || averageDerivates[2] > 3) {
-        return 1;
-    } else {
-        return 0;
+}
+
+
+/* Appends a sample to the flash log, the clock tick followed by the values.
+ * Parameters:
+ * - FlashlogRecordType type: FLASHLOG_MOTION or FLASHLOG_LIGHT.
+ * - const float *values: The values of the sample.
+ * - int count: How many values there are, at most 6.
+ */
+void logRecord(FlashlogRecordType type, const float *values, int count) {
+    uint8_t record[4 + 6 * sizeof(float)];
+    uint32_t tick = Clock_getTicks();
+
+    memcpy(record, &tick, 4);
+    memcpy(record + 4, values, count * sizeof(float));
+    flashlogAppend(type, record, 4 + count * sizeof(float));
+}
+
+
+/* Marks the start or the end of a data session in the flash log.
+ * Parameters:
+ * - int started: 1 at the start, 0 at the end.
+ */
+void logSession(int started) {
+    uint8_t record[5];
+    uint32_t tick = Clock_getTicks();
+
+    memcpy(record, &tick, 4);
+    record[4] = started;
+    flashlogAppend(FLASHLOG_SESSION, record, sizeof(record));
+}
+
+
+/* Sends the next pieces of the flash log to the serial port, as long as
+ * the serial port takes them. Each frame holds the flash address and the
+ * raw bytes, host/logdec puts them together into a flash image.
+ * Parameters:
+ * - FlashlogCursor *cursor: The position of the offload.
+ * Returns 0 when the whole log has been sent.
+ */
+int offloadFlash(FlashlogCursor *cursor) {
+    uint8_t frame[4 + FLASH_OFFLOAD_CHUNK];
+    FlashlogCursor saved;
+    uint32_t address = 0;
+    uint16_t length = 0;
+
+    while (1) {
+        saved = *cursor;
+        length = flashlogRead(cursor, frame + 4, FLASH_OFFLOAD_CHUNK, &address);
+        if (length == 0) {
+            return 0;
+        }
+        memcpy(frame, &address, 4);
+        if (!serialSend(SERIAL_FRAME_FLASH, frame, 4 + length)) {
+            // No room, the same piece again next time
+            *cursor = saved;
+            return 1;
+        }
     }
 }
 
 
-/* Function that plays all the buzzer sounds. The function also turns on the red led if the
- * tamagotchi is not sleeping.
+/* Scans channels 11-26 and reports their occupancy to the gateway, e.g.
+ * "id:0301,CH:12,CHSCAN:-97;-60;...", one peak RSSI per channel in dBm.
+ * CH is the channel the device uses after the scan.
  * Parameters:
- * - float sound[][3]: Array containing the frequencies, note lengths and pauses between notes.
- * - int notes: The amount of notes in a sound, a.k.a. the number of rows in the sound-array.
+ * - int moveToBest: If nonzero, move to the quietest channel after reporting.
+ * Note! Leaves the radio idle, restart receiving afterwards. Call with radioLock held.
  */
-void playBuzzer(float sound[][3], int notes) {
+void scanChannels(int moveToBest) {
+    int8_t rssi[IEEE80154_CHANNEL_COUNT];
+    char output[120];
+    int best = ScanChannels6LoWPAN(rssi);
+    int channel = GetChannel6LoWPAN();
+    int length = 0;
     int i = 0;
 
-    if (petState != SLEEP){
-        PIN_setOutputValue( ledHandle, Board_LED1, 1 );
+    if (best < 0) {
+        LOG0(LOG_CHANNEL_SCAN_FAILED);
+        return;
+    }
+    if (moveToBest) {
+        channel = best;
     }
 
-    for (i = 0; i < notes; i++) {
-        buzzerOpen(buzzerHandle);
-        buzzerSetFrequency(sound[i][0]);
-        Task_sleep(sound[i][1] / Clock_tickPeriod);
-        buzzerClose();
-        Task_sleep(sound[i][2] / Clock_tickPeriod);
+    length = sprintf(output, "id:0301,CH:%d,CHSCAN:", channel);
+    for (i = 0; i < IEEE80154_CHANNEL_COUNT; i++) {
+        length += sprintf(output + length, i ? ";%d" : "%d", rssi[i]);
     }
+    // Reported on the old channel, so the gateway can follow
+    Send6LoWPAN(GATEWAY_ADDR, (uint8_t *)output, length);
 
-    PIN_setOutputValue( ledHandle, Board_LED1, 0 );
+    if (channel != GetChannel6LoWPAN()) {
+        SetChannel6LoWPAN(channel);
+    }
 }
 
 
-// Sends messages to the gateway.
-void sendMessage(char *payload) {
-    uint16_t DestAddr = 0x1234;
-    Send6LoWPAN(DestAddr, payload, strlen(payload));
-    // Note! Radio must always be restored to the receiving state.
-    // Note2! Do not check failure, only check failure when initializing (in commTask).
-    StartReceive6LoWPAN();
+// States of the benchmarks, the input is the last sample of the live detection
+static BiquadState benchStates[DETECT_SECTIONS];
+static float benchValue;
+static float benchSlopes[DETECT_SLOPES];
+static DetectSums benchSums;
+static int benchIndex;
+static Detector benchDetector;
+static DetectConfig benchConfig;
+static char benchOutput[80];
+static uint16_t benchChecksum;
+
+/* Serial console benchmark: the smoothing of one axis.
+ */
+void benchFilter(void) {
+    benchValue = filterSample(detectSections, DETECT_SECTIONS, benchStates, detector.filtered[2]);
+}
+
+
+/* Serial console benchmark: a derivate of one axis into the window, the sums summed over again once a round.
+ */
+void benchDerivates(void) {
+    detectSlide(benchSlopes, DETECT_SLOPES, benchIndex, benchValue, &benchSums);
+    benchIndex = benchIndex == DETECT_SLOPES - 1 ? 0 : benchIndex + 1;
+}
+
+
+/* Serial console benchmark: a sample through a detector of its own, from the live one, as in
+ * sensorTaskFxn once the window is full.
+ */
+void benchWindow(void) {
+    if (benchDetector.samples < DETECT_WINDOW) {
+        benchDetector = detector;
+        benchDetector.samples = DETECT_WINDOW;
+        detectConfig(&benchConfig);
+    }
+    detectSample(&benchDetector, Clock_getTicks() * (Clock_tickPeriod / 1e6f), detector.filtered, &benchConfig);
+}
+
+
+/* Serial console benchmark: formatting a motion message for the radio.
+ */
+void benchFormat(void) {
+    sprintf(benchOutput, "id:0301,ax:%.2f,ay:%.2f,az:%.2f,gx:%.2f,gy:%.2f,gz:%.2f",
+            detector.filtered[0], detector.filtered[1], detector.filtered[2],
+            detector.filtered[3], detector.filtered[4], detector.filtered[5]);
+}
+
+
+/* Serial console benchmark: the CRC of a 64 byte serial frame.
+ */
+void benchCrc(void) {
+    benchChecksum = serialCrc16(0xFFFF, (const uint8_t *)detector.derivates, 64);
 }
 
 
@@ -667,12 +1089,23 @@ Int main(void) {
     Task_Params uartTaskParams;
     Task_Handle commTaskHandle;
     Task_Params commTaskParams;
+    Task_Handle consoleTaskHandle;
+    Task_Params consoleTaskParams;
 
     // Initialize board
     Board_initGeneral();
     Init6LoWPAN();
     Board_initI2C();
     Board_initUART();
+    Board_initSPI();
+    eventsOpen();
+
+    // The radio lock, free
+    Semaphore_Params semParams;
+    Semaphore_Params_init(&semParams);
+    semParams.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&radioLockStruct, 1, &semParams);
+    radioLock = Semaphore_handle(&radioLockStruct);
     
     // CLOCK INITIALIZATION
     // RTOS's clock variables
@@ -689,11 +1122,12 @@ Int main(void) {
     }
 
     // Open the button and led pins
+    buttonsOpen(buttonEvents, sizeof(buttonEvents) / sizeof(buttonEvents[0]));
     powerButtonHandle = PIN_open(&powerButtonState, powerButtonConfig);
     if (!powerButtonHandle) {
        System_abort("Error initializing power button\n");
     }
-    if (PIN_registerIntCb(powerButtonHandle, &powerFxn) != 0) {
+    if (PIN_registerIntCb(powerButtonHandle, &buttonsPinFxn) != 0) {
        System_abort("Error registering power button callback");
     }
 
@@ -701,7 +1135,7 @@ Int main(void) {
     if (!buttonHandle) {
       System_abort("Error initializing button pins\n");
     }
-    if (PIN_registerIntCb(buttonHandle, &buttonFxn) != 0) {
+    if (PIN_registerIntCb(buttonHandle, &buttonsPinFxn) != 0) {
       System_abort("Error registering button callback function");
     }
 
@@ -709,12 +1143,14 @@ Int main(void) {
     if (!ledHandle) {
       System_abort("Error initializing LED pins\n");
     }
+    ledOpen(ledHandle, Board_LED1);
 
     // Open buzzer pin
     buzzerHandle = PIN_open(&buzzerState, buzzerConfig);
     if (buzzerHandle == NULL) {
         System_abort("Error initializing buzzer pin\n");
     }
+    soundOpen(buzzerHandle);
 
     // Open MPU power pin
     hMpuPin = PIN_open(&MpuPinState, MpuPinConfig);
@@ -731,15 +1167,20 @@ Int main(void) {
     if (sensorTaskHandle == NULL) {
         System_abort("Task create failed!");
     }
+    stackmonAdd(sensorTaskHandle, "sensor");
+    cpuloadAddTask(sensorTaskHandle, "sensor");
     
     Task_Params_init(&uartTaskParams);
     uartTaskParams.stackSize = STACKSIZE;
     uartTaskParams.stack = &uartTaskStack;
-    uartTaskParams.priority=2;
+    // Above the sensor task, so events are handled as soon as they are posted
+    uartTaskParams.priority=3;
     uartTaskHandle = Task_create(uartTaskFxn, &uartTaskParams, NULL);
     if (uartTaskHandle == NULL) {
         System_abort("Task create failed!");
     }
+    stackmonAdd(uartTaskHandle, "uart");
+    cpuloadAddTask(uartTaskHandle, "uart");
 
     Task_Params_init(&commTaskParams);
     commTaskParams.stackSize = STACKSIZE;
@@ -749,10 +1190,30 @@ Int main(void) {
     if (commTaskHandle == NULL) {
         System_abort("Task create failed!");
     }
+    stackmonAdd(commTaskHandle, "comm");
+    cpuloadAddTask(commTaskHandle, "comm");
+
+    consoleOpen(consoleBenches);
+    Task_Params_init(&consoleTaskParams);
+    consoleTaskParams.stackSize = CONSOLE_STACKSIZE;
+    consoleTaskParams.stack = &consoleTaskStack;
+    // Above the busy polling comm task, the benchmarks must not hold up the state machine
+    consoleTaskParams.priority=2;
+    consoleTaskHandle = Task_create(consoleTaskFxn, &consoleTaskParams, NULL);
+    if (consoleTaskHandle == NULL) {
+        System_abort("Task create failed!");
+    }
+    stackmonAdd(consoleTaskHandle, "console");
+    cpuloadAddTask(consoleTaskHandle, "console");
+    stackmonOpen(STACK_REPORT_PERIOD_MS);
+
+    // The radio interrupts get their own shares
+    cpuloadAddIsr(INT_RFC_CPE_0, "cpe0");
+    cpuloadAddIsr(INT_RFC_CPE_1, "cpe1");
+    cpuloadOpen(LOAD_REPORT_PERIOD_MS);
 
     /* Sanity check */
-    System_printf("Hello world!\n");
-    System_flush();
+    LOG0(LOG_BOOT);
     
     /* Start BIOS */
     BIOS_start();
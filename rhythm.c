@@ -0,0 +1,216 @@
+/** ============================================================================
+ *  @file       rhythm.c
+ *
+ *  @brief      Rhythm of the shaking, for the exercise detection.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <math.h>
+#include <string.h>
+
+#include "rhythm.h"
+#include "probe.h"
+
+/* -----------------------------------------------------------------------------
+*  Constants
+* ------------------------------------------------------------------------------
+*/
+// Below 1 the sliding DFT forgets the rounding errors, RHYTHM_DAMPING_N is its RHYTHM_POINTS:th power
+#define RHYTHM_DAMPING      0.999f
+#define RHYTHM_DAMPING_N    0.9607702f
+
+// cos and sin of 2 pi k / RHYTHM_POINTS
+static const float twiddles[RHYTHM_BINS][2] = {
+    {1.0000000f, 0.0000000f},
+    {0.9876883f, 0.1564345f},
+    {0.9510565f, 0.3090170f},
+    {0.8910065f, 0.4539905f},
+    {0.8090170f, 0.5877853f},
+    {0.7071068f, 0.7071068f},
+    {0.5877853f, 0.8090170f},
+    {0.4539905f, 0.8910065f},
+    {0.3090170f, 0.9510565f},
+    {0.1564345f, 0.9876883f},
+    {0.0000000f, 1.0000000f},
+    {-0.1564345f, 0.9876883f},
+    {-0.3090170f, 0.9510565f},
+    {-0.4539905f, 0.8910065f},
+    {-0.5877853f, 0.8090170f},
+    {-0.7071068f, 0.7071068f},
+    {-0.8090170f, 0.5877853f},
+    {-0.8910065f, 0.4539905f},
+    {-0.9510565f, 0.3090170f},
+    {-0.9876883f, 0.1564345f}
+};
+
+/* -----------------------------------------------------------------------------
+*  Local Functions
+* ------------------------------------------------------------------------------
+*/
+static float energy(const Rhythm *rhythm, int signal, int bin)
+{
+    return rhythm->re[signal][bin] * rhythm->re[signal][bin] + rhythm->im[signal][bin] * rhythm->im[signal][bin];
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          rhythmReset
+ *
+ * @brief       Empty the window, and place the band at the sample period
+ *
+ * @return      -
+ */
+void rhythmReset(Rhythm *rhythm, float samplePeriod)
+{
+    memset(rhythm, 0, sizeof(*rhythm));
+    rhythm->period = samplePeriod;
+    rhythm->first = (int)ceilf(RHYTHM_MIN_HZ * RHYTHM_POINTS * samplePeriod);
+    rhythm->last = (int)(RHYTHM_MAX_HZ * RHYTHM_POINTS * samplePeriod);
+    if (rhythm->first < 1) {
+        rhythm->first = 1;
+    }
+    // The neighbours of the band are needed too
+    if (rhythm->last > RHYTHM_BINS - 2) {
+        rhythm->last = RHYTHM_BINS - 2;
+    }
+    // No band at all when sampled slower than twice a second
+    if (rhythm->first > rhythm->last) {
+        rhythm->first = 1;
+        rhythm->last = 0;
+    }
+}
+
+/*******************************************************************************
+ * @fn          rhythmSample
+ *
+ * @brief       Add a sample to the window and find its rhythm
+ *
+ * @descr       The peak, its amplitude in g and its share of the band
+ *              energy are left in the Rhythm, for the stronger of z and the
+ *              magnitude. The window starts over if the sample period has
+ *              changed.
+ *
+ * @return      1 if the peak is at least minAmplitude and minPurity
+ */
+int rhythmSample(Rhythm *rhythm, const float motion[6], float samplePeriod, float minAmplitude, float minPurity)
+{
+    float x[RHYTHM_SIGNALS];
+    float delta, re, mean, e, band, peak, best = -1;
+    int count, s, k, top;
+    PROBE_START(PROBE_RHYTHM);
+
+    if (rhythm->period != samplePeriod) {
+        rhythmReset(rhythm, samplePeriod);
+    }
+    count = rhythm->samples < RHYTHM_POINTS ? rhythm->samples + 1 : RHYTHM_POINTS;
+
+    x[0] = motion[2];
+    x[1] = sqrtf(motion[0] * motion[0] + motion[1] * motion[1] + motion[2] * motion[2]);
+
+    for (s = 0; s < RHYTHM_SIGNALS; s++) {
+        // S(n) = r e^(j 2 pi k / N) (S(n - 1) + x(n) - r^N x(n - N)), for the band and its neighbours
+        delta = x[s] - RHYTHM_DAMPING_N * rhythm->history[s][rhythm->pos];
+        rhythm->sum[s] += x[s] - rhythm->history[s][rhythm->pos];
+        rhythm->history[s][rhythm->pos] = x[s];
+        for (k = rhythm->first - 1; k <= rhythm->last + 1; k++) {
+            re = rhythm->re[s][k] + delta;
+            rhythm->re[s][k] = RHYTHM_DAMPING * (twiddles[k][0] * re - twiddles[k][1] * rhythm->im[s][k]);
+            rhythm->im[s][k] = RHYTHM_DAMPING * (twiddles[k][1] * re + twiddles[k][0] * rhythm->im[s][k]);
+        }
+
+        // A crossing of the window mean
+        mean = rhythm->sum[s] / count;
+        if (!rhythm->high[s] && x[s] > mean + minAmplitude / 2) {
+            rhythm->high[s] = 1;
+            rhythm->crossingAt[s][rhythm->crossings[s] % RHYTHM_CROSSINGS] = rhythm->samples;
+            rhythm->crossings[s]++;
+        } else if (rhythm->high[s] && x[s] < mean - minAmplitude / 2) {
+            rhythm->high[s] = 0;
+        }
+
+        // The peak with its neighbours, of the band and its neighbours
+        top = rhythm->first;
+        band = 0;
+        for (k = rhythm->first - 1; k <= rhythm->last + 1; k++) {
+            e = energy(rhythm, s, k);
+            band += e;
+            if (k >= rhythm->first && k <= rhythm->last && e > energy(rhythm, s, top)) {
+                top = k;
+            }
+        }
+        peak = energy(rhythm, s, top - 1) + energy(rhythm, s, top) + energy(rhythm, s, top + 1);
+        if (peak > best) {
+            best = peak;
+            rhythm->signal = s;
+            rhythm->peak = top;
+            rhythm->amplitude = 2 * sqrtf(peak) / RHYTHM_POINTS;
+            rhythm->purity = band > 0 ? peak / band : 0;
+        }
+    }
+    rhythm->pos = (rhythm->pos + 1) % RHYTHM_POINTS;
+    rhythm->samples++;
+
+    PROBE_STOP(PROBE_RHYTHM);
+    // A step, e.g. when turned over, leaks most into the lowest bins with no peak in the band
+    s = rhythm->signal;
+    return rhythm->first <= rhythm->last && energy(rhythm, s, rhythm->peak) >= energy(rhythm, s, rhythm->peak - 1) &&
+           rhythm->amplitude >= minAmplitude && rhythm->purity >= minPurity;
+}
+
+/*******************************************************************************
+ * @fn          rhythmFrequency
+ *
+ * @brief       Frequency of the peak
+ *
+ * @descr       Between the bins, from a parabola through the peak and its
+ *              neighbours.
+ *
+ * @return      The frequency in Hz
+ */
+float rhythmFrequency(const Rhythm *rhythm)
+{
+    float below = sqrtf(energy(rhythm, rhythm->signal, rhythm->peak - 1));
+    float at = sqrtf(energy(rhythm, rhythm->signal, rhythm->peak));
+    float above = sqrtf(energy(rhythm, rhythm->signal, rhythm->peak + 1));
+    float curve = 2 * at - below - above;
+    float offset = curve > 0 ? (above - below) / (2 * curve) : 0;
+
+    // At most half a bin, the peak is the strongest bin
+    if (offset > 0.5f) {
+        offset = 0.5f;
+    } else if (offset < -0.5f) {
+        offset = -0.5f;
+    }
+
+    return (rhythm->peak + offset) / (RHYTHM_POINTS * rhythm->period);
+}
+
+/*******************************************************************************
+ * @fn          rhythmWindowCrossings
+ *
+ * @brief       Crossings of the signal within the window
+ *
+ * @return      The number of upward crossings of the mean
+ */
+uint32_t rhythmWindowCrossings(const Rhythm *rhythm, int signal)
+{
+    uint32_t count = 0;
+    uint32_t i;
+
+    for (i = 0; i < rhythm->crossings[signal] && i < RHYTHM_CROSSINGS; i++) {
+        if (rhythm->samples - rhythm->crossingAt[signal][(rhythm->crossings[signal] - 1 - i) % RHYTHM_CROSSINGS]
+            > RHYTHM_POINTS) {
+            break;
+        }
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,77 @@
+/** ============================================================================
+ *  @file       rhythm.h
+ *
+ *  @brief      Rhythm of the shaking, for the exercise detection.
+ *
+ *  A sliding DFT over the last RHYTHM_POINTS samples of the vertical (z)
+ *  acceleration and of the magnitude of the acceleration. Each sample
+ *  updates the bins of 1 to 5 Hz in place, a rotation and two additions a
+ *  bin, instead of a transform of the window. The motion is rhythmic when
+ *  the strongest bin with its neighbours holds most of the energy of the
+ *  band and its amplitude is big enough; a single jolt spreads over the
+ *  band, and a step such as turning over leaks into its lowest bins. The repetitions are counted on each signal as crossings of its
+ *  window mean, with hysteresis.
+ *
+ *  At the sample period of 100 ms the bins are 0.25 Hz apart and the band
+ *  ends at 4.5 Hz, its upper neighbour below half the sample rate. The
+ *  window starts over when the sample period changes.
+ *  ============================================================================
+ */
+#ifndef _RHYTHM_H_
+#define _RHYTHM_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+#define RHYTHM_POINTS       40
+#define RHYTHM_BINS         (RHYTHM_POINTS / 2)
+#define RHYTHM_MIN_HZ       1.0f
+#define RHYTHM_MAX_HZ       5.0f
+// z and the magnitude
+#define RHYTHM_SIGNALS      2
+// The last crossings kept, at least those of a window at RHYTHM_MAX_HZ
+#define RHYTHM_CROSSINGS    32
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    float history[RHYTHM_SIGNALS][RHYTHM_POINTS];
+    float re[RHYTHM_SIGNALS][RHYTHM_BINS];
+    float im[RHYTHM_SIGNALS][RHYTHM_BINS];
+    float sum[RHYTHM_SIGNALS];          // of the window
+    int pos;                            // of the oldest sample in history
+    uint32_t samples;
+    float period;                       // s
+    int first;                          // bins of the band, from the sample period
+    int last;
+    // The strongest signal of the last sample
+    int signal;
+    int peak;                           // bin
+    float amplitude;                    // g
+    float purity;                       // of the band energy in the peak
+    // Crossings of the window mean
+    int high[RHYTHM_SIGNALS];
+    uint32_t crossings[RHYTHM_SIGNALS];
+    uint32_t crossingAt[RHYTHM_SIGNALS][RHYTHM_CROSSINGS];
+} Rhythm;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void rhythmReset(Rhythm *rhythm, float samplePeriod);
+// 1 when the motion is rhythmic
+int rhythmSample(Rhythm *rhythm, const float motion[6], float samplePeriod, float minAmplitude, float minPurity);
+float rhythmFrequency(const Rhythm *rhythm);
+// Crossings of the signal within the window
+uint32_t rhythmWindowCrossings(const Rhythm *rhythm, int signal);
+
+#endif
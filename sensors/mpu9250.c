@@ -18,6 +18,7 @@
 
 #include "Board.h"
 #include "mpu9250.h"
+#include "binlog.h"
 
 #define PI	3.14159265
 
@@ -99,9 +100,8 @@ void writeByte(uint8_t reg, uint8_t data) {
     i2cTransaction.readCount = 0;
 
     if (!I2C_transfer(i2c, &i2cTransaction)) {
-    	System_printf("MPU9250: write=%x data=%x FAILED\n",reg,data);
+    	LOG2(LOG_MPU_WRITE_FAILED, reg, data);
     }
-    System_flush();
 }
 
 void readByte(uint8_t reg, uint8_t count, uint8_t *data) {
@@ -117,9 +117,8 @@ void readByte(uint8_t reg, uint8_t count, uint8_t *data) {
     i2cTransaction.readCount = count;
 
     if (!I2C_transfer(i2c, &i2cTransaction)) {
-    	System_printf("MPU9250: read=%x count=%x FAILED\n",reg,count);
+    	LOG2(LOG_MPU_READ_FAILED, reg, count);
     }
-    System_flush();
 }
 
 void delay(uint16_t delay) {
@@ -173,8 +172,7 @@ void mpu9250_setup(I2C_Handle *i2c_orig) {
 
 	i2c = *i2c_orig;
 
-	System_printf("MPU9250: Setup start...\n");
-	System_flush();
+	LOG0(LOG_MPU_SETUP_START);
 
 	// Read the WHO_AM_I register, this is a good test of communication
 	// uint8_t c;
@@ -194,8 +192,7 @@ void mpu9250_setup(I2C_Handle *i2c_orig) {
 	initMPU9250();
 	delay(100);
 
-	System_printf("MPU9250: Setup OK\n");
-	System_flush();
+	LOG0(LOG_MPU_SETUP_DONE);
 }
 
 void initMPU9250() {
@@ -521,3 +518,92 @@ void mpu9250_get_data(I2C_Handle *i2c, float *ax, float *ay, float *az, float *g
 	*gy = my*gRes;
 	*gz = mz*gRes;
 }
+
+#define TEMP_OUT_H       0x41
+
+// Quick setup with the results of an earlier mpu9250_setup, skips the self test
+// and the bias measurement. The gyro offset registers are cleared by a power
+// cycle, so they are written again.
+void mpu9250_setup_calibrated(I2C_Handle *i2c_orig, const Mpu9250Calibration *calibration) {
+
+	uint8_t i;
+
+	i2c = *i2c_orig;
+
+	for (i = 0; i < 3; i++) {
+		gyroBias[i] = calibration->gyroBias[i];
+		accelBias[i] = calibration->accelBias[i];
+	}
+	for (i = 0; i < 6; i++) {
+		SelfTest[i] = calibration->selfTest[i];
+	}
+
+	getAres();
+	getGres();
+
+	initMPU9250();
+
+	for (i = 0; i < 3; i++) {
+		writeByte(XG_OFFSET_H + 2 * i, (calibration->gyroOffset[i] >> 8) & 0xFF);
+		writeByte(XG_OFFSET_L + 2 * i, calibration->gyroOffset[i] & 0xFF);
+	}
+}
+
+// Results of the last setup, for mpu9250_setup_calibrated
+void mpu9250_get_calibration(I2C_Handle *i2c_orig, Mpu9250Calibration *calibration) {
+
+	uint8_t rawData[6];
+	uint8_t i;
+
+	i2c = *i2c_orig;
+
+	for (i = 0; i < 3; i++) {
+		calibration->gyroBias[i] = gyroBias[i];
+		calibration->accelBias[i] = accelBias[i];
+	}
+	for (i = 0; i < 6; i++) {
+		calibration->selfTest[i] = SelfTest[i];
+	}
+	readByte(XG_OFFSET_H, 6, rawData);
+	for (i = 0; i < 3; i++) {
+		calibration->gyroOffset[i] = (rawData[2 * i] << 8) | rawData[2 * i + 1];
+	}
+	calibration->temperature = mpu9250_get_temperature(i2c_orig);
+}
+
+// Die temperature in C
+float mpu9250_get_temperature(I2C_Handle *i2c_orig) {
+
+	uint8_t rawData[2];
+
+	i2c = *i2c_orig;
+
+	readByte(TEMP_OUT_H, 2, rawData);
+	return (int16_t)((rawData[0] << 8) | rawData[1]) / 333.87 + 21.0;
+}
+
+// Raw sample: accel x y z, temperature, gyro x y z
+void mpu9250_get_raw(I2C_Handle *i2c_orig, int16_t raw[7]) {
+
+	uint8_t rawData[14];
+	uint8_t i;
+
+	i2c = *i2c_orig;
+
+	readByte(ACCEL_XOUT_H, 14, rawData);
+	for (i = 0; i < 7; i++) {
+		raw[i] = (rawData[2 * i] << 8) | rawData[2 * i + 1];
+	}
+}
+
+// Scale of the raw samples with the current setup
+void mpu9250_get_scale(Mpu9250Scale *scale) {
+
+	uint8_t i;
+
+	scale->aRes = aRes;
+	scale->gRes = gRes;
+	for (i = 0; i < 3; i++) {
+		scale->accelBias[i] = accelBias[i];
+	}
+}
@@ -12,9 +12,31 @@
 #ifndef MPU9250_H_
 #define MPU9250_H_
 
+#include <stdint.h>
 #include <ti/drivers/I2C.h>
 
+// Results of mpu9250_setup, enough to set the sensor up again without it
+typedef struct {
+	float gyroBias[3];		// deg/s
+	float accelBias[3];		// g
+	float selfTest[6];		// % deviation from the factory trim, accel xyz and gyro xyz
+	int16_t gyroOffset[3];	// gyro offset registers
+	float temperature;		// die temperature during the calibration, C
+} Mpu9250Calibration;
+
+// Converts raw samples like mpu9250_get_data: a = raw * aRes - accelBias, g = raw * gRes
+typedef struct {
+	float aRes;				// g per LSB
+	float gRes;				// deg/s per LSB
+	float accelBias[3];		// g
+} Mpu9250Scale;
+
 void mpu9250_setup(I2C_Handle *i2c);
+void mpu9250_setup_calibrated(I2C_Handle *i2c, const Mpu9250Calibration *calibration);
+void mpu9250_get_calibration(I2C_Handle *i2c, Mpu9250Calibration *calibration);
+float mpu9250_get_temperature(I2C_Handle *i2c);
+void mpu9250_get_raw(I2C_Handle *i2c, int16_t raw[7]);
+void mpu9250_get_scale(Mpu9250Scale *scale);
 void mpu9250_get_data(I2C_Handle *i2c, float *ax, float *ay, float *az, float *gx, float *gy, float *gz);
 
 #endif /* MPU9250_H_ */
@@ -15,6 +15,7 @@
 
 #include "sensors/opt3001.h"
 #include "Board.h"
+#include "binlog.h"
 
 void opt3001_setup(I2C_Handle *i2c) {
 
@@ -30,13 +31,7 @@ void opt3001_setup(I2C_Handle *i2c) {
     i2cTransaction.readBuf = NULL;
     i2cTransaction.readCount = 0;
 
-    if (I2C_transfer(*i2c, &i2cTransaction)) {
-
-        System_printf("OPT3001: Config write ok\n");
-    } else {
-        System_printf("OPT3001: Config write failed!\n");
-    }
-    System_flush();
+    LOG1(LOG_OPT_CONFIG, I2C_transfer(*i2c, &i2cTransaction) ? 1 : 0);
 
 }
 
@@ -101,8 +96,7 @@ double opt3001_get_data(I2C_Handle *i2c) {
 
 		} else {
 
-			System_printf("OPT3001: Data read failed!\n");
-			System_flush();
+			LOG0(LOG_OPT_READ_FAILED);
 		}
 
 	} else {
@@ -0,0 +1,255 @@
+/** ============================================================================
+ *  @file       serial.c
+ *
+ *  @brief      Framed, non-blocking serial port output and framed input.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/drivers/UART.h>
+
+#include "Board.h"
+#include "serial.h"
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static UART_Handle hUart = NULL;
+
+// Head is only moved by the senders, tail and busy by the write callback
+static uint8_t txBuf[SERIAL_TX_BUFFER];
+static volatile uint16_t txHead = 0;
+static volatile uint16_t txTail = 0;
+static volatile uint16_t txInFlight = 0;
+static volatile uint8_t txBusy = 0;
+
+static SerialStats stats;
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+static uint16_t serialEscapedLength(const uint8_t *data, uint16_t length)
+{
+    uint16_t escaped = length;
+
+    while (length--) {
+        if (*data == SERIAL_FLAG || *data == SERIAL_ESCAPE) {
+            escaped++;
+        }
+        data++;
+    }
+    return escaped;
+}
+
+// Call with interrupts disabled, the room has been checked
+static void serialPut(const uint8_t *data, uint16_t length)
+{
+    while (length--) {
+        if (*data == SERIAL_FLAG || *data == SERIAL_ESCAPE) {
+            txBuf[txHead++ % SERIAL_TX_BUFFER] = SERIAL_ESCAPE;
+            txBuf[txHead++ % SERIAL_TX_BUFFER] = *data ^ SERIAL_ESCAPE_XOR;
+        } else {
+            txBuf[txHead++ % SERIAL_TX_BUFFER] = *data;
+        }
+        data++;
+    }
+}
+
+// Starts a write of the next contiguous piece of the ring, if idle
+static void serialKick(void)
+{
+    uint16_t start;
+    uint16_t count;
+    UInt key;
+
+    key = Hwi_disable();
+    if (txBusy || txHead == txTail) {
+        Hwi_restore(key);
+        return;
+    }
+    start = txTail % SERIAL_TX_BUFFER;
+    count = txHead - txTail;
+    if (start + count > SERIAL_TX_BUFFER) {
+        count = SERIAL_TX_BUFFER - start;
+    }
+    txBusy = 1;
+    txInFlight = count;
+    Hwi_restore(key);
+
+    UART_write(hUart, &txBuf[start], count);
+}
+
+// UART write callback
+static void serialWriteDone(UART_Handle handle, void *buf, size_t count)
+{
+    UInt key = Hwi_disable();
+    txTail += txInFlight;
+    txBusy = 0;
+    Hwi_restore(key);
+    serialKick();
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          serialOpen
+ *
+ * @brief       Open the UART for framed output
+ *
+ * @descr       Writes use callback mode, reads stay blocking.
+ *
+ * @return      -
+ */
+void serialOpen(unsigned int index, uint32_t baudRate)
+{
+    UART_Params uartParams;
+
+    UART_Params_init(&uartParams);
+    uartParams.writeMode = UART_MODE_CALLBACK;
+    uartParams.writeCallback = serialWriteDone;
+    uartParams.writeDataMode = UART_DATA_BINARY;
+    uartParams.readDataMode = UART_DATA_BINARY;
+    uartParams.readEcho = UART_ECHO_OFF;
+    uartParams.readMode = UART_MODE_BLOCKING;
+    uartParams.baudRate = baudRate;
+    uartParams.dataLength = UART_LEN_8;
+    uartParams.parityType = UART_PAR_NONE;
+    uartParams.stopBits = UART_STOP_ONE;
+
+    hUart = UART_open(index, &uartParams);
+    if (hUart == NULL) {
+        System_abort("Error opening the UART");
+    }
+}
+
+/*******************************************************************************
+ * @fn          serialSend
+ *
+ * @brief       Queue one frame
+ *
+ * @descr       Never blocks. A frame that does not fit is dropped whole.
+ *
+ * @return      1 if queued, 0 if dropped
+ */
+int serialSend(SerialFrameType type, const void *data, uint16_t length)
+{
+    uint8_t typeByte = type;
+    uint8_t trailer[2];
+    uint16_t crc;
+    uint16_t need;
+    UInt key;
+
+    if (hUart == NULL) {
+        return 0;
+    }
+    crc = serialCrc16(0xFFFF, &typeByte, 1);
+    crc = serialCrc16(crc, data, length);
+    trailer[0] = crc;
+    trailer[1] = crc >> 8;
+    need = 2 + serialEscapedLength(&typeByte, 1) + serialEscapedLength(data, length) +
+           serialEscapedLength(trailer, 2);
+
+    key = Hwi_disable();
+    if (SERIAL_TX_BUFFER - (uint16_t)(txHead - txTail) < need) {
+        stats.dropped++;
+        Hwi_restore(key);
+        return 0;
+    }
+    txBuf[txHead++ % SERIAL_TX_BUFFER] = SERIAL_FLAG;
+    serialPut(&typeByte, 1);
+    serialPut(data, length);
+    serialPut(trailer, 2);
+    txBuf[txHead++ % SERIAL_TX_BUFFER] = SERIAL_FLAG;
+    Hwi_restore(key);
+
+    serialKick();
+    return 1;
+}
+
+/*******************************************************************************
+ * @fn          serialPrint
+ *
+ * @brief       Queue a text frame
+ *
+ * @return      1 if queued, 0 if dropped
+ */
+int serialPrint(const char *text)
+{
+    return serialSend(SERIAL_FRAME_TEXT, text, strlen(text));
+}
+
+/*******************************************************************************
+ * @fn          serialReceive
+ *
+ * @brief       Wait for the next good frame from the host
+ *
+ * @descr       Call from one task only, blocks until a frame arrives.
+ *              Frames with a bad CRC and frames longer than size are
+ *              skipped.
+ *
+ * @return      Length of the type and the payload in data, 0 if the UART
+ *              is not open yet
+ */
+int serialReceive(uint8_t *data, uint16_t size)
+{
+    uint16_t length = 0;
+    uint8_t escaped = 0;
+    uint8_t overflow = 0;
+    uint8_t c;
+
+    if (hUart == NULL) {
+        return 0;
+    }
+    while (1) {
+        if (UART_read(hUart, &c, 1) != 1) {
+            continue;
+        }
+        if (c == SERIAL_FLAG) {
+            // Back to back flags are allowed, they are no frame
+            if (overflow || (length > 0 && length < 3)) {
+                stats.bad++;
+            } else if (length > 0) {
+                if (serialCrc16(0xFFFF, data, length - 2) == (data[length - 2] | (data[length - 1] << 8))) {
+                    stats.received++;
+                    return length - 2;
+                }
+                stats.bad++;
+            }
+            length = 0;
+            escaped = 0;
+            overflow = 0;
+        } else if (c == SERIAL_ESCAPE) {
+            escaped = 1;
+        } else if (length < size) {
+            data[length++] = escaped ? c ^ SERIAL_ESCAPE_XOR : c;
+            escaped = 0;
+        } else {
+            overflow = 1;
+        }
+    }
+}
+
+/*******************************************************************************
+ * @fn          serialGetStats
+ *
+ * @brief       Copy of the serial port statistics
+ *
+ * @return      -
+ */
+void serialGetStats(SerialStats *copy)
+{
+    *copy = stats;
+}
@@ -0,0 +1,79 @@
+/** ============================================================================
+ *  @file       serial.h
+ *
+ *  @brief      Framed, non-blocking serial port output and framed input.
+ *
+ *  Frames are queued in a transmit ring and sent by the UART driver in
+ *  callback mode, so a sender never waits for the line. Received frames
+ *  are read by one task, blocking, with serialReceive. A frame on the
+ *  wire is HDLC-like:
+ *      0x7E, type, payload..., crc16 (lsb first), 0x7E
+ *  with 0x7E and 0x7D escaped as 0x7D, byte ^ 0x20. The CRC is
+ *  CRC-16/CCITT-FALSE over type and payload. host/logdec reads them.
+ *  ============================================================================
+ */
+#ifndef _SERIAL_H_
+#define _SERIAL_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+#define SERIAL_FLAG         0x7E
+#define SERIAL_ESCAPE       0x7D
+#define SERIAL_ESCAPE_XOR   0x20
+
+// Power of two, so the indexes can wrap freely
+#define SERIAL_TX_BUFFER    512
+
+typedef enum {
+    SERIAL_FRAME_TEXT = 1,  // plain text, a report or a reply
+    SERIAL_FRAME_LOG  = 2,  // binary log record, see binlog.c
+    SERIAL_FRAME_FLASH = 3, // flash address u32 and raw flash bytes, see flashlog.h
+    SERIAL_FRAME_IMU   = 4, // raw MPU9250 sample, see stream_format.h
+    SERIAL_FRAME_LIGHT = 5, // light sample, see stream_format.h
+    SERIAL_FRAME_IMU_SCALE = 6, // scale of the raw MPU9250 samples, see stream_format.h
+    SERIAL_FRAME_COMMAND = 7,   // from the host, see console_format.h
+    SERIAL_FRAME_REPLY = 8      // to a command, see console_format.h
+} SerialFrameType;
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    uint32_t dropped;       // frames the transmit ring had no room for
+    uint32_t received;      // good frames received
+    uint32_t bad;           // received frames with a bad CRC or too long
+} SerialStats;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void serialOpen(unsigned int index, uint32_t baudRate);
+int serialSend(SerialFrameType type, const void *data, uint16_t length);
+int serialPrint(const char *text);
+int serialReceive(uint8_t *data, uint16_t size);
+void serialGetStats(SerialStats *stats);
+
+// CRC-16/CCITT-FALSE, start with 0xFFFF. Inline so host tools can use it.
+static inline uint16_t serialCrc16(uint16_t crc, const uint8_t *data, uint16_t length)
+{
+    uint8_t i;
+
+    while (length--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for (i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+#endif
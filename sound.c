@@ -0,0 +1,169 @@
+/** ============================================================================
+ *  @file       sound.c
+ *
+ *  @brief      Clock driven buzzer sounds.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Swi.h>
+
+#include "sound.h"
+#include "buzzer.h"
+#include "probe.h"
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static PIN_Handle hPin = NULL;
+static Clock_Handle hClock = NULL;
+
+// Engine state, only touched with Swis disabled or from the Clock function
+static float (*notes)[3] = NULL;
+static int count = 0;
+static int note = 0;
+static uint8_t offPhase = 0;
+// The buzzer is open, between a tone's start and its end
+static uint8_t toneOn = 0;
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+// Returns 0 if the phase is shorter than a tick, then it is skipped
+static uint32_t soundSchedule(float us)
+{
+    uint32_t ticks = (uint32_t)(us / Clock_tickPeriod);
+
+    if (ticks) {
+        Clock_setTimeout(hClock, ticks);
+        Clock_start(hClock);
+    }
+    return ticks;
+}
+
+static void soundToneOff(void)
+{
+    if (toneOn) {
+        toneOn = 0;
+        buzzerClose();
+    }
+}
+
+/*******************************************************************************
+ * @fn          soundNext
+ *
+ * @brief       Drives the buzzer to the next edge of the current sound
+ *
+ * @descr       Tones and pauses shorter than a tick are skipped without
+ *              waking up. After the last note the buzzer is closed.
+ */
+static void soundNext(void)
+{
+    while (note < count) {
+        if (!offPhase) {
+            offPhase = 1;
+            toneOn = 1;
+            buzzerOpen(hPin);
+            buzzerSetFrequency((uint16_t)notes[note][0]);
+            if (soundSchedule(notes[note][1])) {
+                return;
+            }
+        } else {
+            offPhase = 0;
+            soundToneOff();
+            if (soundSchedule(notes[note++][2])) {
+                return;
+            }
+        }
+    }
+    soundToneOff();
+    count = 0;
+}
+
+// Clock function, runs in Swi context
+static Void soundClkFxn(UArg arg0)
+{
+    soundNext();
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          soundOpen
+ *
+ * @brief       Initialize the sound engine
+ *
+ * @descr       The pin must already be opened as a GPIO output.
+ *
+ * @return      -
+ */
+void soundOpen(PIN_Handle hPinGpio)
+{
+    Clock_Params clkParams;
+
+    hPin = hPinGpio;
+
+    Clock_Params_init(&clkParams);
+    clkParams.period = 0;
+    clkParams.startFlag = FALSE;
+    hClock = Clock_create((Clock_FuncPtr)soundClkFxn, 1, &clkParams, NULL);
+    if (hClock == NULL) {
+        System_abort("Sound clock create failed");
+    }
+}
+
+/*******************************************************************************
+ * @fn          soundPlay
+ *
+ * @brief       Start a sound
+ *
+ * @descr       The table is read while the sound plays, so it must outlive
+ *              it; the sound tables are static. A sound already playing is
+ *              cut at once. Call from tasks or Swis, not from Hwis.
+ *
+ * @return      -
+ */
+void soundPlay(float sound[][3], int length)
+{
+    UInt key;
+
+    if (hClock == NULL || length <= 0) {
+        return;
+    }
+    PROBE_START(PROBE_BUZZER);
+
+    key = Swi_disable();
+    Clock_stop(hClock);
+    soundToneOff();
+    notes = sound;
+    count = length;
+    note = 0;
+    offPhase = 0;
+    soundNext();
+    Swi_restore(key);
+
+    PROBE_STOP(PROBE_BUZZER);
+}
+
+/*******************************************************************************
+ * @fn          soundPlaying
+ *
+ * @brief       Whether a sound is still playing
+ *
+ * @return      true until the last note of the sound has ended
+ */
+bool soundPlaying(void)
+{
+    return count != 0;
+}
@@ -0,0 +1,30 @@
+/** ============================================================================
+ *  @file       sound.h
+ *
+ *  @brief      Clock driven buzzer sounds.
+ *
+ *  A sound is a table of notes: frequency in Hz, length of the tone and of
+ *  the pause after it in microseconds. It plays from a one-shot Clock like
+ *  the LED patterns, so posting a sound returns at once and the state
+ *  machine goes on with the next event. A new sound cuts the playing one.
+ *  ============================================================================
+ */
+#ifndef _SOUND_H_
+#define _SOUND_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdbool.h>
+
+#include "Board.h"
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void soundOpen(PIN_Handle hPinGpio);
+void soundPlay(float sound[][3], int notes);
+bool soundPlaying(void);
+
+#endif
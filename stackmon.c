@@ -0,0 +1,154 @@
+/** ============================================================================
+ *  @file       stackmon.c
+ *
+ *  @brief      Stack high-water-mark monitor.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "stackmon.h"
+#include "events.h"
+
+/* -----------------------------------------------------------------------------
+*  Local types
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    const char *name;
+    uint32_t used;
+    uint32_t size;
+} StackUsage;
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static Task_Handle tasks[STACKMON_MAX_TASKS];
+static const char *taskNames[STACKMON_MAX_TASKS];
+static uint8_t taskCount = 0;
+
+static Clock_Struct clockStruct;
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+// Reads the high-water marks, the ISR (system) stack is the last entry
+static uint8_t stackmonSample(StackUsage *usage)
+{
+    Task_Stat taskStat;
+    Hwi_StackInfo hwiInfo;
+    uint8_t i;
+
+    for (i = 0; i < taskCount; i++) {
+        // Counts the bytes that no longer hold the boot time fill pattern
+        Task_stat(tasks[i], &taskStat);
+        usage[i].name = taskNames[i];
+        usage[i].used = taskStat.used;
+        usage[i].size = taskStat.stackSize;
+    }
+    Hwi_getStackInfo(&hwiInfo, TRUE);
+    usage[i].name = "isr";
+    usage[i].used = hwiInfo.hwiStackPeak;
+    usage[i].size = hwiInfo.hwiStackSize;
+    return taskCount + 1;
+}
+
+static uint32_t stackmonSuggest(uint32_t used)
+{
+    uint32_t size = used + used * STACKMON_MARGIN_PERCENT / 100;
+    return (size + STACKMON_ROUND - 1) / STACKMON_ROUND * STACKMON_ROUND;
+}
+
+// Clock function, the report itself is made by the state machine task
+static Void stackmonClkFxn(UArg arg0)
+{
+    eventPost(EVENT_STACK_REPORT, 0);
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          stackmonOpen
+ *
+ * @brief       Start posting EVENT_STACK_REPORT periodically
+ *
+ * @descr       A period of 0 leaves the reports to the application.
+ *
+ * @return      -
+ */
+void stackmonOpen(uint32_t reportPeriodMs)
+{
+    Clock_Params clkParams;
+    uint32_t ticks = reportPeriodMs * (1000 / Clock_tickPeriod);
+
+    if (ticks == 0) {
+        return;
+    }
+    Clock_Params_init(&clkParams);
+    clkParams.period = ticks;
+    clkParams.startFlag = TRUE;
+    Clock_construct(&clockStruct, (Clock_FuncPtr)stackmonClkFxn, ticks, &clkParams);
+}
+
+/*******************************************************************************
+ * @fn          stackmonAdd
+ *
+ * @brief       Add a task to the reports
+ *
+ * @return      -
+ */
+void stackmonAdd(Task_Handle task, const char *name)
+{
+    if (taskCount == STACKMON_MAX_TASKS) {
+        System_abort("Too many monitored tasks");
+    }
+    tasks[taskCount] = task;
+    taskNames[taskCount] = name;
+    taskCount++;
+}
+
+/*******************************************************************************
+ * @fn          stackmonReport
+ *
+ * @brief       Format the peak stack usage of the monitored stacks
+ *
+ * @descr       Scans the stacks, call from a task.
+ *
+ * @return      Length of the report, it is cut to fit in size
+ */
+int stackmonReport(char *buf, int size, StackmonFormat format)
+{
+    StackUsage usage[STACKMON_MAX_TASKS + 1];
+    uint8_t count = stackmonSample(usage);
+    int length = 0;
+    uint8_t i;
+
+    buf[0] = 0;
+    for (i = 0; i < count && length < size; i++) {
+        if (format == STACKMON_FORMAT_RADIO) {
+            length += snprintf(buf + length, size - length, i ? ";%s:%lu/%lu" : "%s:%lu/%lu",
+                               usage[i].name, (unsigned long)usage[i].used,
+                               (unsigned long)usage[i].size);
+        } else {
+            length += snprintf(buf + length, size - length, "%s: peak %lu of %lu bytes, suggest %lu\n",
+                               usage[i].name, (unsigned long)usage[i].used,
+                               (unsigned long)usage[i].size,
+                               (unsigned long)stackmonSuggest(usage[i].used));
+        }
+    }
+    return length < size ? length : size - 1;
+}
@@ -0,0 +1,42 @@
+/** ============================================================================
+ *  @file       stackmon.h
+ *
+ *  @brief      Stack high-water-mark monitor.
+ *
+ *  The kernel paints the task and ISR stacks at boot (Task.initStackFlag and
+ *  Hwi.initStackFlag in empty.cfg). The monitor reads how deep each stack
+ *  has been used so far and suggests a right-sized stack for each of them.
+ *  ============================================================================
+ */
+#ifndef _STACKMON_H_
+#define _STACKMON_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+#include <ti/sysbios/knl/Task.h>
+
+/* -----------------------------------------------------------------------------
+*                                          Constants
+* ------------------------------------------------------------------------------
+*/
+#define STACKMON_MAX_TASKS      4
+// Suggested size: peak plus this margin, rounded up to STACKMON_ROUND bytes
+#define STACKMON_MARGIN_PERCENT 25
+#define STACKMON_ROUND          64
+
+typedef enum {
+    STACKMON_FORMAT_RADIO = 0,  // "sensor:612/2048;...;isr:300/768"
+    STACKMON_FORMAT_TEXT        // one line per stack with the suggested size
+} StackmonFormat;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+void stackmonOpen(uint32_t reportPeriodMs);
+void stackmonAdd(Task_Handle task, const char *name);
+int stackmonReport(char *buf, int size, StackmonFormat format);
+
+#endif
@@ -0,0 +1,128 @@
+/** ============================================================================
+ *  @file       stream.c
+ *
+ *  @brief      Bench streaming of raw sensor samples to the serial port.
+ *  ============================================================================
+ */
+
+/* -----------------------------------------------------------------------------
+*  Includes
+* ------------------------------------------------------------------------------
+*/
+#include <string.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "stream.h"
+#include "serial.h"
+
+/* -----------------------------------------------------------------------------
+*  Local variables
+* ------------------------------------------------------------------------------
+*/
+static uint16_t seq = 0;
+static StreamStats stats;
+
+/* -----------------------------------------------------------------------------
+*  Local functions
+* ------------------------------------------------------------------------------
+*/
+static uint8_t *put16(uint8_t *p, uint16_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t value)
+{
+    put16(p, value);
+    return put16(p + 2, value >> 16);
+}
+
+static uint8_t *putFloat(uint8_t *p, float value)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    return put32(p, bits);
+}
+
+/* -----------------------------------------------------------------------------
+*  Public Functions
+* ------------------------------------------------------------------------------
+*/
+
+/*******************************************************************************
+ * @fn          streamImu
+ *
+ * @brief       Queue one raw MPU9250 sample, see mpu9250_get_raw
+ *
+ * @return      1 if queued, 0 if dropped
+ */
+int streamImu(const int16_t raw[7])
+{
+    uint8_t frame[STREAM_IMU_SIZE];
+    uint8_t *p = frame;
+    uint8_t i;
+
+    p = put32(p, Clock_getTicks());
+    p = put16(p, seq++);
+    for (i = 0; i < 7; i++) {
+        p = put16(p, raw[i]);
+    }
+    if (!serialSend(SERIAL_FRAME_IMU, frame, sizeof(frame))) {
+        stats.dropped++;
+        return 0;
+    }
+    stats.sent++;
+    return 1;
+}
+
+/*******************************************************************************
+ * @fn          streamLight
+ *
+ * @brief       Queue one light sample
+ *
+ * @return      1 if queued, 0 if dropped
+ */
+int streamLight(float lux)
+{
+    uint8_t frame[STREAM_LIGHT_SIZE];
+
+    putFloat(put32(frame, Clock_getTicks()), lux);
+    return serialSend(SERIAL_FRAME_LIGHT, frame, sizeof(frame));
+}
+
+/*******************************************************************************
+ * @fn          streamScale
+ *
+ * @brief       Queue the scale of the raw IMU samples
+ *
+ * @return      1 if queued, 0 if dropped
+ */
+int streamScale(const Mpu9250Scale *scale)
+{
+    uint8_t frame[STREAM_SCALE_SIZE];
+    uint8_t *p = frame;
+
+    p = putFloat(p, scale->aRes);
+    p = putFloat(p, scale->gRes);
+    p = putFloat(p, scale->accelBias[0]);
+    p = putFloat(p, scale->accelBias[1]);
+    putFloat(p, scale->accelBias[2]);
+    return serialSend(SERIAL_FRAME_IMU_SCALE, frame, sizeof(frame));
+}
+
+/*******************************************************************************
+ * @fn          streamGetStats
+ *
+ * @brief       Copy of the streaming statistics
+ *
+ * @return      -
+ */
+void streamGetStats(StreamStats *copy)
+{
+    *copy = stats;
+}
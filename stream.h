@@ -0,0 +1,40 @@
+/** ============================================================================
+ *  @file       stream.h
+ *
+ *  @brief      Bench streaming of raw sensor samples to the serial port.
+ *
+ *  For captures over a cable, at a rate the radio cannot carry. The
+ *  samples are queued without waiting, so a full transmit buffer drops
+ *  a sample rather than stalling the sampling. The frames are described
+ *  in stream_format.h, host/capture turns them into Debug/data.csv lines.
+ *  ============================================================================
+ */
+#ifndef _STREAM_H_
+#define _STREAM_H_
+/* -----------------------------------------------------------------------------
+*                                          Includes
+* ------------------------------------------------------------------------------
+*/
+#include <stdint.h>
+#include "sensors/mpu9250.h"
+#include "stream_format.h"
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+typedef struct {
+    uint32_t sent;      // IMU samples queued
+    uint32_t dropped;   // IMU samples the serial port had no room for
+} StreamStats;
+
+/* -----------------------------------------------------------------------------
+*                                          Functions
+* ------------------------------------------------------------------------------
+*/
+int streamImu(const int16_t raw[7]);
+int streamLight(float lux);
+int streamScale(const Mpu9250Scale *scale);
+void streamGetStats(StreamStats *stats);
+
+#endif
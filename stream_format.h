@@ -0,0 +1,28 @@
+/** ============================================================================
+ *  @file       stream_format.h
+ *
+ *  @brief      Frames of the bench stream, shared with host/capture.
+ *
+ *  Each sample is one serial frame (see serial.h). Frame payloads, all
+ *  little endian:
+ *      SERIAL_FRAME_IMU        tick u32, seq u16, raw i16 x 7
+ *                              (accel x y z, temperature, gyro x y z)
+ *      SERIAL_FRAME_LIGHT      tick u32, lux float
+ *      SERIAL_FRAME_IMU_SCALE  aRes, gRes, accelBias x 3, all float
+ *  seq counts the IMU samples, dropped ones included, so the host sees
+ *  the gaps. Acceleration in g is raw * aRes - accelBias and rotation in
+ *  deg/s is raw * gRes. The scale frame comes at the start and once per
+ *  second.
+ *  ============================================================================
+ */
+#ifndef _STREAM_FORMAT_H_
+#define _STREAM_FORMAT_H_
+
+// The MPU9250 output rate, see initMPU9250
+#define STREAM_RATE_HZ          200
+
+#define STREAM_IMU_SIZE         20
+#define STREAM_LIGHT_SIZE       8
+#define STREAM_SCALE_SIZE       20
+
+#endif
@@ -0,0 +1,21 @@
+/** ============================================================================
+ *  @file       tuned.h
+ *
+ *  @brief      Detection constants tuned on a labeled trace corpus.
+ *
+ *  Generated by host/score/tune, do not edit. The defaults of params.h and
+ *  the window of detect.h.
+ *  The original hand-picked values, not tuned yet.
+ *  ============================================================================
+ */
+#ifndef _TUNED_H_
+#define _TUNED_H_
+
+#define TUNED_DETECT_WINDOW         50
+#define TUNED_DETECT_SMOOTH         3
+#define TUNED_EXERCISE_THRESHOLD    3
+#define TUNED_PET_THRESHOLD         2
+#define TUNED_PET_MAX_VERTICAL      1
+#define TUNED_DARK_LUX              5
+
+#endif
@@ -63,6 +63,7 @@ static volatile rfc_CMD_PING_t rfc_CMD_PING;
 static volatile rfc_CMD_IEEE_TX_t rfc_CMD_IEEE_TX;//send a packet(forced)
 static volatile rfc_CMD_IEEE_RX_t rfc_CMD_IEEE_RX;//start radio in RX (background mode)
 static volatile rfc_CMD_IEEE_ABORT_BG_t rfc_CMD_IEEE_ABORT_BG;//stop background mode
+static volatile rfc_CMD_IEEE_ED_SCAN_t rfc_CMD_IEEE_ED_SCAN;//energy detect scan
 
 //internal status structure
 static volatile CWC_CC2650_154_Status_Struct_t my_CC2650_Status;
@@ -249,6 +250,40 @@ const rfc_CMD_IEEE_RX_t IEEE_RX ={
 		.endTime = 0x00000000,
 };
 
+const rfc_CMD_IEEE_ABORT_BG_t IEEE_ABORT_BG ={
+		.commandNo = CMD_IEEE_ABORT_BG,
+		.status = 0x0000,
+		.pNextOp = 0,
+		.startTime = 0x00000000,
+		.startTrigger.triggerType = TRIG_NOW,
+		.condition.rule = COND_NEVER,
+};
+
+const rfc_CMD_IEEE_ED_SCAN_t IEEE_ED_SCAN ={
+		.commandNo = CMD_IEEE_ED_SCAN,
+		.status = 0x0000,
+		.pNextOp = 0,
+		.startTime = 0x00000000,
+		.startTrigger.triggerType = TRIG_NOW,
+		.startTrigger.bEnaCmd = 0x0,
+		.startTrigger.triggerNo = 0x0,
+		.startTrigger.pastTrig = 0x0,
+		.condition.rule = COND_NEVER,
+		.condition.nSkip = 0x0,
+		.channel = 0,//set per scan
+		.ccaOpt.ccaEnEnergy=1,//energy only, the peak RSSI is what we are after
+		.ccaOpt.ccaEnCorr=0,
+		.ccaOpt.ccaEnSync=0,
+		.ccaOpt.ccaCorrOp=0,
+		.ccaOpt.ccaSyncOp=0,
+		.ccaOpt.ccaCorrThr=0,
+		.ccaRssiThr=0x64,//not used for ED
+		.__dummy0=0,
+		.maxRssi=0,
+		.endTrigger.triggerType = TRIG_REL_START,//scan for the given time
+		.endTime = 0x00000000,//set per scan
+};
+
 //IEEE strutures
 //IEEE packet header const
 const CWC_CC2650_IEEE154_simple_header_struct_t IEEE154_header={
@@ -276,8 +311,13 @@ static uint8_t rx_buf_1[150] __attribute__ ((aligned (4)));
 static dataQueue_t rx_data_queue = { 0 };
 
 //LOCAL FUNCTION PROTOTYPES
+static uint8_t CWC_CC2650_154_StopBackground(void);
 
 //MACROS
+#define RAT_TICKS_PER_US		4//radio timer runs at 4 MHz
+#define CMD_WAIT_LOOPS			1000000//upper bound for polling a radio command
+#define IEEE_STATUS_DONE_OK		0x2400//see ieee_mailbox.h
+#define RADIO_OP_FINISHED(status)	((status)&0x0C00)//any DONE_xxx (0x04xx) or ERROR_xxx (0x08xx) status
 
 //CODE: PUBLIC FUNCTIONS
 
@@ -485,6 +525,95 @@ CWC_CC2650_154_ReceiveStart(void){
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		CWC_CC2650_154_EnergyScan
+///Description:		Measures the peak energy on one channel
+//Inputs: 			u8_Channel - IEEE 802.15.4 channel 11-26
+//					u32_Duration_us - how long to listen
+//					ptr_MaxRssi - peak RSSI in dBm during the scan
+//Outputs:			1 - all is ok, 0 - fail
+//Notes:			Stops background RX. Restart it with CWC_CC2650_154_ReceiveStart afterwards.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+uint8_t
+CWC_CC2650_154_EnergyScan(uint8_t u8_Channel, uint32_t u32_Duration_us, int8_t *ptr_MaxRssi){
+	volatile int result = 0;
+	uint32_t u32_cnt = 0;
+
+	if(ptr_MaxRssi==NULL)return 0;
+	if((u8_Channel<11)||(u8_Channel>26))return 0;//fail - not an IEEE 802.15.4 channel
+	if(!CWC_CC2650_154_StopBackground())return 0;
+
+	memcpy((rfc_CMD_IEEE_ED_SCAN_t *)&rfc_CMD_IEEE_ED_SCAN, &IEEE_ED_SCAN, sizeof(rfc_CMD_IEEE_ED_SCAN_t));
+	rfc_CMD_IEEE_ED_SCAN.channel=u8_Channel;
+	rfc_CMD_IEEE_ED_SCAN.endTime=u32_Duration_us*RAT_TICKS_PER_US;
+	result=RFCDoorbellSendTo((unsigned long)&rfc_CMD_IEEE_ED_SCAN);
+	if(result!=0x01)return 0;//something goes wrong
+	while(!RADIO_OP_FINISHED(rfc_CMD_IEEE_ED_SCAN.status)){//wait for the scan to end
+		if(++u32_cnt>CMD_WAIT_LOOPS)return 0;
+	}
+	if(rfc_CMD_IEEE_ED_SCAN.status!=IEEE_STATUS_DONE_OK)return 0;
+
+	*ptr_MaxRssi=rfc_CMD_IEEE_ED_SCAN.maxRssi;
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		CWC_CC2650_154_SetChannel
+///Description:		Moves the radio to another channel
+//Inputs: 			u8_Channel - IEEE 802.15.4 channel 11-26
+//Outputs:			1 - all is ok, 0 - fail
+//Notes:			Stops background RX. Restart it with CWC_CC2650_154_ReceiveStart afterwards.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+uint8_t
+CWC_CC2650_154_SetChannel(uint8_t u8_Channel){
+	if((u8_Channel<11)||(u8_Channel>26))return 0;//fail - not an IEEE 802.15.4 channel
+	if(!CWC_CC2650_154_StopBackground())return 0;
+	my_CC2650_Status.myChannel=u8_Channel;
+	rfc_CMD_IEEE_RX.channel=u8_Channel;//used by the next RX, TX follows RX (or CMD_FS when idle)
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		CWC_CC2650_154_GetChannel
+///Description:		Returns the current channel
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+uint8_t
+CWC_CC2650_154_GetChannel(void){
+	return my_CC2650_Status.myChannel;
+}
+
+//CODE: LOCAL FUNCTIONS
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		CWC_CC2650_154_StopBackground
+///Description:		Ends background RX so that the radio is idle
+//Outputs:			1 - radio is idle, 0 - fail (e.g. TX in progress)
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static uint8_t
+CWC_CC2650_154_StopBackground(void){
+	volatile int result = 0;
+	uint32_t u32_cnt = 0;
+
+	switch(my_CC2650_Status.myState){
+		case CWC_CC2650_154_STATE_IDLE:
+			return 1;
+		case CWC_CC2650_154_STATE_RX:
+		{
+			memcpy((rfc_CMD_IEEE_ABORT_BG_t *)&rfc_CMD_IEEE_ABORT_BG, &IEEE_ABORT_BG, sizeof(rfc_CMD_IEEE_ABORT_BG_t));
+			result=RFCDoorbellSendTo((unsigned long)&rfc_CMD_IEEE_ABORT_BG);
+			if(result!=0x01)return 0;//something goes wrong
+			while(!RADIO_OP_FINISHED(rfc_CMD_IEEE_RX.status)){//wait for RX to end
+				if(++u32_cnt>CMD_WAIT_LOOPS)return 0;
+			}
+			my_CC2650_Status.myState=CWC_CC2650_154_STATE_IDLE;
+			my_CC2650_Status.myBackgroundState=CWC_CC2650_154_Background_IDLE;
+			return 1;
+		}
+		default:
+			return 0;//cannot stop in the middle of TX
+	}
+}
+
 
 //INTERRUPTS
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -122,6 +122,9 @@ extern volatile uint8_t *rx_read_entry;
 uint8_t CWC_CC2650_154_Init(CWC_CC2650_154_Init_struct_t *ptr_Init_Data);//initialize the radio
 uint8_t CWC_CC2650_154_SendDataPacket_Forced(uint16_t DestAddr, uint8_t *ptr_Payload, uint8_t u8_length);//sent a radio packet in forced mode (i.e. without CCA)
 uint8_t CWC_CC2650_154_ReceiveStart(void);//start receive mode
+uint8_t CWC_CC2650_154_EnergyScan(uint8_t u8_Channel, uint32_t u32_Duration_us, int8_t *ptr_MaxRssi);//peak energy on a channel
+uint8_t CWC_CC2650_154_SetChannel(uint8_t u8_Channel);//move to another channel
+uint8_t CWC_CC2650_154_GetChannel(void);//current channel
 
 //Enable radio IRQs. Should work from each possible state.
 __STATIC_INLINE void
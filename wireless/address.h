@@ -12,6 +12,13 @@
 #define IEEE80154_PANID				0x1337
 #define IEEE80154_CHANNEL			0x0C
 
+// Channels 11-26 are scanned at boot and the result is reported to the gateway on IEEE80154_CHANNEL.
+// With IEEE80154_CHANNEL_AUTO set to 1 the device then moves to the quietest channel; the gateway has to
+// follow it using the report. IEEE80154_SCAN_TIME_US is the listening time per channel.
+#define IEEE80154_CHANNEL_AUTO		0
+#define IEEE80154_SCAN_TIME_US		5000
+#define IEEE80154_SCAN_MARGIN_DB	3//the configured channel is kept unless another one is this much quieter
+
 // JTKJ: Replace here the value 0x8000 with your network address (=the number in your box)
 //       E.g. box number is 123 -> set address below as 0x0123
 #define IEEE80154_MY_ADDR			0x0301
@@ -10,12 +10,14 @@
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <stdio.h>
+#include <string.h>
 
 /* XDCtools files */
 #include <xdc/std.h>
 #include <xdc/runtime/System.h>
 #include <driverlib/pwr_ctrl.h>
 #include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Clock.h>
 
 #include "wireless/comm_lib.h"
 #include "wireless/CWC_CC2650_154Drv.h"
@@ -31,6 +33,15 @@ static volatile uint8_t u8_RXd_Flag = false;
 static volatile uint8_t u8_RX_Error_Flag = false;
 int8_t rssi = 0;
 
+static uint8_t u8_FragmentId = 0;
+static uint8_t u8_FragmentBuf[FRAGMENT_PAYLOAD_MAX+1];
+//received frames have their own buffer, the tasks sending may preempt the receiving one
+static uint8_t u8_RxBuf[FRAGMENT_PAYLOAD_MAX+1];
+static Fragment_Reassembly_t str_Reassembly;
+//reassembly clock in ms, wrapping at 2^32 as the fragment timeout expects
+static uint32_t u32_ReasmMs = 0;
+static uint32_t u32_ReasmTicks = 0;
+
 Hwi_Params cpe0Params;
 Hwi_Handle cpe0Handle;
 Hwi_Params cpe1Params;
@@ -167,6 +178,129 @@ int8_t Receive6LoWPAN(uint16_t *senderAddr, char *payload, uint8_t maxLen) {
 	return i16_MACPDU_length;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		ScanChannels6LoWPAN
+///Description:		Energy detect scan over channels 11-26
+//Inputs: 			ptr_Rssi - IEEE80154_CHANNEL_COUNT entries, peak RSSI in dBm of each channel
+//Outputs:			the quietest channel, -1 - scan failed
+//Notes:			The current channel wins unless another one is IEEE80154_SCAN_MARGIN_DB quieter,
+//					so that a noisy measurement does not move the device around. Stops receiving,
+//					call StartReceive6LoWPAN afterwards.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int8_t ScanChannels6LoWPAN(int8_t *ptr_Rssi) {
+
+	uint8_t u8_i;
+	uint8_t u8_best = 0;
+	uint8_t u8_current = CWC_CC2650_154_GetChannel() - IEEE80154_CHANNEL_FIRST;
+
+	for (u8_i = 0; u8_i < IEEE80154_CHANNEL_COUNT; u8_i++) {
+		if (!CWC_CC2650_154_EnergyScan(IEEE80154_CHANNEL_FIRST + u8_i, IEEE80154_SCAN_TIME_US, &ptr_Rssi[u8_i])) {
+			return -1;
+		}
+		if (ptr_Rssi[u8_i] < ptr_Rssi[u8_best]) {
+			u8_best = u8_i;
+		}
+	}
+	if (ptr_Rssi[u8_current] - ptr_Rssi[u8_best] < IEEE80154_SCAN_MARGIN_DB) {
+		u8_best = u8_current;
+	}
+	return IEEE80154_CHANNEL_FIRST + u8_best;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		SetChannel6LoWPAN
+///Description:		Moves the radio to another channel
+//Outputs:			1 - ok, 0 - invalid channel or radio busy
+//Notes:			Stops receiving, call StartReceive6LoWPAN afterwards.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int8_t SetChannel6LoWPAN(uint8_t u8_Channel) {
+
+	return CWC_CC2650_154_SetChannel(u8_Channel);
+}
+
+uint8_t GetChannel6LoWPAN(void) {
+
+	return CWC_CC2650_154_GetChannel();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		SendBulk6LoWPAN
+///Description:		Sends a message of any length, splitting it into fragments when it does not fit one packet
+//Inputs: 			DestAddr - destination address, ptr_Payload, u16_length - the message
+//Outputs:			number of packets sent, -1 - message too long
+//Notes:			The fragments are sent back to back, the caller restores the receiving state afterwards
+//					just like with Send6LoWPAN. Messages up to FRAGMENT_PAYLOAD_MAX bytes go out unfragmented.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int16_t SendBulk6LoWPAN(uint16_t DestAddr, uint8_t *ptr_Payload, uint16_t u16_length) {
+
+	uint8_t u8_count, u8_index, u8_len;
+
+	if ((u16_length <= FRAGMENT_PAYLOAD_MAX) && ((u16_length == 0) || (ptr_Payload[0] != FRAGMENT_MARKER))) {
+		Send6LoWPAN(DestAddr, ptr_Payload, (uint8_t)u16_length);
+		return 1;
+	}
+
+	u8_count = Fragment_Count(u16_length);
+	if (u8_count == 0) {
+		return -1;
+	}
+	u8_FragmentId++;
+	for (u8_index = 0; u8_index < u8_count; u8_index++) {
+		u8_len = Fragment_Build(u8_FragmentId, ptr_Payload, u16_length, u8_index, u8_FragmentBuf);
+		Send6LoWPAN(DestAddr, u8_FragmentBuf, u8_len);
+	}
+	return u8_count;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		ReceiveMessage6LoWPAN
+///Description:		Like Receive6LoWPAN, but reassembles fragmented messages
+//Inputs: 			senderAddr - sender of the message, payload, maxLen - buffer for the message
+//Outputs:			length of a complete message, 0 - a fragment was stored and the message is not complete yet,
+//					-1 - the packet was dropped
+//Notes:			Call when GetRXFlag() is set. Unfinished messages time out after FRAGMENT_TIMEOUT_MS.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int16_t ReceiveMessage6LoWPAN(uint16_t *senderAddr, char *payload, uint16_t maxLen) {
+
+	//whole ms since the last call, the rest of a ms is left for the next one
+	uint32_t u32_elapsed = (Clock_getTicks() - u32_ReasmTicks) / (1000 / Clock_tickPeriod);
+	uint32_t u32_now;
+	int8_t i8_length;
+
+	u32_ReasmTicks += u32_elapsed * (1000 / Clock_tickPeriod);
+	u32_ReasmMs += u32_elapsed;
+	u32_now = u32_ReasmMs;
+
+	Fragment_Expire(&str_Reassembly, u32_now);
+
+	memset(u8_RxBuf, 0, sizeof(u8_RxBuf));
+	i8_length = Receive6LoWPAN(senderAddr, (char *)u8_RxBuf, sizeof(u8_RxBuf));
+	if (i8_length < 0) {
+		return -1;
+	}
+
+	switch (Fragment_Accept(&str_Reassembly, *senderAddr, u8_RxBuf, (uint8_t)i8_length, u32_now)) {
+		case FRAGMENT_RESULT_NOT_FRAGMENT:
+			if (i8_length >= maxLen) {
+				return -1;
+			}
+			memcpy(payload, u8_RxBuf, i8_length);
+			payload[i8_length] = 0;
+			return i8_length;
+		case FRAGMENT_RESULT_COMPLETE:
+			if (str_Reassembly.Length >= maxLen) {
+				return -1;
+			}
+			memcpy(payload, str_Reassembly.Data, str_Reassembly.Length);
+			payload[str_Reassembly.Length] = 0;
+			return str_Reassembly.Length;
+		case FRAGMENT_RESULT_PENDING:
+			return 0;
+		default:
+			return -1;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //FunctionName:		Radio_IRQ
 ///Description:		Radio IRQ callback function
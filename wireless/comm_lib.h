@@ -14,6 +14,10 @@
 
 #include "wireless/CWC_CC2650_154Drv.h"
 #include "wireless/address.h"
+#include "wireless/fragment.h"
+
+#define IEEE80154_CHANNEL_FIRST		11
+#define IEEE80154_CHANNEL_COUNT		16
 
 void Init6LoWPAN(void);
 int8_t StartReceive6LoWPAN(void);
@@ -23,6 +27,11 @@ uint8_t GetRXFlag(void);
 int8_t GetRSSI(void);
 void Send6LoWPAN(uint16_t DestAddr, uint8_t *ptr_Payload, uint8_t u8_length);
 int8_t Receive6LoWPAN(uint16_t *senderAddr, char *payload, uint8_t maxLen);
+int8_t ScanChannels6LoWPAN(int8_t *ptr_Rssi);
+int8_t SetChannel6LoWPAN(uint8_t u8_Channel);
+uint8_t GetChannel6LoWPAN(void);
+int16_t SendBulk6LoWPAN(uint16_t DestAddr, uint8_t *ptr_Payload, uint16_t u16_length);
+int16_t ReceiveMessage6LoWPAN(uint16_t *senderAddr, char *payload, uint16_t maxLen);
 
 void Radio_IRQ(CWC_CC2650_154_Events_t Event);
 extern void RFCCPE0IntHandler(UArg arg0);
@@ -0,0 +1,128 @@
+//DESCRIPTION/NOTES
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//		Name:			fragment.c
+//		Description:	Fragmentation and reassembly of messages longer than one IEEE 802.15.4 payload
+//		Note: 			Platform independent, the same code is used by the gateway side reassembler in host/reasm
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+
+#include "fragment.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		Fragment_Count
+///Description:		Number of fragments needed for a message
+//Inputs: 			u16_length - length of the message
+//Outputs:			number of fragments, 0 if the message is too long to be fragmented
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+uint8_t
+Fragment_Count(uint16_t u16_length){
+	uint16_t count = (u16_length+FRAGMENT_DATA_MAX-1)/FRAGMENT_DATA_MAX;
+	if(count==0)count=1;//an empty message is still sent as one fragment
+	if(count>255)return 0;
+	return (uint8_t)count;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		Fragment_Build
+///Description:		Builds one fragment of a message
+//Inputs: 			u8_MessageId - id shared by all fragments of the message
+//					ptr_Data, u16_length - the whole message
+//					u8_index - which fragment to build
+//					ptr_Out - buffer of at least FRAGMENT_PAYLOAD_MAX bytes for the fragment
+//Outputs:			length of the fragment, 0 - fail
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+uint8_t
+Fragment_Build(uint8_t u8_MessageId, const uint8_t *ptr_Data, uint16_t u16_length, uint8_t u8_index, uint8_t *ptr_Out){
+	uint8_t count = Fragment_Count(u16_length);
+	uint16_t offset = (uint16_t)u8_index*FRAGMENT_DATA_MAX;
+	uint16_t chunk;
+
+	if((ptr_Out==NULL)||(count==0)||(u8_index>=count))return 0;
+	if((ptr_Data==NULL)&&(u16_length>0))return 0;
+
+	chunk = u16_length-offset;
+	if(chunk>FRAGMENT_DATA_MAX)chunk=FRAGMENT_DATA_MAX;
+
+	ptr_Out[0]=FRAGMENT_MARKER;
+	ptr_Out[1]=u8_MessageId;
+	ptr_Out[2]=u8_index;
+	ptr_Out[3]=count;
+	if(chunk>0)memcpy(&ptr_Out[FRAGMENT_HEADER_BYTES], &ptr_Data[offset], chunk);
+	return (uint8_t)(chunk+FRAGMENT_HEADER_BYTES);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		Fragment_Reset
+///Description:		Drops whatever the reassembly buffer holds
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+Fragment_Reset(Fragment_Reassembly_t *ptr_Reasm){
+	ptr_Reasm->Active=0;
+	ptr_Reasm->Received=0;
+	ptr_Reasm->Length=0;
+	memset(ptr_Reasm->ReceivedMask, 0, sizeof(ptr_Reasm->ReceivedMask));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		Fragment_Accept
+///Description:		Feeds a received radio payload to the reassembly buffer
+//Inputs: 			ptr_Reasm - reassembly buffer
+//					u16_Sender - sender address of the payload
+//					ptr_Frame, u8_length - the received payload
+//					u32_now - current time in ms, used for the timeout
+//Outputs:			see Fragment_Result_t
+//Notes:			A fragment of a new message (other sender or id) replaces an unfinished one.
+//					Duplicates are ignored, so fragments may be resent freely.
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+Fragment_Result_t
+Fragment_Accept(Fragment_Reassembly_t *ptr_Reasm, uint16_t u16_Sender, const uint8_t *ptr_Frame, uint8_t u8_length, uint32_t u32_now){
+	uint8_t index, count, chunk;
+	uint32_t bit;
+
+	if((ptr_Frame==NULL)||(u8_length<FRAGMENT_HEADER_BYTES)||(ptr_Frame[0]!=FRAGMENT_MARKER))return FRAGMENT_RESULT_NOT_FRAGMENT;
+
+	index=ptr_Frame[2];
+	count=ptr_Frame[3];
+	chunk=u8_length-FRAGMENT_HEADER_BYTES;
+	if((count==0)||(index>=count)||(count>FRAGMENT_MAX_FRAGMENTS))return FRAGMENT_RESULT_ERROR;
+	if(chunk>FRAGMENT_DATA_MAX)return FRAGMENT_RESULT_ERROR;
+	if((index<count-1)&&(chunk!=FRAGMENT_DATA_MAX))return FRAGMENT_RESULT_ERROR;//only the last one may be short
+
+	if((!ptr_Reasm->Active)||(ptr_Reasm->Sender!=u16_Sender)||(ptr_Reasm->MessageId!=ptr_Frame[1])||(ptr_Reasm->Count!=count)){
+		Fragment_Reset(ptr_Reasm);
+		ptr_Reasm->Active=1;
+		ptr_Reasm->Sender=u16_Sender;
+		ptr_Reasm->MessageId=ptr_Frame[1];
+		ptr_Reasm->Count=count;
+	}
+	ptr_Reasm->LastTime=u32_now;
+
+	bit=1uL<<(index&31);
+	if(ptr_Reasm->ReceivedMask[index>>5]&bit)return FRAGMENT_RESULT_PENDING;//duplicate
+	ptr_Reasm->ReceivedMask[index>>5]|=bit;
+	ptr_Reasm->Received++;
+
+	memcpy(&ptr_Reasm->Data[(uint16_t)index*FRAGMENT_DATA_MAX], &ptr_Frame[FRAGMENT_HEADER_BYTES], chunk);
+	if(index==count-1)ptr_Reasm->Length=(uint16_t)index*FRAGMENT_DATA_MAX+chunk;
+
+	if(ptr_Reasm->Received<count)return FRAGMENT_RESULT_PENDING;
+	ptr_Reasm->Active=0;//the caller owns the data until the next fragment arrives
+	return FRAGMENT_RESULT_COMPLETE;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//FunctionName:		Fragment_Expire
+///Description:		Drops an unfinished message after FRAGMENT_TIMEOUT_MS of silence
+//Inputs: 			ptr_Reasm - reassembly buffer
+//					u32_now - current time in ms
+//Outputs:			1 - a message was dropped, 0 - nothing to do
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+uint8_t
+Fragment_Expire(Fragment_Reassembly_t *ptr_Reasm, uint32_t u32_now){
+	if(ptr_Reasm->Active&&((int32_t)(u32_now-ptr_Reasm->LastTime)>FRAGMENT_TIMEOUT_MS)){
+		Fragment_Reset(ptr_Reasm);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,60 @@
+//DESCRIPTION/NOTES
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//		Name:			fragment.h
+//		Description:	Fragmentation and reassembly of messages longer than one IEEE 802.15.4 payload
+//		Note: 			Platform independent, the same code is used by the gateway side reassembler in host/reasm
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef WIRELESS_FRAGMENT_H_
+#define WIRELESS_FRAGMENT_H_
+
+#include <stdint.h>
+
+//CONSTANTS
+//A fragment is a normal radio payload that starts with a 4 byte header:
+//  [0] FRAGMENT_MARKER, never the first byte of a text message
+//  [1] message id, increments for each fragmented message of a sender
+//  [2] fragment index, 0..count-1
+//  [3] fragment count
+#define FRAGMENT_MARKER				0xFE
+#define FRAGMENT_HEADER_BYTES		4
+#define FRAGMENT_PAYLOAD_MAX		116//see CWC_CC2650_154_SendDataPacket_Forced
+#define FRAGMENT_DATA_MAX			(FRAGMENT_PAYLOAD_MAX-FRAGMENT_HEADER_BYTES)
+
+//Largest message that can be reassembled. The gateway side builds this with a bigger value.
+#ifndef FRAGMENT_MAX_FRAGMENTS
+#define FRAGMENT_MAX_FRAGMENTS		4
+#endif
+#define FRAGMENT_MESSAGE_MAX		(FRAGMENT_MAX_FRAGMENTS*FRAGMENT_DATA_MAX)
+
+//Incomplete messages are dropped after this many milliseconds without a new fragment
+#define FRAGMENT_TIMEOUT_MS			2000
+
+//TYPEDEFS
+typedef enum{//results of Fragment_Accept
+	FRAGMENT_RESULT_NOT_FRAGMENT	= 0,//plain message, handle it as is
+	FRAGMENT_RESULT_PENDING			= 1,//fragment stored, message not complete yet
+	FRAGMENT_RESULT_COMPLETE		= 2,//message complete, see Data and Length
+	FRAGMENT_RESULT_ERROR			= -1,//malformed or too long, fragment dropped
+}Fragment_Result_t;
+
+typedef struct{//reassembly buffer for one sender
+	uint8_t Active;
+	uint16_t Sender;
+	uint8_t MessageId;
+	uint8_t Count;
+	uint8_t Received;
+	uint16_t Length;//total length, known once the last fragment has arrived
+	uint32_t LastTime;//time of the latest fragment in ms
+	uint32_t ReceivedMask[(FRAGMENT_MAX_FRAGMENTS+31)/32];
+	uint8_t Data[FRAGMENT_MESSAGE_MAX];
+}Fragment_Reassembly_t;
+
+//PUBLIC FUNCTION PROTOTYPES
+uint8_t Fragment_Count(uint16_t u16_length);
+uint8_t Fragment_Build(uint8_t u8_MessageId, const uint8_t *ptr_Data, uint16_t u16_length, uint8_t u8_index, uint8_t *ptr_Out);
+void Fragment_Reset(Fragment_Reassembly_t *ptr_Reasm);
+Fragment_Result_t Fragment_Accept(Fragment_Reassembly_t *ptr_Reasm, uint16_t u16_Sender, const uint8_t *ptr_Frame, uint8_t u8_length, uint32_t u32_now);
+uint8_t Fragment_Expire(Fragment_Reassembly_t *ptr_Reasm, uint32_t u32_now);
+
+#endif /* WIRELESS_FRAGMENT_H_ */